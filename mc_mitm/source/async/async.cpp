@@ -14,6 +14,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "async.hpp"
+#include "../utils.hpp"
+#include "../mcmitm_config.hpp"
 
 namespace ams::async {
 
@@ -21,7 +23,6 @@ namespace ams::async {
 
         constexpr size_t ThreadCount = 1;
         constexpr size_t ThreadStackSize = 0x2000;
-        constexpr s32 ThreadPriority = 10;
 
         alignas(os::MemoryPageSize) constinit u8 g_thread_stacks[ThreadCount][ThreadStackSize];
         constinit os::ThreadType g_thread_pool[ThreadCount];
@@ -30,16 +31,26 @@ namespace ams::async {
         constinit uintptr_t g_message_buffer[MessageBufferSize];
         constinit os::MessageQueueType g_work_queue;
 
+        // Work functions are stored in a fixed pool large enough for a full queue plus those currently executing.
+        // Small captures (eg. this) fit in the std::function's inline storage, so queueing work never touches the heap
+        constexpr size_t WorkPoolSize = MessageBufferSize + ThreadCount;
+        constinit utils::ObjectPool<AsyncFunction, WorkPoolSize> g_work_pool;
+        constinit os::SemaphoreType g_work_pool_semaphore;
+
         void WorkerThreadFunc(void *) {
             uintptr_t ptr;
             for (;;) {
                 os::ReceiveMessageQueue(&ptr, &g_work_queue);
 
-                // Convert pointer to work function back to correct type and claim ownership
-                auto work_func = std::unique_ptr<AsyncFunction>(reinterpret_cast<AsyncFunction *>(ptr));
+                // Convert pointer to work function back to correct type
+                auto work_func = reinterpret_cast<AsyncFunction *>(ptr);
 
                 // Execute the work function
                 (*work_func)();
+
+                // Return the work function to the pool
+                g_work_pool.Free(work_func);
+                os::ReleaseSemaphore(&g_work_pool_semaphore);
             }
         }
 
@@ -47,6 +58,7 @@ namespace ams::async {
 
     Result Initialize() {
         os::InitializeMessageQueue(&g_work_queue, g_message_buffer, MessageBufferSize);
+        os::InitializeSemaphore(&g_work_pool_semaphore, WorkPoolSize, WorkPoolSize);
 
         for (unsigned int i = 0; i < ThreadCount; ++i) {
             R_TRY(os::CreateThread(&g_thread_pool[i],
@@ -54,7 +66,7 @@ namespace ams::async {
                 nullptr,
                 g_thread_stacks[i],
                 ThreadStackSize,
-                ThreadPriority
+                mitm::GetGlobalConfig()->threads.async_priority
             ));
 
             os::SetThreadNamePointer(&g_thread_pool[i], "mc::AsyncWorker");
@@ -66,6 +78,7 @@ namespace ams::async {
 
     void Finalize() {
         os::FinalizeMessageQueue(&g_work_queue);
+        os::FinalizeSemaphore(&g_work_pool_semaphore);
 
         for (unsigned int i = 0; i < ThreadCount; ++i) {
             os::DestroyThread(&g_thread_pool[i]);
@@ -73,8 +86,14 @@ namespace ams::async {
 
     }
 
-    void QueueWork(AsyncFunction *function) {
-        os::SendMessageQueue(&g_work_queue, reinterpret_cast<uintptr_t>(function));
+    void QueueWork(AsyncFunction &&function) {
+        // Wait for a free slot in the work pool
+        os::AcquireSemaphore(&g_work_pool_semaphore);
+
+        auto work_func = g_work_pool.Allocate(std::move(function));
+        AMS_ABORT_UNLESS(work_func != nullptr);
+
+        os::SendMessageQueue(&g_work_queue, reinterpret_cast<uintptr_t>(work_func));
     }
 
 }
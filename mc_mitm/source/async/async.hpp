@@ -24,8 +24,8 @@ namespace ams::async {
     Result Initialize();
     void Finalize();
 
-    void QueueWork(AsyncFunction *function);
+    void QueueWork(AsyncFunction &&function);
 
-    #define MC_RUN_ASYNC(code) async::QueueWork(new async::AsyncFunction ([&]() -> ams::Result { code }));
+    #define MC_RUN_ASYNC(code) async::QueueWork([&]() -> ams::Result { code });
 
 }
@@ -19,7 +19,7 @@
 namespace ams {
 
     template <class T1, class T2, class T3>
-    class FutureResponse {
+    class FutureResponse : public util::IntrusiveListBaseNode<FutureResponse<T1, T2, T3>> {
         public:
             FutureResponse(T1 type) : m_type(type) {
                 os::InitializeEvent(&m_ready_event, false, os::EventClearMode_AutoClear);
@@ -14,13 +14,17 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "bluetooth_ble.hpp"
+#include "bluetooth_event_queue.hpp"
 #include "../btdrv_mitm_flags.hpp"
 
 namespace ams::bluetooth::ble {
 
     namespace {
 
-        constinit os::SdkMutex g_event_data_lock;
+        constexpr size_t EventQueueCapacity = 4;
+
+        EventQueue<bluetooth::BleEventType, bluetooth::BleEventInfo, EventQueueCapacity> g_event_queue;
+
         constinit bluetooth::BleEventInfo g_event_info;
         constinit bluetooth::BleEventType g_current_event_type;
 
@@ -29,7 +33,10 @@ namespace ams::bluetooth::ble {
         os::SystemEvent g_system_event_user_fwd(os::EventClearMode_AutoClear, true);
 
         os::Event g_init_event(os::EventClearMode_ManualClear);
-        os::Event g_data_read_event(os::EventClearMode_AutoClear);
+
+        EventConsumer GetEventConsumer(ncm::ProgramId program_id) {
+            return ncm::IsSystemProgramId(program_id) ? EventConsumer_System : EventConsumer_User;
+        }
 
     }
 
@@ -57,29 +64,44 @@ namespace ams::bluetooth::ble {
         return &g_system_event_user_fwd;
     }
 
-    Result GetEventInfo(bluetooth::BleEventType *type, void *buffer, size_t size) {
-        std::scoped_lock lk(g_event_data_lock);
+    Result GetEventInfo(ncm::ProgramId program_id, bluetooth::BleEventType *type, void *buffer, size_t size) {
+        const auto consumer = GetEventConsumer(program_id);
 
-        *type = g_current_event_type;
-        std::memcpy(buffer, &g_event_info, size);
+        // Never replay an event the consumer has already handled
+        bool pending;
+        R_UNLESS(g_event_queue.Pop(consumer, type, buffer, size, &pending), svc::ResultNotFound());
+
+        // Forward events are auto-clear, so signal again if the consumer still has events waiting
+        if (pending) {
+            consumer == EventConsumer_System ? g_system_event_fwd.Signal() : g_system_event_user_fwd.Signal();
+        }
 
-        g_data_read_event.Signal();
-        
         R_SUCCEED();
     }
 
+    void AttachEventConsumer(ncm::ProgramId program_id) {
+        g_event_queue.Attach(GetEventConsumer(program_id));
+    }
+
+    void GetEventQueueStatistics(EventConsumer consumer, EventQueueStatistics *out_stats) {
+        g_event_queue.GetStatistics(consumer, out_stats);
+    }
+
     void HandleEvent() {
-        {
-            std::scoped_lock lk(g_event_data_lock);
-            R_ABORT_UNLESS(btdrvGetBleManagedEventInfo(&g_event_info, sizeof(bluetooth::BleEventInfo), &g_current_event_type));
-        }
+        R_ABORT_UNLESS(btdrvGetBleManagedEventInfo(&g_event_info, sizeof(bluetooth::BleEventInfo), &g_current_event_type));
 
+        u32 consumers = BIT(EventConsumer_User);
         if (!g_redirect_ble_events) {
+            consumers |= BIT(EventConsumer_System);
+        }
+
+        consumers = g_event_queue.Push(g_current_event_type, &g_event_info, sizeof(g_event_info), consumers);
+
+        if (consumers & BIT(EventConsumer_System)) {
             g_system_event_fwd.Signal();
-            g_data_read_event.Wait();
         }
 
-        if (g_system_event_user_fwd.GetBase()->state) {
+        if (consumers & BIT(EventConsumer_User)) {
             g_system_event_user_fwd.Signal();
         }
     }
@@ -17,6 +17,7 @@
 #include <switch.h>
 #include <stratosphere.hpp>
 #include "bluetooth_types.hpp"
+#include "bluetooth_event_queue.hpp"
 
 namespace ams::bluetooth::ble {
 
@@ -28,7 +29,9 @@ namespace ams::bluetooth::ble {
     os::SystemEvent *GetForwardEvent();
     os::SystemEvent *GetUserForwardEvent();
 
-    Result GetEventInfo(bluetooth::BleEventType *type, void *buffer, size_t size);
+    Result GetEventInfo(ncm::ProgramId program_id, bluetooth::BleEventType *type, void *buffer, size_t size);
+    void AttachEventConsumer(ncm::ProgramId program_id);
+    void GetEventQueueStatistics(EventConsumer consumer, EventQueueStatistics *out_stats);
     void HandleEvent();
 
 }
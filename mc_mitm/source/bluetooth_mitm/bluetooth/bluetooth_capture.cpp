@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bluetooth_capture.hpp"
+#include "../../mcmitm_config.hpp"
+
+namespace ams::bluetooth::capture {
+
+    namespace {
+
+        constexpr const char CaptureDirectoryLocation[] = "sdmc:/config/MissionControl";
+        constexpr const char CaptureFileLocation[] = "sdmc:/config/MissionControl/capture.btsnoop";
+
+        // Reports are staged in one buffer while the other is written out
+        constexpr size_t StagingBufferSize = 0x4000;
+        constexpr TimeSpan FlushInterval = TimeSpan::FromMilliSeconds(20);
+
+        constexpr size_t ThreadStackSize = 0x1000;
+        alignas(os::ThreadStackAlignment) constinit u8 g_thread_stack[ThreadStackSize];
+        constinit os::ThreadType g_thread;
+
+        // btsnoop stores timestamps in microseconds since 0000-01-01. Ticks are counted from boot, so captures start at the Unix epoch
+        constexpr u64 BtsnoopEpochOffset = 0x00dcddb30f2f8000;
+        constexpr u32 BtsnoopVersion = 1;
+        constexpr u32 BtsnoopDatalinkH4 = 1002;
+
+        constexpr u32 BtsnoopFlag_Received = BIT(0);
+        constexpr u32 BtsnoopFlag_Event    = BIT(1);
+
+        constexpr u8 H4PacketType_AclData = 0x02;
+        constexpr u8 H4PacketType_Event   = 0x04;
+
+        constexpr u8 HciEvent_ConnectionComplete = 0x03;
+
+        constexpr u16 AclFlag_FirstFlushable = 0x2000;
+
+        constexpr u16 L2capSignallingCid = 0x0001;
+        constexpr u8 L2capCommand_ConnectionRequest  = 0x02;
+        constexpr u8 L2capCommand_ConnectionResponse = 0x03;
+        constexpr u16 HidInterruptPsm = 0x0013;
+
+        // Each controller is given a fake HID interrupt channel so that Wireshark can decode the reports
+        constexpr u16 HostCid   = 0x0040;
+        constexpr u16 DeviceCid = 0x0041;
+
+        constexpr u8 HidpHeader_InputData  = 0xa1;
+        constexpr u8 HidpHeader_OutputData = 0xa2;
+
+        // Raw device reports and the reports the console actually sees are placed on separate fake connections
+        constexpr u16 EmulatedHandleFlag = 0x80;
+        constexpr size_t MaxConnections = 16;
+
+        // All fields are big endian
+        struct BtsnoopFileHeader {
+            char magic[8];
+            u32 version;
+            u32 datalink;
+        };
+        static_assert(sizeof(BtsnoopFileHeader) == 0x10);
+
+        struct BtsnoopRecordHeader {
+            u32 original_length;
+            u32 included_length;
+            u32 flags;
+            u32 cumulative_drops;
+            u64 timestamp;
+        };
+        static_assert(sizeof(BtsnoopRecordHeader) == 0x18);
+
+        struct StagingBuffer {
+            std::atomic<u32> size;
+            std::atomic<u32> writers;
+            alignas(0x40) u8 data[StagingBufferSize];
+        };
+
+        constinit StagingBuffer g_staging_buffers[2] = {};
+        constinit std::atomic<u32> g_active_buffer = 0;
+
+        constinit std::atomic<bool> g_capture_active = false;
+        constinit std::atomic<u32> g_record_count = 0;
+        constinit std::atomic<u32> g_dropped_count = 0;
+        constinit std::atomic<u64> g_file_size = 0;
+
+        // Slots are claimed with a compare and swap on the packed address, so producers never need a lock to find their connection
+        constinit std::atomic<u64> g_connections[MaxConnections] = {};
+
+        constinit fs::FileHandle g_file = {};
+        constinit s64 g_max_file_size = 0;
+
+        u64 PackAddress(const bluetooth::Address &address) {
+            u64 packed = 0;
+            std::memcpy(&packed, &address, sizeof(address));
+            return packed | (u64(1) << 63);
+        }
+
+        void StoreLe16(u8 *out, u16 value) {
+            out[0] = value & 0xff;
+            out[1] = value >> 8;
+        }
+
+        StagingBuffer *AcquireStagingBuffer() {
+            const u32 index = g_active_buffer.load();
+            auto buffer = &g_staging_buffers[index];
+
+            // The writer waits for writers to drain after swapping buffers. If the swap happened first, this buffer is about to be flushed
+            buffer->writers.fetch_add(1);
+            if (g_active_buffer.load() != index) {
+                buffer->writers.fetch_sub(1);
+                return nullptr;
+            }
+
+            return buffer;
+        }
+
+        // Reserves space for a record in the active staging buffer and fills in its header. Returns nullptr if the record is dropped
+        u8 *BeginRecord(StagingBuffer **out_buffer, size_t packet_size, u32 flags, os::Tick timestamp) {
+            if (!g_capture_active.load(std::memory_order_relaxed)) {
+                return nullptr;
+            }
+
+            auto buffer = AcquireStagingBuffer();
+            if (buffer == nullptr) {
+                buffer = AcquireStagingBuffer();
+            }
+
+            if (buffer != nullptr) {
+                const size_t record_size = sizeof(BtsnoopRecordHeader) + packet_size;
+
+                u32 offset = buffer->size.load(std::memory_order_relaxed);
+                do {
+                    if (offset + record_size > StagingBufferSize) {
+                        buffer->writers.fetch_sub(1);
+                        buffer = nullptr;
+                        break;
+                    }
+                } while (!buffer->size.compare_exchange_weak(offset, offset + record_size));
+
+                if (buffer != nullptr) {
+                    const BtsnoopRecordHeader header = {
+                        .original_length = util::ConvertToBigEndian(static_cast<u32>(packet_size)),
+                        .included_length = util::ConvertToBigEndian(static_cast<u32>(packet_size)),
+                        .flags = util::ConvertToBigEndian(flags),
+                        .cumulative_drops = util::ConvertToBigEndian(g_dropped_count.load(std::memory_order_relaxed)),
+                        .timestamp = util::ConvertToBigEndian(BtsnoopEpochOffset + static_cast<u64>(os::ConvertToTimeSpan(timestamp).GetMicroSeconds())),
+                    };
+
+                    u8 *record = &buffer->data[offset];
+                    std::memcpy(record, &header, sizeof(header));
+
+                    *out_buffer = buffer;
+                    return record + sizeof(header);
+                }
+            }
+
+            g_dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        void EndRecord(StagingBuffer *buffer) {
+            g_record_count.fetch_add(1, std::memory_order_relaxed);
+            buffer->writers.fetch_sub(1);
+        }
+
+        void WriteConnectionComplete(const bluetooth::Address &address, u16 handle, os::Tick timestamp) {
+            constexpr size_t PacketSize = 1 + 2 + 11;
+
+            StagingBuffer *buffer;
+            u8 *packet = BeginRecord(&buffer, PacketSize, BtsnoopFlag_Received | BtsnoopFlag_Event, timestamp);
+            if (packet == nullptr) {
+                return;
+            }
+
+            packet[0] = H4PacketType_Event;
+            packet[1] = HciEvent_ConnectionComplete;
+            packet[2] = 11;
+            packet[3] = 0;  // Success
+            StoreLe16(&packet[4], handle);
+
+            // HCI sends addresses least significant byte first
+            for (size_t i = 0; i < sizeof(address); ++i) {
+                packet[6 + i] = address.address[sizeof(address) - 1 - i];
+            }
+
+            packet[12] = 0x01;  // ACL
+            packet[13] = 0x00;  // Unencrypted
+
+            EndRecord(buffer);
+        }
+
+        void WriteL2capSignal(u16 handle, u8 code, const u8 *data, u16 size, u32 flags, os::Tick timestamp) {
+            const size_t packet_size = 1 + 4 + 4 + 4 + size;
+
+            StagingBuffer *buffer;
+            u8 *packet = BeginRecord(&buffer, packet_size, flags, timestamp);
+            if (packet == nullptr) {
+                return;
+            }
+
+            packet[0] = H4PacketType_AclData;
+            StoreLe16(&packet[1], handle | AclFlag_FirstFlushable);
+            StoreLe16(&packet[3], 4 + 4 + size);
+            StoreLe16(&packet[5], 4 + size);
+            StoreLe16(&packet[7], L2capSignallingCid);
+            packet[9] = code;
+            packet[10] = 1;     // Identifier
+            StoreLe16(&packet[11], size);
+            std::memcpy(&packet[13], data, size);
+
+            EndRecord(buffer);
+        }
+
+        // Announces a fake connection and HID interrupt channel for the controller, so that the reports that follow can be decoded
+        void WriteConnectionSetup(const bluetooth::Address &address, u16 handle, os::Tick timestamp) {
+            WriteConnectionComplete(address, handle, timestamp);
+
+            u8 request[4];
+            StoreLe16(&request[0], HidInterruptPsm);
+            StoreLe16(&request[2], HostCid);
+            WriteL2capSignal(handle, L2capCommand_ConnectionRequest, request, sizeof(request), 0, timestamp);
+
+            u8 response[8];
+            StoreLe16(&response[0], DeviceCid);
+            StoreLe16(&response[2], HostCid);
+            StoreLe16(&response[4], 0);     // Success
+            StoreLe16(&response[6], 0);
+            WriteL2capSignal(handle, L2capCommand_ConnectionResponse, response, sizeof(response), BtsnoopFlag_Received, timestamp);
+        }
+
+        // Returns 0 if every connection slot is taken
+        u16 GetConnectionHandle(const bluetooth::Address &address, os::Tick timestamp) {
+            const u64 packed = PackAddress(address);
+
+            for (size_t i = 0; i < MaxConnections; ++i) {
+                u64 expected = g_connections[i].load(std::memory_order_relaxed);
+                if (expected == packed) {
+                    return static_cast<u16>(i + 1);
+                }
+
+                if ((expected == 0) && g_connections[i].compare_exchange_strong(expected, packed)) {
+                    WriteConnectionSetup(address, static_cast<u16>(i + 1), timestamp);
+                    WriteConnectionSetup(address, static_cast<u16>(i + 1) | EmulatedHandleFlag, timestamp);
+                    return static_cast<u16>(i + 1);
+                }
+
+                // Lost the race for this slot. Another producer may have claimed it for the same controller
+                if (expected == packed) {
+                    return static_cast<u16>(i + 1);
+                }
+            }
+
+            return 0;
+        }
+
+        Result WriteFileHeader() {
+            R_TRY(fs::EnsureDirectory(CaptureDirectoryLocation));
+
+            fs::DeleteFile(CaptureFileLocation);
+            R_TRY(fs::CreateFile(CaptureFileLocation, 0));
+            R_TRY(fs::OpenFile(std::addressof(g_file), CaptureFileLocation, fs::OpenMode_Write | fs::OpenMode_AllowAppend));
+
+            const BtsnoopFileHeader header = {
+                .magic = {'b', 't', 's', 'n', 'o', 'o', 'p', '\0'},
+                .version = util::ConvertToBigEndian(BtsnoopVersion),
+                .datalink = util::ConvertToBigEndian(BtsnoopDatalinkH4),
+            };
+
+            R_TRY(fs::WriteFile(g_file, 0, &header, sizeof(header), fs::WriteOption::Flush));
+            g_file_size = sizeof(header);
+
+            R_SUCCEED();
+        }
+
+        void Flush() {
+            const u32 index = g_active_buffer.load();
+            auto &buffer = g_staging_buffers[index];
+            if (buffer.size.load() == 0) {
+                return;
+            }
+
+            g_active_buffer.store(index ^ 1);
+
+            // Let producers that picked this buffer before the swap finish their records
+            while (buffer.writers.load() != 0) {
+                os::YieldThread();
+            }
+
+            const u32 size = buffer.size.load();
+            const s64 offset = g_file_size.load();
+
+            if (offset + size > g_max_file_size) {
+                g_capture_active = false;
+            } else if (R_SUCCEEDED(fs::WriteFile(g_file, offset, buffer.data, size, fs::WriteOption::Flush))) {
+                g_file_size = offset + size;
+            } else {
+                g_capture_active = false;
+            }
+
+            buffer.size.store(0);
+        }
+
+        void CaptureThreadFunc(void *) {
+            while (g_capture_active) {
+                os::SleepThread(FlushInterval);
+                Flush();
+            }
+
+            fs::CloseFile(g_file);
+        }
+
+    }
+
+    void Initialize() {
+        auto config = mitm::GetGlobalConfig();
+        if (!config->capture.enable) {
+            return;
+        }
+
+        if (R_FAILED(WriteFileHeader())) {
+            return;
+        }
+
+        g_max_file_size = static_cast<s64>(config->capture.max_file_size) * 1_MB;
+        g_capture_active = true;
+
+        R_ABORT_UNLESS(os::CreateThread(&g_thread,
+            CaptureThreadFunc,
+            nullptr,
+            g_thread_stack,
+            ThreadStackSize,
+            config->threads.capture_priority
+        ));
+
+        os::SetThreadNamePointer(&g_thread, "mc::CaptureThread");
+        os::StartThread(&g_thread);
+    }
+
+    void RecordReport(CaptureSource source, const bluetooth::Address &address, const bluetooth::HidReport *report, os::Tick timestamp) {
+        if (!g_capture_active.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        u16 handle = GetConnectionHandle(address, timestamp);
+        if (handle == 0) {
+            g_dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (source != CaptureSource_DeviceInput) {
+            handle |= EmulatedHandleFlag;
+        }
+
+        const bool is_output = source == CaptureSource_HostOutput;
+        const u16 report_size = std::min<u16>(report->size, sizeof(report->data));
+        const u16 payload_size = 1 + report_size;
+
+        StagingBuffer *buffer;
+        u8 *packet = BeginRecord(&buffer, 1 + 4 + 4 + payload_size, is_output ? 0 : BtsnoopFlag_Received, timestamp);
+        if (packet == nullptr) {
+            return;
+        }
+
+        packet[0] = H4PacketType_AclData;
+        StoreLe16(&packet[1], handle | AclFlag_FirstFlushable);
+        StoreLe16(&packet[3], 4 + payload_size);
+        StoreLe16(&packet[5], payload_size);
+        StoreLe16(&packet[7], is_output ? DeviceCid : HostCid);
+        packet[9] = is_output ? HidpHeader_OutputData : HidpHeader_InputData;
+        std::memcpy(&packet[10], report->data, report_size);
+
+        EndRecord(buffer);
+    }
+
+    void GetStatistics(CaptureStatistics *out_stats) {
+        out_stats->active = g_capture_active;
+        out_stats->record_count = g_record_count;
+        out_stats->dropped_count = g_dropped_count;
+        out_stats->file_size = g_file_size;
+    }
+
+}
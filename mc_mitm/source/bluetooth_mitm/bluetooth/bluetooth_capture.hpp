@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "bluetooth_types.hpp"
+
+namespace ams::bluetooth::capture {
+
+    enum CaptureSource {
+        CaptureSource_DeviceInput,      // Input report read from the real btdrv report buffer
+        CaptureSource_HostOutput,       // Output report sent by the hid sysmodule
+        CaptureSource_EmulatedInput,    // Input report written to the fake report buffer
+    };
+
+    struct CaptureStatistics {
+        bool active;
+        u32 record_count;
+        u32 dropped_count;
+        u64 file_size;
+    };
+
+    void Initialize();
+
+    // Never blocks. Reports are dropped, and counted, if the staging buffer is full
+    void RecordReport(CaptureSource source, const bluetooth::Address &address, const bluetooth::HidReport *report, os::Tick timestamp);
+
+    void GetStatistics(CaptureStatistics *out_stats);
+
+}
@@ -14,6 +14,9 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "bluetooth_core.hpp"
+#include "bluetooth_event_queue.hpp"
+#include "bluetooth_hci.hpp"
+#include "bluetooth_inquiry.hpp"
 #include "../btdrv_ext.h"
 #include "../btdrv_mitm_flags.hpp"
 #include "../../controllers/controller_management.hpp"
@@ -23,7 +26,10 @@ namespace ams::bluetooth::core {
 
     namespace {
 
-        constinit os::SdkMutex g_event_info_lock;
+        constexpr size_t EventQueueCapacity = 8;
+
+        EventQueue<bluetooth::EventType, bluetooth::EventInfo, EventQueueCapacity> g_event_queue;
+
         constinit bluetooth::EventInfo g_event_info;
         constinit bluetooth::EventType g_current_event_type;
 
@@ -33,8 +39,10 @@ namespace ams::bluetooth::core {
 
         os::Event g_init_event(os::EventClearMode_ManualClear);
         os::Event g_enable_event(os::EventClearMode_ManualClear);
-        os::Event g_custom_data_event(os::EventClearMode_AutoClear);
-        os::Event g_data_read_event(os::EventClearMode_AutoClear);
+
+        EventConsumer GetEventConsumer(ncm::ProgramId program_id) {
+            return ncm::IsSystemProgramId(program_id) ? EventConsumer_System : EventConsumer_User;
+        }
 
     }
 
@@ -58,10 +66,6 @@ namespace ams::bluetooth::core {
         g_enable_event.Wait();
     }
 
-    os::Event *GetCustomDataEvent() {
-        return &g_custom_data_event;
-    }
-
     os::SystemEvent *GetSystemEvent() {
         return &g_system_event;
     }
@@ -75,16 +79,16 @@ namespace ams::bluetooth::core {
     }
 
     void SignalFakeEvent(bluetooth::EventType type, const void *data, size_t size) {
-        g_current_event_type = type;
-        std::memcpy(&g_event_info, data, size);
-
-        g_system_event_fwd.Signal();
+        // Fake events come from threads that must not stall behind a slow system reader, so they're dropped if it's fallen too far behind
+        if (g_event_queue.TryPush(type, data, size, BIT(EventConsumer_System))) {
+            g_system_event_fwd.Signal();
+        }
     }
 
     inline void ModifyEventInfov1(bluetooth::EventInfo *event_info, BtdrvEventType event_type) {
         switch (event_type) {
             case BtdrvEventTypeOld_InquiryDevice:
-                if (controller::IsAllowedDeviceClass(&event_info->inquiry_device.v1.class_of_device) && !controller::IsOfficialSwitchControllerName(event_info->inquiry_device.v1.name)) {
+                if (inquiry::ShouldRenameInquiryResult(event_info->inquiry_device.v1.addr, &event_info->inquiry_device.v1.class_of_device, event_info->inquiry_device.v1.name)) {
                     std::strncpy(event_info->inquiry_device.v1.name, controller::ProControllerName, sizeof(event_info->inquiry_device.v1.name) - 1);
                 }
                 break;
@@ -92,11 +96,15 @@ namespace ams::bluetooth::core {
                 if (!controller::IsOfficialSwitchControllerName(event_info->pairing_pin_code_request.name)) {
                     std::strncpy(event_info->pairing_pin_code_request.name, controller::ProControllerName, sizeof(event_info->pairing_pin_code_request.name) - 1);
                 }
+                // The device is stored under the name the system sees here, which is now always an official one
+                controller::SetNameClassification(event_info->pairing_pin_code_request.addr, true);
                 break;
             case BtdrvEventTypeOld_SspRequest:
                 if (!controller::IsOfficialSwitchControllerName(event_info->ssp_request.v1.name)) {
                     std::strncpy(event_info->ssp_request.v1.name, controller::ProControllerName, sizeof(event_info->ssp_request.v1.name) - 1);
                 }
+                // The device is stored under the name the system sees here, which is now always an official one
+                controller::SetNameClassification(event_info->ssp_request.v1.addr, true);
                 break;
             default:
                 break;
@@ -106,7 +114,7 @@ namespace ams::bluetooth::core {
     inline void ModifyEventInfov12(bluetooth::EventInfo *event_info, BtdrvEventType event_type) {
         switch (event_type) {
             case BtdrvEventType_InquiryDevice:
-                if (controller::IsAllowedDeviceClass(&event_info->inquiry_device.v12.class_of_device) && !controller::IsOfficialSwitchControllerName(event_info->inquiry_device.v12.name)) {
+                if (inquiry::ShouldRenameInquiryResult(event_info->inquiry_device.v12.addr, &event_info->inquiry_device.v12.class_of_device, event_info->inquiry_device.v12.name)) {
                     std::strncpy(event_info->inquiry_device.v12.name, controller::ProControllerName, sizeof(event_info->inquiry_device.v12.name) - 1);
                 }
                 break;
@@ -114,11 +122,15 @@ namespace ams::bluetooth::core {
                 if (!controller::IsOfficialSwitchControllerName(event_info->pairing_pin_code_request.name)) {
                     std::strncpy(event_info->pairing_pin_code_request.name, controller::ProControllerName, sizeof(event_info->pairing_pin_code_request.name) - 1);
                 }
+                // The device is stored under the name the system sees here, which is now always an official one
+                controller::SetNameClassification(event_info->pairing_pin_code_request.addr, true);
                 break;
             case BtdrvEventType_SspRequest:
                 if (!controller::IsOfficialSwitchControllerName(event_info->ssp_request.v12.name)) {
                     std::strncpy(event_info->ssp_request.v12.name, controller::ProControllerName, sizeof(event_info->ssp_request.v12.name) - 1);
                 }
+                // The device is stored under the name the system sees here, which is now always an official one
+                controller::SetNameClassification(event_info->ssp_request.v12.addr, true);
                 break;
             default:
                 break;
@@ -126,26 +138,38 @@ namespace ams::bluetooth::core {
     }
 
     Result GetEventInfo(ncm::ProgramId program_id, bluetooth::EventType *type, void *buffer, size_t size) {
-        std::scoped_lock lk(g_event_info_lock);
+        const auto consumer = GetEventConsumer(program_id);
 
-        *type = g_current_event_type;
-        std::memcpy(buffer, &g_event_info, size);
+        // Never replay an event the consumer has already handled
+        bool pending;
+        R_UNLESS(g_event_queue.Pop(consumer, type, buffer, size, &pending), svc::ResultNotFound());
 
         if (program_id == ncm::SystemProgramId::Btm) {
             auto event_info = reinterpret_cast<bluetooth::EventInfo *>(buffer);
 
             if (hos::GetVersion() < hos::Version_12_0_0) {
-                ModifyEventInfov1(event_info, g_current_event_type);
+                ModifyEventInfov1(event_info, *type);
             } else {
-                ModifyEventInfov12(event_info, g_current_event_type);
+                ModifyEventInfov12(event_info, *type);
             }
         }
 
-        g_data_read_event.Signal();
+        // Forward events are auto-clear, so signal again if the consumer still has events waiting
+        if (pending) {
+            consumer == EventConsumer_System ? g_system_event_fwd.Signal() : g_system_event_user_fwd.Signal();
+        }
 
         R_SUCCEED();
     }
 
+    void AttachEventConsumer(ncm::ProgramId program_id) {
+        g_event_queue.Attach(GetEventConsumer(program_id));
+    }
+
+    void GetEventQueueStatistics(EventConsumer consumer, EventQueueStatistics *out_stats) {
+        g_event_queue.GetStatistics(consumer, out_stats);
+    }
+
     inline void HandlePinCodeRequestEventV1(bluetooth::EventInfo *event_info) {
         // Default pin used by bluetooth service
         bluetooth::PinCode pin = { "0000" };
@@ -187,31 +211,63 @@ namespace ams::bluetooth::core {
         R_ABORT_UNLESS(btdrvRespondToPinRequest(event_info->pairing_pin_code_request.addr, &pin));
     }
 
-    void HandleEvent() {
-        {
-            std::scoped_lock lk(g_event_info_lock);
-            R_ABORT_UNLESS(btdrvGetEventInfo(&g_event_info, sizeof(bluetooth::EventInfo), &g_current_event_type));
+    // Returns false if the event is a repeated inquiry result that the system doesn't need to see again
+    inline bool HandleInquiryEventV1(bluetooth::EventInfo *event_info, BtdrvEventType event_type) {
+        switch (event_type) {
+            case BtdrvEventTypeOld_InquiryDevice:
+                return inquiry::HandleInquiryResult(event_info->inquiry_device.v1.addr, &event_info->inquiry_device.v1.class_of_device, event_info->inquiry_device.v1.name);
+            case BtdrvEventTypeOld_InquiryStatus:
+                inquiry::HandleInquiryStatus(event_info->inquiry_status.status == BtdrvInquiryStatus_Started);
+                return true;
+            default:
+                return true;
+        }
+    }
+
+    inline bool HandleInquiryEventV12(bluetooth::EventInfo *event_info, BtdrvEventType event_type) {
+        switch (event_type) {
+            case BtdrvEventType_InquiryDevice:
+                return inquiry::HandleInquiryResult(event_info->inquiry_device.v12.addr, &event_info->inquiry_device.v12.class_of_device, event_info->inquiry_device.v12.name);
+            case BtdrvEventType_InquiryStatus:
+                inquiry::HandleInquiryStatus(event_info->inquiry_status.status == BtdrvInquiryStatus_Started);
+                return true;
+            default:
+                return true;
         }
+    }
 
-        // Process custom event and return
+    void HandleEvent() {
+        R_ABORT_UNLESS(btdrvGetEventInfo(&g_event_info, sizeof(bluetooth::EventInfo), &g_current_event_type));
+
+        // Hand custom event replies to the request waiting on them and return
         if (g_current_event_type == BtdrvEventType_MissionControlCustomEvent) {
-            g_custom_data_event.Signal();
-            g_data_read_event.Wait();
+            bluetooth::hci::HandleCustomEvent(&g_event_info, sizeof(g_event_info));
             return;
         }
 
+        u32 consumers = BIT(EventConsumer_User);
+
         if (!g_redirect_core_events) {
             if ((hos::GetVersion() < hos::Version_12_0_0) && (g_current_event_type == BtdrvEventTypeOld_PairingPinCodeRequest)) {
                 HandlePinCodeRequestEventV1(&g_event_info);
             } else if ((hos::GetVersion() >= hos::Version_12_0_0) && (g_current_event_type == BtdrvEventType_PairingPinCodeRequest)) {
                 HandlePinCodeRequestEventV12(&g_event_info);
             } else {
-                g_system_event_fwd.Signal();
-                g_data_read_event.Wait();
+                const bool forward = hos::GetVersion() < hos::Version_12_0_0 ? HandleInquiryEventV1(&g_event_info, g_current_event_type) : HandleInquiryEventV12(&g_event_info, g_current_event_type);
+                if (forward) {
+                    consumers |= BIT(EventConsumer_System);
+                }
             }
         }
 
-        if (g_system_event_user_fwd.GetBase()->state) {
+        // Queue the event for its attached consumers. This waits if the system consumer has fallen too far behind
+        consumers = g_event_queue.Push(g_current_event_type, &g_event_info, sizeof(g_event_info), consumers);
+
+        if (consumers & BIT(EventConsumer_System)) {
+            g_system_event_fwd.Signal();
+        }
+
+        if (consumers & BIT(EventConsumer_User)) {
             g_system_event_user_fwd.Signal();
         }
     }
@@ -17,6 +17,7 @@
 #include <switch.h>
 #include <stratosphere.hpp>
 #include "bluetooth_types.hpp"
+#include "bluetooth_event_queue.hpp"
 
 namespace ams::bluetooth::core {
 
@@ -26,13 +27,14 @@ namespace ams::bluetooth::core {
     void SignalEnabled();
     void WaitEnabled();
 
-    os::Event *GetCustomDataEvent();
     os::SystemEvent *GetSystemEvent();
     os::SystemEvent *GetForwardEvent();
     os::SystemEvent *GetUserForwardEvent();
 
     void SignalFakeEvent(bluetooth::EventType type, const void *data, size_t size);
     Result GetEventInfo(ncm::ProgramId program_id, bluetooth::EventType *type, void *buffer, size_t size);
+    void AttachEventConsumer(ncm::ProgramId program_id);
+    void GetEventQueueStatistics(EventConsumer consumer, EventQueueStatistics *out_stats);
     void HandleEvent();
 
 }
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::bluetooth {
+
+    enum EventConsumer {
+        EventConsumer_System,
+        EventConsumer_User,
+        EventConsumer_Count
+    };
+
+    struct EventQueueStatistics {
+        u32 depth;
+        u32 peak_depth;
+        u32 dropped_count;
+        u32 read_count;
+        u64 last_lag_us;
+        u64 peak_lag_us;
+    };
+
+    // Bounded queue of events with an independent read cursor per consumer. Events are only queued for consumers that
+    // have attached. The system consumer must never miss an event from the Bluetooth stack, so Push waits for it to catch
+    // up rather than overwrite an event it hasn't read. Producers that can't wait use TryPush, which drops the new event
+    // instead. Any other consumer that falls more than Capacity events behind has its oldest unread events dropped
+    template <typename Type, typename Info, size_t Capacity, size_t NumConsumers = EventConsumer_Count>
+    class EventQueue {
+        private:
+            static constexpr u32 BlockingConsumerMask = BIT(EventConsumer_System);
+
+            struct Entry {
+                Type type;
+                u32 consumer_mask;
+                os::Tick timestamp;
+                Info info;
+            };
+
+            struct Cursor {
+                u64 read_index;
+                EventQueueStatistics stats;
+            };
+
+        public:
+            constexpr EventQueue() = default;
+
+            // Starts queueing events for a consumer. Events queued before it attached are never delivered to it
+            void Attach(size_t consumer) {
+                std::scoped_lock lk(m_mutex);
+
+                auto &cursor = m_cursors[consumer];
+                cursor.read_index = m_write_index;
+                cursor.stats.depth = 0;
+
+                m_attached_mask |= BIT(consumer);
+            }
+
+            // Returns the mask of consumers the event was actually queued for
+            u32 Push(Type type, const void *data, size_t size, u32 consumer_mask) {
+                std::scoped_lock lk(m_mutex);
+
+                consumer_mask &= m_attached_mask;
+                if (consumer_mask == 0) {
+                    return 0;
+                }
+
+                // Wait for any blocking consumer that still has to read the event in the slot about to be overwritten
+                while (this->IsOldestEntryUnread(m_attached_mask & BlockingConsumerMask)) {
+                    m_cv.Wait(m_mutex);
+                }
+
+                this->WriteEntry(type, data, size, consumer_mask);
+
+                return consumer_mask;
+            }
+
+            // As Push, but never waits. If a blocking consumer still has to read the event in the slot about to be overwritten,
+            // the new event is dropped instead and counted against each consumer it was meant for
+            u32 TryPush(Type type, const void *data, size_t size, u32 consumer_mask) {
+                std::scoped_lock lk(m_mutex);
+
+                consumer_mask &= m_attached_mask;
+                if (consumer_mask == 0) {
+                    return 0;
+                }
+
+                if (this->IsOldestEntryUnread(m_attached_mask & BlockingConsumerMask)) {
+                    for (size_t i = 0; i < NumConsumers; ++i) {
+                        if (consumer_mask & BIT(i)) {
+                            m_cursors[i].stats.dropped_count += 1;
+                        }
+                    }
+
+                    return 0;
+                }
+
+                this->WriteEntry(type, data, size, consumer_mask);
+
+                return consumer_mask;
+            }
+
+            // Returns false if no event is pending for the consumer. out_pending is set if more events remain after this one
+            bool Pop(size_t consumer, Type *out_type, void *out_data, size_t size, bool *out_pending) {
+                std::scoped_lock lk(m_mutex);
+
+                auto &cursor = m_cursors[consumer];
+                this->SkipEntries(consumer);
+
+                if (cursor.read_index == m_write_index) {
+                    *out_pending = false;
+                    return false;
+                }
+
+                const auto &entry = m_entries[cursor.read_index % Capacity];
+                *out_type = entry.type;
+                std::memcpy(out_data, &entry.info, std::min(size, sizeof(Info)));
+
+                const u64 lag = os::ConvertToTimeSpan(os::GetSystemTick() - entry.timestamp).GetMicroSeconds();
+                cursor.stats.last_lag_us = lag;
+                cursor.stats.peak_lag_us = std::max(cursor.stats.peak_lag_us, lag);
+                cursor.stats.read_count += 1;
+
+                cursor.read_index += 1;
+                this->SkipEntries(consumer);
+
+                // Wake the writer if it was waiting on this consumer
+                m_cv.Broadcast();
+
+                cursor.stats.depth = this->GetDepth(consumer);
+                *out_pending = cursor.read_index != m_write_index;
+
+                return true;
+            }
+
+            void GetStatistics(size_t consumer, EventQueueStatistics *out_stats) {
+                std::scoped_lock lk(m_mutex);
+                *out_stats = m_cursors[consumer].stats;
+            }
+
+        private:
+            void WriteEntry(Type type, const void *data, size_t size, u32 consumer_mask) {
+                // Slot about to be overwritten still holds the oldest event. Drop it for any consumer that hasn't read it yet
+                if (m_write_index >= Capacity) {
+                    const u64 oldest_index = m_write_index - Capacity;
+                    const auto &oldest = m_entries[oldest_index % Capacity];
+                    for (size_t i = 0; i < NumConsumers; ++i) {
+                        auto &cursor = m_cursors[i];
+                        if (cursor.read_index <= oldest_index) {
+                            if (oldest.consumer_mask & BIT(i)) {
+                                cursor.stats.dropped_count += 1;
+                            }
+                            cursor.read_index = oldest_index + 1;
+                        }
+                    }
+                }
+
+                auto &entry = m_entries[m_write_index % Capacity];
+                entry.type = type;
+                entry.consumer_mask = consumer_mask;
+                entry.timestamp = os::GetSystemTick();
+                std::memcpy(&entry.info, data, std::min(size, sizeof(Info)));
+
+                m_write_index += 1;
+
+                for (size_t i = 0; i < NumConsumers; ++i) {
+                    if (consumer_mask & BIT(i)) {
+                        auto &stats = m_cursors[i].stats;
+                        stats.depth = this->GetDepth(i);
+                        stats.peak_depth = std::max(stats.peak_depth, stats.depth);
+                    }
+                }
+            }
+
+            bool IsOldestEntryUnread(u32 consumer_mask) const {
+                if (m_write_index < Capacity) {
+                    return false;
+                }
+
+                const u64 oldest_index = m_write_index - Capacity;
+                const auto &oldest = m_entries[oldest_index % Capacity];
+                for (size_t i = 0; i < NumConsumers; ++i) {
+                    if ((consumer_mask & BIT(i)) && (oldest.consumer_mask & BIT(i)) && (m_cursors[i].read_index <= oldest_index)) {
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            void SkipEntries(size_t consumer) {
+                auto &cursor = m_cursors[consumer];
+                while ((cursor.read_index < m_write_index) && !(m_entries[cursor.read_index % Capacity].consumer_mask & BIT(consumer))) {
+                    cursor.read_index += 1;
+                }
+            }
+
+            u32 GetDepth(size_t consumer) const {
+                u32 depth = 0;
+                for (u64 i = m_cursors[consumer].read_index; i < m_write_index; ++i) {
+                    if (m_entries[i % Capacity].consumer_mask & BIT(consumer)) {
+                        depth += 1;
+                    }
+                }
+
+                return depth;
+            }
+
+        private:
+            os::SdkMutex m_mutex;
+            os::SdkConditionVariable m_cv;
+            Entry m_entries[Capacity];
+            Cursor m_cursors[NumConsumers] = {};
+            u64 m_write_index = 0;
+            u32 m_attached_mask = 0;
+    };
+
+}
@@ -18,81 +18,80 @@
 #include "bluetooth_core.hpp"
 #include "bluetooth_hid.hpp"
 #include "bluetooth_ble.hpp"
+#include "../../mcmitm_config.hpp"
 
 namespace ams::bluetooth::events {
 
     namespace {
 
-        constexpr s32 ThreadPriority = 9;
+        // Each event class is forwarded by its own thread, so that a consumer that is slow to read one class of events
+        // never holds up delivery of the others
+        struct EventForwarder {
+            const char *thread_name;
+            bool (*IsSupported)();
+            void (*WaitInitialized)();
+            os::SystemEvent *(*GetSystemEvent)();
+            void (*HandleEvent)();
+        };
+
+        constexpr EventForwarder EventForwarders[] = {
+            { "mc::CoreEventThread", [] { return true; },                                  core::WaitInitialized, core::GetSystemEvent, core::HandleEvent },
+            { "mc::HidEventThread",  [] { return true; },                                  hid::WaitInitialized,  hid::GetSystemEvent,  hid::HandleEvent  },
+            { "mc::BleEventThread",  [] { return hos::GetVersion() >= hos::Version_5_0_0; }, ble::WaitInitialized,  ble::GetSystemEvent,  ble::HandleEvent  },
+        };
+
+        constexpr size_t NumEventForwarders = util::size(EventForwarders);
+
         constexpr size_t ThreadStackSize = 0x2000;
-        alignas(os::ThreadStackAlignment) constinit u8 g_thread_stack[ThreadStackSize];
-        constinit os::ThreadType g_thread;
-
-        constinit os::MultiWaitType g_manager;
-        constinit os::MultiWaitHolderType g_holder_bt_core;
-        constinit os::MultiWaitHolderType g_holder_bt_hid;
-        constinit os::MultiWaitHolderType g_holder_bt_ble;
-
-        void EventHandlerThreadFunc(void *) {
-            os::InitializeMultiWait(&g_manager);
-
-            ams::bluetooth::core::WaitInitialized();
-            os::InitializeMultiWaitHolder(&g_holder_bt_core, core::GetSystemEvent()->GetBase());
-            os::SetMultiWaitHolderUserData(&g_holder_bt_core, BtdrvEventType_BluetoothCore);
-            os::LinkMultiWaitHolder(&g_manager, &g_holder_bt_core);
-
-            ams::bluetooth::hid::WaitInitialized();
-            os::InitializeMultiWaitHolder(&g_holder_bt_hid, hid::GetSystemEvent()->GetBase());
-            os::SetMultiWaitHolderUserData(&g_holder_bt_hid, BtdrvEventType_BluetoothHid);
-            os::LinkMultiWaitHolder(&g_manager, &g_holder_bt_hid);
-
-            if (hos::GetVersion() >= hos::Version_5_0_0) {
-                ams::bluetooth::ble::WaitInitialized();
-                os::InitializeMultiWaitHolder(&g_holder_bt_ble, ble::GetSystemEvent()->GetBase());
-                os::SetMultiWaitHolderUserData(&g_holder_bt_ble, BtdrvEventType_BluetoothBle);
-                os::LinkMultiWaitHolder(&g_manager, &g_holder_bt_ble);
-            }
+        alignas(os::ThreadStackAlignment) constinit u8 g_thread_stacks[NumEventForwarders][ThreadStackSize];
+        constinit os::ThreadType g_threads[NumEventForwarders];
+        constinit bool g_thread_created[NumEventForwarders];
+
+        void EventForwarderThreadFunc(void *arg) {
+            auto forwarder = static_cast<const EventForwarder *>(arg);
+
+            forwarder->WaitInitialized();
 
+            auto system_event = forwarder->GetSystemEvent();
             for (;;) {
-                auto signalled_holder = os::WaitAny(&g_manager);
-                switch (os::GetMultiWaitHolderUserData(signalled_holder)) {
-                    case BtdrvEventType_BluetoothCore:
-                        core::GetSystemEvent()->Clear();
-                        core::HandleEvent();
-                        break;
-                    case BtdrvEventType_BluetoothHid:
-                        hid::GetSystemEvent()->Clear();
-                        hid::HandleEvent();
-                        break;
-                    case BtdrvEventType_BluetoothBle:
-                        ble::GetSystemEvent()->Clear();
-                        ble::HandleEvent();
-                        break;
-                    default:
-                        break;
-                }
+                system_event->Wait();
+                system_event->Clear();
+                forwarder->HandleEvent();
             }
         }
 
     }
 
     Result Initialize() {
-        R_TRY(os::CreateThread(&g_thread,
-            EventHandlerThreadFunc,
-            nullptr,
-            g_thread_stack,
-            ThreadStackSize,
-            ThreadPriority
-        ));
+        for (size_t i = 0; i < NumEventForwarders; ++i) {
+            const auto &forwarder = EventForwarders[i];
+            if (!forwarder.IsSupported()) {
+                continue;
+            }
+
+            R_TRY(os::CreateThread(&g_threads[i],
+                EventForwarderThreadFunc,
+                const_cast<EventForwarder *>(&forwarder),
+                g_thread_stacks[i],
+                ThreadStackSize,
+                mitm::GetGlobalConfig()->threads.event_priority
+            ));
 
-        os::SetThreadNamePointer(&g_thread, "mc::EventThread");
-        os::StartThread(&g_thread);
+            os::SetThreadNamePointer(&g_threads[i], forwarder.thread_name);
+            os::StartThread(&g_threads[i]);
+            g_thread_created[i] = true;
+        }
 
         R_SUCCEED();
     }
 
     void Finalize() {
-        os::DestroyThread(&g_thread);
+        for (size_t i = 0; i < NumEventForwarders; ++i) {
+            if (g_thread_created[i]) {
+                os::DestroyThread(&g_threads[i]);
+                g_thread_created[i] = false;
+            }
+        }
     }
 
 }
@@ -18,12 +18,6 @@
 
 namespace ams::bluetooth::events {
 
-    enum BtdrvEventType {
-        BtdrvEventType_BluetoothCore,
-        BtdrvEventType_BluetoothHid,
-        BtdrvEventType_BluetoothBle,
-    };
-
     Result Initialize();
     void Finalize();
 
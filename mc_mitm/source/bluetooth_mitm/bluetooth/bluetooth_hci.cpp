@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bluetooth_hci.hpp"
+#include "../btdrv_ext.h"
+#include "../../utils.hpp"
+
+namespace ams::bluetooth::hci {
+
+    namespace {
+
+        constexpr size_t MaxPendingRequests = 16;
+
+        // A reply may still arrive for a request that timed out. Its slot is kept for a while so that the late reply isn't
+        // mistaken for that of the next request with the same opcode
+        constexpr TimeSpan StaleReplyTimeout = TimeSpan::FromSeconds(3);
+
+        enum RequestState {
+            RequestState_Free,
+            RequestState_Pending,
+            RequestState_Completed,
+            RequestState_Abandoned,
+        };
+
+        struct PendingRequest {
+            RequestState state;
+            u32 type;
+            u16 opcode;
+            bluetooth::Address address;
+            os::Tick stale_deadline;
+            BtdrvExtCustomEventInfo reply;
+        };
+
+        constinit os::SdkMutex g_hci_lock;
+        constinit os::SdkConditionVariable g_hci_cv;
+        constinit PendingRequest g_requests[MaxPendingRequests] = {};
+
+        constinit os::SdkMutex g_config_lock;
+        constinit u8 g_first_disabled_channel = 0xff;
+        constinit u8 g_last_disabled_channel = 0xff;
+
+        bool IsMatchingRequest(const PendingRequest &request, u32 type, u16 opcode, const bluetooth::Address &address) {
+            if (request.type != type) {
+                return false;
+            }
+
+            return type == BtdrvExtCustomEventType_GetHciHandle ? utils::BluetoothAddressCompare(request.address, address) : (request.opcode == opcode);
+        }
+
+        PendingRequest *FindAwaitingRequest(u32 type, u16 opcode, const bluetooth::Address &address) {
+            const auto now = os::GetSystemTick();
+            for (auto &request : g_requests) {
+                if ((request.state == RequestState_Abandoned) && (now >= request.stale_deadline)) {
+                    request.state = RequestState_Free;
+                }
+
+                if (((request.state == RequestState_Pending) || (request.state == RequestState_Abandoned)) && IsMatchingRequest(request, type, opcode, address)) {
+                    return &request;
+                }
+            }
+
+            return nullptr;
+        }
+
+        // Waits until no other request with the same key is awaiting a reply and a slot is free, then claims it
+        Result AllocateRequest(u32 type, u16 opcode, const bluetooth::Address &address, os::Tick deadline, PendingRequest **out_request) {
+            while (true) {
+                if (FindAwaitingRequest(type, opcode, address) == nullptr) {
+                    auto request = std::find_if(std::begin(g_requests), std::end(g_requests), [](const PendingRequest &r) { return r.state == RequestState_Free; });
+                    if (request != std::end(g_requests)) {
+                        request->state = RequestState_Pending;
+                        request->type = type;
+                        request->opcode = opcode;
+                        request->address = address;
+                        *out_request = request;
+                        R_SUCCEED();
+                    }
+                }
+
+                const auto now = os::GetSystemTick();
+                R_UNLESS(now < deadline, svc::ResultTimedOut());
+                g_hci_cv.TimedWait(g_hci_lock, os::ConvertToTimeSpan(deadline - now));
+            }
+        }
+
+        void FreeRequest(PendingRequest *request) {
+            request->state = RequestState_Free;
+            g_hci_cv.Broadcast();
+        }
+
+        Result WaitRequest(PendingRequest *request, os::Tick deadline) {
+            while (request->state != RequestState_Completed) {
+                const auto now = os::GetSystemTick();
+                if (now >= deadline) {
+                    request->state = RequestState_Abandoned;
+                    request->stale_deadline = now + os::ConvertToTick(StaleReplyTimeout);
+                    R_RETURN(svc::ResultTimedOut());
+                }
+
+                g_hci_cv.TimedWait(g_hci_lock, os::ConvertToTimeSpan(deadline - now));
+            }
+
+            R_SUCCEED();
+        }
+
+        // The lock is dropped while the request is issued so that the event thread isn't held up behind the IPC call
+        template <typename F>
+        Result IssueRequest(PendingRequest *request, F issue) {
+            g_hci_lock.Unlock();
+            const Result result = issue();
+            g_hci_lock.Lock();
+
+            if (R_FAILED(result)) {
+                FreeRequest(request);
+            }
+
+            R_RETURN(result);
+        }
+
+        Result CompleteCommand(CommandRequest *command, PendingRequest *request, os::Tick deadline) {
+            R_TRY(WaitRequest(request, deadline));
+
+            const auto &response = request->reply.hci_command_response;
+            command->out_data_size = std::min<size_t>(response.size, command->out_size);
+            if (command->out_data != nullptr) {
+                std::memcpy(command->out_data, response.data, command->out_data_size);
+            }
+
+            const u16 status = response.status;
+            FreeRequest(request);
+
+            R_RETURN(status);
+        }
+
+    }
+
+    Result GetHandle(const bluetooth::Address &address, u16 *out_handle, TimeSpan timeout) {
+        const auto deadline = os::GetSystemTick() + os::ConvertToTick(timeout);
+
+        std::scoped_lock lk(g_hci_lock);
+
+        PendingRequest *request;
+        R_TRY(AllocateRequest(BtdrvExtCustomEventType_GetHciHandle, 0, address, deadline, &request));
+        R_TRY(IssueRequest(request, [&] { return btdrvextGetHciHandle(address); }));
+        R_TRY(WaitRequest(request, deadline));
+
+        const u16 status = request->reply.get_hci_handle.status;
+        if (status == 0) {
+            *out_handle = request->reply.get_hci_handle.handle;
+        }
+
+        FreeRequest(request);
+
+        R_RETURN(status);
+    }
+
+    Result SendCommand(u16 opcode, const void *data, size_t size, void *out_data, size_t out_size, TimeSpan timeout) {
+        CommandRequest command = {
+            .opcode = opcode,
+            .data = data,
+            .size = size,
+            .out_data = out_data,
+            .out_size = out_size,
+            .timeout = timeout
+        };
+
+        SendCommandBatch(&command, 1);
+
+        R_RETURN(command.result);
+    }
+
+    void SendCommandBatch(CommandRequest *commands, size_t count) {
+        AMS_ABORT_UNLESS(count <= MaxBatchCommands);
+
+        const auto start = os::GetSystemTick();
+
+        std::scoped_lock lk(g_hci_lock);
+
+        // Everything is submitted before waiting on any reply, so commands with different opcodes are in flight together.
+        // A command sharing its opcode with one still in flight is held back until that reply has arrived
+        PendingRequest *requests[MaxBatchCommands] = {};
+        for (size_t i = 0; i < count; ++i) {
+            auto &command = commands[i];
+            command.out_data_size = 0;
+
+            command.result = AllocateRequest(BtdrvExtCustomEventType_SendHciCommand, command.opcode, {}, start + os::ConvertToTick(command.timeout), &requests[i]);
+            if (R_SUCCEEDED(command.result)) {
+                command.result = IssueRequest(requests[i], [&] { return btdrvextSendHciCommand(command.opcode, command.data, command.size); });
+            }
+
+            if (R_FAILED(command.result)) {
+                requests[i] = nullptr;
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            if (requests[i] != nullptr) {
+                commands[i].result = CompleteCommand(&commands[i], requests[i], start + os::ConvertToTick(commands[i].timeout));
+            }
+        }
+    }
+
+    Result DmSetConfig(const tBSA_DM_SET_CONFIG *config) {
+        std::scoped_lock lk(g_config_lock);
+
+        R_TRY(btdrvextDmSetConfig(config));
+
+        if (config->config_mask & BSA_DM_CONFIG_CHANNEL_MASK) {
+            g_first_disabled_channel = config->first_disabled_channel;
+            g_last_disabled_channel = config->last_disabled_channel;
+        }
+
+        R_SUCCEED();
+    }
+
+    void GetDisabledChannels(u8 *out_first, u8 *out_last) {
+        std::scoped_lock lk(g_config_lock);
+        *out_first = g_first_disabled_channel;
+        *out_last = g_last_disabled_channel;
+    }
+
+    void HandleCustomEvent(const void *data, size_t size) {
+        auto info = reinterpret_cast<const BtdrvExtCustomEventInfo *>(data);
+        AMS_ABORT_UNLESS(size >= sizeof(*info));
+
+        std::scoped_lock lk(g_hci_lock);
+
+        PendingRequest *request = nullptr;
+        switch (info->type) {
+            case BtdrvExtCustomEventType_GetHciHandle:
+                request = FindAwaitingRequest(info->type, 0, info->get_hci_handle.address);
+                break;
+            case BtdrvExtCustomEventType_SendHciCommand:
+                request = FindAwaitingRequest(info->type, info->hci_command_response.opcode, {});
+                break;
+            default:
+                break;
+        }
+
+        if (request == nullptr) {
+            return;
+        }
+
+        if (request->state == RequestState_Abandoned) {
+            FreeRequest(request);
+            return;
+        }
+
+        request->reply = *info;
+        request->state = RequestState_Completed;
+        g_hci_cv.Broadcast();
+    }
+
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <stratosphere.hpp>
+#include "bluetooth_types.hpp"
+#include "../bsa_defs.h"
+
+namespace ams::bluetooth::hci {
+
+    // Opcodes are (OGF << 10) | OCF
+    enum HciOpcode : u16 {
+        HciOpcode_SniffMode                   = 0x0803,
+        HciOpcode_ExitSniffMode               = 0x0804,
+        HciOpcode_QosSetup                    = 0x0807,
+        HciOpcode_WriteLinkPolicySettings     = 0x080d,
+        HciOpcode_SetEventFilter              = 0x0c05,
+        HciOpcode_ReadPageScanActivity        = 0x0c1b,
+        HciOpcode_WriteAutomaticFlushTimeout  = 0x0c28,
+        HciOpcode_ReadFailedContactCounter    = 0x1401,
+        HciOpcode_ReadLinkQuality             = 0x1403,
+        HciOpcode_ReadRssi                    = 0x1405,
+        HciOpcode_ReadAfhChannelMap           = 0x1406,
+    };
+
+    enum HciLinkPolicy : u16 {
+        HciLinkPolicy_RoleSwitch = BIT(0),
+        HciLinkPolicy_Hold       = BIT(1),
+        HciLinkPolicy_Sniff      = BIT(2),
+        HciLinkPolicy_Park       = BIT(3),
+    };
+
+    enum HciServiceType : u8 {
+        HciServiceType_NoTraffic   = 0x0,
+        HciServiceType_BestEffort  = 0x1,
+        HciServiceType_Guaranteed  = 0x2,
+    };
+
+    enum HciEventFilterType : u8 {
+        HciEventFilterType_Clear         = 0x0,
+        HciEventFilterType_InquiryResult = 0x1,
+    };
+
+    enum HciInquiryFilterCondition : u8 {
+        HciInquiryFilterCondition_AllDevices    = 0x0,
+        HciInquiryFilterCondition_ClassOfDevice = 0x1,
+    };
+
+    struct HciConnectionHandleParams {
+        u16 handle;
+    } PACKED;
+
+    struct HciQosSetupParams {
+        u16 handle;
+        u8 flags;
+        u8 service_type;
+        u32 token_rate;
+        u32 peak_bandwidth;
+        u32 latency;
+        u32 delay_variation;
+    } PACKED;
+
+    struct HciWriteAutomaticFlushTimeoutParams {
+        u16 handle;
+        u16 timeout;
+    } PACKED;
+
+    struct HciClearEventFilterParams {
+        u8 filter_type;
+    } PACKED;
+
+    // Class of device fields are little endian
+    struct HciInquiryClassFilterParams {
+        u8 filter_type;
+        u8 condition_type;
+        u8 class_of_device[3];
+        u8 class_of_device_mask[3];
+    } PACKED;
+
+    // Replies hold the return parameters of the command complete event, beginning with the status
+    struct HciReadFailedContactCounterReply {
+        u8 status;
+        u16 handle;
+        u16 counter;
+    } PACKED;
+
+    struct HciReadPageScanActivityReply {
+        u8 status;
+        u16 interval;
+        u16 window;
+    } PACKED;
+
+    struct HciReadLinkQualityReply {
+        u8 status;
+        u16 handle;
+        u8 link_quality;
+    } PACKED;
+
+    struct HciReadRssiReply {
+        u8 status;
+        u16 handle;
+        s8 rssi;
+    } PACKED;
+
+    // Channel map has one bit per channel, set if the channel is in use
+    struct HciReadAfhChannelMapReply {
+        u8 status;
+        u16 handle;
+        u8 afh_mode;
+        u8 channel_map[10];
+    } PACKED;
+
+    constexpr TimeSpan DefaultTimeout = TimeSpan::FromSeconds(1);
+    constexpr TimeSpan MaxTimeout = TimeSpan::FromSeconds(5);
+    constexpr size_t MaxBatchCommands = 8;
+
+    struct CommandRequest {
+        u16 opcode;
+        const void *data;
+        size_t size;
+        void *out_data;
+        size_t out_size;
+        TimeSpan timeout;
+        Result result;
+        u16 out_data_size;
+    };
+
+    // Replies are matched to pending requests by opcode (or address for handle lookups), so requests for different opcodes
+    // may be in flight at once while those sharing an opcode are queued behind each other. These block until the reply
+    // arrives, so must not be called from the bluetooth event thread that delivers it
+    Result GetHandle(const bluetooth::Address &address, u16 *out_handle, TimeSpan timeout = DefaultTimeout);
+    Result SendCommand(u16 opcode, const void *data, size_t size, void *out_data = nullptr, size_t out_size = 0, TimeSpan timeout = DefaultTimeout);
+    void SendCommandBatch(CommandRequest *requests, size_t count);
+    Result DmSetConfig(const tBSA_DM_SET_CONFIG *config);
+
+    // The controller can't be asked which channels the host has disabled, so the last range applied through DmSetConfig is
+    // remembered instead. Both channels are 0xff when none have been disabled
+    void GetDisabledChannels(u8 *out_first, u8 *out_last);
+
+    void HandleCustomEvent(const void *data, size_t size);
+
+}
@@ -14,6 +14,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "bluetooth_hid.hpp"
+#include "bluetooth_event_queue.hpp"
 #include "../btdrv_mitm_flags.hpp"
 #include "../../controllers/controller_management.hpp"
 
@@ -21,7 +22,10 @@ namespace ams::bluetooth::hid {
 
     namespace {
 
-        constinit os::SdkMutex g_event_info_lock;
+        constexpr size_t EventQueueCapacity = 8;
+
+        EventQueue<bluetooth::HidEventType, bluetooth::HidEventInfo, EventQueueCapacity> g_event_queue;
+
         constinit bluetooth::HidEventInfo g_event_info;
         constinit bluetooth::HidEventType g_current_event_type;
 
@@ -30,7 +34,10 @@ namespace ams::bluetooth::hid {
         os::SystemEvent g_system_event_user_fwd(os::EventClearMode_AutoClear, true);
 
         os::Event g_init_event(os::EventClearMode_ManualClear);
-        os::Event g_data_read_event(os::EventClearMode_AutoClear);
+
+        EventConsumer GetEventConsumer(ncm::ProgramId program_id) {
+            return ncm::IsSystemProgramId(program_id) ? EventConsumer_System : EventConsumer_User;
+        }
 
     }
 
@@ -59,23 +66,49 @@ namespace ams::bluetooth::hid {
     }
 
     void SignalFakeEvent(bluetooth::HidEventType type, const void *data, size_t size) {
-        g_current_event_type = type;
-        std::memcpy(&g_event_info, data, size);
+        // Fake events come from threads that must not stall behind a slow system reader, so they're dropped if it's fallen too far behind
+        if (g_event_queue.TryPush(type, data, size, BIT(EventConsumer_System))) {
+            g_system_event_fwd.Signal();
+        }
+    }
+
+    // Announces a controller that isn't connected through the Bluetooth stack, such as a wired or virtual one
+    void SignalFakeConnectionState(const bluetooth::Address &address, bool opened) {
+        bluetooth::HidEventInfo event_info = {};
+        if (hos::GetVersion() < hos::Version_12_0_0) {
+            event_info.connection.v1.addr = address;
+            event_info.connection.v1.status = opened ? BtdrvHidConnectionStatusOld_Opened : BtdrvHidConnectionStatusOld_Closed;
+        } else {
+            event_info.connection.v12.addr = address;
+            event_info.connection.v12.status = opened ? BtdrvHidConnectionStatus_Opened : BtdrvHidConnectionStatus_Closed;
+        }
 
-        g_system_event_fwd.Signal();
+        SignalFakeEvent(BtdrvHidEventType_Connection, &event_info, sizeof(event_info));
     }
 
-    Result GetEventInfo(bluetooth::HidEventType *type, void *buffer, size_t size) {
-        std::scoped_lock lk(g_event_info_lock);
+    Result GetEventInfo(ncm::ProgramId program_id, bluetooth::HidEventType *type, void *buffer, size_t size) {
+        const auto consumer = GetEventConsumer(program_id);
 
-        *type = g_current_event_type;
-        std::memcpy(buffer, &g_event_info, size);
+        // Never replay an event the consumer has already handled
+        bool pending;
+        R_UNLESS(g_event_queue.Pop(consumer, type, buffer, size, &pending), svc::ResultNotFound());
 
-        g_data_read_event.Signal();
+        // Forward events are auto-clear, so signal again if the consumer still has events waiting
+        if (pending) {
+            consumer == EventConsumer_System ? g_system_event_fwd.Signal() : g_system_event_user_fwd.Signal();
+        }
 
         R_SUCCEED();
     }
 
+    void AttachEventConsumer(ncm::ProgramId program_id) {
+        g_event_queue.Attach(GetEventConsumer(program_id));
+    }
+
+    void GetEventQueueStatistics(EventConsumer consumer, EventQueueStatistics *out_stats) {
+        g_event_queue.GetStatistics(consumer, out_stats);
+    }
+
     inline void HandleConnectionStateEventV1(bluetooth::HidEventInfo *event_info) {
         switch (event_info->connection.v1.status) {
             case BtdrvHidConnectionStatusOld_Opened:
@@ -103,10 +136,7 @@ namespace ams::bluetooth::hid {
     }
 
     void HandleEvent() {
-        {
-            std::scoped_lock lk(g_event_info_lock);
-            R_ABORT_UNLESS(btdrvGetHidEventInfo(&g_event_info, sizeof(bluetooth::HidEventInfo), &g_current_event_type));
-        }
+        R_ABORT_UNLESS(btdrvGetHidEventInfo(&g_event_info, sizeof(bluetooth::HidEventInfo), &g_current_event_type));
 
         switch (g_current_event_type) {
             case BtdrvHidEventType_Connection:
@@ -116,10 +146,13 @@ namespace ams::bluetooth::hid {
                 break;
         }
 
-        g_system_event_fwd.Signal();
-        g_data_read_event.Wait();
+        const u32 consumers = g_event_queue.Push(g_current_event_type, &g_event_info, sizeof(g_event_info), BIT(EventConsumer_System) | BIT(EventConsumer_User));
+
+        if (consumers & BIT(EventConsumer_System)) {
+            g_system_event_fwd.Signal();
+        }
 
-        if (g_system_event_user_fwd.GetBase()->state) {
+        if (consumers & BIT(EventConsumer_User)) {
             g_system_event_user_fwd.Signal();
         }
     }
@@ -17,6 +17,7 @@
 #include <switch.h>
 #include <stratosphere.hpp>
 #include "bluetooth_types.hpp"
+#include "bluetooth_event_queue.hpp"
 
 namespace ams::bluetooth::hid {
 
@@ -29,7 +30,10 @@ namespace ams::bluetooth::hid {
     os::SystemEvent *GetUserForwardEvent();
 
     void SignalFakeEvent(bluetooth::HidEventType type, const void *data, size_t size);
-    Result GetEventInfo(bluetooth::HidEventType *type, void *buffer, size_t size);
+    void SignalFakeConnectionState(const bluetooth::Address &address, bool opened);
+    Result GetEventInfo(ncm::ProgramId program_id, bluetooth::HidEventType *type, void *buffer, size_t size);
+    void AttachEventConsumer(ncm::ProgramId program_id);
+    void GetEventQueueStatistics(EventConsumer consumer, EventQueueStatistics *out_stats);
     void HandleEvent();
 
 }
@@ -15,9 +15,11 @@
  */
 #include "bluetooth_hid_report.hpp"
 #include "bluetooth_circular_buffer.hpp"
+#include "bluetooth_capture.hpp"
 #include "../btdrv_shim.h"
 #include "../btdrv_mitm_flags.hpp"
 #include "../../controllers/controller_management.hpp"
+#include "../../mcmitm_config.hpp"
 
 namespace ams::bluetooth::hid::report {
 
@@ -25,7 +27,6 @@ namespace ams::bluetooth::hid::report {
 
         constexpr size_t BluetoothSharedMemorySize = 0x3000;
 
-        constexpr s32 ThreadPriority = -11;
         constexpr size_t ThreadStackSize = 0x1000;
         alignas(os::ThreadStackAlignment) constinit u8 g_thread_stack[ThreadStackSize];
         constinit os::ThreadType g_thread;
@@ -49,14 +50,38 @@ namespace ams::bluetooth::hid::report {
         bluetooth::CircularBuffer *g_real_buffer;
         bluetooth::CircularBuffer *g_fake_buffer;
 
+        // Reports can be written from the hid report thread and from wired controller threads, which all share the same staging buffer
+        constinit os::SdkMutex g_fake_report_lock;
         constinit bluetooth::HidReportEventInfo g_fake_report_event_info;
 
+        // Wake latency is measured from when btdrv queued the first pending report to when this thread starts handling it
+        constinit utils::LatencyHistogram g_wake_latency;
+        constinit utils::LatencyHistogram g_run_time;
+
         void EventThreadFunc(void *) {
 
             WaitInitialized();
             for (;;) {
                 g_system_event.Wait();
+
+                const auto start_tick = os::GetSystemTick();
                 HandleEvent();
+                g_run_time.Record(os::ConvertToTimeSpan(os::GetSystemTick() - start_tick));
+            }
+        }
+
+        void RecordWakeLatency(const bluetooth::CircularBufferPacket *packet, bool *recorded) {
+            if (!*recorded) {
+                g_wake_latency.Record(os::ConvertToTimeSpan(os::GetSystemTick() - packet->header.timestamp));
+                *recorded = true;
+            }
+        }
+
+        void CaptureDataReport(const bluetooth::CircularBufferPacket *packet) {
+            if (hos::GetVersion() >= hos::Version_9_0_0) {
+                capture::RecordReport(capture::CaptureSource_DeviceInput, packet->data.data_report.v9.addr, &packet->data.data_report.v9.report, packet->header.timestamp);
+            } else {
+                capture::RecordReport(capture::CaptureSource_DeviceInput, packet->data.data_report.v7.addr, reinterpret_cast<const bluetooth::HidReport *>(&packet->data.data_report.v7.report), packet->header.timestamp);
             }
         }
 
@@ -114,7 +139,7 @@ namespace ams::bluetooth::hid::report {
             nullptr,
             g_thread_stack,
             ThreadStackSize,
-            ThreadPriority
+            mitm::GetGlobalConfig()->threads.hid_report_priority
         ));
 
         os::SetThreadNamePointer(&g_thread, "mc::HidReportThread");
@@ -127,6 +152,11 @@ namespace ams::bluetooth::hid::report {
         os::DestroyThread(&g_thread);
     }
 
+    void GetThreadStatistics(utils::LatencyHistogramData *out_wake_latency, utils::LatencyHistogramData *out_run_time) {
+        g_wake_latency.GetData(out_wake_latency);
+        g_run_time.GetData(out_run_time);
+    }
+
     Result MapRemoteSharedMemory(os::NativeHandle handle) {
         g_real_bt_shmem.Attach(BluetoothSharedMemorySize, handle, true);
         g_real_bt_shmem.Map(os::MemoryPermission_ReadWrite);
@@ -149,6 +179,8 @@ namespace ams::bluetooth::hid::report {
     }
 
     Result WriteHidDataReport(const bluetooth::Address address, const bluetooth::HidReport *report) {
+        std::scoped_lock lk(g_fake_report_lock);
+
         if (hos::GetVersion() >= hos::Version_9_0_0) {
             g_fake_report_event_info.data_report.v9.addr = address;
             std::memcpy(&g_fake_report_event_info.data_report.v9.report, report, report->size + sizeof(report->size));
@@ -159,13 +191,18 @@ namespace ams::bluetooth::hid::report {
             std::memcpy(&g_fake_report_event_info.data_report.v7.report, report, report->size + sizeof(report->size));
         }
 
-        g_fake_buffer->Write(hos::GetVersion() >= hos::Version_12_0_0 ? BtdrvHidEventType_Data : BtdrvHidEventTypeOld_Data, &g_fake_report_event_info, report->size + 0x11);
+        const auto timestamp = os::GetSystemTick();
+        if (R_SUCCEEDED(g_fake_buffer->Write(hos::GetVersion() >= hos::Version_12_0_0 ? BtdrvHidEventType_Data : BtdrvHidEventTypeOld_Data, &g_fake_report_event_info, report->size + 0x11))) {
+            capture::RecordReport(capture::CaptureSource_EmulatedInput, address, report, timestamp);
+        }
         g_system_event_fwd.Signal();
 
         R_SUCCEED();
     }
 
     Result WriteHidSetReport(const bluetooth::Address address, u32 status) {
+        std::scoped_lock lk(g_fake_report_lock);
+
         g_fake_report_event_info.set_report.addr = address;
         g_fake_report_event_info.set_report.res = status;
 
@@ -176,6 +213,8 @@ namespace ams::bluetooth::hid::report {
     }
 
     Result WriteHidGetReport(const bluetooth::Address address, const bluetooth::HidReport *report) {
+        std::scoped_lock lk(g_fake_report_lock);
+
         if (hos::GetVersion() >= hos::Version_9_0_0) {
             g_fake_report_event_info.get_report.v9.addr = address;
             g_fake_report_event_info.get_report.v9.res = 0;
@@ -240,6 +279,8 @@ namespace ams::bluetooth::hid::report {
         switch (g_current_event_type) {
             case BtdrvHidEventTypeOld_Data:
                 {
+                    capture::RecordReport(capture::CaptureSource_DeviceInput, g_event_info.data_report.v1.addr, reinterpret_cast<const bluetooth::HidReport *>(&g_event_info.data_report.v1.report), os::GetSystemTick());
+
                     auto device = controller::LocateHandler(g_event_info.data_report.v1.addr);
                     if (device) {
                         device->HandleDataReportEvent(&g_event_info);
@@ -268,6 +309,7 @@ namespace ams::bluetooth::hid::report {
     }
 
     inline void HandleHidReportEventV7() {
+        bool latency_recorded = false;
         while (true) {
             auto real_packet = g_real_buffer->Read();
             if (!real_packet) {
@@ -276,11 +318,17 @@ namespace ams::bluetooth::hid::report {
 
             g_real_buffer->Free();
 
+            if (real_packet->header.type != 0xff) {
+                RecordWakeLatency(real_packet, &latency_recorded);
+            }
+
             switch (real_packet->header.type) {
                 case 0xff:
                     continue;
                 case BtdrvHidEventTypeOld_Data:
                     {
+                        CaptureDataReport(real_packet);
+
                         auto device = controller::LocateHandler(hos::GetVersion() < hos::Version_9_0_0 ? real_packet->data.data_report.v7.addr : real_packet->data.data_report.v9.addr);
                         if (device) {
                             device->HandleDataReportEvent(&real_packet->data);
@@ -310,6 +358,7 @@ namespace ams::bluetooth::hid::report {
     }
 
     inline void HandleHidReportEventV12() {
+        bool latency_recorded = false;
         while (true) {
             auto real_packet = g_real_buffer->Read();
             if (!real_packet) {
@@ -318,11 +367,17 @@ namespace ams::bluetooth::hid::report {
 
             g_real_buffer->Free();
 
+            if (real_packet->header.type != 0xff) {
+                RecordWakeLatency(real_packet, &latency_recorded);
+            }
+
             switch (real_packet->header.type) {
                 case 0xff:
                     continue;
                 case BtdrvHidEventType_Data:
                     {
+                        CaptureDataReport(real_packet);
+
                         auto device = controller::LocateHandler(real_packet->data.data_report.v9.addr);
                         if (device) {
                             device->HandleDataReportEvent(&real_packet->data);
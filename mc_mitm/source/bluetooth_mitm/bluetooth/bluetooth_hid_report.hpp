@@ -17,6 +17,7 @@
 #include <switch.h>
 #include <stratosphere.hpp>
 #include "bluetooth_types.hpp"
+#include "../../utils/utils_latency_histogram.hpp"
 
 namespace ams::bluetooth::hid::report {
 
@@ -37,6 +38,8 @@ namespace ams::bluetooth::hid::report {
     Result Initialize();
     void Finalize();
 
+    void GetThreadStatistics(utils::LatencyHistogramData *out_wake_latency, utils::LatencyHistogramData *out_run_time);
+
     Result MapRemoteSharedMemory(os::NativeHandle handle);
     Result InitializeReportBuffer();
 
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bluetooth_inquiry.hpp"
+#include "bluetooth_hci.hpp"
+#include "../../async/async.hpp"
+#include "../../controllers/controller_management.hpp"
+#include "../../mcmitm_config.hpp"
+#include "../../utils.hpp"
+
+namespace ams::bluetooth::inquiry {
+
+    namespace {
+
+        constexpr size_t InquiryCacheSize = 32;
+
+        // Devices are re-reported on every inquiry cycle. Repeats within this window are dropped, later ones are passed on to keep the system's view fresh
+        constexpr TimeSpan DuplicateWindow = TimeSpan::FromSeconds(5);
+
+        struct InquiryResult {
+            bluetooth::Address address;
+            bluetooth::DeviceClass cod;
+            u32 name_hash;
+            bool rename;
+            os::Tick last_forwarded;
+        };
+
+        constinit os::SdkMutex g_inquiry_lock;
+        constinit InquiryResult g_results[InquiryCacheSize] = {};
+        constinit size_t g_num_results = 0;
+        constinit size_t g_next_result = 0;
+        constinit InquiryStatistics g_stats = {};
+
+        // FNV-1a. Names can be up to 249 characters, so only a hash is kept to detect changes
+        u32 HashName(const char *name) {
+            u32 hash = 0x811c9dc5;
+            for (const char *c = name; *c != '\0'; ++c) {
+                hash = (hash ^ static_cast<u8>(*c)) * 0x01000193;
+            }
+
+            return hash;
+        }
+
+        InquiryResult *FindInquiryResult(const bluetooth::Address &address) {
+            for (size_t i = 0; i < g_num_results; ++i) {
+                if (utils::BluetoothAddressCompare(g_results[i].address, address)) {
+                    return &g_results[i];
+                }
+            }
+
+            return nullptr;
+        }
+
+        InquiryResult *AllocateInquiryResult() {
+            // Replace entries round-robin once the cache is full
+            if (g_num_results < InquiryCacheSize) {
+                return &g_results[g_num_results++];
+            }
+
+            auto result = &g_results[g_next_result];
+            g_next_result = (g_next_result + 1) % InquiryCacheSize;
+            return result;
+        }
+
+        bool IsSameResult(const InquiryResult &result, const bluetooth::DeviceClass *cod, u32 name_hash) {
+            return (std::memcmp(&result.cod, cod, sizeof(result.cod)) == 0) && (result.name_hash == name_hash);
+        }
+
+        // Only devices with the peripheral major class (0x05) pass the filter
+        Result EnableGamepadInquiryFilter() {
+            const hci::HciInquiryClassFilterParams params = {
+                .filter_type = hci::HciEventFilterType_InquiryResult,
+                .condition_type = hci::HciInquiryFilterCondition_ClassOfDevice,
+                .class_of_device = { 0x00, 0x05, 0x00 },
+                .class_of_device_mask = { 0x00, 0x1f, 0x00 }
+            };
+            R_RETURN(hci::SendCommand(hci::HciOpcode_SetEventFilter, &params, sizeof(params)));
+        }
+
+        // Filters can't be removed individually, so all of them are cleared
+        Result DisableGamepadInquiryFilter() {
+            const hci::HciClearEventFilterParams params = { hci::HciEventFilterType_Clear };
+            R_RETURN(hci::SendCommand(hci::HciOpcode_SetEventFilter, &params, sizeof(params)));
+        }
+
+        Result SetGamepadInquiryFilter(bool enable) {
+            const Result result = enable ? EnableGamepadInquiryFilter() : DisableGamepadInquiryFilter();
+
+            std::scoped_lock lk(g_inquiry_lock);
+
+            g_stats.filter_result = result.GetValue();
+            if (R_SUCCEEDED(result)) {
+                g_stats.filter_active = enable;
+            }
+
+            R_RETURN(result);
+        }
+
+    }
+
+    bool HandleInquiryResult(const bluetooth::Address &address, const bluetooth::DeviceClass *cod, const char *name) {
+        const u32 name_hash = HashName(name);
+        const auto now = os::GetSystemTick();
+
+        std::scoped_lock lk(g_inquiry_lock);
+
+        g_stats.num_results += 1;
+
+        auto result = FindInquiryResult(address);
+        if ((result != nullptr) && IsSameResult(*result, cod, name_hash)) {
+            if (os::ConvertToTimeSpan(now - result->last_forwarded) < DuplicateWindow) {
+                g_stats.num_duplicates += 1;
+                return false;
+            }
+        } else {
+            // New device, or its name has been resolved since it was last seen
+            if (result == nullptr) {
+                result = AllocateInquiryResult();
+            }
+
+            *result = {
+                .address = address,
+                .cod = *cod,
+                .name_hash = name_hash,
+                .rename = controller::IsAllowedDeviceClass(cod) && !controller::IsOfficialSwitchControllerName(name)
+            };
+
+            if (result->rename) {
+                g_stats.num_renamed += 1;
+            }
+        }
+
+        result->last_forwarded = now;
+        g_stats.num_cached = g_num_results;
+
+        return true;
+    }
+
+    void HandleInquiryStatus(bool started) {
+        const bool filter = mitm::GetGlobalConfig()->bluetooth.gamepad_inquiry_filter;
+
+        bool active;
+        {
+            std::scoped_lock lk(g_inquiry_lock);
+            active = g_stats.filter_active;
+        }
+
+        // Sending HCI commands blocks on a reply delivered by the event thread, so this can't be done from here
+        if ((started && filter && !active) || (!started && active)) {
+            async::QueueWork([started]() -> ams::Result {
+                R_RETURN(SetGamepadInquiryFilter(started));
+            });
+        }
+    }
+
+    bool ShouldRenameInquiryResult(const bluetooth::Address &address, const bluetooth::DeviceClass *cod, const char *name) {
+        {
+            std::scoped_lock lk(g_inquiry_lock);
+
+            auto result = FindInquiryResult(address);
+            if ((result != nullptr) && IsSameResult(*result, cod, HashName(name))) {
+                return result->rename;
+            }
+        }
+
+        return controller::IsAllowedDeviceClass(cod) && !controller::IsOfficialSwitchControllerName(name);
+    }
+
+    void GetInquiryStatistics(InquiryStatistics *out_stats) {
+        std::scoped_lock lk(g_inquiry_lock);
+        *out_stats = g_stats;
+    }
+
+}
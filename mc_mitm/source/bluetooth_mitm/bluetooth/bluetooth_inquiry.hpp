@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <stratosphere.hpp>
+#include "bluetooth_types.hpp"
+
+namespace ams::bluetooth::inquiry {
+
+    struct InquiryStatistics {
+        u32 num_cached;
+        u32 num_results;
+        u32 num_duplicates;
+        u32 num_renamed;
+        bool filter_active;
+        u32 filter_result;
+    };
+
+    // Called from the event thread for every inquiry result. Returns false if the same device was already reported with the
+    // same class and name a moment ago, in which case the result doesn't need to be passed on to the system
+    bool HandleInquiryResult(const bluetooth::Address &address, const bluetooth::DeviceClass *cod, const char *name);
+    void HandleInquiryStatus(bool started);
+
+    // Whether an inquiry result should be renamed to an official controller name, using the classification cached when it arrived
+    bool ShouldRenameInquiryResult(const bluetooth::Address &address, const bluetooth::DeviceClass *cod, const char *name);
+
+    void GetInquiryStatistics(InquiryStatistics *out_stats);
+
+}
@@ -15,6 +15,8 @@
  */
 #include "bluetoothmitm_module.hpp"
 #include "btdrv_mitm_service.hpp"
+#include "../mcmitm_config.hpp"
+#include "../mcmitm_initialization.hpp"
 #include <stratosphere.hpp>
 
 namespace ams::mitm::bluetooth {
@@ -28,7 +30,9 @@ namespace ams::mitm::bluetooth {
 
         constexpr sm::ServiceName BtdrvMitmServiceName = sm::ServiceName::Encode("btdrv");
 
-        struct ServerOptions {
+        // Sessions opened by the hid sysmodule carry the per-report WriteHidData traffic. These are served by a dedicated
+        // high-priority thread so that they are never queued behind control requests from btm or homebrew clients.
+        struct DataServerOptions {
             static constexpr size_t PointerBufferSize   = 0x1000;
             static constexpr size_t MaxDomains          = 0;
             static constexpr size_t MaxDomainObjects    = 0;
@@ -36,13 +40,32 @@ namespace ams::mitm::bluetooth {
             static constexpr bool CanManageMitmServers  = true;
         };
 
-        constexpr size_t MaxSessions = 30;
+        // Everything else is served by a small pool of lower priority threads. Requests that would otherwise block
+        // a server thread (eg. EnableBluetooth waiting for module initialisation) are deferred instead.
+        struct ControlServerOptions {
+            static constexpr size_t PointerBufferSize   = 0x1000;
+            static constexpr size_t MaxDomains          = 0;
+            static constexpr size_t MaxDomainObjects    = 0;
+            static constexpr bool CanDeferInvokeRequest = true;
+            static constexpr bool CanManageMitmServers  = true;
+        };
+
+        constexpr size_t MaxDataSessions = 4;
+        constexpr size_t MaxControlSessions = 30;
 
-        class ServerManager final : public sf::hipc::ServerManager<PortIndex_Count, ServerOptions, MaxSessions> {
+        class DataServerManager final : public sf::hipc::ServerManager<PortIndex_Count, DataServerOptions, MaxDataSessions> {
+            public:
+                Result AcceptDataSession(Server *server, sf::SharedPointer<IBtdrvMitmInterface> &&obj, std::shared_ptr<::Service> fsrv) {
+                    return this->AcceptMitmImpl(server, std::move(obj), fsrv);
+                }
+        };
+
+        class ServerManager final : public sf::hipc::ServerManager<PortIndex_Count, ControlServerOptions, MaxControlSessions> {
             private:
                 virtual Result OnNeedsToAccept(int port_index, Server *server) override;
         };
 
+        DataServerManager g_data_server_manager;
         ServerManager g_server_manager;
 
         Result ServerManager::OnNeedsToAccept(int port_index, Server *server) {
@@ -53,38 +76,144 @@ namespace ams::mitm::bluetooth {
 
             switch (port_index) {
                 case PortIndex_BtdrvMitm:
-                    return this->AcceptMitmImpl(server, sf::CreateSharedObjectEmplaced<IBtdrvMitmInterface, BtdrvMitmService>(decltype(fsrv)(fsrv), client_info), fsrv);
+                    {
+                        auto obj = sf::CreateSharedObjectEmplaced<IBtdrvMitmInterface, BtdrvMitmService>(decltype(fsrv)(fsrv), client_info);
+
+                        // Hand sessions from the hid sysmodule over to the data plane server
+                        if (client_info.program_id == ncm::SystemProgramId::Hid) {
+                            return g_data_server_manager.AcceptDataSession(server, std::move(obj), fsrv);
+                        }
+
+                        return this->AcceptMitmImpl(server, std::move(obj), fsrv);
+                    }
                 AMS_UNREACHABLE_DEFAULT_CASE();
             }
         }
 
-        constexpr s32 ThreadPriority = -11;
+        constexpr size_t NumControlThreads = 2;
         constexpr size_t ThreadStackSize = 0x1000;
-        alignas(os::ThreadStackAlignment) constinit u8 g_thread_stack[ThreadStackSize];
-        constinit os::ThreadType g_thread;
 
-        void BtdrvMitmThreadFunction(void *) {
-            R_ABORT_UNLESS((g_server_manager.RegisterMitmServer<BtdrvMitmService>(PortIndex_BtdrvMitm, BtdrvMitmServiceName)));
-            g_server_manager.LoopProcess();
+        alignas(os::ThreadStackAlignment) constinit u8 g_data_thread_stack[ThreadStackSize];
+        constinit os::ThreadType g_data_thread;
+
+        alignas(os::ThreadStackAlignment) constinit u8 g_control_thread_stacks[NumControlThreads][ThreadStackSize];
+        constinit os::ThreadType g_control_threads[NumControlThreads];
+
+        constexpr const char *ControlThreadNames[NumControlThreads] = {
+            "mc::BtdrvMitmControlThread0",
+            "mc::BtdrvMitmControlThread1",
+        };
+
+        constinit utils::LatencyHistogram g_data_run_time;
+        constinit utils::LatencyHistogram g_control_run_time;
+
+        // Number of requests that chose to be deferred until module initialisation and have not yet been resumed
+        constinit os::SdkMutex g_deferral_lock;
+        constinit os::SdkConditionVariable g_deferral_cv;
+        constinit size_t g_num_deferred_requests = 0;
+
+        // A request that was only placed on the server's deferred list after the last resume was triggered is never re-invoked
+        // by it. Another resume is triggered if no deferred request has been re-invoked within this time
+        constexpr TimeSpan ResumeRetryInterval = TimeSpan::FromMilliSeconds(100);
+
+        // Equivalent to LoopProcess, but records how long the thread spends handling each signalled request
+        template <typename Manager>
+        void LoopProcessWithStatistics(Manager *manager, utils::LatencyHistogram *run_time) {
+            while (auto signaled_holder = manager->WaitSignaled()) {
+                const auto start_tick = os::GetSystemTick();
+                R_ABORT_UNLESS(manager->Process(signaled_holder));
+                run_time->Record(os::ConvertToTimeSpan(os::GetSystemTick() - start_tick));
+            }
+        }
+
+        void BtdrvMitmDataThreadFunction(void *) {
+            LoopProcessWithStatistics(&g_data_server_manager, &g_data_run_time);
+        }
+
+        void BtdrvMitmControlThreadFunction(void *) {
+            LoopProcessWithStatistics(&g_server_manager, &g_control_run_time);
         }
 
     }
 
     void Launch() {
-        R_ABORT_UNLESS(os::CreateThread(&g_thread,
-            BtdrvMitmThreadFunction,
+        R_ABORT_UNLESS((g_server_manager.RegisterMitmServer<BtdrvMitmService>(PortIndex_BtdrvMitm, BtdrvMitmServiceName)));
+
+        R_ABORT_UNLESS(os::CreateThread(&g_data_thread,
+            BtdrvMitmDataThreadFunction,
             nullptr,
-            g_thread_stack,
+            g_data_thread_stack,
             ThreadStackSize,
-            ThreadPriority
+            mitm::GetGlobalConfig()->threads.btdrv_data_priority
         ));
 
-        os::SetThreadNamePointer(&g_thread, "mc::BtdrvMitmThread");
-        os::StartThread(&g_thread);
+        os::SetThreadNamePointer(&g_data_thread, "mc::BtdrvMitmDataThread");
+        os::StartThread(&g_data_thread);
+
+        for (size_t i = 0; i < NumControlThreads; ++i) {
+            R_ABORT_UNLESS(os::CreateThread(&g_control_threads[i],
+                BtdrvMitmControlThreadFunction,
+                nullptr,
+                g_control_thread_stacks[i],
+                ThreadStackSize,
+                mitm::GetGlobalConfig()->threads.btdrv_control_priority
+            ));
+
+            os::SetThreadNamePointer(&g_control_threads[i], ControlThreadNames[i]);
+            os::StartThread(&g_control_threads[i]);
+        }
     }
 
     void WaitFinished() {
-        os::WaitThread(&g_thread);
+        for (size_t i = 0; i < NumControlThreads; ++i) {
+            os::WaitThread(&g_control_threads[i]);
+        }
+
+        os::WaitThread(&g_data_thread);
+    }
+
+    bool UpdateRequestDeferral(bool was_deferred) {
+        std::scoped_lock lk(g_deferral_lock);
+
+        if (was_deferred) {
+            --g_num_deferred_requests;
+            g_deferral_cv.Broadcast();
+        }
+
+        const bool defer = !ams::mitm::IsInitialized();
+        if (defer) {
+            ++g_num_deferred_requests;
+        }
+
+        return defer;
+    }
+
+    void ResumeDeferredRequests() {
+        // A request can decide to defer just before initialisation completes, but only be placed on the server's deferred
+        // list after we have triggered a resume. Wait for each deferred request to be re-invoked, triggering another resume
+        // only if one appears to have missed the last.
+        std::scoped_lock lk(g_deferral_lock);
+
+        while (g_num_deferred_requests != 0) {
+            const size_t num_deferred = g_num_deferred_requests;
+
+            g_server_manager.TriggerResume();
+
+            const auto deadline = os::GetSystemTick() + os::ConvertToTick(ResumeRetryInterval);
+            while (g_num_deferred_requests == num_deferred) {
+                const auto now = os::GetSystemTick();
+                if (now >= deadline) {
+                    break;
+                }
+
+                g_deferral_cv.TimedWait(g_deferral_lock, os::ConvertToTimeSpan(deadline - now));
+            }
+        }
+    }
+
+    void GetThreadStatistics(utils::LatencyHistogramData *out_data_run_time, utils::LatencyHistogramData *out_control_run_time) {
+        g_data_run_time.GetData(out_data_run_time);
+        g_control_run_time.GetData(out_control_run_time);
     }
 
 }
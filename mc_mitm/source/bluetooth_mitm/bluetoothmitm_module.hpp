@@ -15,10 +15,17 @@
  */
 #pragma once
 #include <stratosphere.hpp>
+#include "../utils/utils_latency_histogram.hpp"
 
 namespace ams::mitm::bluetooth {
 
     void Launch();
     void WaitFinished();
 
+    // Must be called by a deferrable request on every invocation. Returns whether it should (still) be deferred until module initialisation has completed
+    bool UpdateRequestDeferral(bool was_deferred);
+    void ResumeDeferredRequests();
+
+    void GetThreadStatistics(utils::LatencyHistogramData *out_data_run_time, utils::LatencyHistogramData *out_control_run_time);
+
 }
@@ -14,13 +14,15 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "btdrv_mitm_service.hpp"
+#include "bluetoothmitm_module.hpp"
 #include "btdrv_mitm_flags.hpp"
 #include "btdrv_shim.h"
 #include "bluetooth/bluetooth_core.hpp"
 #include "bluetooth/bluetooth_hid.hpp"
 #include "bluetooth/bluetooth_ble.hpp"
-#include "../mcmitm_initialization.hpp"
+#include "bluetooth/bluetooth_capture.hpp"
 #include "../controllers/controller_management.hpp"
+#include "../link/link_reconnect.hpp"
 #include <switch.h>
 
 namespace ams::mitm::bluetooth {
@@ -40,21 +42,29 @@ namespace ams::mitm::bluetooth {
             // Initialise the hid report circular buffer
             R_TRY(ams::bluetooth::hid::report::InitializeReportBuffer());
 
+            // Start queueing events for the caller before event handling begins
+            ams::bluetooth::core::AttachEventConsumer(m_client_info.program_id);
+
             // Signal that the interface is initialised
             ams::bluetooth::core::SignalInitialized();
         } else {
             out_handle.SetValue(ams::bluetooth::core::GetUserForwardEvent()->GetReadableHandle(), false);
+            ams::bluetooth::core::AttachEventConsumer(m_client_info.program_id);
         }
 
         R_SUCCEED();
     }
 
     Result BtdrvMitmService::EnableBluetooth() {
-        R_TRY(btdrvEnableBluetoothFwd(m_forward_service.get()));
-        ams::bluetooth::core::SignalEnabled();
+        // A deferred request is re-invoked once resumed, so only forward the call the first time around
+        if (!m_enable_deferred) {
+            R_TRY(btdrvEnableBluetoothFwd(m_forward_service.get()));
+            ams::bluetooth::core::SignalEnabled();
+        }
 
-        // Wait until mc.mitm module initialisation has completed before returning
-        ams::mitm::WaitInitialized();
+        // Defer the request until mc.mitm module initialisation has completed rather than blocking a server thread
+        m_enable_deferred = UpdateRequestDeferral(m_enable_deferred);
+        R_UNLESS(!m_enable_deferred, sf::ResultRequestDeferredByUser());
 
         R_SUCCEED();
     }
@@ -75,17 +85,30 @@ namespace ams::mitm::bluetooth {
             // Return our forwarder event handle to the caller instead
             out_handle.SetValue(ams::bluetooth::hid::GetForwardEvent()->GetReadableHandle(), false);
 
+            // Start queueing events for the caller before event handling begins
+            ams::bluetooth::hid::AttachEventConsumer(m_client_info.program_id);
+
             // Signal that the interface is initialised
             ams::bluetooth::hid::SignalInitialized();
         } else {
             out_handle.SetValue(ams::bluetooth::hid::GetUserForwardEvent()->GetReadableHandle(), false);
+            ams::bluetooth::hid::AttachEventConsumer(m_client_info.program_id);
         }
 
         R_SUCCEED();
     }
 
+    Result BtdrvMitmService::CloseHidConnection(ams::bluetooth::Address address) {
+        // Connections closed by the console aren't expected to come back on their own
+        ams::link::OnLocalDisconnect(address);
+
+        R_RETURN(btdrvCloseHidConnectionFwd(m_forward_service.get(), address));
+    }
+
     Result BtdrvMitmService::WriteHidData(ams::bluetooth::Address address, const sf::InPointerBuffer &buffer) {
         auto report = reinterpret_cast<const ams::bluetooth::HidReport *>(buffer.GetPointer());
+        ams::bluetooth::capture::RecordReport(ams::bluetooth::capture::CaptureSource_HostOutput, address, report, os::GetSystemTick());
+
         if (m_client_info.program_id == ncm::SystemProgramId::Hid) {
             auto device = controller::LocateHandler(address);
             if (device) {
@@ -113,7 +136,7 @@ namespace ams::mitm::bluetooth {
     }
 
     Result BtdrvMitmService::GetHidEventInfo(sf::Out<ams::bluetooth::HidEventType> out_type, const sf::OutPointerBuffer &out_buffer) {
-        R_RETURN(ams::bluetooth::hid::GetEventInfo(out_type.GetPointer(), out_buffer.GetPointer(), out_buffer.GetSize()));
+        R_RETURN(ams::bluetooth::hid::GetEventInfo(m_client_info.program_id, out_type.GetPointer(), out_buffer.GetPointer(), out_buffer.GetSize()));
     }
 
     Result BtdrvMitmService::RegisterHidReportEvent(sf::OutCopyHandle out_handle) {
@@ -158,17 +181,21 @@ namespace ams::mitm::bluetooth {
             // Return our forwarder event handle to the caller instead
             out_handle.SetValue(ams::bluetooth::ble::GetForwardEvent()->GetReadableHandle(), false);
 
+            // Start queueing events for the caller before event handling begins
+            ams::bluetooth::ble::AttachEventConsumer(m_client_info.program_id);
+
             // Signal that the interface is initialised
             ams::bluetooth::ble::SignalInitialized();
         }  else {
             out_handle.SetValue(ams::bluetooth::ble::GetUserForwardEvent()->GetReadableHandle(), false);
+            ams::bluetooth::ble::AttachEventConsumer(m_client_info.program_id);
         }
 
         R_SUCCEED();
     }
 
     Result BtdrvMitmService::GetBleManagedEventInfo(sf::Out<ams::bluetooth::BleEventType> out_type, const sf::OutPointerBuffer &out_buffer) {
-        R_RETURN(ams::bluetooth::ble::GetEventInfo(out_type.GetPointer(), out_buffer.GetPointer(), out_buffer.GetSize()));
+        R_RETURN(ams::bluetooth::ble::GetEventInfo(m_client_info.program_id, out_type.GetPointer(), out_buffer.GetPointer(), out_buffer.GetSize()));
     }
 
     /* Deprecated */
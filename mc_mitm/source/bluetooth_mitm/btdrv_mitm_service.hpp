@@ -22,6 +22,7 @@
     AMS_SF_METHOD_INFO(C, H, 2,     Result, EnableBluetooth,                  (),                                                                                       ())                                                             \
     AMS_SF_METHOD_INFO(C, H, 15,    Result, GetEventInfo,                     (sf::Out<ams::bluetooth::EventType> out_type, const sf::OutPointerBuffer &out_buffer),    (out_type, out_buffer))                                         \
     AMS_SF_METHOD_INFO(C, H, 16,    Result, InitializeHid,                    (sf::OutCopyHandle out_handle, u16 version),                                              (out_handle, version))                                          \
+    AMS_SF_METHOD_INFO(C, H, 18,    Result, CloseHidConnection,               (ams::bluetooth::Address address),                                                        (address))                                                      \
     AMS_SF_METHOD_INFO(C, H, 19,    Result, WriteHidData,                     (ams::bluetooth::Address address, const sf::InPointerBuffer &buffer),                     (address, buffer))                                              \
     AMS_SF_METHOD_INFO(C, H, 20,    Result, WriteHidData2,                    (ams::bluetooth::Address address, const sf::InPointerBuffer &buffer),                     (address, buffer))                                              \
     AMS_SF_METHOD_INFO(C, H, 27,    Result, GetHidEventInfo,                  (sf::Out<ams::bluetooth::HidEventType> out_type, const sf::OutPointerBuffer &out_buffer), (out_type, out_buffer))                                         \
@@ -48,6 +49,9 @@ namespace ams::mitm::bluetooth {
 
     class BtdrvMitmService : public sf::MitmServiceImplBase {
 
+        private:
+            bool m_enable_deferred = false;
+
         public:
             using MitmServiceImplBase::MitmServiceImplBase;
 
@@ -62,6 +66,7 @@ namespace ams::mitm::bluetooth {
             Result EnableBluetooth();
             Result GetEventInfo(sf::Out<ams::bluetooth::EventType> out_type, const sf::OutPointerBuffer &out_buffer);
             Result InitializeHid(sf::OutCopyHandle out_handle, u16 version);
+            Result CloseHidConnection(ams::bluetooth::Address address);
             Result WriteHidData(ams::bluetooth::Address address, const sf::InPointerBuffer &buffer);
             Result WriteHidData2(ams::bluetooth::Address address, const sf::InPointerBuffer &buffer);
             Result GetHidEventInfo(sf::Out<ams::bluetooth::HidEventType> out_type, const sf::OutPointerBuffer &out_buffer);
@@ -24,7 +24,7 @@ namespace ams::mitm::btm {
         void RenameConnectedDevices(BtmConnectedDeviceV1 devices[], size_t count) {
             for (unsigned int i = 0; i < count; ++i) {
                 auto device = &devices[i];
-                if (!controller::IsOfficialSwitchControllerName(device->name)) {
+                if (!controller::IsOfficialSwitchController(device->address, device->name)) {
                     std::strncpy(device->name, controller::LicensedProControllerName, sizeof(device->name) - 1);
                 }
             }
@@ -38,7 +38,7 @@ namespace ams::mitm::btm {
 
         for (int i = 0; i < total_out.GetValue(); ++i) {
             auto device = &device_condition[i];
-            if (!controller::IsOfficialSwitchControllerName(device->name)) {
+            if (!controller::IsOfficialSwitchController(device->address, device->name)) {
                 std::strncpy(device->name, controller::LicensedProControllerName, sizeof(device->name) - 1);
             }
         }
@@ -15,6 +15,7 @@
  */
 #include "btmmitm_module.hpp"
 #include "btm_mitm_service.hpp"
+#include "../mcmitm_config.hpp"
 #include <stratosphere.hpp>
 
 namespace ams::mitm::btm {
@@ -58,7 +59,6 @@ namespace ams::mitm::btm {
             }
         }
 
-        constexpr s32 ThreadPriority = 9;
         constexpr size_t ThreadStackSize = 0x1000;
         alignas(os::ThreadStackAlignment) constinit u8 g_thread_stack[ThreadStackSize];
         constinit os::ThreadType g_thread;
@@ -76,7 +76,7 @@ namespace ams::mitm::btm {
             nullptr,
             g_thread_stack,
             ThreadStackSize,
-            ThreadPriority
+            mitm::GetGlobalConfig()->threads.btm_priority
         ));
 
         os::SetThreadNamePointer(&g_thread, "mc::BtmMitmThread");
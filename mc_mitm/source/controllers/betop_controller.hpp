@@ -69,6 +69,24 @@ namespace ams::controller {
         };
     } PACKED;
 
+    // Triggers are read from their digital bits
+    constexpr layout::Button BetopExtraButtons[] = {
+        { 1, 0, SwitchButtonBit_ZL   },
+        { 1, 1, SwitchButtonBit_ZR   },
+        { 1, 4, SwitchButtonBit_Home },
+    };
+
+    constexpr auto BetopInputReport0x03Layout = []() {
+        constexpr u16 ButtonsOffset = offsetof(BetopReportData, input0x03.buttons) + sizeof(BetopButtonData::dpad);
+
+        layout::ReportLayout l;
+        l.SetSticks(offsetof(BetopReportData, input0x03.left_stick), offsetof(BetopReportData, input0x03.right_stick));
+        l.SetHat(offsetof(BetopReportData, input0x03.buttons.dpad), BetopDPad_N);
+        l.AddButtons(ButtonsOffset, layout::GenericGamepadButtons);
+        l.AddButtons(ButtonsOffset, BetopExtraButtons);
+        return l;
+    }();
+
     class BetopController final : public EmulatedSwitchController {
 
         public:
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "controller_device_cache.hpp"
+#include "../utils/utils_crc32.hpp"
+
+namespace ams::controller {
+
+    namespace {
+
+        constexpr u32 DeviceCacheMagic = util::FourCC<'M','C','D','C'>::Code;
+
+        // Bump whenever the layout of any cached structure changes so that stale files are discarded
+        constexpr u16 DeviceCacheVersion = 2;
+
+        constexpr size_t DeviceCacheMaxDataSize = 0x100;
+
+        struct DeviceCacheHeader {
+            u32 magic;
+            u16 version;
+            u16 data_size;
+            HardwareID id;
+            u32 data_version;
+            u32 crc;
+        };
+
+    }
+
+    Result DeviceCache::Load(void *data, size_t size, u32 data_version) const {
+        AMS_ABORT_UNLESS(size <= DeviceCacheMaxDataSize);
+
+        fs::FileHandle file;
+        R_TRY(fs::OpenFile(std::addressof(file), this->GetPath().c_str(), fs::OpenMode_Read));
+        ON_SCOPE_EXIT { fs::CloseFile(file); };
+
+        struct {
+            DeviceCacheHeader header;
+            u8 data[DeviceCacheMaxDataSize];
+        } cache;
+
+        size_t read_size;
+        R_TRY(fs::ReadFile(std::addressof(read_size), file, 0, &cache, sizeof(cache.header) + size));
+
+        // Treat anything that doesn't match exactly as a cache miss
+        R_UNLESS(read_size == sizeof(cache.header) + size,                      fs::ResultDataCorrupted());
+        R_UNLESS(cache.header.magic == DeviceCacheMagic,                        fs::ResultDataCorrupted());
+        R_UNLESS(cache.header.version == DeviceCacheVersion,                    fs::ResultDataCorrupted());
+        R_UNLESS(cache.header.data_size == size,                                fs::ResultDataCorrupted());
+        R_UNLESS(cache.header.id.vid == m_id.vid,                               fs::ResultDataCorrupted());
+        R_UNLESS(cache.header.id.pid == m_id.pid,                               fs::ResultDataCorrupted());
+        R_UNLESS(cache.header.data_version == data_version,                     fs::ResultDataCorrupted());
+        R_UNLESS(cache.header.crc == utils::Crc32::Calculate(cache.data, size), fs::ResultDataCorrupted());
+
+        std::memcpy(data, cache.data, size);
+
+        R_SUCCEED();
+    }
+
+    Result DeviceCache::Store(const void *data, size_t size, u32 data_version) const {
+        AMS_ABORT_UNLESS(size <= DeviceCacheMaxDataSize);
+
+        struct {
+            DeviceCacheHeader header;
+            u8 data[DeviceCacheMaxDataSize];
+        } cache = {
+            .header = {
+                .magic = DeviceCacheMagic,
+                .version = DeviceCacheVersion,
+                .data_size = static_cast<u16>(size),
+                .id = m_id,
+                .data_version = data_version,
+                .crc = utils::Crc32::Calculate(data, size),
+            },
+            .data = {}
+        };
+        std::memcpy(cache.data, data, size);
+
+        const auto path = this->GetPath();
+        const size_t file_size = sizeof(cache.header) + size;
+
+        bool file_exists;
+        R_TRY(fs::HasFile(&file_exists, path.c_str()));
+        if (!file_exists) {
+            R_TRY(fs::CreateFile(path.c_str(), file_size));
+        }
+
+        fs::FileHandle file;
+        R_TRY(fs::OpenFile(std::addressof(file), path.c_str(), fs::OpenMode_Write | fs::OpenMode_AllowAppend));
+        ON_SCOPE_EXIT { fs::CloseFile(file); };
+
+        R_TRY(fs::SetFileSize(file, file_size));
+        R_TRY(fs::WriteFile(file, 0, &cache, file_size, fs::WriteOption::Flush));
+
+        R_SUCCEED();
+    }
+
+    std::string DeviceCache::GetPath() const {
+        return GetControllerDirectory(m_address) + "/device_cache.bin";
+    }
+
+}
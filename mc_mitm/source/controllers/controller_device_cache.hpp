@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "switch_controller.hpp"
+
+namespace ams::controller {
+
+    // Persists data that would otherwise be requested from a controller on every connection (calibration, firmware info etc.)
+    // in the controller's config directory. Cached data is tagged with the hardware id and a data version, and only loaded if
+    // both still match. The data version is the firmware version the data was read from, or the format version of data derived
+    // from it. Controllers that don't report a firmware version use 0
+    class DeviceCache {
+        public:
+            DeviceCache(bluetooth::Address address, HardwareID id) : m_address(address), m_id(id) { }
+
+            Result Load(void *data, size_t size, u32 data_version = 0) const;
+            Result Store(const void *data, size_t size, u32 data_version = 0) const;
+
+        private:
+            std::string GetPath() const;
+
+            bluetooth::Address m_address;
+            HardwareID m_id;
+    };
+
+}
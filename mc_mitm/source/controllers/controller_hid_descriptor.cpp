@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "controller_hid_descriptor.hpp"
+
+namespace ams::controller {
+
+    namespace {
+
+        bool IsFieldInBounds(const HidPlanField &field, u32 end_bit) {
+            if (field.bit_size == 0) {
+                return true;
+            }
+
+            return (field.bit_size <= 32) && (field.bit_offset + field.bit_size <= end_bit) && (field.logical_max > field.logical_min);
+        }
+
+        enum HidItemType {
+            HidItemType_Main   = 0,
+            HidItemType_Global = 1,
+            HidItemType_Local  = 2,
+        };
+
+        enum HidMainTag {
+            HidMainTag_Input = 0x8,
+        };
+
+        enum HidGlobalTag {
+            HidGlobalTag_UsagePage   = 0x0,
+            HidGlobalTag_LogicalMin  = 0x1,
+            HidGlobalTag_LogicalMax  = 0x2,
+            HidGlobalTag_ReportSize  = 0x7,
+            HidGlobalTag_ReportId    = 0x8,
+            HidGlobalTag_ReportCount = 0x9,
+            HidGlobalTag_Push        = 0xa,
+            HidGlobalTag_Pop         = 0xb,
+        };
+
+        enum HidLocalTag {
+            HidLocalTag_Usage    = 0x0,
+            HidLocalTag_UsageMin = 0x1,
+            HidLocalTag_UsageMax = 0x2,
+        };
+
+        constexpr u8 HidLongItemPrefix = 0xfe;
+
+        constexpr u32 HidInputFlag_Constant = BIT(0);
+        constexpr u32 HidInputFlag_Variable = BIT(1);
+
+        constexpr u16 UsagePage_GenericDesktop = 0x01;
+        constexpr u16 UsagePage_Simulation     = 0x02;
+        constexpr u16 UsagePage_Button         = 0x09;
+
+        constexpr u32 MakeUsage(u16 page, u16 id) { return (static_cast<u32>(page) << 16) | id; }
+
+        enum DescriptorAxis {
+            DescriptorAxis_X,
+            DescriptorAxis_Y,
+            DescriptorAxis_Z,
+            DescriptorAxis_Rx,
+            DescriptorAxis_Ry,
+            DescriptorAxis_Rz,
+            DescriptorAxis_Accelerator,
+            DescriptorAxis_Brake,
+            DescriptorAxis_Count
+        };
+
+        constexpr u32 DescriptorAxisUsages[DescriptorAxis_Count] = {
+            MakeUsage(UsagePage_GenericDesktop, 0x30),
+            MakeUsage(UsagePage_GenericDesktop, 0x31),
+            MakeUsage(UsagePage_GenericDesktop, 0x32),
+            MakeUsage(UsagePage_GenericDesktop, 0x33),
+            MakeUsage(UsagePage_GenericDesktop, 0x34),
+            MakeUsage(UsagePage_GenericDesktop, 0x35),
+            MakeUsage(UsagePage_Simulation,     0xc4),
+            MakeUsage(UsagePage_Simulation,     0xc5),
+        };
+
+        constexpr u32 HatSwitchUsage = MakeUsage(UsagePage_GenericDesktop, 0x39);
+
+        constexpr size_t MaxReportPayloadBits = sizeof(bluetooth::HidReport::data) * 8;
+
+        constexpr size_t MaxLocalUsages = 16;
+        constexpr size_t MaxGlobalStackDepth = 4;
+        constexpr size_t MaxReportIds = 0x100;
+
+        struct GlobalState {
+            u16 usage_page;
+            s32 logical_min;
+            s32 logical_max;
+            u32 report_size;
+            u32 report_count;
+            u8 report_id;
+        };
+
+        struct LocalState {
+            u32 usages[MaxLocalUsages];
+            size_t num_usages;
+            u32 usage_min;
+            u32 usage_max;
+            bool has_range;
+        };
+
+        class DescriptorCompiler {
+            public:
+                explicit DescriptorCompiler(HidMappingPlan *plan) : m_plan(plan) {
+                    std::memset(m_plan, 0, sizeof(*m_plan));
+                    std::fill(std::begin(m_plan->button_bit_offsets), std::end(m_plan->button_bit_offsets), HidMappingPlan::UnusedButton);
+                }
+
+                bool Compile(const u8 *descriptor, size_t size) {
+                    size_t pos = 0;
+                    while (pos < size) {
+                        const u8 prefix = descriptor[pos++];
+
+                        if (prefix == HidLongItemPrefix) {
+                            if (pos + 2 > size) {
+                                break;
+                            }
+                            pos += 2 + descriptor[pos];
+                            continue;
+                        }
+
+                        const size_t data_size = (prefix & 0x3) == 0x3 ? 4 : (prefix & 0x3);
+                        if (pos + data_size > size) {
+                            // A truncated descriptor still describes everything before the cut
+                            break;
+                        }
+
+                        u32 data = 0;
+                        for (size_t i = 0; i < data_size; ++i) {
+                            data |= static_cast<u32>(descriptor[pos + i]) << (8 * i);
+                        }
+                        pos += data_size;
+
+                        const u8 tag = prefix >> 4;
+                        switch ((prefix >> 2) & 0x3) {
+                            case HidItemType_Main:
+                                this->HandleMainItem(tag, data);
+                                break;
+                            case HidItemType_Global:
+                                this->HandleGlobalItem(tag, data, data_size);
+                                break;
+                            case HidItemType_Local:
+                                this->HandleLocalItem(tag, data, data_size);
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+
+                    return this->Finalize();
+                }
+
+            private:
+                static s32 SignExtend(u32 data, size_t size) {
+                    switch (size) {
+                        case 1: return static_cast<s8>(data);
+                        case 2: return static_cast<s16>(data);
+                        default: return static_cast<s32>(data);
+                    }
+                }
+
+                void HandleMainItem(u8 tag, u32 data) {
+                    if (tag == HidMainTag_Input) {
+                        const u32 bit_offset = m_bit_offsets[m_global.report_id];
+                        if (!(data & HidInputFlag_Constant) && (data & HidInputFlag_Variable)) {
+                            for (u32 i = 0; i < m_global.report_count; ++i) {
+                                this->RecordField(this->GetUsage(i), bit_offset + i * m_global.report_size);
+                            }
+                        }
+
+                        m_bit_offsets[m_global.report_id] = std::min<u32>(bit_offset + m_global.report_size * m_global.report_count, UINT16_MAX);
+                    }
+
+                    // Local items only apply to the main item that follows them
+                    m_local = {};
+                }
+
+                void HandleGlobalItem(u8 tag, u32 data, size_t size) {
+                    switch (tag) {
+                        case HidGlobalTag_UsagePage:
+                            m_global.usage_page = data;
+                            break;
+                        case HidGlobalTag_LogicalMin:
+                            m_global.logical_min = SignExtend(data, size);
+                            break;
+                        case HidGlobalTag_LogicalMax:
+                            m_global.logical_max = SignExtend(data, size);
+                            // Many devices encode an unsigned maximum such as 0xff in too few bytes
+                            if (m_global.logical_max < m_global.logical_min) {
+                                m_global.logical_max = data;
+                            }
+                            break;
+                        case HidGlobalTag_ReportSize:
+                            m_global.report_size = data;
+                            break;
+                        case HidGlobalTag_ReportId:
+                            m_global.report_id = data;
+                            m_has_report_id = true;
+                            break;
+                        case HidGlobalTag_ReportCount:
+                            m_global.report_count = data;
+                            break;
+                        case HidGlobalTag_Push:
+                            if (m_global_stack_depth < MaxGlobalStackDepth) {
+                                m_global_stack[m_global_stack_depth++] = m_global;
+                            }
+                            break;
+                        case HidGlobalTag_Pop:
+                            if (m_global_stack_depth > 0) {
+                                m_global = m_global_stack[--m_global_stack_depth];
+                            }
+                            break;
+                        default:
+                            break;
+                    }
+                }
+
+                void HandleLocalItem(u8 tag, u32 data, size_t size) {
+                    // Usages shorter than four bytes are qualified by the current usage page
+                    const u32 usage = size == 4 ? data : MakeUsage(m_global.usage_page, data);
+
+                    switch (tag) {
+                        case HidLocalTag_Usage:
+                            if (m_local.num_usages < MaxLocalUsages) {
+                                m_local.usages[m_local.num_usages++] = usage;
+                            }
+                            break;
+                        case HidLocalTag_UsageMin:
+                            m_local.usage_min = usage;
+                            m_local.has_range = true;
+                            break;
+                        case HidLocalTag_UsageMax:
+                            m_local.usage_max = usage;
+                            m_local.has_range = true;
+                            break;
+                        default:
+                            break;
+                    }
+                }
+
+                // Fields beyond the declared usages repeat the last one
+                u32 GetUsage(u32 index) const {
+                    if (m_local.num_usages > 0) {
+                        return m_local.usages[std::min<size_t>(index, m_local.num_usages - 1)];
+                    }
+
+                    if (m_local.has_range) {
+                        return std::min(m_local.usage_min + index, m_local.usage_max);
+                    }
+
+                    return 0;
+                }
+
+                void RecordField(u32 usage, u32 bit_offset) {
+                    const u16 page = usage >> 16;
+                    const u16 id = usage & 0xffff;
+
+                    const bool is_button = (page == UsagePage_Button) && (id >= 1) && (id <= HidMappingPlan::MaxButtons);
+                    const auto axis = std::find(std::begin(DescriptorAxisUsages), std::end(DescriptorAxisUsages), usage);
+                    const bool is_axis = axis != std::end(DescriptorAxisUsages);
+                    if (!is_button && !is_axis && (usage != HatSwitchUsage)) {
+                        return;
+                    }
+
+                    // Only the first report carrying gamepad inputs is mapped
+                    if (!m_report_chosen) {
+                        m_plan->report_id = m_global.report_id;
+                        m_report_chosen = true;
+                    } else if (m_global.report_id != m_plan->report_id) {
+                        return;
+                    }
+
+                    // Fields that can't fit in a report would only ever be read out of bounds
+                    if ((m_global.report_size == 0) || (m_global.report_size > 32) || (bit_offset + m_global.report_size > MaxReportPayloadBits)) {
+                        return;
+                    }
+
+                    const HidPlanField field = {
+                        .bit_offset = static_cast<u16>(bit_offset),
+                        .bit_size = static_cast<u8>(m_global.report_size),
+                        .is_signed = m_global.logical_min < 0,
+                        .logical_min = m_global.logical_min,
+                        .logical_max = m_global.logical_max,
+                    };
+
+                    if (is_button) {
+                        m_plan->button_bit_offsets[id - 1] = field.bit_offset;
+                        m_plan->num_buttons = std::max<u8>(m_plan->num_buttons, id);
+                    } else if (is_axis) {
+                        m_axes[axis - std::begin(DescriptorAxisUsages)] = field;
+                    } else {
+                        m_plan->hat = field;
+                    }
+
+                    m_end_bit = std::max(m_end_bit, bit_offset + m_global.report_size);
+                }
+
+                static bool IsPresent(const HidPlanField &field) {
+                    return (field.bit_size != 0) && (field.logical_max > field.logical_min);
+                }
+
+                bool Finalize() {
+                    if (!IsPresent(m_axes[DescriptorAxis_X]) && (m_plan->num_buttons == 0)) {
+                        return false;
+                    }
+
+                    m_plan->has_report_id = m_has_report_id;
+                    m_plan->report_size = (m_end_bit + 7) / 8;
+
+                    m_plan->axes[HidPlanAxis_LeftStickX] = m_axes[DescriptorAxis_X];
+                    m_plan->axes[HidPlanAxis_LeftStickY] = m_axes[DescriptorAxis_Y];
+
+                    // Most Bluetooth gamepads put the right stick on Z/Rz, with Rx/Ry or the simulation controls for the triggers
+                    const bool right_on_z = IsPresent(m_axes[DescriptorAxis_Z]) && IsPresent(m_axes[DescriptorAxis_Rz]);
+                    m_plan->axes[HidPlanAxis_RightStickX] = m_axes[right_on_z ? DescriptorAxis_Z : DescriptorAxis_Rx];
+                    m_plan->axes[HidPlanAxis_RightStickY] = m_axes[right_on_z ? DescriptorAxis_Rz : DescriptorAxis_Ry];
+
+                    if (IsPresent(m_axes[DescriptorAxis_Brake]) || IsPresent(m_axes[DescriptorAxis_Accelerator])) {
+                        m_plan->axes[HidPlanAxis_LeftTrigger] = m_axes[DescriptorAxis_Brake];
+                        m_plan->axes[HidPlanAxis_RightTrigger] = m_axes[DescriptorAxis_Accelerator];
+                    } else if (right_on_z) {
+                        m_plan->axes[HidPlanAxis_LeftTrigger] = m_axes[DescriptorAxis_Rx];
+                        m_plan->axes[HidPlanAxis_RightTrigger] = m_axes[DescriptorAxis_Ry];
+                    }
+
+                    for (auto &field : m_plan->axes) {
+                        if (!IsPresent(field)) {
+                            field = {};
+                        }
+                    }
+
+                    if (!IsPresent(m_plan->hat)) {
+                        m_plan->hat = {};
+                    }
+
+                    return IsValidHidMappingPlan(*m_plan);
+                }
+
+            private:
+                HidMappingPlan *m_plan;
+                GlobalState m_global = {};
+                GlobalState m_global_stack[MaxGlobalStackDepth] = {};
+                size_t m_global_stack_depth = 0;
+                LocalState m_local = {};
+                u16 m_bit_offsets[MaxReportIds] = {};
+                HidPlanField m_axes[DescriptorAxis_Count] = {};
+                u32 m_end_bit = 0;
+                bool m_has_report_id = false;
+                bool m_report_chosen = false;
+        };
+
+    }
+
+    bool CompileHidMappingPlan(const u8 *descriptor, size_t size, HidMappingPlan *out_plan) {
+        return DescriptorCompiler(out_plan).Compile(descriptor, size);
+    }
+
+    bool IsValidHidMappingPlan(const HidMappingPlan &plan) {
+        const size_t max_report_size = sizeof(bluetooth::HidReport::data) - (plan.has_report_id ? 1 : 0);
+        if ((plan.report_size > max_report_size) || (plan.num_buttons > HidMappingPlan::MaxButtons)) {
+            return false;
+        }
+
+        const u32 end_bit = plan.report_size * 8;
+
+        for (size_t i = 0; i < plan.num_buttons; ++i) {
+            if ((plan.button_bit_offsets[i] != HidMappingPlan::UnusedButton) && (plan.button_bit_offsets[i] >= end_bit)) {
+                return false;
+            }
+        }
+
+        for (const auto &field : plan.axes) {
+            if (!IsFieldInBounds(field, end_bit)) {
+                return false;
+            }
+        }
+
+        return IsFieldInBounds(plan.hat, end_bit);
+    }
+
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include "controller_report_layout.hpp"
+
+namespace ams::controller {
+
+    enum HidPlanAxis {
+        HidPlanAxis_LeftStickX,
+        HidPlanAxis_LeftStickY,
+        HidPlanAxis_RightStickX,
+        HidPlanAxis_RightStickY,
+        HidPlanAxis_LeftTrigger,
+        HidPlanAxis_RightTrigger,
+        HidPlanAxis_Count
+    };
+
+    struct HidPlanField {
+        u16 bit_offset;
+        u8 bit_size;  // 0 if the field isn't present
+        u8 is_signed;
+        s32 logical_min;
+        s32 logical_max;
+    };
+
+    // Flat description of where a gamepad's inputs sit within one of its input reports, compiled from its HID report descriptor.
+    // Executing the plan only extracts fixed bit ranges, so the descriptor is never walked while handling reports
+    struct HidMappingPlan {
+        static constexpr size_t MaxButtons = 16;
+        static constexpr u16 UnusedButton = 0xffff;
+
+        u8 has_report_id;
+        u8 report_id;
+        u16 report_size;  // Minimum payload size in bytes, excluding the report id
+        u8 num_buttons;
+        u16 button_bit_offsets[MaxButtons];
+        HidPlanField axes[HidPlanAxis_Count];
+        HidPlanField hat;
+    };
+
+    // Bump whenever the layout or meaning of HidMappingPlan changes, so that plans cached by an older version are recompiled
+    constexpr u32 HidMappingPlanVersion = 1;
+
+    bool CompileHidMappingPlan(const u8 *descriptor, size_t size, HidMappingPlan *out_plan);
+
+    // Checks that every field of the plan lies within its report, and that the report fits in a HidReport
+    bool IsValidHidMappingPlan(const HidMappingPlan &plan);
+
+}
@@ -16,12 +16,13 @@
 #include "controller_management.hpp"
 #include <stratosphere.hpp>
 #include "../utils.hpp"
+#include "../link/link_policy.hpp"
 
 namespace ams::controller {
 
     namespace {
 
-        const std::string OfficialGamepadNames[] = {
+        constexpr std::string_view OfficialGamepadNames[] = {
             "NintendoGamepad",
             "Joy-Con",
             "Pro Controller",
@@ -35,13 +36,163 @@ namespace ams::controller {
             "Lic3 Pro Controller",
         };
 
+        constexpr utils::PrefixTrie<192> OfficialGamepadNameTrie(OfficialGamepadNames);
+
+        // Names don't change for the lifetime of a pairing, so classifications are cached by address for the btm device queries
+        struct NameClassification {
+            bluetooth::Address address;
+            bool is_official;
+        };
+
+        constexpr size_t NameClassificationCacheSize = 16;
+
+        constinit os::SdkMutex g_name_classification_lock;
+        constinit std::array<NameClassification, NameClassificationCacheSize> g_name_classifications = {};
+        constinit size_t g_name_classification_count = 0;
+        constinit size_t g_name_classification_next = 0;
+
+        NameClassification *FindNameClassification(const bluetooth::Address &address) {
+            for (size_t i = 0; i < g_name_classification_count; ++i) {
+                if (utils::BluetoothAddressCompare(g_name_classifications[i].address, address)) {
+                    return &g_name_classifications[i];
+                }
+            }
+
+            return nullptr;
+        }
+
+        void StoreNameClassification(const bluetooth::Address &address, bool is_official) {
+            auto entry = FindNameClassification(address);
+            if (entry == nullptr) {
+                // Replace entries round-robin once the cache is full
+                if (g_name_classification_count < NameClassificationCacheSize) {
+                    entry = &g_name_classifications[g_name_classification_count++];
+                } else {
+                    entry = &g_name_classifications[g_name_classification_next];
+                    g_name_classification_next = (g_name_classification_next + 1) % NameClassificationCacheSize;
+                }
+            }
+
+            *entry = { address, is_official };
+        }
+
+        // Paired device info doesn't change while a device stays paired, so the hardware id and type are cached by address
+        // rather than being fetched from btdrv every time a controller reconnects
+        struct KnownDevice {
+            bluetooth::Address address;
+            HardwareID id;
+            ControllerType type;
+        };
+
+        constexpr size_t KnownDeviceCacheSize = 16;
+
+        constinit os::SdkMutex g_known_device_lock;
+        constinit std::array<KnownDevice, KnownDeviceCacheSize> g_known_devices = {};
+        constinit size_t g_known_device_count = 0;
+        constinit size_t g_known_device_next = 0;
+
+        KnownDevice *FindKnownDevice(const bluetooth::Address &address) {
+            for (size_t i = 0; i < g_known_device_count; ++i) {
+                if (utils::BluetoothAddressCompare(g_known_devices[i].address, address)) {
+                    return &g_known_devices[i];
+                }
+            }
+
+            return nullptr;
+        }
+
+        void StoreKnownDevice(const bluetooth::Address &address, HardwareID id, ControllerType type) {
+            std::scoped_lock lk(g_known_device_lock);
+
+            auto entry = FindKnownDevice(address);
+            if (entry == nullptr) {
+                // Replace entries round-robin once the cache is full
+                if (g_known_device_count < KnownDeviceCacheSize) {
+                    entry = &g_known_devices[g_known_device_count++];
+                } else {
+                    entry = &g_known_devices[g_known_device_next];
+                    g_known_device_next = (g_known_device_next + 1) % KnownDeviceCacheSize;
+                }
+            }
+
+            *entry = { address, id, type };
+        }
+
+        bool LookupKnownDevice(const bluetooth::Address &address, HardwareID *out_id, ControllerType *out_type) {
+            std::scoped_lock lk(g_known_device_lock);
+
+            auto entry = FindKnownDevice(address);
+            if (entry == nullptr) {
+                return false;
+            }
+
+            *out_id = entry->id;
+            *out_type = entry->type;
+            return true;
+        }
+
         constexpr u8 DeviceClassMajorPeripheral = 0x05;
         constexpr u8 DeviceClassMinorGamepad    = 0x08;
         constexpr u8 DeviceClassMinorJoystick   = 0x04;
         constexpr u8 DeviceClassMinorKeyboard   = 0x40;
 
+        // Controller objects are constructed in a fixed arena rather than the global heap, so that heap fragmentation can never cause a connection to fail
+        constexpr size_t ControllerSlotSize = util::AlignUp(std::max({
+            sizeof(SwitchController),
+            sizeof(WiiController),
+            sizeof(Dualshock3Controller),
+            sizeof(Dualshock4Controller),
+            sizeof(DualsenseController),
+            sizeof(XboxOneController),
+            sizeof(OuyaController),
+            sizeof(GamestickController),
+            sizeof(GemboxController),
+            sizeof(IpegaController),
+            sizeof(XiaomiController),
+            sizeof(GamesirController),
+            sizeof(SteelseriesController),
+            sizeof(NvidiaShieldController),
+            sizeof(EightBitDoController),
+            sizeof(PowerAController),
+            sizeof(MadCatzController),
+            sizeof(MocuteController),
+            sizeof(RazerController),
+            sizeof(ICadeController),
+            sizeof(LanShenController),
+            sizeof(AtGamesController),
+            sizeof(HyperkinController),
+            sizeof(BetopController),
+            sizeof(AtariController),
+            sizeof(BionikController),
+            sizeof(AmazonController),
+            sizeof(VirtualController),
+            sizeof(UnknownController),
+        }) + 0x40, 0x10); // Additional space for the shared_ptr control block
+
+        // A couple of spare slots allow a reconnecting controller to be constructed while a stale reference to the previous instance is still held elsewhere
+        constexpr size_t ControllerArenaSlotCount = MaxControllers + 2;
+
+        using ControllerArena = utils::SlabHeap<ControllerSlotSize, ControllerArenaSlotCount>;
+
+        constinit ControllerArena g_controller_arena;
+
         constinit os::SdkMutex g_controller_lock;
-        std::vector<std::shared_ptr<SwitchController>> g_controllers;
+
+        // Controllers that disconnect within this long of their last input report are assumed to have done so deliberately
+        constexpr TimeSpan RemoteDisconnectReportWindow = TimeSpan::FromMilliSeconds(250);
+
+        constinit u32 g_applied_profile_generation = 0;
+        std::array<std::shared_ptr<SwitchController>, MaxControllers> g_controllers;
+
+        template <typename T>
+        std::shared_ptr<SwitchController> CreateController(bluetooth::Address address, HardwareID id) {
+            void *storage = g_controller_arena.Allocate();
+            if (storage == nullptr) {
+                return nullptr;
+            }
+
+            return std::allocate_shared<T>(utils::SlabAllocator<T, ControllerArena>(&g_controller_arena, storage), address, id);
+        }
 
     }
 
@@ -213,6 +364,12 @@ namespace ams::controller {
             }
         }
 
+        for (auto hwId : VirtualController::hardware_ids) {
+            if ( (device->vid == hwId.vid) && (device->pid == hwId.pid) ) {
+                return ControllerType_Virtual;
+            }
+        }
+
         return ControllerType_Unknown;
     }
 
@@ -221,138 +378,241 @@ namespace ams::controller {
                (((cod->class_of_device[2] & 0x0f) == DeviceClassMinorGamepad) || ((cod->class_of_device[2] & 0x0f) == DeviceClassMinorJoystick) || ((cod->class_of_device[2] & 0x40) == DeviceClassMinorKeyboard));
     }
 
-    bool IsOfficialSwitchControllerName(const std::string& name) {
-        for (auto n : OfficialGamepadNames) {
-            if (name.rfind(n, 0) == 0)
-                return true;
+    bool IsOfficialSwitchControllerName(std::string_view name) {
+        return OfficialGamepadNameTrie.HasPrefixOf(name);
+    }
+
+    bool IsOfficialSwitchController(const bluetooth::Address &address, std::string_view name) {
+        std::scoped_lock lk(g_name_classification_lock);
+
+        if (auto entry = FindNameClassification(address); entry != nullptr) {
+            return entry->is_official;
+        }
+
+        const bool is_official = IsOfficialSwitchControllerName(name);
+        StoreNameClassification(address, is_official);
+
+        return is_official;
+    }
+
+    // Some controllers keep their address but report a different hardware id after being re-paired in another mode
+    void ForgetKnownDevice(const bluetooth::Address &address) {
+        std::scoped_lock lk(g_known_device_lock);
+
+        if (auto entry = FindKnownDevice(address); entry != nullptr) {
+            entry->address = {};
         }
+    }
 
-        return false;
+    void SetNameClassification(const bluetooth::Address &address, bool is_official) {
+        // Only called while pairing, so any cached device info for this address is about to be out of date
+        ForgetKnownDevice(address);
+
+        std::scoped_lock lk(g_name_classification_lock);
+        StoreNameClassification(address, is_official);
     }
 
-    void AttachHandler(bluetooth::Address address) {
-        bluetooth::DevicesSettings device_settings;
-        R_ABORT_UNLESS(btdrvGetPairedDeviceInfo(address, &device_settings));
+    bool AttachHandler(bluetooth::Address address, ControllerTransport *transport) {
+        HardwareID id;
+        ControllerType type;
+        if (!LookupKnownDevice(address, &id, &type)) {
+            bluetooth::DevicesSettings device_settings;
+            R_ABORT_UNLESS(btdrvGetPairedDeviceInfo(address, &device_settings));
 
-        HardwareID id = { device_settings.vid, device_settings.pid };
+            id = { device_settings.vid, device_settings.pid };
+            type = Identify(&device_settings);
+            StoreKnownDevice(address, id, type);
+        }
 
         std::shared_ptr<SwitchController> controller;
 
-        switch (Identify(&device_settings)) {
+        switch (type) {
             case ControllerType_Switch:
-                controller = std::make_shared<SwitchController>(address, id);
+                controller = CreateController<SwitchController>(address, id);
                 break;
             case ControllerType_Wii:
-                controller = std::make_shared<WiiController>(address, id);
+                controller = CreateController<WiiController>(address, id);
                 break;
             case ControllerType_Dualshock3:
-                controller = std::make_shared<Dualshock3Controller>(address, id);
+                controller = CreateController<Dualshock3Controller>(address, id);
                 break;
             case ControllerType_Dualshock4:
-                controller = std::make_shared<Dualshock4Controller>(address, id);
+                controller = CreateController<Dualshock4Controller>(address, id);
                 break;
             case ControllerType_Dualsense:
-                controller = std::make_shared<DualsenseController>(address, id);
+                controller = CreateController<DualsenseController>(address, id);
                 break;
             case ControllerType_XboxOne:
-                controller = std::make_shared<XboxOneController>(address, id);
+                controller = CreateController<XboxOneController>(address, id);
                 break;
             case ControllerType_Ouya:
-                controller = std::make_shared<OuyaController>(address, id);
+                controller = CreateController<OuyaController>(address, id);
                 break;
             case ControllerType_Gamestick:
-                controller = std::make_shared<GamestickController>(address, id);
+                controller = CreateController<GamestickController>(address, id);
                 break;
             case ControllerType_Gembox:
-                controller = std::make_shared<GemboxController>(address, id);
+                controller = CreateController<GemboxController>(address, id);
                 break;
             case ControllerType_Ipega:
-                controller = std::make_shared<IpegaController>(address, id);
+                controller = CreateController<IpegaController>(address, id);
                 break;
             case ControllerType_Xiaomi:
-                controller = std::make_shared<XiaomiController>(address, id);
+                controller = CreateController<XiaomiController>(address, id);
                 break;
             case ControllerType_Gamesir:
-                controller = std::make_shared<GamesirController>(address, id);
+                controller = CreateController<GamesirController>(address, id);
                 break;
             case ControllerType_Steelseries:
-                controller = std::make_shared<SteelseriesController>(address, id);
+                controller = CreateController<SteelseriesController>(address, id);
                 break;
             case ControllerType_NvidiaShield:
-                controller = std::make_shared<NvidiaShieldController>(address, id);
+                controller = CreateController<NvidiaShieldController>(address, id);
                 break;
             case ControllerType_8BitDo:
-                controller = std::make_shared<EightBitDoController>(address, id);
+                controller = CreateController<EightBitDoController>(address, id);
                 break;
             case ControllerType_PowerA:
-                controller = std::make_shared<PowerAController>(address, id);
+                controller = CreateController<PowerAController>(address, id);
                 break;
             case ControllerType_MadCatz:
-                controller = std::make_shared<MadCatzController>(address, id);
+                controller = CreateController<MadCatzController>(address, id);
                 break;
             case ControllerType_Mocute:
-                controller = std::make_shared<MocuteController>(address, id);
+                controller = CreateController<MocuteController>(address, id);
                 break;
             case ControllerType_Razer:
-                controller = std::make_shared<RazerController>(address, id);
+                controller = CreateController<RazerController>(address, id);
                 break;
             case ControllerType_ICade:
-                controller = std::make_shared<ICadeController>(address, id);
+                controller = CreateController<ICadeController>(address, id);
                 break;
             case ControllerType_LanShen:
-                controller = std::make_shared<LanShenController>(address, id);
+                controller = CreateController<LanShenController>(address, id);
                 break;
             case ControllerType_AtGames:
-                controller = std::make_shared<AtGamesController>(address, id);
+                controller = CreateController<AtGamesController>(address, id);
                 break;
             case ControllerType_Hyperkin:
-                controller = std::make_shared<HyperkinController>(address, id);
+                controller = CreateController<HyperkinController>(address, id);
                 break;
             case ControllerType_Betop:
-                controller = std::make_shared<BetopController>(address, id);
+                controller = CreateController<BetopController>(address, id);
                 break;
             case ControllerType_Atari:
-                controller = std::make_shared<AtariController>(address, id);
+                controller = CreateController<AtariController>(address, id);
                 break;
             case ControllerType_Bionik:
-                controller = std::make_shared<BionikController>(address, id);
+                controller = CreateController<BionikController>(address, id);
                 break;
             case ControllerType_Amazon:
-                controller = std::make_shared<AmazonController>(address, id);
+                controller = CreateController<AmazonController>(address, id);
+                break;
+            case ControllerType_Virtual:
+                controller = CreateController<VirtualController>(address, id);
                 break;
             default:
-                controller = std::make_shared<UnknownController>(address, id);
+                controller = CreateController<UnknownController>(address, id);
                 break;
         }
 
+        if (!controller) {
+            // Controller arena is exhausted
+            link::OnLocalDisconnect(address);
+            btdrvCloseHidConnection(address);
+            return false;
+        }
+
+        controller->SetTransport(transport);
+
         {
             std::scoped_lock lk(g_controller_lock);
-            g_controllers.push_back(controller);
+
+            auto slot = std::find(g_controllers.begin(), g_controllers.end(), nullptr);
+            if (slot == g_controllers.end()) {
+                link::OnLocalDisconnect(address);
+                btdrvCloseHidConnection(address);
+                return false;
+            }
+
+            *slot = controller;
         }
 
         if (R_FAILED(controller->Initialize())) {
             // Try to disconnect the controller
+            link::OnLocalDisconnect(address);
             btdrvCloseHidConnection(controller->Address());
+            return false;
+        }
+
+        // Wired controllers have no radio link to manage
+        if (!controller->IsWired()) {
+            link::AttachController(address, type);
         }
+
+        return true;
     }
 
     void RemoveHandler(bluetooth::Address address) {
+        auto handler = LocateHandler(address);
+        if (!handler || !handler->IsWired()) {
+            // The stack doesn't report why a connection closed. A controller that was switched off disconnects straight after its
+            // last report, whereas a lost link is only torn down once the supervision timeout has passed with no reports at all
+            auto reason = link::DisconnectReason_LinkLoss;
+            if (handler && (os::GetSystemTick() - handler->GetLastInputReportTick() < os::ConvertToTick(RemoteDisconnectReportWindow))) {
+                reason = link::DisconnectReason_RemoteUser;
+            }
+
+            link::DetachController(address, reason);
+        }
+
         std::scoped_lock lk(g_controller_lock);
 
-        for (auto it = g_controllers.begin(); it < g_controllers.end(); ++it) {
-            if (utils::BluetoothAddressCompare((*it)->Address(), address)) {
-                g_controllers.erase(it);
+        for (auto &controller : g_controllers) {
+            if (controller && utils::BluetoothAddressCompare(controller->Address(), address)) {
+                controller.reset();
                 return;
             }
         }
     }
 
+    size_t GetConnectedControllers(std::shared_ptr<SwitchController> *out_controllers, size_t max_count) {
+        std::scoped_lock lk(g_controller_lock);
+
+        size_t count = 0;
+        for (auto &controller : g_controllers) {
+            if (controller && (count < max_count)) {
+                out_controllers[count++] = controller;
+            }
+        }
+
+        return count;
+    }
+
+    void ApplyPerformanceProfile() {
+        const u32 generation = mitm::GetProfileGeneration();
+        if (generation == g_applied_profile_generation) {
+            return;
+        }
+
+        g_applied_profile_generation = generation;
+
+        std::shared_ptr<SwitchController> controllers[MaxControllers];
+        const size_t num_controllers = GetConnectedControllers(controllers, MaxControllers);
+
+        mitm::PerformanceProfile profile;
+        mitm::GetActiveProfile(&profile);
+        for (size_t i = 0; i < num_controllers; ++i) {
+            static_cast<void>(controllers[i]->ApplyProfile(&profile));
+        }
+    }
+
     std::shared_ptr<SwitchController> LocateHandler(bluetooth::Address address) {
         std::scoped_lock lk(g_controller_lock);
 
-        for (auto it = g_controllers.begin(); it < g_controllers.end(); ++it) {
-            if (utils::BluetoothAddressCompare((*it)->Address(), address)) {
-                return (*it);
+        for (auto &controller : g_controllers) {
+            if (controller && utils::BluetoothAddressCompare(controller->Address(), address)) {
+                return controller;
             }
         }
 
@@ -16,6 +16,7 @@
 #pragma once
 #include <switch.h>
 #include <string>
+#include <string_view>
 
 #include "switch_controller.hpp"
 #include "wii_controller.hpp"
@@ -44,6 +45,8 @@
 #include "atari_controller.hpp"
 #include "bionik_controller.hpp"
 #include "amazon_controller.hpp"
+#include "virtual_controller.hpp"
+#include "unknown_controller.hpp"
 
 namespace ams::controller {
 
@@ -79,21 +82,32 @@ namespace ams::controller {
         ControllerType_Atari,
         ControllerType_Bionik,
         ControllerType_Amazon,
+        ControllerType_Virtual,
         ControllerType_Unknown,
     };
 
-    class UnknownController : public EmulatedSwitchController {
-        public:
-            UnknownController(bluetooth::Address address, HardwareID id)
-            : EmulatedSwitchController(address, id) { }
-    };
-
     ControllerType Identify(const bluetooth::DevicesSettings *device);
     bool IsAllowedDeviceClass(const bluetooth::DeviceClass *cod);
-    bool IsOfficialSwitchControllerName(const std::string& name);
+    bool IsOfficialSwitchControllerName(std::string_view name);
+    bool IsOfficialSwitchController(const bluetooth::Address &address, std::string_view name);
+    void ForgetKnownDevice(const bluetooth::Address &address);
+    void SetNameClassification(const bluetooth::Address &address, bool is_official);
+
+    // Bound fixed size name fields, which aren't guaranteed to be null terminated
+    template <size_t N>
+    inline bool IsOfficialSwitchControllerName(const char (&name)[N]) {
+        return IsOfficialSwitchControllerName(std::string_view(name, ::strnlen(name, N)));
+    }
+
+    template <size_t N>
+    inline bool IsOfficialSwitchController(const bluetooth::Address &address, const char (&name)[N]) {
+        return IsOfficialSwitchController(address, std::string_view(name, ::strnlen(name, N)));
+    }
 
-    void AttachHandler(bluetooth::Address address);
+    bool AttachHandler(bluetooth::Address address, ControllerTransport *transport = nullptr);
     void RemoveHandler(bluetooth::Address address);
     std::shared_ptr<SwitchController> LocateHandler(bluetooth::Address address);
+    size_t GetConnectedControllers(std::shared_ptr<SwitchController> *out_controllers, size_t max_count);
+    void ApplyPerformanceProfile();
 
 }
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "switch_controller.hpp"
+#include <utility>
+
+namespace ams::controller {
+
+    // Bit index of each button within SwitchButtonData
+    enum SwitchButtonBit : u8 {
+        SwitchButtonBit_Y         = 0,
+        SwitchButtonBit_X         = 1,
+        SwitchButtonBit_B         = 2,
+        SwitchButtonBit_A         = 3,
+        SwitchButtonBit_R         = 6,
+        SwitchButtonBit_ZR        = 7,
+        SwitchButtonBit_Minus     = 8,
+        SwitchButtonBit_Plus      = 9,
+        SwitchButtonBit_RStick    = 10,
+        SwitchButtonBit_LStick    = 11,
+        SwitchButtonBit_Home      = 12,
+        SwitchButtonBit_Capture   = 13,
+        SwitchButtonBit_DpadDown  = 16,
+        SwitchButtonBit_DpadUp    = 17,
+        SwitchButtonBit_DpadRight = 18,
+        SwitchButtonBit_DpadLeft  = 19,
+        SwitchButtonBit_L         = 22,
+        SwitchButtonBit_ZL        = 23,
+    };
+
+    namespace layout {
+
+        constexpr u16 NotPresent = 0xffff;
+
+        struct Button {
+            u16 offset;
+            u8 bit;
+            SwitchButtonBit target;
+        };
+
+        // Analog trigger byte, pressed once past the configured activation threshold
+        struct Trigger {
+            u16 offset;
+            SwitchButtonBit target;
+        };
+
+        // 8-way hat switch byte. Directions run clockwise from north, any other value means released
+        struct Hat {
+            u16 offset;
+            u8 north;
+        };
+
+        // Pair of 8-bit axes, with y increasing downwards
+        struct Stick {
+            u16 offset;
+        };
+
+        // Button bits shared by many generic gamepads, relative to the first of their two button bytes
+        constexpr Button GenericGamepadButtons[] = {
+            { 0, 1, SwitchButtonBit_A      },
+            { 0, 0, SwitchButtonBit_B      },
+            { 0, 4, SwitchButtonBit_X      },
+            { 0, 3, SwitchButtonBit_Y      },
+            { 0, 7, SwitchButtonBit_R      },
+            { 0, 6, SwitchButtonBit_L      },
+            { 1, 2, SwitchButtonBit_Minus  },
+            { 1, 3, SwitchButtonBit_Plus   },
+            { 1, 5, SwitchButtonBit_LStick },
+            { 1, 6, SwitchButtonBit_RStick },
+        };
+
+        // Description of where a report keeps each input. Offsets are from the start of the report, including its id.
+        // Descriptions are used as template arguments, so every offset and bit is a constant in the generated mapper
+        struct ReportLayout {
+            static constexpr size_t MaxButtons = 24;
+            static constexpr size_t MaxTriggers = 2;
+
+            Stick left_stick = { NotPresent };
+            Stick right_stick = { NotPresent };
+            Hat hat = { NotPresent, 0 };
+            std::array<Button, MaxButtons> buttons = {};
+            size_t num_buttons = 0;
+            std::array<Trigger, MaxTriggers> triggers = {};
+            size_t num_triggers = 0;
+
+            constexpr void SetSticks(u16 left_offset, u16 right_offset) {
+                left_stick = { left_offset };
+                right_stick = { right_offset };
+            }
+
+            constexpr void SetHat(u16 offset, u8 north) {
+                hat = { offset, north };
+            }
+
+            template <size_t N>
+            constexpr void AddButtons(u16 base, const Button (&mappings)[N]) {
+                for (const auto &mapping : mappings) {
+                    this->AddButton(base, mapping);
+                }
+            }
+
+            constexpr void AddButton(u16 base, const Button &mapping) {
+                if (num_buttons >= MaxButtons) {
+                    // Not a constant expression, so fails the build if the layout is too large
+                    AMS_ABORT("Report layout button capacity exceeded");
+                }
+
+                buttons[num_buttons++] = { static_cast<u16>(base + mapping.offset), mapping.bit, mapping.target };
+            }
+
+            constexpr void AddTrigger(u16 offset, SwitchButtonBit target) {
+                if (num_triggers >= MaxTriggers) {
+                    AMS_ABORT("Report layout trigger capacity exceeded");
+                }
+
+                triggers[num_triggers++] = { offset, target };
+            }
+
+            // Buttons written by the layout. Any others keep their current state
+            constexpr u32 GetButtonMask() const {
+                u32 mask = 0;
+                for (size_t i = 0; i < num_buttons; ++i) {
+                    mask |= BIT(buttons[i].target);
+                }
+                for (size_t i = 0; i < num_triggers; ++i) {
+                    mask |= BIT(triggers[i].target);
+                }
+                if (hat.offset != NotPresent) {
+                    mask |= BIT(SwitchButtonBit_DpadDown) | BIT(SwitchButtonBit_DpadUp) | BIT(SwitchButtonBit_DpadRight) | BIT(SwitchButtonBit_DpadLeft);
+                }
+                return mask;
+            }
+        };
+
+        // Dpad bits for each hat direction, clockwise from north
+        constexpr u8 HatDirections[] = {
+            BIT(1),           // N
+            BIT(1) | BIT(2),  // NE
+            BIT(2),           // E
+            BIT(0) | BIT(2),  // SE
+            BIT(0),           // S
+            BIT(0) | BIT(3),  // SW
+            BIT(3),           // W
+            BIT(1) | BIT(3),  // NW
+        };
+
+        template <ReportLayout Layout>
+        void MapButtons(const u8 *report, float trigger_threshold, SwitchButtonData *out_buttons) {
+            constexpr u32 Mask = Layout.GetButtonMask();
+            const float threshold = trigger_threshold * UINT8_MAX;
+
+            u32 value = 0;
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ((value |= static_cast<u32>((report[Layout.buttons[I].offset] >> Layout.buttons[I].bit) & 1) << Layout.buttons[I].target), ...);
+            }(std::make_index_sequence<Layout.num_buttons>());
+
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ((value |= static_cast<u32>(report[Layout.triggers[I].offset] > threshold) << Layout.triggers[I].target), ...);
+            }(std::make_index_sequence<Layout.num_triggers>());
+
+            if constexpr (Layout.hat.offset != NotPresent) {
+                const u8 direction = report[Layout.hat.offset] - Layout.hat.north;
+                if (direction < std::size(HatDirections)) {
+                    value |= static_cast<u32>(HatDirections[direction]) << SwitchButtonBit_DpadDown;
+                }
+            }
+
+            u32 buttons = 0;
+            std::memcpy(&buttons, out_buttons, sizeof(SwitchButtonData));
+            buttons = (buttons & ~Mask) | value;
+            std::memcpy(out_buttons, &buttons, sizeof(SwitchButtonData));
+        }
+
+        template <Stick Layout>
+        void MapStick(const u8 *report, SwitchAnalogStick *out_stick) {
+            if constexpr (Layout.offset != NotPresent) {
+                *out_stick = PackAnalogStickValues(report[Layout.offset], InvertAnalogStickValue(report[Layout.offset + 1]));
+            }
+        }
+
+    }
+
+}
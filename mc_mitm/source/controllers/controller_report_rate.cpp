@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "controller_report_rate.hpp"
+#include "controller_management.hpp"
+#include "../mcmitm_config.hpp"
+#include "../utils.hpp"
+
+namespace ams::controller {
+
+    namespace {
+
+        // Total input reports per second to share between adjustable controllers
+        constexpr u32 ReportBudget = 1000;
+        constexpr u16 MinReportRate = 62;
+
+        constexpr TimeSpan ActivityTimeout = TimeSpan::FromSeconds(5);
+
+        // Number of consecutive updates a lower rate must be wanted before it is applied. Rate increases are applied immediately
+        constexpr u8 RateDecreaseHoldCount = 3;
+
+        struct ReportRateState {
+            bluetooth::Address address;
+            u8 decrease_count;
+            ReportRateStatistics stats;
+        };
+
+        constinit os::SdkMutex g_report_rate_lock;
+        constinit ReportRateState g_rate_states[MaxControllers] = {};
+        constinit size_t g_num_rate_states = 0;
+        constinit os::Tick g_last_update_tick = os::Tick(0);
+
+        ReportRateState *GetRateState(const bluetooth::Address &address, ReportRateState *states, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                if (utils::BluetoothAddressCompare(states[i].address, address)) {
+                    return &states[i];
+                }
+            }
+
+            return nullptr;
+        }
+
+        u32 GetReportRateWeight(const ReportRateStatistics &stats, bool most_recent) {
+            u32 weight = 1;
+            if (stats.active) {
+                weight += 1;
+            }
+            if (stats.motion_active) {
+                weight += 2;
+            }
+            if (most_recent) {
+                weight += 2;
+            }
+
+            return weight;
+        }
+
+    }
+
+    void UpdateReportRates() {
+        std::shared_ptr<SwitchController> controllers[MaxControllers];
+        const size_t num_controllers = GetConnectedControllers(controllers, MaxControllers);
+
+        std::scoped_lock lk(g_report_rate_lock);
+
+        const auto now = os::GetSystemTick();
+        const s64 elapsed_ms = g_last_update_tick.GetInt64Value() != 0 ? os::ConvertToTimeSpan(now - g_last_update_tick).GetMilliSeconds() : 0;
+        g_last_update_tick = now;
+
+        // Carry over per-controller state from the previous update, dropping controllers that have since disconnected
+        ReportRateState states[MaxControllers] = {};
+        for (size_t i = 0; i < num_controllers; ++i) {
+            auto &state = states[i];
+            auto &controller = controllers[i];
+
+            auto previous = GetRateState(controller->Address(), g_rate_states, g_num_rate_states);
+            if (previous) {
+                state = *previous;
+            } else {
+                state.address = controller->Address();
+                state.stats.address = state.address;
+            }
+
+            const auto last_activity = controller->GetLastActivityTick();
+            const u32 num_reports = controller->ConsumeInputReportCount();
+
+            state.stats.active = (last_activity.GetInt64Value() != 0) && (os::ConvertToTimeSpan(now - last_activity) < ActivityTimeout);
+            state.stats.motion_active = controller->IsMotionActive();
+            state.stats.report_rate = controller->GetReportRate();
+            state.stats.measured_rate = elapsed_ms > 0 ? static_cast<u16>(std::min<s64>(num_reports * 1000 / elapsed_ms, UINT16_MAX)) : 0;
+        }
+
+        // Controllers that can't change rate still use up part of the budget
+        u32 budget = ReportBudget;
+        u32 total_weight = 0;
+        size_t most_recent = num_controllers;
+        for (size_t i = 0; i < num_controllers; ++i) {
+            if (states[i].stats.report_rate == 0) {
+                budget -= std::min<u32>(budget, states[i].stats.measured_rate);
+                continue;
+            }
+
+            if (states[i].stats.active && ((most_recent == num_controllers) || (controllers[i]->GetLastActivityTick() > controllers[most_recent]->GetLastActivityTick()))) {
+                most_recent = i;
+            }
+        }
+
+        for (size_t i = 0; i < num_controllers; ++i) {
+            if (states[i].stats.report_rate != 0) {
+                total_weight += GetReportRateWeight(states[i].stats, i == most_recent);
+            }
+        }
+
+        const bool adaptive = mitm::GetGlobalConfig()->misc.dualshock4_adaptive_polling_rate;
+
+        for (size_t i = 0; i < num_controllers; ++i) {
+            auto &state = states[i];
+            if (state.stats.report_rate == 0) {
+                state.stats.target_rate = 0;
+                continue;
+            }
+
+            const u32 share = budget * GetReportRateWeight(state.stats, i == most_recent) / total_weight;
+            state.stats.target_rate = static_cast<u16>(std::clamp<u32>(share, MinReportRate, ReportBudget));
+
+            if (!adaptive) {
+                continue;
+            }
+
+            // Only lower the rate once it has been consistently over budget and the change is large enough to be worth a report
+            u16 rate = state.stats.report_rate;
+            if (state.stats.target_rate > rate) {
+                rate = state.stats.target_rate;
+                state.decrease_count = 0;
+            } else if (state.stats.target_rate < rate - rate / 10) {
+                if (++state.decrease_count >= RateDecreaseHoldCount) {
+                    rate = state.stats.target_rate;
+                    state.decrease_count = 0;
+                }
+            } else {
+                state.decrease_count = 0;
+            }
+
+            if (rate != state.stats.report_rate) {
+                if (R_SUCCEEDED(controllers[i]->SetReportRate(rate))) {
+                    state.stats.report_rate = controllers[i]->GetReportRate();
+                }
+            }
+        }
+
+        std::memcpy(g_rate_states, states, sizeof(states));
+        g_num_rate_states = num_controllers;
+    }
+
+    size_t GetReportRateStatistics(ReportRateStatistics *out_stats, size_t max_count) {
+        std::scoped_lock lk(g_report_rate_lock);
+
+        const size_t count = std::min(g_num_rate_states, max_count);
+        for (size_t i = 0; i < count; ++i) {
+            out_stats[i] = g_rate_states[i].stats;
+        }
+
+        return count;
+    }
+
+    bool GetReportRateStatistics(const bluetooth::Address &address, ReportRateStatistics *out_stats) {
+        std::scoped_lock lk(g_report_rate_lock);
+
+        auto state = GetRateState(address, g_rate_states, g_num_rate_states);
+        if (state == nullptr) {
+            return false;
+        }
+
+        *out_stats = state->stats;
+        return true;
+    }
+
+}
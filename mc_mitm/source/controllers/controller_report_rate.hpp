@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "switch_controller.hpp"
+
+namespace ams::controller {
+
+    struct ReportRateStatistics {
+        bluetooth::Address address;
+        bool active;
+        bool motion_active;
+        u16 report_rate;
+        u16 measured_rate;
+        u16 target_rate;
+    };
+
+    // Measures the input report rate of each connected controller and redistributes a shared report budget between those
+    // that support changing their rate. Expected to be called periodically (~1s) from a single thread
+    void UpdateReportRates();
+    size_t GetReportRateStatistics(ReportRateStatistics *out_stats, size_t max_count);
+    bool GetReportRateStatistics(const bluetooth::Address &address, ReportRateStatistics *out_stats);
+
+}
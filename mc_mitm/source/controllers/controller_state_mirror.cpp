@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "controller_state_mirror.hpp"
+
+namespace ams::controller {
+
+    namespace {
+
+        // Other processes may only map the mirror for reading
+        os::SharedMemory g_state_mirror_shmem(ControllerStateMirrorSize, os::MemoryPermission_ReadWrite, os::MemoryPermission_ReadOnly);
+
+        constinit ControllerStateMirror *g_state_mirror = nullptr;
+
+        constinit os::SdkMutex g_slot_lock;
+        constinit bool g_slot_used[MaxControllers] = {};
+
+        void BeginWrite(ControllerState *state) {
+            const u32 sequence = state->sequence.load(std::memory_order_relaxed);
+            state->sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        void EndWrite(ControllerState *state) {
+            const u32 sequence = state->sequence.load(std::memory_order_relaxed);
+            state->sequence.store(sequence + 1, std::memory_order_release);
+        }
+
+        ControllerState *GetState(s32 slot) {
+            if ((g_state_mirror == nullptr) || (slot < 0) || (slot >= static_cast<s32>(MaxControllers))) {
+                return nullptr;
+            }
+
+            return &g_state_mirror->controllers[slot];
+        }
+
+    }
+
+    void InitializeStateMirror() {
+        auto mirror = reinterpret_cast<ControllerStateMirror *>(g_state_mirror_shmem.Map(os::MemoryPermission_ReadWrite));
+        AMS_ABORT_UNLESS(mirror != nullptr);
+
+        std::memset(static_cast<void *>(mirror), 0, ControllerStateMirrorSize);
+        mirror->version = ControllerStateMirrorVersion;
+        mirror->max_controllers = MaxControllers;
+
+        g_state_mirror = mirror;
+    }
+
+    os::SharedMemory *GetStateMirrorSharedMemory() {
+        return &g_state_mirror_shmem;
+    }
+
+    s32 AcquireStateMirrorSlot(const bluetooth::Address &address, bool wired) {
+        std::scoped_lock lk(g_slot_lock);
+
+        for (s32 slot = 0; slot < static_cast<s32>(MaxControllers); ++slot) {
+            if (g_slot_used[slot]) {
+                continue;
+            }
+
+            g_slot_used[slot] = true;
+
+            if (auto state = GetState(slot); state != nullptr) {
+                BeginWrite(state);
+                state->flags = ControllerStateFlag_Connected | (wired ? ControllerStateFlag_Wired : 0);
+                state->address = address;
+                state->battery = 0;
+                state->connection_info = 0;
+                state->buttons = 0;
+                state->left_stick[0] = state->left_stick[1] = SwitchAnalogStick::Center;
+                state->right_stick[0] = state->right_stick[1] = SwitchAnalogStick::Center;
+                state->left_trigger = 0;
+                state->right_trigger = 0;
+                std::memset(state->accel, 0, sizeof(state->accel));
+                std::memset(state->gyro, 0, sizeof(state->gyro));
+                state->input_report_count = 0;
+                state->forwarded_report_count = 0;
+                state->timestamp = os::GetSystemTick().GetInt64Value();
+                EndWrite(state);
+            }
+
+            return slot;
+        }
+
+        return -1;
+    }
+
+    void ReleaseStateMirrorSlot(s32 slot) {
+        if ((slot < 0) || (slot >= static_cast<s32>(MaxControllers))) {
+            return;
+        }
+
+        std::scoped_lock lk(g_slot_lock);
+
+        if (auto state = GetState(slot); state != nullptr) {
+            BeginWrite(state);
+            state->flags = 0;
+            state->timestamp = os::GetSystemTick().GetInt64Value();
+            EndWrite(state);
+        }
+
+        g_slot_used[slot] = false;
+    }
+
+    void PublishControllerState(s32 slot, const SwitchInputReport *report, bool forwarded) {
+        auto state = GetState(slot);
+        if (state == nullptr) {
+            return;
+        }
+
+        BeginWrite(state);
+
+        state->input_report_count += 1;
+        if (forwarded) {
+            state->forwarded_report_count += 1;
+        }
+
+        // Only the standard full reports share the Pro Controller input layout
+        if ((report->id == 0x21) || (report->id == 0x30) || (report->id == 0x31)) {
+            auto buttons = reinterpret_cast<const u8 *>(&report->buttons);
+            state->buttons = buttons[0] | (buttons[1] << 8) | (buttons[2] << 16);
+
+            auto left_stick = report->left_stick;
+            auto right_stick = report->right_stick;
+            state->left_stick[0] = left_stick.GetX();
+            state->left_stick[1] = left_stick.GetY();
+            state->right_stick[0] = right_stick.GetX();
+            state->right_stick[1] = right_stick.GetY();
+
+            state->left_trigger = report->buttons.ZL ? UINT8_MAX : 0;
+            state->right_trigger = report->buttons.ZR ? UINT8_MAX : 0;
+
+            state->battery = report->battery;
+            state->connection_info = report->conn_info;
+        }
+
+        // Subcommand replies carry no IMU data, and the sample is left zeroed while motion is disabled. An accelerometer always
+        // reads gravity, so an all zero one means there was no sample
+        if ((report->id == 0x30) || (report->id == 0x31)) {
+            const auto &motion = report->type0x30.motion_data.standard;
+            state->accel[0] = motion.accel_0.x;
+            state->accel[1] = motion.accel_0.y;
+            state->accel[2] = motion.accel_0.z;
+            state->gyro[0] = motion.gyro_0.x;
+            state->gyro[1] = motion.gyro_0.y;
+            state->gyro[2] = motion.gyro_0.z;
+        }
+
+        if ((report->id == 0x21) || (report->id == 0x30) || (report->id == 0x31)) {
+            const bool has_motion = (report->id != 0x21) && ((state->accel[0] != 0) || (state->accel[1] != 0) || (state->accel[2] != 0));
+            if (has_motion) {
+                state->flags |= ControllerStateFlag_Motion;
+            } else {
+                state->flags &= ~ControllerStateFlag_Motion;
+            }
+        }
+
+        state->timestamp = os::GetSystemTick().GetInt64Value();
+
+        EndWrite(state);
+    }
+
+}
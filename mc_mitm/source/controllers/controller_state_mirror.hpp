@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "switch_controller.hpp"
+
+namespace ams::controller {
+
+    constexpr u32 ControllerStateMirrorVersion = 1;
+    constexpr size_t ControllerStateMirrorSize = 0x1000;
+
+    enum ControllerStateFlag : u32 {
+        ControllerStateFlag_Connected = BIT(0),
+        ControllerStateFlag_Wired     = BIT(1),
+        ControllerStateFlag_Motion    = BIT(2),  // accel and gyro hold the first raw IMU sample of the latest report. Cleared by input reports without one. gyro is meaningless while quaternion packing is in use
+    };
+
+    // Latest input state of a single controller, normalised to the Switch Pro Controller report format. The writer makes
+    // sequence odd while updating the entry. Readers copy the entry and retry if sequence was odd or changed during the copy
+    struct ControllerState {
+        std::atomic<u32> sequence;
+        u32 flags;
+        bluetooth::Address address;
+        u8 battery;                 // Switch battery nibble: level in bits 1-3, charging in bit 0
+        u8 connection_info;
+        u32 buttons;                // SwitchButtonData in the low 24 bits
+        u16 left_stick[2];          // 12-bit x, y
+        u16 right_stick[2];
+        u8 left_trigger;            // ZL and ZR are digital in the Switch format, so these are either 0 or 0xff
+        u8 right_trigger;
+        u16 reserved;
+        s16 accel[3];
+        s16 gyro[3];
+        u32 input_report_count;     // reports received from the controller
+        u32 forwarded_report_count; // reports passed on to the system
+        u64 timestamp;              // system tick of the last update
+    };
+    static_assert(std::atomic<u32>::is_always_lock_free);
+    static_assert(sizeof(ControllerState) == 0x48);
+
+    struct ControllerStateMirror {
+        u32 version;
+        u32 max_controllers;
+        u64 reserved;
+        ControllerState controllers[MaxControllers];
+    };
+    static_assert(sizeof(ControllerStateMirror) <= ControllerStateMirrorSize);
+
+    void InitializeStateMirror();
+    os::SharedMemory *GetStateMirrorSharedMemory();
+
+    // Slots are claimed for the lifetime of a controller. Publishing never blocks, so it's safe to call from the report thread
+    s32 AcquireStateMirrorSlot(const bluetooth::Address &address, bool wired);
+    void ReleaseStateMirrorSlot(s32 slot);
+    void PublishControllerState(s32 slot, const SwitchInputReport *report, bool forwarded);
+
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
+
+namespace ams::controller {
+
+    // Carries reports for a controller that isn't attached through the Bluetooth stack. Reports are exchanged in the format the
+    // controller uses over Bluetooth, so the controller drivers don't need to know how the device is actually connected
+    class ControllerTransport {
+
+        public:
+            virtual ~ControllerTransport() { }
+
+            virtual Result WriteDataReport(const bluetooth::HidReport *report) = 0;
+            virtual Result SetReport(BtdrvBluetoothHhReportType type, const bluetooth::HidReport *report) = 0;
+            virtual Result GetReport(u8 id, BtdrvBluetoothHhReportType type, bluetooth::HidReport *out_report) = 0;
+
+    };
+
+}
@@ -14,7 +14,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "dualsense_controller.hpp"
+#include "controller_device_cache.hpp"
 #include "../mcmitm_config.hpp"
+#include "../async/async.hpp"
+#include "../utils/utils_crc32.hpp"
 #include <stratosphere.hpp>
 
 namespace ams::controller {
@@ -65,7 +68,11 @@ namespace ams::controller {
         constexpr u8 Step = 4;
         constinit const u8 LedBrightnessMultipliers[] = { 0, 1, 1 * Step, 2 * Step, 3 * Step, 4 * Step, 5 * Step, 6 * Step, 7 * Step, 8 * Step };
 
-        constexpr u32 CrcSeed = 0x8C36CCAE; // CRC32 of {0xa2, 0x31} bytes at beginning of output report
+        constexpr u32 CrcSeed = utils::Crc32::ComputeSeed({ 0xa2, 0x31 });  // CRC32 of bytes at beginning of output report
+
+        u16 GetFirmwareVersion(const DualsenseVersionInfo *version_info) {
+            return *reinterpret_cast<const u16 *>(&version_info->data[43]);
+        }
 
     }
 
@@ -73,11 +80,25 @@ namespace ams::controller {
         R_TRY(this->PushRumbleLedState());
         R_TRY(EmulatedSwitchController::Initialize());
 
-        // Request controller firmware version info
+        // Request controller firmware version info. This selects the player LED layout and the cached calibration to use
         R_TRY(this->GetVersionInfo(&m_version_info));
 
-        // Request motion calibration data from DualSense
-        R_TRY(this->GetCalibrationData(&m_motion_calibration));
+        // Use cached motion calibration if we have it for this firmware, and only refresh it from the controller in the background
+        DualsenseImuCalibrationData calibration;
+        if (R_SUCCEEDED(DeviceCache(m_address, m_id).Load(&calibration, sizeof(calibration), GetFirmwareVersion(&m_version_info)))) {
+            m_motion_calibration = calibration;
+
+            // The controller may be removed before the refresh runs, so only hold a weak reference to it until then
+            async::QueueWork([controller = this->weak_from_this()]() -> Result {
+                if (auto locked = controller.lock()) {
+                    R_RETURN(std::static_pointer_cast<DualsenseController>(locked)->RefreshDeviceCache(true));
+                }
+
+                R_SUCCEED();
+            });
+        } else {
+            R_TRY(this->RefreshDeviceCache(false));
+        }
 
         auto config = mitm::GetGlobalConfig();
         m_lightbar_brightness = config->misc.dualsense_lightbar_brightness;
@@ -100,7 +121,7 @@ namespace ams::controller {
     Result DualsenseController::SetPlayerLed(u8 led_mask) {
         SwitchPlayerNumber player_number = LedMaskToPlayerNumber(led_mask);
 
-        u16 fw_version = *reinterpret_cast<u16 *>(&m_version_info.data[43]);
+        u16 fw_version = GetFirmwareVersion(&m_version_info);
 
         auto config = mitm::GetGlobalConfig();
         if (!config->misc.dualsense_enable_player_leds || (player_number == SwitchPlayerNumber_Unknown)) {
@@ -200,13 +221,16 @@ namespace ams::controller {
             }
         }
 
-        m_accel.x = -src->input0x31.acc_z / float(m_motion_calibration.acc.z_max);
-        m_accel.y = -src->input0x31.acc_x / float(m_motion_calibration.acc.x_max);
-        m_accel.z =  src->input0x31.acc_y / float(m_motion_calibration.acc.y_max);
+        // Skip IMU conversion while the console has motion sensors disabled
+        if (m_motion_active) {
+            m_accel.x = -src->input0x31.acc_z / float(m_motion_calibration.acc.z_max);
+            m_accel.y = -src->input0x31.acc_x / float(m_motion_calibration.acc.x_max);
+            m_accel.z =  src->input0x31.acc_y / float(m_motion_calibration.acc.y_max);
 
-        m_gyro.x = -(float(src->input0x31.vel_z) - m_motion_calibration.gyro.roll_bias)  / ((m_motion_calibration.gyro.roll_max  - m_motion_calibration.gyro.roll_bias)  / m_motion_calibration.gyro.speed_max);
-        m_gyro.y = -(float(src->input0x31.vel_x) - m_motion_calibration.gyro.pitch_bias) / ((m_motion_calibration.gyro.pitch_max - m_motion_calibration.gyro.pitch_bias) / m_motion_calibration.gyro.speed_max);
-        m_gyro.z =  (float(src->input0x31.vel_y) - m_motion_calibration.gyro.yaw_bias) / ((m_motion_calibration.gyro.yaw_max - m_motion_calibration.gyro.yaw_bias) / m_motion_calibration.gyro.speed_max);
+            m_gyro.x = -(float(src->input0x31.vel_z) - m_motion_calibration.gyro.roll_bias)  / ((m_motion_calibration.gyro.roll_max  - m_motion_calibration.gyro.roll_bias)  / m_motion_calibration.gyro.speed_max);
+            m_gyro.y = -(float(src->input0x31.vel_x) - m_motion_calibration.gyro.pitch_bias) / ((m_motion_calibration.gyro.pitch_max - m_motion_calibration.gyro.pitch_bias) / m_motion_calibration.gyro.speed_max);
+            m_gyro.z =  (float(src->input0x31.vel_y) - m_motion_calibration.gyro.yaw_bias) / ((m_motion_calibration.gyro.yaw_max - m_motion_calibration.gyro.yaw_bias) / m_motion_calibration.gyro.speed_max);
+        }
     }
 
     void DualsenseController::MapButtons(const DualsenseButtonData *buttons) {
@@ -241,6 +265,29 @@ namespace ams::controller {
         m_buttons.home    = buttons->ps;
     }
 
+    Result DualsenseController::RefreshDeviceCache(bool cached) {
+        // Request motion calibration data from DualSense
+        DualsenseImuCalibrationData calibration;
+        R_TRY(this->GetCalibrationData(&calibration));
+
+        {
+            // Calibration is read by the input report handler
+            std::scoped_lock lk(m_input_mutex);
+
+            // Avoid rewriting the cache file if nothing has changed
+            if (cached && (std::memcmp(&calibration, &m_motion_calibration, sizeof(m_motion_calibration)) == 0)) {
+                R_SUCCEED();
+            }
+
+            m_motion_calibration = calibration;
+        }
+
+        // Failing to update the cache file shouldn't prevent the controller from being used
+        static_cast<void>(DeviceCache(m_address, m_id).Store(&calibration, sizeof(calibration), GetFirmwareVersion(&m_version_info)));
+
+        R_SUCCEED();
+    }
+
     Result DualsenseController::GetVersionInfo(DualsenseVersionInfo *version_info) {
         bluetooth::HidReport output;
         R_TRY(this->GetReport(0x20, BtdrvBluetoothHhReportType_Feature, &output));
@@ -281,7 +328,7 @@ namespace ams::controller {
         report.output0x31.data[45] = m_lightbar_colour.r;
         report.output0x31.data[46] = m_lightbar_colour.g;
         report.output0x31.data[47] = m_lightbar_colour.b;
-        report.output0x31.crc = crc32CalculateWithSeed(CrcSeed, report.output0x31.data, sizeof(report.output0x31.data));
+        report.output0x31.crc = utils::Crc32::Calculate(report.output0x31.data, sizeof(report.output0x31.data), CrcSeed);
 
         m_output_report.size = sizeof(report.output0x31) + sizeof(report.id);
         std::memcpy(m_output_report.data, &report, m_output_report.size);
@@ -101,6 +101,19 @@ namespace ams::controller {
         u32 crc;
     } PACKED;
 
+    struct DualsenseFeatureReport0x09 {
+        bluetooth::Address address;         // Little endian
+        u8 _unk0[3];
+        bluetooth::Address host_address;    // Little endian
+        u8 _unk1[4];
+    } PACKED;
+
+    struct DualsenseFeatureReport0x0a {
+        bluetooth::Address host_address;    // Little endian
+        u8 link_key[0x10];
+        u8 _unk0[4];
+    } PACKED;
+
     struct DualsenseFeatureReport0x20 {
         DualsenseVersionInfo version_info;
     } PACKED;
@@ -150,6 +163,8 @@ namespace ams::controller {
         u8 id;
         union {
             DualsenseFeatureReport0x05 feature0x05;
+            DualsenseFeatureReport0x09 feature0x09;
+            DualsenseFeatureReport0x0a feature0x0a;
             DualsenseFeatureReport0x20 feature0x20;
             DualsenseOutputReport0x31 output0x31;
             DualsenseInputReport0x01 input0x01;
@@ -185,6 +200,7 @@ namespace ams::controller {
 
             void MapButtons(const DualsenseButtonData *buttons);
 
+            Result RefreshDeviceCache(bool cached);
             Result GetVersionInfo(DualsenseVersionInfo *version_info);
             Result GetCalibrationData(DualsenseImuCalibrationData *calibration);
             Result PushRumbleLedState();
@@ -15,7 +15,6 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "dualshock3_controller.hpp"
-#include "../bluetooth_mitm/bluetooth/bluetooth_core.hpp"
 #include "../mcmitm_config.hpp"
 #include <stratosphere.hpp>
 #include <cstdlib>
@@ -30,10 +29,6 @@ namespace ams::controller {
             Dualshock3LedMode_Hybrid = 2,
         };
 
-        constexpr const char Ds3DeviceName[] = "PLAYSTATION(R)3 Controller";
-        constexpr u16 Ds3VendorId = 0x054c;
-        constexpr u16 Ds3ProductId = 0x0268;
-
         constexpr u8 TriggerMax = UINT8_MAX;
         constexpr float AccelScaleFactor = 1 / 113.0f;
 
@@ -41,147 +36,6 @@ namespace ams::controller {
         constinit const u8 LedConfig[] = { 0xff, 0x27, 0x10, 0x00, 0x32 };
         constinit const u8 PlayerLedPatterns[] = { 0b1000, 0b1100, 0b1110, 0b1111, 0b1001, 0b0101, 0b1101, 0b0110 };
 
-        alignas(os::MemoryPageSize) constinit u8 g_usb_buffer[0x1000];
-
-        constinit const UsbHsInterfaceFilter g_interface_filter = {
-            .Flags = UsbHsInterfaceFilterFlags_idVendor | UsbHsInterfaceFilterFlags_idProduct | UsbHsInterfaceFilterFlags_bInterfaceClass,
-            .idVendor = Ds3VendorId,
-            .idProduct = Ds3ProductId,
-            .bInterfaceClass = USB_CLASS_HID,
-        };
-
-        Result SetMasterAddress(UsbHsClientIfSession *if_session, const BtdrvAddress *address) {
-            const struct {
-                u8 unk1;
-                u8 unk2;
-                BtdrvAddress address;
-            } data = {0x01, 0x00, *address};
-
-            std::memcpy(&g_usb_buffer, &data, sizeof(data));
-
-            u32 rx_size = 0;
-            R_TRY(usbHsIfCtrlXfer(if_session,
-                USB_ENDPOINT_OUT | (0x01 << 5) | 0x01,
-                USB_REQUEST_SET_CONFIGURATION,
-                0x3f5,
-                0,
-                sizeof(data),
-                &g_usb_buffer,
-                &rx_size
-            ));
-
-            R_SUCCEED();
-        }
-
-        Result GetSlaveAddress(UsbHsClientIfSession *if_session, BtdrvAddress *address) {
-            u32 tx_size = 0;
-            R_TRY(usbHsIfCtrlXfer(if_session,
-                USB_ENDPOINT_IN | (0x01 << 5) | 0x01,
-                USB_REQUEST_CLEAR_FEATURE,
-                0x3f2,
-                0,
-                18,
-                &g_usb_buffer,
-                &tx_size
-            ));
-
-            *address = *reinterpret_cast<BtdrvAddress *>(&g_usb_buffer[4]);
-
-            R_SUCCEED();
-        }
-
-        Result TrustDevice(const BtdrvAddress *address) {
-            SetSysBluetoothDevicesSettings device = {};
-            device.addr = *address;
-            device.class_of_device = {0x00, 0x05, 0x08};
-            device.link_key_present = false;
-            device.trusted_services = 0x100000;
-            device.vid = Ds3VendorId;
-            device.pid = Ds3ProductId;
-            device.sub_class = 0x08;
-            device.attribute_mask = 0xff;
-
-            if (hos::GetVersion() < hos::Version_13_0_0) {
-                std::strncpy(device.name.name, Ds3DeviceName, sizeof(device.name));
-            }
-            else {
-                std::strncpy(device.name2, Ds3DeviceName, sizeof(device.name2));
-            }
-
-            R_RETURN(btdrvAddPairedDeviceInfo(&device));
-        }
-
-        void SignalBondComplete(const BtdrvAddress *address) {
-            if (hos::GetVersion() < hos::Version_9_0_0) {
-                const struct {
-                    BtdrvAddress addr;
-                    u8 pad[2];
-                    u32 status;
-                    u32 type;
-                } bond_event = { *address, {0}, 0,  BtdrvConnectionEventType_Suspended };
-                
-                bluetooth::core::SignalFakeEvent(BtdrvEventTypeOld_Connection, &bond_event, sizeof(bond_event));
-            } else if (hos::GetVersion() < hos::Version_12_0_0) {
-                const struct {
-                    u32 status;
-                    BtdrvAddress addr;
-                    u8 pad[2];
-                    u32 type;
-                } bond_event = { 0, *address, {0}, BtdrvConnectionEventType_Suspended };
-
-                bluetooth::core::SignalFakeEvent(BtdrvEventTypeOld_Connection, &bond_event, sizeof(bond_event));
-            } else {
-                const struct {
-                    u32 type;
-                    BtdrvAddress addr;
-                    u8 reserved[0xfe];
-                } bond_event = { BtdrvConnectionEventType_Suspended, *address, {0} };
-
-                bluetooth::core::SignalFakeEvent(BtdrvEventType_Connection, &bond_event, sizeof(bond_event));
-            }
-        }
-
-    }
-
-    const UsbHsInterfaceFilter *Dualshock3Controller::GetUsbInterfaceFilter() {
-        return &g_interface_filter;
-    }
-
-    bool Dualshock3Controller::UsbIdentify(UsbHsInterface *iface) {
-        return (iface->device_desc.idVendor == Ds3VendorId) && (iface->device_desc.idProduct == Ds3ProductId);
-    }
-
-    Result Dualshock3Controller::UsbPair(UsbHsInterface *iface) {
-        // Acquire usb:hs client interface session
-        UsbHsClientIfSession if_session;
-        R_TRY(usbHsAcquireUsbIf(&if_session, iface));
-
-        // Close session on function exit
-        ON_SCOPE_EXIT {
-            if (usbHsIfIsActive(&if_session)) {
-                usbHsIfClose(&if_session);
-            }
-        };
-
-        // Fetch the console bluetooth address
-        BtdrvAdapterProperty property;
-        R_TRY(btdrvGetAdapterProperty(BtdrvAdapterPropertyType_Address, &property));
-
-        // Set the console address as the master on the DS3
-        BtdrvAddress master_address = *reinterpret_cast<BtdrvAddress *>(property.data);
-        R_TRY(SetMasterAddress(&if_session, &master_address));
-
-        // Get the address of the DS3
-        BtdrvAddress slave_address;
-        R_TRY(GetSlaveAddress(&if_session, &slave_address));
-
-        // Add DS3 to list of trusted devices
-        R_TRY(TrustDevice(&slave_address));
-        
-        // Signal fake bonding success event for btm
-        SignalBondComplete(&slave_address);
-
-        R_SUCCEED();
     }
 
     Result Dualshock3Controller::Initialize() {
@@ -270,9 +124,12 @@ namespace ams::controller {
 
         m_buttons.home = src->input0x01.buttons.ps;
 
-        m_accel.x = -AccelScaleFactor * (511 - util::SwapEndian(src->input0x01.accel_y));
-        m_accel.y = -AccelScaleFactor * (util::SwapEndian(src->input0x01.accel_x) - 511);
-        m_accel.z =  AccelScaleFactor * (511 - util::SwapEndian(src->input0x01.accel_z));
+        // Skip IMU conversion while the console has motion sensors disabled
+        if (m_motion_active) {
+            m_accel.x = -AccelScaleFactor * (511 - util::SwapEndian(src->input0x01.accel_y));
+            m_accel.y = -AccelScaleFactor * (util::SwapEndian(src->input0x01.accel_x) - 511);
+            m_accel.z =  AccelScaleFactor * (511 - util::SwapEndian(src->input0x01.accel_z));
+        }
     }
 
     Result Dualshock3Controller::SendEnablePayload() {
@@ -97,10 +97,6 @@ namespace ams::controller {
                 {0x054c, 0x0268},   // Official Dualshock3
             };
 
-            static const UsbHsInterfaceFilter *GetUsbInterfaceFilter();
-            static bool UsbIdentify(UsbHsInterface *iface);
-            static Result UsbPair(UsbHsInterface *iface);
-
         public:
             Dualshock3Controller(bluetooth::Address address, HardwareID id) : EmulatedSwitchController(address, id) { }
 
@@ -14,7 +14,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "dualshock4_controller.hpp"
+#include "controller_device_cache.hpp"
 #include "../mcmitm_config.hpp"
+#include "../async/async.hpp"
+#include "../utils/utils_crc32.hpp"
 #include <switch.h>
 #include <stratosphere.hpp>
 
@@ -43,20 +46,47 @@ namespace ams::controller {
         constexpr u8 Step = 4;
         constinit const u8 LedBrightnessMultipliers[] = { 0, 1, 1 * Step, 2 * Step, 3 * Step, 4 * Step, 5 * Step, 6 * Step, 7 * Step, 8 * Step };
 
-        constexpr u32 CrcSeed = 0xB758EC66;  // CRC32 of {0xa2, 0x11} bytes at beginning of output report
+        constexpr u32 CrcSeed = utils::Crc32::ComputeSeed({ 0xa2, 0x11 });  // CRC32 of bytes at beginning of output report
+
+        // Report rate values are the report interval in milliseconds, with 0 meaning as fast as possible
+        constexpr u16 ReportRateToHz(Dualshock4ReportRate rate) {
+            return 1000 / std::max<u16>(rate, Dualshock4ReportRate_1000Hz);
+        }
+
+        constexpr Dualshock4ReportRate HzToReportRate(u16 hz) {
+            const u16 interval = (1000 + hz / 2) / std::max<u16>(hz, 1);
+            return static_cast<Dualshock4ReportRate>(std::clamp<u16>(interval, Dualshock4ReportRate_1000Hz, Dualshock4ReportRate_62Hz));
+        }
 
     }
 
     Result Dualshock4Controller::Initialize() {
         auto config = mitm::GetGlobalConfig();
-        m_report_rate = static_cast<Dualshock4ReportRate>(config->misc.dualshock4_polling_rate);
+
+        mitm::PerformanceProfile profile;
+        mitm::GetActiveProfile(&profile);
+
+        m_report_rate = static_cast<Dualshock4ReportRate>(profile.dualshock4_polling_rate);
+        m_max_report_rate = m_report_rate;
         m_lightbar_brightness = config->misc.dualshock4_lightbar_brightness;
 
         R_TRY(this->PushRumbleLedState());
         R_TRY(EmulatedSwitchController::Initialize());
 
-        // Request motion calibration data from Dualshock4
-        if(R_FAILED(this->GetCalibrationData(&m_motion_calibration))) {
+        // Use cached motion calibration if we have it, and only refresh it from the controller in the background
+        Dualshock4ImuCalibrationData calibration;
+        if (R_SUCCEEDED(DeviceCache(m_address, m_id).Load(&calibration, sizeof(calibration)))) {
+            m_motion_calibration = calibration;
+
+            // The controller may be removed before the refresh runs, so only hold a weak reference to it until then
+            async::QueueWork([controller = this->weak_from_this()]() -> Result {
+                if (auto locked = controller.lock()) {
+                    R_RETURN(std::static_pointer_cast<Dualshock4Controller>(locked)->RefreshDeviceCache(true));
+                }
+
+                R_SUCCEED();
+            });
+        } else if (R_FAILED(this->RefreshDeviceCache(false))) {
             m_enable_motion = false;
         }
 
@@ -95,6 +125,45 @@ namespace ams::controller {
         R_RETURN(this->PushRumbleLedState());
     }
 
+    u16 Dualshock4Controller::GetReportRate() {
+        return ReportRateToHz(m_report_rate);
+    }
+
+    Result Dualshock4Controller::SetReportRate(u16 rate) {
+        // Never poll faster than the rate configured by the user
+        auto report_rate = HzToReportRate(rate);
+        if (report_rate <= m_max_report_rate) {
+            report_rate = m_max_report_rate;
+        }
+
+        if (report_rate == m_report_rate) {
+            R_SUCCEED();
+        }
+
+        m_report_rate = report_rate;
+
+        R_RETURN(this->PushRumbleLedState());
+    }
+
+    Result Dualshock4Controller::ApplyProfile(const mitm::PerformanceProfile *profile) {
+        R_TRY(EmulatedSwitchController::ApplyProfile(profile));
+
+        m_max_report_rate = static_cast<Dualshock4ReportRate>(profile->dualshock4_polling_rate);
+
+        // With adaptive polling the rate is raised again as needed by the report rate manager
+        if (mitm::GetGlobalConfig()->misc.dualshock4_adaptive_polling_rate && (m_report_rate > m_max_report_rate)) {
+            R_SUCCEED();
+        }
+
+        if (m_report_rate == m_max_report_rate) {
+            R_SUCCEED();
+        }
+
+        m_report_rate = m_max_report_rate;
+
+        R_RETURN(this->PushRumbleLedState());
+    }
+
     void Dualshock4Controller::ProcessInputData(const bluetooth::HidReport *report) {
         auto ds4_report = reinterpret_cast<const Dualshock4ReportData *>(&report->data);
 
@@ -169,13 +238,16 @@ namespace ams::controller {
             m_buttons.capture = 0;
         }
 
-        m_accel.x = -src->input0x11.acc_z / float(m_motion_calibration.acc.z_max);
-        m_accel.y = -src->input0x11.acc_x / float(m_motion_calibration.acc.x_max);
-        m_accel.z =  src->input0x11.acc_y / float(m_motion_calibration.acc.y_max);
+        // Skip IMU conversion while the console has motion sensors disabled
+        if (m_motion_active) {
+            m_accel.x = -src->input0x11.acc_z / float(m_motion_calibration.acc.z_max);
+            m_accel.y = -src->input0x11.acc_x / float(m_motion_calibration.acc.x_max);
+            m_accel.z =  src->input0x11.acc_y / float(m_motion_calibration.acc.y_max);
 
-        m_gyro.x = -(src->input0x11.vel_z - m_motion_calibration.gyro.roll_bias)  / ((m_motion_calibration.gyro.roll_max  - m_motion_calibration.gyro.roll_bias)  / m_motion_calibration.gyro.speed_max);
-        m_gyro.y = -(src->input0x11.vel_x - m_motion_calibration.gyro.pitch_bias) / ((m_motion_calibration.gyro.pitch_max - m_motion_calibration.gyro.pitch_bias) / m_motion_calibration.gyro.speed_max);
-        m_gyro.z =  (src->input0x11.vel_y - m_motion_calibration.gyro.yaw_bias)   / ((m_motion_calibration.gyro.yaw_max   - m_motion_calibration.gyro.yaw_bias)   / m_motion_calibration.gyro.speed_max);
+            m_gyro.x = -(src->input0x11.vel_z - m_motion_calibration.gyro.roll_bias)  / ((m_motion_calibration.gyro.roll_max  - m_motion_calibration.gyro.roll_bias)  / m_motion_calibration.gyro.speed_max);
+            m_gyro.y = -(src->input0x11.vel_x - m_motion_calibration.gyro.pitch_bias) / ((m_motion_calibration.gyro.pitch_max - m_motion_calibration.gyro.pitch_bias) / m_motion_calibration.gyro.speed_max);
+            m_gyro.z =  (src->input0x11.vel_y - m_motion_calibration.gyro.yaw_bias)   / ((m_motion_calibration.gyro.yaw_max   - m_motion_calibration.gyro.yaw_bias)   / m_motion_calibration.gyro.speed_max);
+        }
     }
 
     void Dualshock4Controller::MapButtons(const Dualshock4ButtonData *buttons) {
@@ -211,6 +283,29 @@ namespace ams::controller {
         m_buttons.home    = buttons->ps;
     }
 
+    Result Dualshock4Controller::RefreshDeviceCache(bool cached) {
+        // Request motion calibration data from Dualshock4
+        Dualshock4ImuCalibrationData calibration;
+        R_TRY(this->GetCalibrationData(&calibration));
+
+        {
+            // Calibration is read by the input report handler
+            std::scoped_lock lk(m_input_mutex);
+
+            // Avoid rewriting the cache file if nothing has changed
+            if (cached && (std::memcmp(&calibration, &m_motion_calibration, sizeof(m_motion_calibration)) == 0)) {
+                R_SUCCEED();
+            }
+
+            m_motion_calibration = calibration;
+        }
+
+        // Failing to update the cache file shouldn't prevent the controller from being used
+        static_cast<void>(DeviceCache(m_address, m_id).Store(&calibration, sizeof(calibration)));
+
+        R_SUCCEED();
+    }
+
     Result Dualshock4Controller::GetVersionInfo(Dualshock4VersionInfo *version_info) {
         bluetooth::HidReport output;
         R_TRY(this->GetReport(0x06, BtdrvBluetoothHhReportType_Feature, &output));
@@ -245,7 +340,7 @@ namespace ams::controller {
         report.output0x11.data[7] = m_lightbar_colour.r;
         report.output0x11.data[8] = m_lightbar_colour.g;
         report.output0x11.data[9] = m_lightbar_colour.b;
-        report.output0x11.crc = crc32CalculateWithSeed(CrcSeed, report.output0x11.data, sizeof(report.output0x11.data));
+        report.output0x11.crc = utils::Crc32::Calculate(report.output0x11.data, sizeof(report.output0x11.data), CrcSeed);
 
         m_output_report.size = sizeof(report.output0x11) + sizeof(report.id);
         std::memcpy(m_output_report.data, &report, m_output_report.size);
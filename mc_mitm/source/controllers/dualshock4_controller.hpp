@@ -128,6 +128,17 @@ namespace ams::controller {
         u32 crc;
     } PACKED;
 
+    struct Dualshock4FeatureReport0x12 {
+        bluetooth::Address address;         // Little endian
+        u8 _unk0[3];
+        bluetooth::Address host_address;    // Little endian
+    } PACKED;
+
+    struct Dualshock4FeatureReport0x13 {
+        bluetooth::Address host_address;    // Little endian
+        u8 link_key[0x10];
+    } PACKED;
+
     struct Dualshock4FeatureReport0xa3 {
         Dualshock4VersionInfo version_info;
     } PACKED;
@@ -184,6 +195,8 @@ namespace ams::controller {
         union {
             Dualshock4FeatureReport0x05 feature0x05;
             Dualshock4FeatureReport0x06 feature0x06;
+            Dualshock4FeatureReport0x12 feature0x12;
+            Dualshock4FeatureReport0x13 feature0x13;
             Dualshock4FeatureReport0xa3 feature0xa3;
             Dualshock4OutputReport0x11 output0x11;
             Dualshock4InputReport0x01 input0x01;
@@ -205,6 +218,7 @@ namespace ams::controller {
 
             Dualshock4Controller(bluetooth::Address address, HardwareID id) : EmulatedSwitchController(address, id)
             , m_report_rate(Dualshock4ReportRate_125Hz)
+            , m_max_report_rate(Dualshock4ReportRate_125Hz)
             , m_lightbar_colour({0, 0, 0})
             , m_lightbar_brightness(0)
             , m_rumble_state({0, 0}) { }
@@ -215,6 +229,11 @@ namespace ams::controller {
             Result SetPlayerLed(u8 led_mask);
             Result SetLightbarColour(RGBColour colour);
 
+            u16 GetReportRate();
+            Result SetReportRate(u16 rate);
+
+            Result ApplyProfile(const mitm::PerformanceProfile *profile) override;
+
             void ProcessInputData(const bluetooth::HidReport *report) override;
 
         private:
@@ -223,11 +242,13 @@ namespace ams::controller {
 
             void MapButtons(const Dualshock4ButtonData *buttons);
             
+            Result RefreshDeviceCache(bool cached);
             Result GetVersionInfo(Dualshock4VersionInfo *version_info);
             Result GetCalibrationData(Dualshock4ImuCalibrationData *calibration);
             Result PushRumbleLedState();
 
             Dualshock4ReportRate m_report_rate;
+            Dualshock4ReportRate m_max_report_rate;
             RGBColour m_lightbar_colour;
             u8 m_lightbar_brightness;
             Dualshock4RumbleData m_rumble_state;
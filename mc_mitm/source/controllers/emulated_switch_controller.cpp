@@ -26,6 +26,53 @@ namespace ams::controller {
             return utils::Crc8<7>::Calculate(data, size);
         }
 
+        constexpr SwitchInputReportTemplate MakeInputReportTemplate(u8 id, size_t size, bool has_motion) {
+            SwitchInputReportTemplate report_template = { .size = static_cast<u16>(size), .has_motion = has_motion, .data = {} };
+            report_template.data[offsetof(SwitchInputReport, id)] = id;
+            return report_template;
+        }
+
+        // The 0x21 layout carries a command response where the other layouts carry motion data
+        constexpr auto InputReportTemplate0x21 = MakeInputReportTemplate(0x21, offsetof(SwitchInputReport, type0x21) + sizeof(SwitchInputReport::type0x21), false);
+        constexpr auto InputReportTemplate0x30 = MakeInputReportTemplate(0x30, offsetof(SwitchInputReport, type0x30) + sizeof(SwitchInputReport::type0x30), true);
+
+        // Standard input reports in 0x31 mode carry an empty MCU response, which is constant along with its CRC
+        constexpr auto InputReportTemplate0x31 = []() {
+            auto report_template = MakeInputReportTemplate(0x31, offsetof(SwitchInputReport, type0x31) + sizeof(SwitchInputReport::type0x31), true);
+
+            constexpr size_t McuResponseOffset = offsetof(SwitchInputReport, type0x31.mcu_response);
+            report_template.data[McuResponseOffset + offsetof(SwitchMcuResponse, command)] = McuCommand_EmptyAwaitingCmd;
+            report_template.data[offsetof(SwitchInputReport, type0x31.crc)] = utils::Crc8<7>::Calculate(std::span<const u8>(&report_template.data[McuResponseOffset], sizeof(SwitchMcuResponse)));
+
+            return report_template;
+        }();
+
+        // Modes without a layout of their own are sent with the 0x30 layout
+        constexpr const SwitchInputReportTemplate *GetInputReportTemplate(u8 mode) {
+            switch (mode) {
+                case 0x21:
+                    return &InputReportTemplate0x21;
+                case 0x31:
+                    return &InputReportTemplate0x31;
+                default:
+                    return &InputReportTemplate0x30;
+            }
+        }
+
+        constexpr u16 StickActivityThreshold = 0x200;
+
+        bool IsStickDeflected(SwitchAnalogStick &stick) {
+            return (std::abs(stick.GetX() - SwitchAnalogStick::Center) > StickActivityThreshold) ||
+                   (std::abs(stick.GetY() - SwitchAnalogStick::Center) > StickActivityThreshold);
+        }
+
+        // Unchanged input reports are still forwarded at this interval when coalescing, so battery and connection info stays current
+        constexpr TimeSpan InputReportKeepAliveInterval = TimeSpan::FromMilliSeconds(100);
+
+        bool IsMotorIdle(const SwitchVibrationValues &motor) {
+            return (motor.low_band_amp == 0.0f) && (motor.high_band_amp == 0.0f);
+        }
+
     }
 
     EmulatedSwitchController::EmulatedSwitchController(bluetooth::Address address, HardwareID id)
@@ -35,13 +82,23 @@ namespace ams::controller {
     , m_battery(BATTERY_MAX)
     , m_led_pattern(0)
     , m_input_report_mode(0x30)
+    , m_input_report_template(GetInputReportTemplate(0x30))
+    , m_input_report_prepared(false)
+    , m_motion_active(false)
+    , m_sensor_sleep_mode(SensorSleepType_Inactive)
+    , m_rumble_idle(true)
     , m_mcu_mode(McuMode_Suspended) {
         this->ClearControllerState();
 
         auto config = mitm::GetGlobalConfig();
         m_enable_rumble = config->general.enable_rumble;
-        m_enable_motion = config->general.enable_motion;
         m_trigger_threshold = config->misc.analog_trigger_activation_threshold / 100.0;
+
+        std::memset(m_last_forwarded_state, 0, sizeof(m_last_forwarded_state));
+
+        mitm::PerformanceProfile profile;
+        mitm::GetActiveProfile(&profile);
+        this->LoadProfileSettings(&profile);
     };
 
     Result EmulatedSwitchController::Initialize() {
@@ -56,6 +113,26 @@ namespace ams::controller {
         R_SUCCEED();
     }
 
+    Result EmulatedSwitchController::ApplyProfile(const mitm::PerformanceProfile *profile) {
+        std::scoped_lock lk(m_input_mutex);
+
+        const bool motion_changed = profile->enable_motion != m_enable_motion;
+        this->LoadProfileSettings(profile);
+
+        if (motion_changed) {
+            R_TRY(this->UpdateMotionState());
+        }
+
+        R_SUCCEED();
+    }
+
+    void EmulatedSwitchController::LoadProfileSettings(const mitm::PerformanceProfile *profile) {
+        m_enable_motion = profile->enable_motion;
+        m_rumble_interval = profile->rumble_rate_limit > 0 ? TimeSpan::FromMicroSeconds(1'000'000 / profile->rumble_rate_limit) : TimeSpan(0);
+        m_input_report_interval = TimeSpan::FromMilliSeconds(profile->input_report_interval);
+        m_coalesce_input_reports = profile->coalesce_input_reports;
+    }
+
     void EmulatedSwitchController::ClearControllerState() {
         std::memset(&m_buttons, 0, sizeof(m_buttons));
         m_left_stick.SetData(SwitchAnalogStick::Center, SwitchAnalogStick::Center);
@@ -70,31 +147,71 @@ namespace ams::controller {
         this->ProcessInputData(report);
 
         auto input_report = reinterpret_cast<SwitchInputReport *>(m_input_report.data);
-        input_report->id = m_input_report_mode;
+
+        // Keep track of when the controller was last in use. The input report buffer still holds the previous button state at this point
+        if ((std::memcmp(&input_report->buttons, &m_buttons, sizeof(m_buttons)) != 0) || IsStickDeflected(m_left_stick) || IsStickDeflected(m_right_stick)) {
+            m_last_activity_tick.store(os::GetSystemTick().GetInt64Value(), std::memory_order_relaxed);
+        }
+
+        // The constant sections only need restoring after a mode change or a faked response has overwritten them
+        if (!m_input_report_prepared) {
+            this->PrepareInputReport(m_input_report_template);
+            input_report->id = m_input_report_mode;
+            m_input_report_prepared = true;
+        }
+
+        this->UpdateInputReportState();
+
+        // Motion data sits at the same offset in the 0x30 and 0x31 layouts, but would overwrite the command response in 0x21 mode
+        if (m_input_report_template->has_motion) {
+            m_motion_packer->PackData(&input_report->type0x30.motion_data, m_accel, m_gyro);
+        }
+    }
+
+    void EmulatedSwitchController::PrepareInputReport(const SwitchInputReportTemplate *report_template) {
+        // Timer keeps counting across report modes
+        auto input_report = reinterpret_cast<SwitchInputReport *>(m_input_report.data);
+        const u8 timer = input_report->timer;
+
+        std::memcpy(m_input_report.data, report_template->data, report_template->size);
+        m_input_report.size = report_template->size;
+
+        input_report->timer = timer;
+    }
+
+    void EmulatedSwitchController::UpdateInputReportState() {
+        auto input_report = reinterpret_cast<SwitchInputReport *>(m_input_report.data);
         input_report->timer = (input_report->timer + 1) & 0xff;
         input_report->conn_info = (0 << 1) | m_ext_power;
         input_report->battery = m_battery | m_charging;
         input_report->buttons = m_buttons;
         input_report->left_stick = m_left_stick;
-        input_report->right_stick = m_right_stick; 
+        input_report->right_stick = m_right_stick;
+    }
 
-        const SwitchMcuResponse empty_mcu_response = {
-          .command = McuCommand_EmptyAwaitingCmd,
-          .data = {},
-        };
+    bool EmulatedSwitchController::ShouldForwardInputReport(const SwitchInputReport *report) {
+        // Command responses must always reach the console
+        if (report->id == 0x21) {
+            return true;
+        }
 
-        switch (m_input_report_mode) {
-            case 0x31:
-                m_motion_packer->PackData(&input_report->type0x31.motion_data, m_accel, m_gyro);
-                std::memcpy(&input_report->type0x31.mcu_response, &empty_mcu_response, sizeof(empty_mcu_response));
-                input_report->type0x31.crc = ComputeCrc8(&empty_mcu_response, sizeof(SwitchMcuResponse));
-                m_input_report.size = offsetof(SwitchInputReport, type0x31) + sizeof(input_report->type0x31);
-                break;
-            default:
-                m_motion_packer->PackData(&input_report->type0x30.motion_data, m_accel, m_gyro);
-                m_input_report.size = offsetof(SwitchInputReport, type0x30) + sizeof(input_report->type0x30);
-                break;
+        const auto now = os::GetSystemTick();
+        const auto elapsed = os::ConvertToTimeSpan(now - m_last_forwarded_tick);
+        if (elapsed < m_input_report_interval) {
+            return false;
+        }
+
+        // Buttons and sticks are laid out contiguously in the report
+        if (m_coalesce_input_reports && !m_motion_active && (elapsed < InputReportKeepAliveInterval)) {
+            if (std::memcmp(&report->buttons, m_last_forwarded_state, sizeof(m_last_forwarded_state)) == 0) {
+                return false;
+            }
         }
+
+        std::memcpy(m_last_forwarded_state, &report->buttons, sizeof(m_last_forwarded_state));
+        m_last_forwarded_tick = now;
+
+        return true;
     }
 
     Result EmulatedSwitchController::HandleOutputDataReport(const bluetooth::HidReport *report) {
@@ -123,6 +240,16 @@ namespace ams::controller {
         if (m_enable_rumble) {
             SwitchMotorData motor_data;
             if (m_rumble_handler.GetDecodedValues(encoded_motor_data, &motor_data)) {
+                // Drop updates arriving faster than the profile's rumble rate limit. Motors starting or stopping are never delayed
+                const bool idle = IsMotorIdle(motor_data.left_motor) && IsMotorIdle(motor_data.right_motor);
+                const auto now = os::GetSystemTick();
+                if ((idle == m_rumble_idle) && (os::ConvertToTimeSpan(now - m_last_rumble_tick) < m_rumble_interval)) {
+                    R_SUCCEED();
+                }
+
+                m_rumble_idle = idle;
+                m_last_rumble_tick = now;
+
                 R_TRY(this->SetVibration(&motor_data));
             }
         }
@@ -225,7 +352,12 @@ namespace ams::controller {
     }
 
     Result EmulatedSwitchController::HandleHidCommandSetDataFormat(const SwitchHidCommand *command) {
-        m_input_report_mode = command->set_data_format.id;
+        {
+            std::scoped_lock lk(m_input_mutex);
+            m_input_report_mode = command->set_data_format.id;
+            m_input_report_template = GetInputReportTemplate(m_input_report_mode);
+            m_input_report_prepared = false;
+        }
 
         const SwitchHidCommandResponse response = {
             .ack = 0x80,
@@ -480,46 +612,79 @@ namespace ams::controller {
     }
 
     Result EmulatedSwitchController::HandleHidCommandSensorSleep(const SwitchHidCommand* command) {
-        m_enable_motion = mitm::GetGlobalConfig()->general.enable_motion;
+        {
+            // Motion state is also read by the input report handler and changed by profile updates
+            std::scoped_lock lk(m_input_mutex);
+            m_sensor_sleep_mode = command->sensor_sleep.mode;
+
+            // The console must always receive an ack. If the controller couldn't be switched to the matching report format it simply keeps
+            // sending what it did before, which is harmless, and the switch is attempted again on the next motion state change
+            static_cast<void>(this->UpdateMotionState());
+        }
 
+        const SwitchHidCommandResponse response = {
+            .ack = 0x80,
+            .id = command->id
+        };
+
+        R_RETURN(this->FakeHidCommandResponse(&response));
+    }
+
+    // Must be called with m_input_mutex held
+    Result EmulatedSwitchController::UpdateMotionState() {
         GyroSensitivity gyro_sensitivity = m_motion_packer->GetGyroSensitivity();
         AccelSensitivity accel_sensitivity = m_motion_packer->GetAccelSensitivity();
 
         if (m_enable_motion) {
-            switch (command->sensor_sleep.mode) {
+            switch (m_sensor_sleep_mode) {
                 case SensorSleepType_Active:
-                    m_motion_packer = std::make_unique<StandardMotionPacker>();
+                    m_motion_packer = &m_standard_motion_packer;
                     break;
 
                 case SensorSleepType_ActiveDscaleMode1:
                 case SensorSleepType_ActiveDscaleMode2:
                 case SensorSleepType_ActiveDscaleMode3:
                 case SensorSleepType_ActiveDscaleMode4:
-                    m_motion_packer = std::make_unique<QuaternionMotionPacker>();
+                    m_quaternion_motion_packer = QuaternionMotionPacker();
+                    m_motion_packer = &m_quaternion_motion_packer;
                     break;
 
                 default:
-                    m_motion_packer = std::make_unique<NullMotionPacker>();
+                    m_motion_packer = &m_null_motion_packer;
                     break;
             }
         } else {
-            m_motion_packer = std::make_unique<NullMotionPacker>();
+            m_motion_packer = &m_null_motion_packer;
         }
 
         m_motion_packer->SetGyroSensitivity(gyro_sensitivity);
         m_motion_packer->SetAccelSensitivity(accel_sensitivity);
 
-        const SwitchHidCommandResponse response = {
-            .ack = 0x80,
-            .id = command->id
-        };
+        // Motion data is only converted from the controller's native format while the console has the IMU enabled.
+        // Controllers are also given the chance to switch to a lighter report format while it isn't needed
+        const bool motion_active = m_motion_packer != &m_null_motion_packer;
+        if (motion_active != m_motion_active) {
+            m_motion_active = motion_active;
+            if (!motion_active) {
+                std::memset(&m_accel, 0, sizeof(m_accel));
+                std::memset(&m_gyro, 0, sizeof(m_gyro));
+            }
 
-        R_RETURN(this->FakeHidCommandResponse(&response));
+            // Retry once before giving up, as output reports can occasionally fail while the link is busy
+            if (R_FAILED(this->SetMotionActive(motion_active))) {
+                R_TRY(this->SetMotionActive(motion_active));
+            }
+        }
+
+        R_SUCCEED();
     }
 
     Result EmulatedSwitchController::HandleHidCommandSensorConfig(const SwitchHidCommand *command) {
-        m_motion_packer->SetGyroSensitivity(command->sensor_config.gyro_sensitivity);
-        m_motion_packer->SetAccelSensitivity(command->sensor_config.accel_sensitivity);
+        {
+            std::scoped_lock lk(m_input_mutex);
+            m_motion_packer->SetGyroSensitivity(command->sensor_config.gyro_sensitivity);
+            m_motion_packer->SetAccelSensitivity(command->sensor_config.accel_sensitivity);
+        }
 
         const SwitchHidCommandResponse response = {
             .ack = 0x80,
@@ -544,17 +709,11 @@ namespace ams::controller {
         std::scoped_lock lk(m_input_mutex);
 
         auto input_report = reinterpret_cast<SwitchInputReport *>(m_input_report.data);
-        input_report->id = 0x21;
-        input_report->timer = (input_report->timer + 1) & 0xff;
-        input_report->conn_info = (0 << 1) | m_ext_power;
-        input_report->battery = m_battery | m_charging;
-        input_report->buttons = m_buttons;
-        input_report->left_stick = m_left_stick;
-        input_report->right_stick = m_right_stick;
-        input_report->vibrator = 0;
+        this->PrepareInputReport(&InputReportTemplate0x21);
+        this->UpdateInputReportState();
+        m_input_report_prepared = false;
 
         std::memcpy(&input_report->type0x21.hid_command_response, response, sizeof(SwitchHidCommandResponse));
-        m_input_report.size = offsetof(SwitchInputReport, type0x21) + sizeof(input_report->type0x21);
 
         // Write a fake response into the report buffer
         R_RETURN(bluetooth::hid::report::WriteHidDataReport(m_address, &m_input_report));
@@ -635,19 +794,13 @@ namespace ams::controller {
         std::scoped_lock lk(m_input_mutex);
 
         auto input_report = reinterpret_cast<SwitchInputReport *>(m_input_report.data);
-        input_report->id = 0x31;
-        input_report->timer = (input_report->timer + 1) & 0xff;
-        input_report->conn_info = (0 << 1) | m_ext_power;
-        input_report->battery = m_battery | m_charging;
-        input_report->buttons = m_buttons;
-        input_report->left_stick = m_left_stick;
-        input_report->right_stick = m_right_stick;
-        input_report->vibrator = 0;
+        this->PrepareInputReport(&InputReportTemplate0x31);
+        this->UpdateInputReportState();
+        m_input_report_prepared = false;
 
         m_motion_packer->PackData(&input_report->type0x31.motion_data, m_accel, m_gyro);
         std::memcpy(&input_report->type0x31.mcu_response, response, sizeof(SwitchMcuResponse));
         input_report->type0x31.crc = ComputeCrc8(response, sizeof(SwitchMcuResponse));
-        m_input_report.size = offsetof(SwitchInputReport, type0x31) + sizeof(input_report->type0x31);
 
         // Write a fake response into the report buffer
         R_RETURN(bluetooth::hid::report::WriteHidDataReport(m_address, &m_input_report));
@@ -15,10 +15,18 @@
  */
 #pragma once
 #include "switch_controller.hpp"
+#include "controller_report_layout.hpp"
 #include "virtual_spi_flash.hpp"
 
 namespace ams::controller {
 
+    // Input report prefilled with the sections that stay constant for a given report mode
+    struct SwitchInputReportTemplate {
+        u16 size;
+        bool has_motion;
+        u8 data[sizeof(SwitchInputReport)];
+    };
+
     class EmulatedSwitchController : public SwitchController {
 
         public:
@@ -27,19 +35,35 @@ namespace ams::controller {
 
             virtual Result Initialize();
             bool IsOfficialController() { return false; }
+            bool IsMotionActive() { return m_motion_active; }
+            os::Tick GetLastActivityTick() { return os::Tick(m_last_activity_tick.load(std::memory_order_relaxed)); }
+
+            Result ApplyProfile(const mitm::PerformanceProfile *profile) override;
 
             Result HandleOutputDataReport(const bluetooth::HidReport *report) override;
 
         protected:
             void ClearControllerState();
+            void LoadProfileSettings(const mitm::PerformanceProfile *profile);
             virtual Result SetVibration(const SwitchMotorData *motor_data) { AMS_UNUSED(motor_data); R_SUCCEED(); }
             virtual Result CancelVibration() { R_SUCCEED(); }
             virtual Result SetPlayerLed(u8 led_mask) { AMS_UNUSED(led_mask); R_SUCCEED(); }
+            virtual Result SetMotionActive(bool active) { AMS_UNUSED(active); R_SUCCEED(); }
 
             void UpdateControllerState(const bluetooth::HidReport *report) override;
+            bool ShouldForwardInputReport(const SwitchInputReport *report) override;
             virtual void ProcessInputData(const bluetooth::HidReport *report) { AMS_UNUSED(report); }
 
+            template <layout::ReportLayout Layout>
+            void MapReportLayout(const void *report) {
+                auto data = static_cast<const u8 *>(report);
+                layout::MapStick<Layout.left_stick>(data, &m_left_stick);
+                layout::MapStick<Layout.right_stick>(data, &m_right_stick);
+                layout::MapButtons<Layout>(data, m_trigger_threshold, &m_buttons);
+            }
+
             Result HandleRumbleData(const SwitchEncodedMotorData *enc_motor_data);
+            Result UpdateMotionState();
             Result HandleHidCommand(const SwitchHidCommand *command);
             Result HandleMcuCommand(const SwitchMcuCommand *command);
 
@@ -70,6 +94,9 @@ namespace ams::controller {
             Result FakeHidCommandResponse(const SwitchHidCommandResponse *response);
             Result FakeMcuResponse(const SwitchMcuResponse *response);
 
+            void PrepareInputReport(const SwitchInputReportTemplate *report_template);
+            void UpdateInputReportState();
+
             bool m_charging;
             bool m_ext_power;
             u8 m_battery;
@@ -82,15 +109,32 @@ namespace ams::controller {
             Vec3d<float> m_gyro;
 
             u8 m_input_report_mode;
+            const SwitchInputReportTemplate *m_input_report_template;
+            bool m_input_report_prepared;
 
             SwitchRumbleHandler m_rumble_handler;
-            std::unique_ptr<SwitchMotionPacker> m_motion_packer = std::make_unique<NullMotionPacker>();
+            NullMotionPacker m_null_motion_packer;
+            StandardMotionPacker m_standard_motion_packer;
+            QuaternionMotionPacker m_quaternion_motion_packer;
+            SwitchMotionPacker *m_motion_packer = &m_null_motion_packer;
 
             bool m_enable_rumble;
             bool m_enable_motion;
+            bool m_motion_active;
+            SensorSleepType m_sensor_sleep_mode;
+            std::atomic<s64> m_last_activity_tick = 0;
 
             float m_trigger_threshold;
 
+            TimeSpan m_rumble_interval;
+            os::Tick m_last_rumble_tick;
+            bool m_rumble_idle;
+
+            TimeSpan m_input_report_interval;
+            bool m_coalesce_input_reports;
+            os::Tick m_last_forwarded_tick;
+            u8 m_last_forwarded_state[sizeof(SwitchButtonData) + 2 * sizeof(SwitchAnalogStick)];
+
             McuModeType m_mcu_mode;
 
             VirtualSpiFlash m_virtual_memory;
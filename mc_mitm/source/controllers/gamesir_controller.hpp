@@ -110,6 +110,43 @@ namespace ams::controller {
         };
     } PACKED;
 
+    // Home is only present in report 0x03, but has always been read from 0x07 as well
+    constexpr layout::Button GamesirExtraButtons[] = {
+        { 1, 4, SwitchButtonBit_Home },
+    };
+
+    constexpr auto GamesirInputReport0x03Layout = []() {
+        layout::ReportLayout l;
+        l.SetSticks(offsetof(GamesirReportData, input0x03.left_stick), offsetof(GamesirReportData, input0x03.right_stick));
+        l.SetHat(offsetof(GamesirReportData, input0x03.dpad), GamesirDpad2_N);
+        l.AddButtons(offsetof(GamesirReportData, input0x03.buttons), layout::GenericGamepadButtons);
+        l.AddButtons(offsetof(GamesirReportData, input0x03.buttons), GamesirExtraButtons);
+        l.AddTrigger(offsetof(GamesirReportData, input0x03.right_trigger), SwitchButtonBit_ZR);
+        l.AddTrigger(offsetof(GamesirReportData, input0x03.left_trigger), SwitchButtonBit_ZL);
+        return l;
+    }();
+
+    constexpr auto GamesirInputReport0x07Layout = []() {
+        layout::ReportLayout l;
+        l.SetSticks(offsetof(GamesirReportData, input0x07.left_stick), offsetof(GamesirReportData, input0x07.right_stick));
+        l.SetHat(offsetof(GamesirReportData, input0x07.dpad), GamesirDpad2_N);
+        l.AddButtons(offsetof(GamesirReportData, input0x07.buttons), layout::GenericGamepadButtons);
+        l.AddButtons(offsetof(GamesirReportData, input0x07.buttons), GamesirExtraButtons);
+        l.AddTrigger(offsetof(GamesirReportData, input0x07.right_trigger), SwitchButtonBit_ZR);
+        l.AddTrigger(offsetof(GamesirReportData, input0x07.left_trigger), SwitchButtonBit_ZL);
+        return l;
+    }();
+
+    constexpr auto GamesirInputReport0xc4Layout = []() {
+        layout::ReportLayout l;
+        l.SetSticks(offsetof(GamesirReportData, input0xc4.left_stick), offsetof(GamesirReportData, input0xc4.right_stick));
+        l.SetHat(offsetof(GamesirReportData, input0xc4.dpad), GamesirDpad_N);
+        l.AddButtons(offsetof(GamesirReportData, input0xc4.buttons), layout::GenericGamepadButtons);
+        l.AddTrigger(offsetof(GamesirReportData, input0xc4.right_trigger), SwitchButtonBit_ZR);
+        l.AddTrigger(offsetof(GamesirReportData, input0xc4.left_trigger), SwitchButtonBit_ZL);
+        return l;
+    }();
+
     class GamesirController final : public EmulatedSwitchController {
 
         public:
@@ -18,12 +18,6 @@
 
 namespace ams::controller {
 
-    namespace {
-
-        constexpr u8 TriggerMax = UINT8_MAX;
-
-    }
-
     void IpegaController::ProcessInputData(const bluetooth::HidReport *report) {
         auto ipega_report = reinterpret_cast<const IpegaReportData *>(&report->data);
 
@@ -42,37 +36,7 @@ namespace ams::controller {
     }
 
     void IpegaController::MapInputReport0x07(const IpegaReportData *src) {
-        m_left_stick  = PackAnalogStickValues(src->input0x07.left_stick.x,  InvertAnalogStickValue(src->input0x07.left_stick.y));
-        m_right_stick = PackAnalogStickValues(src->input0x07.right_stick.x, InvertAnalogStickValue(src->input0x07.right_stick.y));
-
-        m_buttons.dpad_down  = (src->input0x07.buttons.dpad == IpegaDPad_S)  ||
-                               (src->input0x07.buttons.dpad == IpegaDPad_SE) ||
-                               (src->input0x07.buttons.dpad == IpegaDPad_SW);
-        m_buttons.dpad_up    = (src->input0x07.buttons.dpad == IpegaDPad_N)  ||
-                               (src->input0x07.buttons.dpad == IpegaDPad_NE) ||
-                               (src->input0x07.buttons.dpad == IpegaDPad_NW);
-        m_buttons.dpad_right = (src->input0x07.buttons.dpad == IpegaDPad_E)  ||
-                               (src->input0x07.buttons.dpad == IpegaDPad_NE) ||
-                               (src->input0x07.buttons.dpad == IpegaDPad_SE);
-        m_buttons.dpad_left  = (src->input0x07.buttons.dpad == IpegaDPad_W)  ||
-                               (src->input0x07.buttons.dpad == IpegaDPad_NW) ||
-                               (src->input0x07.buttons.dpad == IpegaDPad_SW);
-
-        m_buttons.A = src->input0x07.buttons.B;
-        m_buttons.B = src->input0x07.buttons.A;
-        m_buttons.X = src->input0x07.buttons.Y;
-        m_buttons.Y = src->input0x07.buttons.X;
-
-        m_buttons.R  = src->input0x07.buttons.RB;
-        m_buttons.ZR = src->input0x07.right_trigger > (m_trigger_threshold * TriggerMax);
-        m_buttons.L  = src->input0x07.buttons.LB;
-        m_buttons.ZL = src->input0x07.left_trigger  > (m_trigger_threshold * TriggerMax);
-
-        m_buttons.minus = src->input0x07.buttons.view;
-        m_buttons.plus  = src->input0x07.buttons.menu;
-
-        m_buttons.lstick_press = src->input0x07.buttons.lstick_press | src->input0x07.buttons.L3_g910;
-        m_buttons.rstick_press = src->input0x07.buttons.rstick_press | src->input0x07.buttons.R3_g910;
+        this->MapReportLayout<IpegaInputReport0x07Layout>(src);
     }
 
 }
@@ -73,6 +73,25 @@ namespace ams::controller {
         };
     } PACKED;
 
+    // Some models (eg. G910) report the stick buttons in an alternate position
+    constexpr layout::Button IpegaExtraButtons[] = {
+        { 0, 2, SwitchButtonBit_LStick },
+        { 0, 5, SwitchButtonBit_RStick },
+    };
+
+    constexpr auto IpegaInputReport0x07Layout = []() {
+        constexpr u16 ButtonsOffset = offsetof(IpegaReportData, input0x07.buttons) + sizeof(IpegaButtonData::dpad);
+
+        layout::ReportLayout l;
+        l.SetSticks(offsetof(IpegaReportData, input0x07.left_stick), offsetof(IpegaReportData, input0x07.right_stick));
+        l.SetHat(offsetof(IpegaReportData, input0x07.buttons.dpad), IpegaDPad_N);
+        l.AddButtons(ButtonsOffset, layout::GenericGamepadButtons);
+        l.AddButtons(ButtonsOffset, IpegaExtraButtons);
+        l.AddTrigger(offsetof(IpegaReportData, input0x07.right_trigger), SwitchButtonBit_ZR);
+        l.AddTrigger(offsetof(IpegaReportData, input0x07.left_trigger), SwitchButtonBit_ZL);
+        return l;
+    }();
+
     class IpegaController final : public EmulatedSwitchController {
 
         public:
@@ -14,6 +14,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "switch_controller.hpp"
+#include "controller_state_mirror.hpp"
 #include "../mcmitm_config.hpp"
 #include <string>
 
@@ -59,7 +60,16 @@ namespace ams::controller {
         return path;
     }
 
+    SwitchController::~SwitchController() {
+        ReleaseStateMirrorSlot(m_state_slot);
+    }
+
     Result SwitchController::Initialize() {
+        std::scoped_lock lk(m_input_mutex);
+        if (m_state_slot < 0) {
+            m_state_slot = AcquireStateMirrorSlot(m_address, this->IsWired());
+        }
+
         R_SUCCEED();
     }
 
@@ -73,12 +83,27 @@ namespace ams::controller {
             report = reinterpret_cast<const bluetooth::HidReport *>(&event_info->data_report.v1.report);
         }
 
-        if (!m_future_responses.empty()) {
-            if ((m_future_responses.front()->GetType() == BtdrvHidEventType_Data) && (m_future_responses.front()->GetUserData() == report->data[0])) {
-                m_future_responses.front()->SetData(*event_info);
+        {
+            std::scoped_lock lk(m_response_mutex);
+            if (!m_future_responses.empty()) {
+                if ((m_future_responses.front().GetType() == BtdrvHidEventType_Data) && (m_future_responses.front().GetUserData() == report->data[0])) {
+                    m_future_responses.front().SetData(*event_info);
+                }
             }
         }
 
+        R_RETURN(this->HandleInputReport(report));
+    }
+
+    Result SwitchController::HandleInputReport(const bluetooth::HidReport *report) {
+        m_input_report_count.fetch_add(1, std::memory_order_relaxed);
+
+        const s64 now = os::GetSystemTick().GetInt64Value();
+        if (m_first_input_report_tick.load(std::memory_order_relaxed) == 0) {
+            m_first_input_report_tick.store(now, std::memory_order_relaxed);
+        }
+        m_last_input_report_tick.store(now, std::memory_order_relaxed);
+
         std::scoped_lock lk(m_input_mutex);
 
         this->UpdateControllerState(report);
@@ -97,28 +122,41 @@ namespace ams::controller {
 
         this->ApplyButtonCombos(&input_report->buttons); 
 
+        const bool forward = this->ShouldForwardInputReport(input_report);
+        PublishControllerState(m_state_slot, input_report, forward);
+
+        if (!forward) {
+            R_SUCCEED();
+        }
+
         R_RETURN(bluetooth::hid::report::WriteHidDataReport(m_address, &m_input_report));
     }
 
     Result SwitchController::HandleSetReportEvent(const bluetooth::HidReportEventInfo *event_info) {
-        if (!m_future_responses.empty()) {
-            if (m_future_responses.front()->GetType() == BtdrvHidEventType_SetReport) {
-                m_future_responses.front()->SetData(*event_info);
-            }
+        {
+            std::scoped_lock lk(m_response_mutex);
+            if (!m_future_responses.empty()) {
+                if (m_future_responses.front().GetType() == BtdrvHidEventType_SetReport) {
+                    m_future_responses.front().SetData(*event_info);
+                }
 
-            R_SUCCEED();
+                R_SUCCEED();
+            }
         }
 
         R_RETURN(bluetooth::hid::report::WriteHidSetReport(m_address, event_info->set_report.res));
     }
 
     Result SwitchController::HandleGetReportEvent(const bluetooth::HidReportEventInfo *event_info) {
-        if (!m_future_responses.empty()) {
-            if (m_future_responses.front()->GetType() == BtdrvHidEventType_GetReport) {
-                m_future_responses.front()->SetData(*event_info);
-            }
+        {
+            std::scoped_lock lk(m_response_mutex);
+            if (!m_future_responses.empty()) {
+                if (m_future_responses.front().GetType() == BtdrvHidEventType_GetReport) {
+                    m_future_responses.front().SetData(*event_info);
+                }
 
-            R_SUCCEED();
+                R_SUCCEED();
+            }
         }
 
         auto report = hos::GetVersion() >= hos::Version_9_0_0 ? &event_info->get_report.v9.report : reinterpret_cast<const bluetooth::HidReport *>(&event_info->get_report.v1.report);
@@ -130,22 +168,26 @@ namespace ams::controller {
     }
 
     Result SwitchController::WriteDataReport(const bluetooth::HidReport *report) {
+        if (m_transport != nullptr) {
+            R_RETURN(m_transport->WriteDataReport(report));
+        }
+
         R_RETURN(btdrvWriteHidData(m_address, report));
     }
 
     Result SwitchController::WriteDataReport(const bluetooth::HidReport *report, u8 response_id, bluetooth::HidReport *out_report) {       
-        auto response = std::make_shared<HidResponse>(BtdrvHidEventType_Data);
-        response->SetUserData(response_id);
-        m_future_responses.push(response);
-        ON_SCOPE_EXIT { m_future_responses.pop(); };
+        HidResponse response(BtdrvHidEventType_Data);
+        response.SetUserData(response_id);
+        this->PushFutureResponse(&response);
+        ON_SCOPE_EXIT { this->RemoveFutureResponse(&response); };
 
         R_TRY(btdrvWriteHidData(m_address, report));
 
-        if (!response->TimedWait(ams::TimeSpan::FromMilliSeconds(500))) {
+        if (!response.TimedWait(ams::TimeSpan::FromMilliSeconds(500))) {
             return -1; // This should return a proper failure code
         }
 
-        auto response_data = response->GetData();
+        const auto &response_data = response.GetData();
 
         const bluetooth::HidReport *data_report;
         if (hos::GetVersion() >= hos::Version_9_0_0) {
@@ -162,34 +204,52 @@ namespace ams::controller {
         R_SUCCEED();
     }
 
+    void SwitchController::PushFutureResponse(HidResponse *response) {
+        std::scoped_lock lk(m_response_mutex);
+        m_future_responses.push_back(*response);
+    }
+
+    void SwitchController::RemoveFutureResponse(HidResponse *response) {
+        std::scoped_lock lk(m_response_mutex);
+        m_future_responses.erase(m_future_responses.iterator_to(*response));
+    }
+
     Result SwitchController::SetReport(BtdrvBluetoothHhReportType type, const bluetooth::HidReport *report) {
-        auto response = std::make_shared<HidResponse>(BtdrvHidEventType_SetReport);
-        m_future_responses.push(response);
-        ON_SCOPE_EXIT { m_future_responses.pop(); };
+        if (m_transport != nullptr) {
+            R_RETURN(m_transport->SetReport(type, report));
+        }
+
+        HidResponse response(BtdrvHidEventType_SetReport);
+        this->PushFutureResponse(&response);
+        ON_SCOPE_EXIT { this->RemoveFutureResponse(&response); };
 
         R_TRY(btdrvSetHidReport(m_address, type, report));
 
-        if (!response->TimedWait(ams::TimeSpan::FromMilliSeconds(500))) {
+        if (!response.TimedWait(ams::TimeSpan::FromMilliSeconds(500))) {
             return -1; // This should return a proper failure code
         }
 
-        auto response_data = response->GetData();
+        const auto &response_data = response.GetData();
 
         return response_data.set_report.res;
     }
 
     Result SwitchController::GetReport(u8 id, BtdrvBluetoothHhReportType type, bluetooth::HidReport *out_report) {
-        auto response = std::make_shared<HidResponse>(BtdrvHidEventType_GetReport);
-        m_future_responses.push(response);
-        ON_SCOPE_EXIT { m_future_responses.pop(); };
+        if (m_transport != nullptr) {
+            R_RETURN(m_transport->GetReport(id, type, out_report));
+        }
+
+        HidResponse response(BtdrvHidEventType_GetReport);
+        this->PushFutureResponse(&response);
+        ON_SCOPE_EXIT { this->RemoveFutureResponse(&response); };
 
         R_TRY(btdrvGetHidReport(m_address, id, type));
 
-        if (!response->TimedWait(ams::TimeSpan::FromMilliSeconds(500))) {
+        if (!response.TimedWait(ams::TimeSpan::FromMilliSeconds(500))) {
             return -1; // This should return a proper failure code
         }
 
-        auto response_data = response->GetData();
+        const auto &response_data = response.GetData();
         
         Result result;
         const bluetooth::HidReport *get_report;
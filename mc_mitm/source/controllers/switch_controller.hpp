@@ -15,12 +15,13 @@
  */
 #pragma once
 #include "switch_analog_stick.hpp"
+#include "controller_transport.hpp"
 #include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
 #include "../bluetooth_mitm/bluetooth/bluetooth_hid_report.hpp"
 #include "../async/future_response.hpp"
 #include "switch_rumble_handler.hpp"
 #include "switch_motion_packing.hpp"
-#include <queue>
+#include "../mcmitm_config.hpp"
 
 namespace ams::controller {
 
@@ -392,11 +393,13 @@ namespace ams::controller {
         };
     } PACKED;
 
+    constexpr size_t MaxControllers = 10;
+
     SwitchPlayerNumber LedMaskToPlayerNumber(u8 led_mask);
 
     std::string GetControllerDirectory(bluetooth::Address address);
 
-    class SwitchController {
+    class SwitchController : public std::enable_shared_from_this<SwitchController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = {
@@ -410,12 +413,27 @@ namespace ams::controller {
 
             SwitchController(bluetooth::Address address, HardwareID id) : m_address(address), m_id(id) { }
 
-            virtual ~SwitchController() { };
+            virtual ~SwitchController();
 
             const bluetooth::Address& Address() const { return m_address; }
 
+            // Route output to a transport other than Bluetooth. Must be set before the controller is initialised
+            void SetTransport(ControllerTransport *transport) { m_transport = transport; }
+            bool IsWired() const { return m_transport != nullptr; }
+
             virtual bool IsOfficialController() { return true; }
 
+            virtual bool IsMotionActive() { return false; }
+            virtual os::Tick GetLastActivityTick() { return os::Tick(0); }
+            virtual u16 GetReportRate() { return 0; }
+            virtual Result SetReportRate(u16 rate) { AMS_UNUSED(rate); R_SUCCEED(); }
+
+            u32 ConsumeInputReportCount() { return m_input_report_count.exchange(0); }
+            os::Tick GetFirstInputReportTick() const { return os::Tick(m_first_input_report_tick.load(std::memory_order_relaxed)); }
+            os::Tick GetLastInputReportTick() const { return os::Tick(m_last_input_report_tick.load(std::memory_order_relaxed)); }
+
+            virtual Result ApplyProfile(const mitm::PerformanceProfile *profile) { AMS_UNUSED(profile); R_SUCCEED(); }
+
             virtual Result Initialize();
 
             virtual Result HandleDataReportEvent(const bluetooth::HidReportEventInfo *event_info);
@@ -423,25 +441,38 @@ namespace ams::controller {
             virtual Result HandleGetReportEvent(const bluetooth::HidReportEventInfo *event_info);
             virtual Result HandleOutputDataReport(const bluetooth::HidReport *report);
 
+            Result HandleInputReport(const bluetooth::HidReport *report);
+
         protected:
             Result WriteDataReport(const bluetooth::HidReport *report);
             Result WriteDataReport(const bluetooth::HidReport *report, u8 response_id, bluetooth::HidReport *out_report);
             Result SetReport(BtdrvBluetoothHhReportType type, const bluetooth::HidReport *report);
             Result GetReport(u8 id, BtdrvBluetoothHhReportType type, bluetooth::HidReport *out_report);
 
+            void PushFutureResponse(HidResponse *response);
+            void RemoveFutureResponse(HidResponse *response);
+
             virtual void UpdateControllerState(const bluetooth::HidReport *report);
             virtual void ApplyButtonCombos(SwitchButtonData *buttons);
+            virtual bool ShouldForwardInputReport(const SwitchInputReport *report) { AMS_UNUSED(report); return true; }
 
             bluetooth::Address m_address;
             HardwareID m_id;
 
+            ControllerTransport *m_transport = nullptr;
+
             os::SdkMutex m_input_mutex;
             bluetooth::HidReport m_input_report;
+            std::atomic<u32> m_input_report_count = 0;
+            std::atomic<s64> m_first_input_report_tick = 0;
+            std::atomic<s64> m_last_input_report_tick = 0;
+            s32 m_state_slot = -1;
 
             os::SdkMutex m_output_mutex;
             bluetooth::HidReport m_output_report;
 
-            std::queue<std::shared_ptr<HidResponse>> m_future_responses;
+            os::SdkMutex m_response_mutex;
+            util::IntrusiveListBaseTraits<HidResponse>::ListType m_future_responses;
     };
 
 }
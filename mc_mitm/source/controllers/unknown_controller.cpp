@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "unknown_controller.hpp"
+#include "controller_device_cache.hpp"
+#include <stratosphere.hpp>
+
+namespace ams::controller {
+
+    namespace {
+
+        // Generic HID gamepads number their buttons in the order A, B, C, X, Y, Z, L1, R1, L2, R2, Select, Start, Mode, L3, R3
+        constexpr s8 NoButton = -1;
+        constexpr s8 ButtonTargets[HidMappingPlan::MaxButtons] = {
+            SwitchButtonBit_B,
+            SwitchButtonBit_A,
+            NoButton,
+            SwitchButtonBit_Y,
+            SwitchButtonBit_X,
+            NoButton,
+            SwitchButtonBit_L,
+            SwitchButtonBit_R,
+            SwitchButtonBit_ZL,
+            SwitchButtonBit_ZR,
+            SwitchButtonBit_Minus,
+            SwitchButtonBit_Plus,
+            SwitchButtonBit_Home,
+            SwitchButtonBit_LStick,
+            SwitchButtonBit_RStick,
+            SwitchButtonBit_Capture,
+        };
+
+        u32 ExtractBits(const u8 *data, u32 bit_offset, u8 bit_size) {
+            u64 value = 0;
+            const u32 first_byte = bit_offset / 8;
+            const u32 last_byte = (bit_offset + bit_size - 1) / 8;
+            for (u32 i = first_byte; i <= last_byte; ++i) {
+                value |= static_cast<u64>(data[i]) << (8 * (i - first_byte));
+            }
+
+            return (value >> (bit_offset % 8)) & ((u64(1) << bit_size) - 1);
+        }
+
+        s32 ReadField(const u8 *data, const HidPlanField &field) {
+            const u32 raw = ExtractBits(data, field.bit_offset, field.bit_size);
+            if (field.is_signed && (field.bit_size < 32) && (raw & BIT(field.bit_size - 1))) {
+                return static_cast<s32>(raw | ~((u32(1) << field.bit_size) - 1));
+            }
+
+            return static_cast<s32>(raw);
+        }
+
+        // Scales a field to the range [0, 1]
+        float ReadNormalised(const u8 *data, const HidPlanField &field) {
+            const s32 value = std::clamp(ReadField(data, field), field.logical_min, field.logical_max);
+            return static_cast<float>(static_cast<s64>(value) - field.logical_min) / (static_cast<s64>(field.logical_max) - field.logical_min);
+        }
+
+        u16 ReadStickAxis(const u8 *data, const HidPlanField &field, bool invert) {
+            if (field.bit_size == 0) {
+                return SwitchAnalogStick::Center;
+            }
+
+            const u16 value = static_cast<u16>(ReadNormalised(data, field) * SwitchAnalogStick::Max);
+            return invert ? SwitchAnalogStick::Max - value : value;
+        }
+
+    }
+
+    Result UnknownController::Initialize() {
+        R_TRY(EmulatedSwitchController::Initialize());
+
+        m_plan_valid = this->LoadMappingPlan();
+
+        R_SUCCEED();
+    }
+
+    bool UnknownController::LoadMappingPlan() {
+        // Compiled plans are cached with the controller's other data, so the descriptor is only parsed on first connection
+        const DeviceCache cache(m_address, m_id);
+        if (R_SUCCEEDED(cache.Load(&m_plan, sizeof(m_plan), HidMappingPlanVersion)) && IsValidHidMappingPlan(m_plan)) {
+            return true;
+        }
+
+        bluetooth::DevicesSettings device_settings;
+        if (R_FAILED(btdrvGetPairedDeviceInfo(m_address, &device_settings))) {
+            return false;
+        }
+
+        // The system only stores the start of long descriptors, but the gamepad inputs normally come first
+        const size_t size = std::min<size_t>(device_settings.descriptor_length, sizeof(device_settings.descriptor));
+        if (!CompileHidMappingPlan(device_settings.descriptor, size, &m_plan)) {
+            return false;
+        }
+
+        static_cast<void>(cache.Store(&m_plan, sizeof(m_plan), HidMappingPlanVersion));
+
+        return true;
+    }
+
+    void UnknownController::ProcessInputData(const bluetooth::HidReport *report) {
+        if (!m_plan_valid) {
+            return;
+        }
+
+        const u8 *data = report->data;
+        size_t size = report->size;
+        if (m_plan.has_report_id) {
+            if ((size == 0) || (data[0] != m_plan.report_id)) {
+                return;
+            }
+
+            data += 1;
+            size -= 1;
+        }
+
+        if (size < m_plan.report_size) {
+            return;
+        }
+
+        m_left_stick.SetData(
+            ReadStickAxis(data, m_plan.axes[HidPlanAxis_LeftStickX], false),
+            ReadStickAxis(data, m_plan.axes[HidPlanAxis_LeftStickY], true)
+        );
+        m_right_stick.SetData(
+            ReadStickAxis(data, m_plan.axes[HidPlanAxis_RightStickX], false),
+            ReadStickAxis(data, m_plan.axes[HidPlanAxis_RightStickY], true)
+        );
+
+        u32 buttons = 0;
+        for (size_t i = 0; i < m_plan.num_buttons; ++i) {
+            if ((ButtonTargets[i] != NoButton) && (m_plan.button_bit_offsets[i] != HidMappingPlan::UnusedButton) && ExtractBits(data, m_plan.button_bit_offsets[i], 1)) {
+                buttons |= BIT(ButtonTargets[i]);
+            }
+        }
+
+        const auto &left_trigger = m_plan.axes[HidPlanAxis_LeftTrigger];
+        if ((left_trigger.bit_size != 0) && (ReadNormalised(data, left_trigger) > m_trigger_threshold)) {
+            buttons |= BIT(SwitchButtonBit_ZL);
+        }
+
+        const auto &right_trigger = m_plan.axes[HidPlanAxis_RightTrigger];
+        if ((right_trigger.bit_size != 0) && (ReadNormalised(data, right_trigger) > m_trigger_threshold)) {
+            buttons |= BIT(SwitchButtonBit_ZR);
+        }
+
+        // Hats report either eight directions or only the four cardinal ones, clockwise from north
+        if (m_plan.hat.bit_size != 0) {
+            const s64 direction = static_cast<s64>(ReadField(data, m_plan.hat)) - m_plan.hat.logical_min;
+            const s64 num_directions = static_cast<s64>(m_plan.hat.logical_max) - m_plan.hat.logical_min + 1;
+            if ((direction >= 0) && (direction < num_directions) && ((num_directions == 8) || (num_directions == 4))) {
+                buttons |= static_cast<u32>(layout::HatDirections[direction * (8 / num_directions)]) << SwitchButtonBit_DpadDown;
+            }
+        }
+
+        std::memcpy(&m_buttons, &buttons, sizeof(m_buttons));
+    }
+
+}
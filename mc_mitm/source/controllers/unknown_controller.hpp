@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "emulated_switch_controller.hpp"
+#include "controller_hid_descriptor.hpp"
+
+namespace ams::controller {
+
+    // Fallback for controllers without a dedicated driver. Inputs are mapped according to the device's HID report descriptor where possible
+    class UnknownController : public EmulatedSwitchController {
+
+        public:
+            UnknownController(bluetooth::Address address, HardwareID id)
+            : EmulatedSwitchController(address, id)
+            , m_plan_valid(false) { }
+
+            Result Initialize();
+            void ProcessInputData(const bluetooth::HidReport *report) override;
+
+        private:
+            bool LoadMappingPlan();
+
+            HidMappingPlan m_plan;
+            bool m_plan_valid;
+
+    };
+
+}
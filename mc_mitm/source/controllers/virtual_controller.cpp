@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "virtual_controller.hpp"
+
+namespace ams::controller {
+
+    Result VirtualController::SubmitFrame(const VirtualControllerFrame *frame) {
+        // Frames are passed through as input reports so they follow the same path as those from a real controller
+        bluetooth::HidReport report;
+        report.size = sizeof(VirtualControllerFrame);
+        std::memcpy(report.data, frame, sizeof(VirtualControllerFrame));
+
+        R_RETURN(this->HandleInputReport(&report));
+    }
+
+    void VirtualController::ProcessInputData(const bluetooth::HidReport *report) {
+        if (report->size < sizeof(VirtualControllerFrame)) {
+            return;
+        }
+
+        VirtualControllerFrame frame;
+        std::memcpy(&frame, report->data, sizeof(frame));
+
+        static_assert(sizeof(m_buttons) == 3);
+        const u8 buttons[] = {
+            static_cast<u8>(frame.buttons),
+            static_cast<u8>(frame.buttons >> 8),
+            static_cast<u8>(frame.buttons >> 16)
+        };
+        std::memcpy(&m_buttons, buttons, sizeof(m_buttons));
+
+        m_left_stick.SetData(std::min(frame.left_stick[0], SwitchAnalogStick::Max), std::min(frame.left_stick[1], SwitchAnalogStick::Max));
+        m_right_stick.SetData(std::min(frame.right_stick[0], SwitchAnalogStick::Max), std::min(frame.right_stick[1], SwitchAnalogStick::Max));
+
+        m_accel = { frame.accel[0], frame.accel[1], frame.accel[2] };
+        m_gyro = { frame.gyro[0], frame.gyro[1], frame.gyro[2] };
+
+        m_battery = (std::min<u8>(frame.battery_level, 4) << 1) & 0x0e;
+        m_charging = frame.flags & VirtualControllerFrameFlag_Charging;
+        m_ext_power = frame.flags & VirtualControllerFrameFlag_ExternalPower;
+    }
+
+}
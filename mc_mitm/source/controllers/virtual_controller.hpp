@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "emulated_switch_controller.hpp"
+
+namespace ams::controller {
+
+    enum VirtualControllerFrameFlag : u8 {
+        VirtualControllerFrameFlag_Charging      = BIT(0),
+        VirtualControllerFrameFlag_ExternalPower = BIT(1),
+    };
+
+    // Input state supplied by a client. Sticks are 12-bit, acceleration is in g and angular velocity in degrees per second
+    struct VirtualControllerFrame {
+        u64 timestamp;          // system tick at which to apply the frame, or 0 to apply it as soon as it's read. See VirtualControllerMaxScheduleAhead
+        u32 buttons;            // SwitchButtonData in the low 24 bits
+        u16 left_stick[2];
+        u16 right_stick[2];
+        float accel[3];
+        float gyro[3];
+        u8 battery_level;       // 0-4
+        u8 flags;
+        u8 reserved[2];
+    };
+    static_assert(sizeof(VirtualControllerFrame) == 0x30);
+
+    // Frames may be scheduled at most this far ahead. Later timestamps are taken to be bogus, and the frame is applied as soon as it's read
+    constexpr TimeSpan VirtualControllerMaxScheduleAhead = TimeSpan::FromMilliSeconds(100);
+
+    // Single producer, single consumer ring shared with the client. The client fills frames[write_index % Capacity] and then advances
+    // write_index, never moving more than Capacity frames ahead of read_index. Both indices increase freely and wrap around
+    struct VirtualControllerRing {
+        static constexpr u32 Capacity = 256;
+
+        alignas(0x40) std::atomic<u32> write_index;
+        alignas(0x40) std::atomic<u32> read_index;
+        alignas(0x40) VirtualControllerFrame frames[Capacity];
+    };
+    static_assert(std::atomic<u32>::is_always_lock_free);
+
+    constexpr size_t VirtualControllerRingSize = util::AlignUp(sizeof(VirtualControllerRing), os::MemoryPageSize);
+
+    // Controller driven by frames from another process rather than by a physical device
+    class VirtualController : public EmulatedSwitchController {
+
+        public:
+            static constexpr const HardwareID hardware_ids[] = {
+                {0x1209, 0x4d43}    // Mission Control virtual controller
+            };
+
+            VirtualController(bluetooth::Address address, HardwareID id) : EmulatedSwitchController(address, id) { }
+
+            Result SubmitFrame(const VirtualControllerFrame *frame);
+
+        protected:
+            void ProcessInputData(const bluetooth::HidReport *report) override;
+
+    };
+
+}
@@ -77,14 +77,21 @@ namespace ams::controller {
     }
 
     Result VirtualSpiFlash::CheckMemoryRegion(int offset, size_t size, bool *is_initialized) {
-        auto data = std::unique_ptr<u8[]>(new u8[size]());
+        u8 buff[64];
 
-        R_TRY(this->Read(offset, data.get(), size));
-        for (size_t i = 0; i < size; ++i) {
-            if (data[i] != 0xff) {
-                *is_initialized = true;
-                R_SUCCEED();
+        // Check region in chunks rather than allocating a buffer for the whole thing
+        while (size > 0) {
+            size_t chunk_size = std::min(size, sizeof(buff));
+            R_TRY(this->Read(offset, buff, chunk_size));
+            for (size_t i = 0; i < chunk_size; ++i) {
+                if (buff[i] != 0xff) {
+                    *is_initialized = true;
+                    R_SUCCEED();
+                }
             }
+
+            offset += chunk_size;
+            size -= chunk_size;
         }
 
         *is_initialized = false;
@@ -15,6 +15,7 @@
  */
 #include "wii_controller.hpp"
 #include "controller_utils.hpp"
+#include "controller_device_cache.hpp"
 #include "../async/async.hpp"
 #include <stratosphere.hpp>
 
@@ -44,6 +45,18 @@ namespace ams::controller {
             }
         }
 
+        // Equivalent report modes without accelerometer data, used while the console has motion sensors disabled
+        constexpr u8 GetReportModeWithoutAccelerometer(u8 mode) {
+            switch (mode) {
+                case 0x31:
+                    return 0x30;
+                case 0x35:
+                    return 0x34;
+                default:
+                    return mode;
+            }
+        }
+
         constexpr float ApplyEasingFunction(float x) {
             constexpr float a = 3.0;
             constexpr float s = 0.15;
@@ -59,8 +72,22 @@ namespace ams::controller {
 
         // Only attempt to grab calibration and check for MotionPlus for Wiimote controllers
         if (m_id.pid == 0x0306) {
-            // Read the accelerometer calibration from Wiimote memory
-            R_TRY(this->GetAccelerometerCalibration(&m_accel_calibration));
+            // Use cached accelerometer calibration if we have it, and only read it from Wiimote memory in the background
+            WiiAccelerometerCalibrationData calibration;
+            if (R_SUCCEEDED(DeviceCache(m_address, m_id).Load(&calibration, sizeof(calibration)))) {
+                m_accel_calibration = calibration;
+
+                // The controller may be removed before the refresh runs, so only hold a weak reference to it until then
+                async::QueueWork([controller = this->weak_from_this()]() -> Result {
+                    if (auto locked = controller.lock()) {
+                        R_RETURN(std::static_pointer_cast<WiiController>(locked)->RefreshDeviceCache(true));
+                    }
+
+                    R_SUCCEED();
+                });
+            } else {
+                R_TRY(this->RefreshDeviceCache(false));
+            }
         }
 
         // Request a status report to check extension controller status
@@ -78,9 +105,13 @@ namespace ams::controller {
                 this->HandleStatusReport(wii_report);
                 break;
             case 0x21:
-                this->MapInputReport0x21(wii_report); break;
+                this->MapInputReport0x21(wii_report);
+                this->HandleMemoryReadResponse(&wii_report->input0x21);
+                break;
             case 0x22:
-                this->MapInputReport0x22(wii_report); break;
+                this->MapInputReport0x22(wii_report);
+                this->HandleMemoryWriteResponse(&wii_report->input0x22);
+                break;
             case 0x30:
                 this->MapInputReport0x30(wii_report); break;
             case 0x31:
@@ -129,7 +160,15 @@ namespace ams::controller {
     }
 
     void WiiController::MapInputReport0x34(const WiiReportData *src) {
-        this->MapCoreButtons(&src->input0x34.buttons);
+        if (m_extension == WiiExtensionController_MotionPlusClassicControllerPassthrough) {
+            // Don't map core buttons when receiving an interleaved MotionPlus report to avoid clobbering classic controller button state
+            auto extension_data = reinterpret_cast<const WiiClassicControllerPassthroughExtensionData *>(src->input0x34.extension);
+            if (!extension_data->motionplus_report) {
+                this->MapCoreButtons(&src->input0x34.buttons);
+            }
+        } else {
+            this->MapCoreButtons(&src->input0x34.buttons);
+        }
         this->MapExtensionBytes(src->input0x34.extension);
     }
 
@@ -201,6 +240,11 @@ namespace ams::controller {
     }
 
     void WiiController::MapAccelerometerData(const WiiAccelerometerData *accel, const WiiButtonData *buttons) {
+        // Reports can still carry accelerometer data until a report mode change takes effect
+        if (!m_motion_active) {
+            return;
+        }
+
         u16 x_raw = (accel->x << 2) | ((buttons->raw[0] >> 5) & 0x3);
         u16 y_raw = (accel->y << 2) | (((buttons->raw[1] >> 4) & 0x1) << 1);
         u16 z_raw = (accel->z << 2) | (((buttons->raw[1] >> 5) & 0x1) << 1);
@@ -363,6 +407,11 @@ namespace ams::controller {
         this->UpdateMotionPlusExtensionStatus(extension_data->extension_connected);
 
         if (extension_data->motionplus_report) {
+            // Skip gyro conversion while the console has motion sensors disabled
+            if (!m_motion_active) {
+                return;
+            }
+
             u16 pitch_raw = ((extension_data->pitch_speed_hi << 8) | extension_data->pitch_speed_lo) << 2;
             u16 roll_raw =  ((extension_data->roll_speed_hi  << 8) | extension_data->roll_speed_lo) << 2;
             u16 yaw_raw =   ((extension_data->yaw_speed_hi   << 8) | extension_data->yaw_speed_lo) << 2;
@@ -596,6 +645,29 @@ namespace ams::controller {
         return WiiExtensionController_None;
     }
 
+    Result WiiController::RefreshDeviceCache(bool cached) {
+        // Read the accelerometer calibration from Wiimote memory
+        WiiAccelerometerCalibrationData calibration;
+        R_TRY(this->GetAccelerometerCalibration(&calibration));
+
+        {
+            // Calibration is read by the input report handler
+            std::scoped_lock lk(m_input_mutex);
+
+            // Avoid rewriting the cache file if nothing has changed
+            if (cached && (std::memcmp(&calibration, &m_accel_calibration, sizeof(m_accel_calibration)) == 0)) {
+                R_SUCCEED();
+            }
+
+            m_accel_calibration = calibration;
+        }
+
+        // Failing to update the cache file shouldn't prevent the controller from being used
+        static_cast<void>(DeviceCache(m_address, m_id).Store(&calibration, sizeof(calibration)));
+
+        R_SUCCEED();
+    }
+
     Result WiiController::GetAccelerometerCalibration(WiiAccelerometerCalibrationData *calibration) {
         struct {
             u8 acc_x_0g_92;
@@ -654,8 +726,11 @@ namespace ams::controller {
             };
         } calibration_raw;
 
-        R_TRY(this->ReadMemory(0x04a60020, 16, &calibration_raw.raw));
-        R_TRY(this->ReadMemory(0x04a60030, 16, &calibration_raw.raw[0x10]));
+        WiiMemoryTransaction transaction;
+        transaction.Read(0x04a60020, 16, &calibration_raw.raw);
+        transaction.Read(0x04a60030, 16, &calibration_raw.raw[0x10]);
+        R_TRY(this->ExecuteMemoryTransaction(&transaction));
+        R_TRY(transaction.GetResult());
 
         calibration->fast.yaw_zero    = util::SwapEndian(calibration_raw.fast.calib.yaw_zero);
         calibration->fast.roll_zero   = util::SwapEndian(calibration_raw.fast.calib.roll_zero);
@@ -691,8 +766,11 @@ namespace ams::controller {
             };
         } calibration_raw;
 
-        R_TRY(this->ReadMemory(0x04a40020, 16, &calibration_raw.raw));
-        R_TRY(this->ReadMemory(0x04a40030, 16, &calibration_raw.raw[0x10]));
+        WiiMemoryTransaction transaction;
+        transaction.Read(0x04a40020, 16, &calibration_raw.raw);
+        transaction.Read(0x04a40030, 16, &calibration_raw.raw[0x10]);
+        R_TRY(this->ExecuteMemoryTransaction(&transaction));
+        R_TRY(transaction.GetResult());
 
         calibration->top_right_0kg     = util::SwapEndian(calibration_raw.calib.top_right_0kg);
         calibration->bottom_right_0kg  = util::SwapEndian(calibration_raw.calib.bottom_right_0kg);
@@ -710,14 +788,23 @@ namespace ams::controller {
         R_SUCCEED();
     }
 
+    Result WiiController::SetMotionActive(bool active) {
+        AMS_UNUSED(active);
+
+        // Reapply the current report mode, which drops accelerometer data while motion is inactive
+        R_RETURN(this->SetReportMode(m_report_mode));
+    }
+
     Result WiiController::SetReportMode(u8 mode) {
         std::scoped_lock lk(m_output_mutex);
 
+        m_report_mode = mode;
+
         m_output_report.size = sizeof(WiiOutputReport0x12) + 1;
         auto report_data = reinterpret_cast<WiiReportData *>(m_output_report.data);
         report_data->id = 0x12;
         report_data->output0x12.rumble = m_rumble_state;
-        report_data->output0x12.report_mode = mode;
+        report_data->output0x12.report_mode = m_motion_active ? mode : GetReportModeWithoutAccelerometer(mode);
 
         R_RETURN(this->WriteDataReport(&m_output_report));
     }
@@ -733,66 +820,250 @@ namespace ams::controller {
         R_RETURN(this->WriteDataReport(&m_output_report));
     }
 
-    Result WiiController::WriteMemory(u32 write_addr, const void *data, u8 size) {       
+    size_t WiiMemoryTransaction::Read(u32 address, u16 size, void *out_data) {
+        AMS_ABORT_UNLESS(m_count < MaxOperations);
+
+        m_operations[m_count] = {
+            .address = address,
+            .size = size,
+            .is_write = false,
+            .out_data = out_data,
+            .write_data = {},
+            .request_index = 0,
+            .result = ResultSuccess(),
+        };
+
+        return m_count++;
+    }
+
+    size_t WiiMemoryTransaction::Write(u32 address, const void *data, u8 size) {
+        AMS_ABORT_UNLESS(m_count < MaxOperations);
+        AMS_ABORT_UNLESS(size <= sizeof(Operation::write_data));
+
+        m_operations[m_count] = {
+            .address = address,
+            .size = size,
+            .is_write = true,
+            .out_data = nullptr,
+            .write_data = {},
+            .request_index = 0,
+            .result = ResultSuccess(),
+        };
+        std::memcpy(m_operations[m_count].write_data, data, size);
+
+        return m_count++;
+    }
+
+    // Returns the result of the first operation that failed, if any
+    Result WiiMemoryTransaction::GetResult() const {
+        for (size_t i = 0; i < m_count; ++i) {
+            R_TRY(m_operations[i].result);
+        }
+
+        R_SUCCEED();
+    }
+
+    Result WiiController::WriteMemory(u32 write_addr, const void *data, u8 size) {
+        WiiMemoryTransaction transaction;
+        transaction.Write(write_addr, data, size);
+        R_TRY(this->ExecuteMemoryTransaction(&transaction));
+        R_RETURN(transaction.GetResult());
+    }
+
+    Result WiiController::ReadMemory(u32 read_addr, u16 size, void *out_data) {
+        WiiMemoryTransaction transaction;
+        transaction.Read(read_addr, size, out_data);
+        R_TRY(this->ExecuteMemoryTransaction(&transaction));
+        R_RETURN(transaction.GetResult());
+    }
+
+    Result WiiController::ExecuteMemoryTransaction(WiiMemoryTransaction *transaction) {
+        std::scoped_lock lk(m_memory_transaction_mutex);
+
+        // Give the controller time to settle. This is now paid once per transaction rather than once per access
         os::SleepThread(ams::TimeSpan::FromMilliSeconds(30));
 
         Result result;
-        auto output = std::make_unique<bluetooth::HidReport>();
-
-        std::scoped_lock lk(m_output_mutex);
 
         int attempts = 0;
         do {
-            m_output_report.size = sizeof(WiiOutputReport0x16) + 1;
-            auto report_data = reinterpret_cast<WiiReportData *>(m_output_report.data);
-            report_data->id = 0x16;
-            report_data->output0x16.address = ams::util::SwapEndian(write_addr);
-            report_data->output0x16.size = size;
-            std::memcpy(&report_data->output0x16.data, data, size);
-
-            R_TRY(this->WriteDataReport(&m_output_report, 0x22, output.get()));
-            report_data = reinterpret_cast<WiiReportData *>(&output->data);
-            result = report_data->input0x22.error;
+            result = this->IssueMemoryRequests(transaction);
         } while (!(R_SUCCEEDED(result) || (++attempts >= 2)));
 
         return result;
     }
 
-    Result WiiController::ReadMemory(u32 read_addr, u16 size, void *out_data) {
-        os::SleepThread(ams::TimeSpan::FromMilliSeconds(30));
+    Result WiiController::IssueMemoryRequests(WiiMemoryTransaction *transaction) {
+        {
+            std::scoped_lock lk(m_memory_request_mutex);
+
+            // Build the list of requests to be sent, merging runs of reads that fall close enough together to be covered by a single request.
+            // Reads are never merged across a write, so that the controller sees accesses in the order they were queued
+            m_num_memory_requests = 0;
+            for (size_t i = 0; i < transaction->m_count; ++i) {
+                auto &op = transaction->m_operations[i];
+
+                // Operations are considered failed until a response has been received for them
+                op.result = -1;
+
+                if (!op.is_write && (m_num_memory_requests > 0)) {
+                    auto &prev = m_memory_requests[m_num_memory_requests - 1];
+                    if (!prev.is_write) {
+                        const u32 start = std::min(prev.address, op.address);
+                        const u32 end = std::max(prev.address + prev.size, op.address + op.size);
+                        if ((op.address <= prev.address + prev.size + 0x10) && (prev.address <= op.address + op.size + 0x10) && (end - start <= MaxMemoryReadSize)) {
+                            prev.address = start;
+                            prev.size = end - start;
+                            op.request_index = m_num_memory_requests - 1;
+                            continue;
+                        }
+                    }
+                }
 
-        Result result;
-        auto output = std::make_unique<bluetooth::HidReport>();
+                AMS_ABORT_UNLESS(op.is_write || (op.size <= MaxMemoryReadSize));
+
+                op.request_index = m_num_memory_requests;
+                auto &request = m_memory_requests[m_num_memory_requests++];
+                request.address = op.address;
+                request.size = op.size;
+                request.bytes_received = 0;
+                request.is_write = op.is_write;
+                request.complete = false;
+                request.result = ResultSuccess();
+                if (op.is_write) {
+                    std::memcpy(request.data, op.write_data, op.size);
+                }
+            }
 
-        std::scoped_lock lk(m_output_mutex);
+            m_num_memory_requests_pending = m_num_memory_requests;
+            m_memory_request_event.Clear();
+        }
+
+        // Abandon any requests still outstanding when we leave, so that late responses are ignored
+        ON_SCOPE_EXIT {
+            std::scoped_lock lk(m_memory_request_mutex);
+            m_num_memory_requests = 0;
+            m_num_memory_requests_pending = 0;
+        };
+
+        // Send all requests back to back. Responses are collected as they arrive in ProcessInputData
+        for (size_t i = 0; i < m_num_memory_requests; ++i) {
+            const auto &request = m_memory_requests[i];
+
+            std::scoped_lock lk(m_output_mutex);
 
-        int attempts = 0;
-        do {
-            m_output_report.size = sizeof(WiiOutputReport0x17) + 1;
             auto report_data = reinterpret_cast<WiiReportData *>(m_output_report.data);
-            report_data->id = 0x17;
-            report_data->output0x17.address = ams::util::SwapEndian(read_addr);
-            report_data->output0x17.size = ams::util::SwapEndian(size);
+            if (request.is_write) {
+                m_output_report.size = sizeof(WiiOutputReport0x16) + 1;
+                report_data->id = 0x16;
+                report_data->output0x16.address = ams::util::SwapEndian(request.address);
+                report_data->output0x16.size = request.size;
+                std::memcpy(&report_data->output0x16.data, request.data, request.size);
+            } else {
+                m_output_report.size = sizeof(WiiOutputReport0x17) + 1;
+                report_data->id = 0x17;
+                report_data->output0x17.address = ams::util::SwapEndian(request.address);
+                report_data->output0x17.size = ams::util::SwapEndian(request.size);
+            }
 
-            R_TRY(this->WriteDataReport(&m_output_report, 0x21, output.get()));
-            report_data = reinterpret_cast<WiiReportData *>(&output->data);
-            result = report_data->input0x21.error;
+            R_TRY(this->WriteDataReport(&m_output_report));
+        }
 
-            if (R_SUCCEEDED(result)) {
-                std::memcpy(out_data, report_data->input0x21.data, report_data->input0x21.size + 1);
+        // Wait for all requests to complete. The timeout restarts whenever a response arrives
+        while (true) {
+            {
+                std::scoped_lock lk(m_memory_request_mutex);
+                if (m_num_memory_requests_pending == 0) {
+                    break;
+                }
             }
-        } while (!(R_SUCCEEDED(result) || (++attempts >= 2)));
 
-        return result;
-    }
+            if (!m_memory_request_event.TimedWait(ams::TimeSpan::FromMilliSeconds(500))) {
+                return -1; // This should return a proper failure code
+            }
+        }
 
-    Result WiiController::InitializeStandardExtension() {
-        R_TRY(this->WriteMemory(0x04a400f0, InitData1, sizeof(InitData1)));
-        R_TRY(this->WriteMemory(0x04a400fb, InitData2, sizeof(InitData2)));
+        // Hand results and read data back to the queued operations. A failed access (eg. reading an unmapped region) is only
+        // reported against its own operations, as every request still received a response
+        for (size_t i = 0; i < transaction->m_count; ++i) {
+            auto &op = transaction->m_operations[i];
+
+            const auto &request = m_memory_requests[op.request_index];
+            op.result = request.result;
+            if (R_SUCCEEDED(op.result) && !op.is_write) {
+                std::memcpy(op.out_data, &request.data[op.address - request.address], op.size);
+            }
+        }
 
         R_SUCCEED();
     }
 
+    void WiiController::HandleMemoryReadResponse(const WiiInputReport0x21 *response) {
+        std::scoped_lock lk(m_memory_request_mutex);
+
+        // Responses only carry the low 16 bits of the address they were read from, which isn't enough to tell apart reads of
+        // different regions (eg. 0x04a600fe and 0x04a400fe). The controller services reads in the order they were sent though,
+        // so a response always belongs to the oldest outstanding read
+        const u16 address = util::SwapEndian(response->address);
+
+        for (size_t i = 0; i < m_num_memory_requests; ++i) {
+            auto &request = m_memory_requests[i];
+            if (request.is_write || request.complete) {
+                continue;
+            }
+
+            if (response->error) {
+                request.result = response->error;
+            } else {
+                // Ignore stray responses, such as late ones for a request that was abandoned after timing out
+                if (address != static_cast<u16>(request.address + request.bytes_received)) {
+                    return;
+                }
+
+                const size_t size = std::min<size_t>(response->size + 1, request.size - request.bytes_received);
+                std::memcpy(&request.data[request.bytes_received], response->data, size);
+                request.bytes_received += size;
+            }
+
+            if (R_FAILED(request.result) || (request.bytes_received >= request.size)) {
+                request.complete = true;
+                m_num_memory_requests_pending -= 1;
+            }
+
+            m_memory_request_event.Signal();
+            return;
+        }
+    }
+
+    void WiiController::HandleMemoryWriteResponse(const WiiInputReport0x22 *response) {
+        if (response->report_id != 0x16) {
+            return;
+        }
+
+        std::scoped_lock lk(m_memory_request_mutex);
+
+        // Write acknowledgements carry no address, but the controller handles requests in order, so complete the oldest outstanding write
+        for (size_t i = 0; i < m_num_memory_requests; ++i) {
+            auto &request = m_memory_requests[i];
+            if (request.is_write && !request.complete) {
+                request.result = response->error;
+                request.complete = true;
+                m_num_memory_requests_pending -= 1;
+
+                m_memory_request_event.Signal();
+                return;
+            }
+        }
+    }
+
+    Result WiiController::InitializeStandardExtension() {
+        WiiMemoryTransaction transaction;
+        transaction.Write(0x04a400f0, InitData1, sizeof(InitData1));
+        transaction.Write(0x04a400fb, InitData2, sizeof(InitData2));
+        R_TRY(this->ExecuteMemoryTransaction(&transaction));
+        R_RETURN(transaction.GetResult());
+    }
+
     Result WiiController::InitializeMotionPlus() {
         R_TRY(this->WriteMemory(0x04a600f0, InitData1, sizeof(InitData1)));
 
@@ -803,11 +1074,18 @@ namespace ams::controller {
     }
 
     MotionPlusStatus WiiController::GetMotionPlusStatus() {
-        u16 extension_id;
+        u16 inactive_extension_id;
+        u16 active_extension_id;
+
+        // Query both the inactive and active extension ids in a single transaction. Either read may fail depending on the MotionPlus state
+        WiiMemoryTransaction transaction;
+        const auto inactive_read = transaction.Read(0x04a600fe, 2, &inactive_extension_id);
+        const auto active_read = transaction.Read(0x04a400fe, 2, &active_extension_id);
+        static_cast<void>(this->ExecuteMemoryTransaction(&transaction));
 
         // Check for inactive motion plus addon
-        if (R_SUCCEEDED(this->ReadMemory(0x04a600fe, 2, &extension_id))) {
-            extension_id = util::SwapEndian(extension_id);
+        if (R_SUCCEEDED(transaction.GetResult(inactive_read))) {
+            u16 extension_id = util::SwapEndian(inactive_extension_id);
 
             switch (extension_id) {
                 case 0x0005:
@@ -822,8 +1100,8 @@ namespace ams::controller {
         }
 
         // Check for active motion plus addon
-        if (R_SUCCEEDED(this->ReadMemory(0x04a400fe, 2, &extension_id))) {
-            extension_id = util::SwapEndian(extension_id);
+        if (R_SUCCEEDED(transaction.GetResult(active_read))) {
+            u16 extension_id = util::SwapEndian(active_extension_id);
 
             switch (extension_id) {
                 case 0x0405:
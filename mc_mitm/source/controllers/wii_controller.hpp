@@ -483,6 +483,37 @@ namespace ams::controller {
         };
     } PACKED;
 
+    // A batch of Wiimote memory accesses. Operations are issued back to back without waiting on each acknowledgement in turn,
+    // and runs of adjacent reads are merged into a single read request
+    class WiiMemoryTransaction {
+        public:
+            static constexpr size_t MaxOperations = 8;
+
+            WiiMemoryTransaction() : m_operations(), m_count(0) { }
+
+            size_t Read(u32 address, u16 size, void *out_data);
+            size_t Write(u32 address, const void *data, u8 size);
+
+            Result GetResult(size_t index) const { return m_operations[index].result; }
+            Result GetResult() const;
+
+        private:
+            friend class WiiController;
+
+            struct Operation {
+                u32 address;
+                u16 size;
+                bool is_write;
+                void *out_data;
+                u8 write_data[16];
+                size_t request_index;
+                Result result;
+            };
+
+            Operation m_operations[MaxOperations];
+            size_t m_count;
+    };
+
     class WiiController final : public EmulatedSwitchController {
 
         public:
@@ -495,13 +526,18 @@ namespace ams::controller {
             , m_orientation(WiiControllerOrientation_Horizontal)
             , m_extension(WiiExtensionController_None)
             , m_rumble_state(0)
+            , m_report_mode(0x30)
             , m_mp_extension_flag(false)
-            , m_mp_state_changing(false) { }
+            , m_mp_state_changing(false)
+            , m_memory_request_event(os::EventClearMode_AutoClear)
+            , m_num_memory_requests(0)
+            , m_num_memory_requests_pending(0) { }
 
             Result Initialize();
             Result SetVibration(const SwitchMotorData *motor_data);
             Result CancelVibration();
             Result SetPlayerLed(u8 led_mask);
+            Result SetMotionActive(bool active);
             void ProcessInputData(const bluetooth::HidReport *report) override;
 
         protected:
@@ -532,6 +568,7 @@ namespace ams::controller {
             WiiExtensionController GetExtensionControllerType();
             MotionPlusStatus GetMotionPlusStatus();
 
+            Result RefreshDeviceCache(bool cached);
             Result GetAccelerometerCalibration(WiiAccelerometerCalibrationData *calibration);
             Result GetMotionPlusCalibration(MotionPlusCalibrationData *calibration);
             Result GetBalanceBoardCalibration(BalanceBoardCalibrationData *calibration);
@@ -550,10 +587,12 @@ namespace ams::controller {
 
             Result WriteMemory(u32 write_addr, const void *data, u8 size);
             Result ReadMemory(u32 read_addr, u16 size, void *out_data);
+            Result ExecuteMemoryTransaction(WiiMemoryTransaction *transaction);
 
             WiiControllerOrientation m_orientation;
             WiiExtensionController m_extension;
             bool m_rumble_state;
+            u8 m_report_mode;
 
             bool m_mp_extension_flag;
             bool m_mp_state_changing;
@@ -564,6 +603,31 @@ namespace ams::controller {
                 MotionPlusCalibrationData motion_plus;
                 BalanceBoardCalibrationData balance_board;
             } m_ext_calibration;
+
+        private:
+            static constexpr size_t MaxMemoryReadSize = 0x40;
+
+            struct WiiMemoryRequest {
+                u32 address;
+                u16 size;
+                u16 bytes_received;
+                bool is_write;
+                bool complete;
+                Result result;
+                u8 data[MaxMemoryReadSize];
+            };
+
+            Result IssueMemoryRequests(WiiMemoryTransaction *transaction);
+            void HandleMemoryReadResponse(const WiiInputReport0x21 *response);
+            void HandleMemoryWriteResponse(const WiiInputReport0x22 *response);
+
+            os::SdkMutex m_memory_transaction_mutex;
+
+            os::SdkMutex m_memory_request_mutex;
+            os::Event m_memory_request_event;
+            WiiMemoryRequest m_memory_requests[WiiMemoryTransaction::MaxOperations];
+            size_t m_num_memory_requests;
+            size_t m_num_memory_requests_pending;
     };
 
 }
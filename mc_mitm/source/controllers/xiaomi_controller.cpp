@@ -21,8 +21,6 @@ namespace ams::controller {
 
     namespace {
 
-        constexpr u8 TriggerMax = UINT8_MAX;
-
         constinit const u8 InitPacket[] = { 0x20, 0x00, 0x00 };  // packet to init vibration apparently
 
     }
@@ -53,39 +51,7 @@ namespace ams::controller {
     void XiaomiController::MapInputReport0x04(const XiaomiReportData *src) {
         m_battery = convert_battery_100(src->input0x04.battery);
 
-        m_left_stick  = PackAnalogStickValues(src->input0x04.left_stick.x,  InvertAnalogStickValue(src->input0x04.left_stick.y));
-        m_right_stick = PackAnalogStickValues(src->input0x04.right_stick.x, InvertAnalogStickValue(src->input0x04.right_stick.y));
-
-        m_buttons.dpad_down  = (src->input0x04.buttons.dpad == XiaomiDPad_S)  ||
-                               (src->input0x04.buttons.dpad == XiaomiDPad_SE) ||
-                               (src->input0x04.buttons.dpad == XiaomiDPad_SW);
-        m_buttons.dpad_up    = (src->input0x04.buttons.dpad == XiaomiDPad_N)  ||
-                               (src->input0x04.buttons.dpad == XiaomiDPad_NE) ||
-                               (src->input0x04.buttons.dpad == XiaomiDPad_NW);
-        m_buttons.dpad_right = (src->input0x04.buttons.dpad == XiaomiDPad_E)  ||
-                               (src->input0x04.buttons.dpad == XiaomiDPad_NE) ||
-                               (src->input0x04.buttons.dpad == XiaomiDPad_SE);
-        m_buttons.dpad_left  = (src->input0x04.buttons.dpad == XiaomiDPad_W)  ||
-                               (src->input0x04.buttons.dpad == XiaomiDPad_NW) ||
-                               (src->input0x04.buttons.dpad == XiaomiDPad_SW);
-
-        m_buttons.A = src->input0x04.buttons.B;
-        m_buttons.B = src->input0x04.buttons.A;
-        m_buttons.X = src->input0x04.buttons.Y;
-        m_buttons.Y = src->input0x04.buttons.X;
-
-        m_buttons.R  = src->input0x04.buttons.R1;
-        m_buttons.ZR = src->input0x04.right_trigger > (m_trigger_threshold * TriggerMax);
-        m_buttons.L  = src->input0x04.buttons.L1;
-        m_buttons.ZL = src->input0x04.left_trigger  > (m_trigger_threshold * TriggerMax);
-
-        m_buttons.minus = src->input0x04.buttons.back;
-        m_buttons.plus  = src->input0x04.buttons.menu;
-
-        m_buttons.lstick_press = src->input0x04.buttons.lstick_press;
-        m_buttons.rstick_press = src->input0x04.buttons.rstick_press;
-
-        m_buttons.home = src->input0x04.home;
+        this->MapReportLayout<XiaomiInputReport0x04Layout>(src);
     }
 
 }
@@ -76,6 +76,22 @@ namespace ams::controller {
         };
     } PACKED;
 
+    // Home shares the byte following the battery level
+    constexpr layout::Button XiaomiExtraButtons[] = {
+        { sizeof(XiaomiInputReport0x04::battery), 0, SwitchButtonBit_Home },
+    };
+
+    constexpr auto XiaomiInputReport0x04Layout = []() {
+        layout::ReportLayout l;
+        l.SetSticks(offsetof(XiaomiReportData, input0x04.left_stick), offsetof(XiaomiReportData, input0x04.right_stick));
+        l.SetHat(offsetof(XiaomiReportData, input0x04.buttons.dpad), XiaomiDPad_N);
+        l.AddButtons(offsetof(XiaomiReportData, input0x04.buttons), layout::GenericGamepadButtons);
+        l.AddButtons(offsetof(XiaomiReportData, input0x04.battery), XiaomiExtraButtons);
+        l.AddTrigger(offsetof(XiaomiReportData, input0x04.right_trigger), SwitchButtonBit_ZR);
+        l.AddTrigger(offsetof(XiaomiReportData, input0x04.left_trigger), SwitchButtonBit_ZL);
+        return l;
+    }();
+
     class XiaomiController final : public EmulatedSwitchController {
 
         public:
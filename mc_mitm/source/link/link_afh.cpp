@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "link_afh.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_hci.hpp"
+#include "../mcmitm_config.hpp"
+
+namespace ams::link {
+
+    namespace {
+
+        // Bluetooth channel n is centred on 2402 + n MHz, while 2.4GHz Wi-Fi channel n is 20MHz wide centred on 2407 + 5n MHz
+        constexpr int MinWifiChannel = 1;
+        constexpr int MaxWifiChannel = 13;
+
+        constexpr u8 GetWifiBandFirstChannel(int wifi_channel) { return static_cast<u8>(std::max(5 * wifi_channel - 5, 0)); }
+        constexpr u8 GetWifiBandLastChannel(int wifi_channel)  { return static_cast<u8>(std::min<int>(5 * wifi_channel + 15, BluetoothChannelCount - 1)); }
+
+        // A band is excluded once the links have avoided most of it for several evaluations in a row. It is released again after a
+        // hold time, as excluded channels look avoided for as long as the exclusion lasts and so can't be reassessed while it is active
+        constexpr float CongestionThreshold = 0.5f;
+        constexpr float CongestionSmoothing = 0.5f;
+        constexpr u32 ExclusionEnterCount = 3;
+
+        constinit os::SdkMutex g_afh_lock;
+        constinit AfhStatistics g_stats = {};
+
+        constinit float g_congestion[BluetoothChannelCount] = {};
+        constinit int g_candidate_channel = 0;
+        constinit u32 g_candidate_count = 0;
+        constinit os::Tick g_last_evaluation = os::Tick(0);
+        constinit os::Tick g_exclusion_start = os::Tick(0);
+
+        // Channels that were disabled before the exclusion was applied, restored when it is released
+        constinit u8 g_saved_first_channel = 0xff;
+        constinit u8 g_saved_last_channel = 0xff;
+
+        Result SetDisabledChannels(u8 first, u8 last) {
+            tBSA_DM_SET_CONFIG config = {};
+            config.config_mask = BSA_DM_CONFIG_CHANNEL_MASK;
+            config.first_disabled_channel = first;
+            config.last_disabled_channel = last;
+            R_RETURN(bluetooth::hci::DmSetConfig(&config));
+        }
+
+        void ResetCongestion() {
+            std::fill(std::begin(g_congestion), std::end(g_congestion), 0.0f);
+            g_candidate_channel = 0;
+            g_candidate_count = 0;
+        }
+
+        void RecordResult(Result result) {
+            std::scoped_lock lk(g_afh_lock);
+
+            g_stats.last_result = result.GetValue();
+            if (R_FAILED(result)) {
+                g_stats.num_failures += 1;
+            }
+        }
+
+        void ApplyExclusion(int wifi_channel) {
+            const u8 first = GetWifiBandFirstChannel(wifi_channel);
+            const u8 last = GetWifiBandLastChannel(wifi_channel);
+
+            bluetooth::hci::GetDisabledChannels(&g_saved_first_channel, &g_saved_last_channel);
+
+            const Result result = SetDisabledChannels(first, last);
+            RecordResult(result);
+            if (R_FAILED(result)) {
+                return;
+            }
+
+            g_exclusion_start = os::GetSystemTick();
+
+            std::scoped_lock lk(g_afh_lock);
+            g_stats.exclusion_active = true;
+            g_stats.first_excluded_channel = first;
+            g_stats.last_excluded_channel = last;
+            g_stats.wifi_channel = wifi_channel;
+            g_stats.num_exclusions += 1;
+        }
+
+        void ReleaseExclusion() {
+            u8 first, last;
+            bluetooth::hci::GetDisabledChannels(&first, &last);
+
+            // Leave the channels alone if something else has changed them since the exclusion was applied
+            {
+                std::scoped_lock lk(g_afh_lock);
+                if ((first == g_stats.first_excluded_channel) && (last == g_stats.last_excluded_channel)) {
+                    first = g_saved_first_channel;
+                    last = g_saved_last_channel;
+                }
+            }
+
+            const Result result = SetDisabledChannels(first, last);
+            RecordResult(result);
+            if (R_FAILED(result)) {
+                return;
+            }
+
+            ResetCongestion();
+
+            std::scoped_lock lk(g_afh_lock);
+            g_stats.exclusion_active = false;
+        }
+
+        // Fraction of links that have classified each channel as unusable. Returns false if no link has AFH enabled
+        bool ReadChannelAvoidance(const u16 *handles, size_t count, float *out_avoidance) {
+            u32 avoided[BluetoothChannelCount] = {};
+            u32 num_maps = 0;
+
+            for (size_t i = 0; i < count; ++i) {
+                const bluetooth::hci::HciConnectionHandleParams params = { handles[i] };
+                bluetooth::hci::HciReadAfhChannelMapReply reply = {};
+                if (R_FAILED(bluetooth::hci::SendCommand(bluetooth::hci::HciOpcode_ReadAfhChannelMap, &params, sizeof(params), &reply, sizeof(reply))) || (reply.afh_mode == 0)) {
+                    continue;
+                }
+
+                for (size_t channel = 0; channel < BluetoothChannelCount; ++channel) {
+                    if ((reply.channel_map[channel / 8] & BIT(channel % 8)) == 0) {
+                        avoided[channel] += 1;
+                    }
+                }
+
+                num_maps += 1;
+            }
+
+            if (num_maps == 0) {
+                return false;
+            }
+
+            for (size_t channel = 0; channel < BluetoothChannelCount; ++channel) {
+                out_avoidance[channel] = static_cast<float>(avoided[channel]) / num_maps;
+            }
+
+            return true;
+        }
+
+        // Finds the Wi-Fi channel whose band the links are avoiding the most
+        int FindMostCongestedWifiChannel(float *out_congestion) {
+            int best_channel = MinWifiChannel;
+            float best_congestion = 0.0f;
+
+            for (int wifi_channel = MinWifiChannel; wifi_channel <= MaxWifiChannel; ++wifi_channel) {
+                const u8 first = GetWifiBandFirstChannel(wifi_channel);
+                const u8 last = GetWifiBandLastChannel(wifi_channel);
+
+                float congestion = 0.0f;
+                for (u8 channel = first; channel <= last; ++channel) {
+                    congestion += g_congestion[channel];
+                }
+                congestion /= (last - first + 1);
+
+                if (congestion > best_congestion) {
+                    best_channel = wifi_channel;
+                    best_congestion = congestion;
+                }
+            }
+
+            *out_congestion = best_congestion;
+            return best_channel;
+        }
+
+    }
+
+    void UpdateChannelExclusion(const u16 *handles, size_t count) {
+        auto config = &mitm::GetGlobalConfig()->afh;
+
+        bool active;
+        {
+            std::scoped_lock lk(g_afh_lock);
+            active = g_stats.exclusion_active;
+        }
+
+        // Nothing to steer around without any links
+        if (!config->enable || (count == 0)) {
+            if (active) {
+                ReleaseExclusion();
+            }
+            return;
+        }
+
+        const auto now = os::GetSystemTick();
+        if ((g_last_evaluation.GetInt64Value() != 0) && (os::ConvertToTimeSpan(now - g_last_evaluation) < TimeSpan::FromSeconds(config->interval))) {
+            return;
+        }
+        g_last_evaluation = now;
+
+        if (active) {
+            if (os::ConvertToTimeSpan(now - g_exclusion_start) >= TimeSpan::FromSeconds(config->hold_time)) {
+                ReleaseExclusion();
+            }
+            return;
+        }
+
+        float avoidance[BluetoothChannelCount];
+        if (!ReadChannelAvoidance(handles, count, avoidance)) {
+            return;
+        }
+
+        for (size_t channel = 0; channel < BluetoothChannelCount; ++channel) {
+            g_congestion[channel] += (avoidance[channel] - g_congestion[channel]) * CongestionSmoothing;
+        }
+
+        float congestion;
+        const int wifi_channel = FindMostCongestedWifiChannel(&congestion);
+
+        if ((congestion >= CongestionThreshold) && (wifi_channel == g_candidate_channel)) {
+            g_candidate_count += 1;
+        } else {
+            g_candidate_channel = wifi_channel;
+            g_candidate_count = congestion >= CongestionThreshold ? 1 : 0;
+        }
+
+        {
+            std::scoped_lock lk(g_afh_lock);
+            for (size_t channel = 0; channel < BluetoothChannelCount; ++channel) {
+                g_stats.channel_congestion[channel] = static_cast<u8>(g_congestion[channel] * 255.0f);
+            }
+            g_stats.wifi_channel = g_candidate_channel;
+        }
+
+        if (g_candidate_count >= ExclusionEnterCount) {
+            ApplyExclusion(g_candidate_channel);
+        }
+    }
+
+    void GetAfhStatistics(AfhStatistics *out_stats) {
+        std::scoped_lock lk(g_afh_lock);
+        *out_stats = g_stats;
+    }
+
+}
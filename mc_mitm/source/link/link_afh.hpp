@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::link {
+
+    constexpr size_t BluetoothChannelCount = 79;
+
+    struct AfhStatistics {
+        bool exclusion_active;
+        u8 first_excluded_channel;
+        u8 last_excluded_channel;
+        u8 wifi_channel;  // 2.4GHz Wi-Fi channel whose band is (or would be) excluded
+        u32 num_exclusions;
+        u32 num_failures;
+        u32 last_result;
+        u8 channel_congestion[BluetoothChannelCount];  // 0 = used by every link, 255 = avoided by every link
+    };
+
+    // Called periodically from the link thread with the handles of the connected controllers
+    void UpdateChannelExclusion(const u16 *handles, size_t count);
+    void GetAfhStatistics(AfhStatistics *out_stats);
+
+}
@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "link_policy.hpp"
+#include "link_afh.hpp"
+#include "link_quality.hpp"
+#include "link_reconnect.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_hci.hpp"
+#include "../mcmitm_config.hpp"
+#include "../utils.hpp"
+
+namespace ams::link {
+
+    namespace {
+
+        constexpr TimeSpan UpdateInterval = TimeSpan::FromSeconds(1);
+
+        constexpr size_t ThreadStackSize = 0x1000;
+        alignas(os::ThreadStackAlignment) constinit u8 g_thread_stack[ThreadStackSize];
+        constinit os::ThreadType g_thread;
+
+        os::Event g_update_event(os::EventClearMode_AutoClear);
+
+        struct Link {
+            bool in_use;
+            bool handle_valid;
+            bool applied;
+            u32 generation;
+            os::Tick attach_tick;
+            LinkPolicyStatistics stats;
+            LinkQualityRecorder quality;
+        };
+
+        constinit os::SdkMutex g_link_lock;
+        constinit Link g_links[controller::MaxControllers] = {};
+        constinit u32 g_link_generation = 0;
+
+        constinit bool g_rssi_monitoring = false;
+
+        LinkPolicyMode GetLinkPolicyMode(controller::ControllerType type) {
+            auto config = &mitm::GetGlobalConfig()->link_policy;
+            if (!config->enable) {
+                return LinkPolicyMode_None;
+            }
+
+            switch (type) {
+                case controller::ControllerType_Switch:
+                    return static_cast<LinkPolicyMode>(config->switch_mode);
+                case controller::ControllerType_Wii:
+                    return static_cast<LinkPolicyMode>(config->wii_mode);
+                case controller::ControllerType_Dualshock3:
+                    return static_cast<LinkPolicyMode>(config->dualshock3_mode);
+                case controller::ControllerType_Dualshock4:
+                    return static_cast<LinkPolicyMode>(config->dualshock4_mode);
+                case controller::ControllerType_Dualsense:
+                    return static_cast<LinkPolicyMode>(config->dualsense_mode);
+                case controller::ControllerType_XboxOne:
+                    return static_cast<LinkPolicyMode>(config->xboxone_mode);
+                default:
+                    return static_cast<LinkPolicyMode>(config->other_mode);
+            }
+        }
+
+        // Controllers that don't track their own activity are treated as always active
+        bool IsLinkActive(const Link &link) {
+            auto controller = controller::LocateHandler(link.stats.address);
+            if (!controller) {
+                return false;
+            }
+
+            const auto last_activity = controller->GetLastActivityTick();
+            if ((last_activity.GetInt64Value() == 0) && controller->IsOfficialController()) {
+                return true;
+            }
+
+            const auto idle_timeout = TimeSpan::FromSeconds(mitm::GetGlobalConfig()->link_policy.idle_timeout);
+            return os::ConvertToTimeSpan(os::GetSystemTick() - std::max(last_activity, link.attach_tick)) < idle_timeout;
+        }
+
+        Result SetSniffEnabled(Link *link, bool enable) {
+            tBSA_DM_SET_CONFIG config = {};
+            config.config_mask = BSA_DM_CONFIG_LINK_POLICY_MASK;
+            config.policy_param.link_bd_addr = link->stats.address;
+            config.policy_param.policy_mask = bluetooth::hci::HciLinkPolicy_Sniff;
+            config.policy_param.set = enable;
+            R_TRY(bluetooth::hci::DmSetConfig(&config));
+
+            link->stats.sniff_disabled = !enable;
+
+            // Changing the policy doesn't wake a link that is already sniffing. This fails harmlessly if the link is already active
+            if (!enable) {
+                const bluetooth::hci::HciConnectionHandleParams params = { link->stats.handle };
+                static_cast<void>(bluetooth::hci::SendCommand(bluetooth::hci::HciOpcode_ExitSniffMode, &params, sizeof(params)));
+            }
+
+            R_SUCCEED();
+        }
+
+        Result SetLowLatency(Link *link, bool enable) {
+            auto config = &mitm::GetGlobalConfig()->link_policy;
+
+            const bluetooth::hci::HciQosSetupParams qos_params = {
+                .handle = link->stats.handle,
+                .flags = 0,
+                .service_type = enable ? bluetooth::hci::HciServiceType_Guaranteed : bluetooth::hci::HciServiceType_BestEffort,
+                .token_rate = 0,
+                .peak_bandwidth = 0,
+                .latency = enable ? static_cast<u32>(config->qos_latency) : UINT32_MAX,
+                .delay_variation = UINT32_MAX
+            };
+            R_TRY(bluetooth::hci::SendCommand(bluetooth::hci::HciOpcode_QosSetup, &qos_params, sizeof(qos_params)));
+
+            link->stats.qos_guaranteed = enable;
+
+            // Flush timeout is given in 0.625ms slots, with 0 meaning packets are retransmitted until acknowledged
+            const bluetooth::hci::HciWriteAutomaticFlushTimeoutParams flush_params = {
+                .handle = link->stats.handle,
+                .timeout = enable ? static_cast<u16>(config->flush_timeout * 8 / 5) : u16(0)
+            };
+            R_TRY(bluetooth::hci::SendCommand(bluetooth::hci::HciOpcode_WriteAutomaticFlushTimeout, &flush_params, sizeof(flush_params)));
+
+            link->stats.flush_timeout = flush_params.timeout;
+
+            R_SUCCEED();
+        }
+
+        Result GetLinkHandle(Link *link) {
+            if (!link->handle_valid) {
+                R_TRY(bluetooth::hci::GetHandle(link->stats.address, &link->stats.handle));
+                link->handle_valid = true;
+            }
+
+            R_SUCCEED();
+        }
+
+        Result ApplyLinkPolicy(Link *link, bool active) {
+            R_TRY(GetLinkHandle(link));
+
+            // Power saving is restored in the reverse order it was disabled
+            if (active) {
+                R_TRY(SetSniffEnabled(link, false));
+                if (link->stats.mode == LinkPolicyMode_LowLatency) {
+                    R_TRY(SetLowLatency(link, true));
+                }
+            } else {
+                if (link->stats.mode == LinkPolicyMode_LowLatency) {
+                    R_TRY(SetLowLatency(link, false));
+                }
+                R_TRY(SetSniffEnabled(link, true));
+            }
+
+            R_SUCCEED();
+        }
+
+        bool UpdateLinkPolicy(Link *link) {
+            if (link->stats.mode == LinkPolicyMode_None) {
+                return false;
+            }
+
+            const bool active = IsLinkActive(*link);
+            if (link->applied && (active == link->stats.active)) {
+                return false;
+            }
+
+            const Result result = ApplyLinkPolicy(link, active);
+
+            link->stats.last_result = result.GetValue();
+            if (R_SUCCEEDED(result)) {
+                link->stats.active = active;
+                link->stats.num_updates += 1;
+                link->applied = true;
+            } else {
+                link->stats.num_failures += 1;
+            }
+
+            return true;
+        }
+
+        bool UpdateLinkQuality(Link *link) {
+            auto config = &mitm::GetGlobalConfig()->link_quality;
+            if (!config->enable || !link->quality.IsSampleDue(TimeSpan::FromSeconds(config->sample_interval))) {
+                return false;
+            }
+
+            LinkQualitySample sample = {};
+            Result result = GetLinkHandle(link);
+            if (R_SUCCEEDED(result)) {
+                result = SampleLinkQuality(link->stats.address, link->stats.handle, &sample);
+            }
+
+            link->quality.Record(result, sample);
+
+            return true;
+        }
+
+        void UpdateLink(Link *link) {
+            Link snapshot;
+            {
+                std::scoped_lock lk(g_link_lock);
+                if (!link->in_use) {
+                    return;
+                }
+
+                snapshot = *link;
+            }
+
+            const bool policy_updated = UpdateLinkPolicy(&snapshot);
+            const bool quality_updated = UpdateLinkQuality(&snapshot);
+            if (!policy_updated && !quality_updated) {
+                return;
+            }
+
+            // The controller may have disconnected while we were waiting on the bluetooth stack
+            std::scoped_lock lk(g_link_lock);
+            if (link->in_use && (link->generation == snapshot.generation)) {
+                *link = snapshot;
+            }
+        }
+
+        // RSSI monitoring is a global setting of the bluetooth stack, so is only applied once a controller is connected and the stack is known to be up
+        void UpdateRssiMonitoring() {
+            auto config = &mitm::GetGlobalConfig()->link_quality;
+            if (!config->monitor_rssi || g_rssi_monitoring) {
+                return;
+            }
+
+            {
+                std::scoped_lock lk(g_link_lock);
+                if (std::none_of(std::begin(g_links), std::end(g_links), [](const Link &l) { return l.in_use; })) {
+                    return;
+                }
+            }
+
+            g_rssi_monitoring = R_SUCCEEDED(SetRssiMonitoring(true, config->rssi_monitor_period));
+        }
+
+        void UpdateAfh() {
+            u16 handles[controller::MaxControllers];
+            size_t count = 0;
+
+            // Handles are otherwise only resolved by the link policy and quality paths, which may both be disabled
+            if (mitm::GetGlobalConfig()->afh.enable) {
+                for (auto &link : g_links) {
+                    Link snapshot;
+                    {
+                        std::scoped_lock lk(g_link_lock);
+                        if (!link.in_use) {
+                            continue;
+                        }
+
+                        snapshot = link;
+                    }
+
+                    if (R_FAILED(GetLinkHandle(&snapshot))) {
+                        continue;
+                    }
+
+                    handles[count++] = snapshot.stats.handle;
+
+                    std::scoped_lock lk(g_link_lock);
+                    if (link.in_use && (link.generation == snapshot.generation)) {
+                        link.stats.handle = snapshot.stats.handle;
+                        link.handle_valid = true;
+                    }
+                }
+            }
+
+            UpdateChannelExclusion(handles, count);
+        }
+
+        void LinkPolicyThreadFunc(void *) {
+            while (true) {
+                g_update_event.TimedWait(UpdateInterval);
+
+                UpdateRssiMonitoring();
+                UpdateReconnect();
+
+                for (auto &link : g_links) {
+                    UpdateLink(&link);
+                }
+
+                UpdateAfh();
+            }
+        }
+
+    }
+
+    void Initialize() {
+        R_ABORT_UNLESS(os::CreateThread(&g_thread,
+            LinkPolicyThreadFunc,
+            nullptr,
+            g_thread_stack,
+            ThreadStackSize,
+            mitm::GetGlobalConfig()->threads.link_priority
+        ));
+
+        os::SetThreadNamePointer(&g_thread, "mc::LinkPolicyThread");
+        os::StartThread(&g_thread);
+    }
+
+    void AttachController(const bluetooth::Address &address, controller::ControllerType type) {
+        const auto mode = GetLinkPolicyMode(type);
+
+        {
+            std::scoped_lock lk(g_link_lock);
+
+            auto link = std::find_if(std::begin(g_links), std::end(g_links), [](const Link &l) { return !l.in_use; });
+            if (link == std::end(g_links)) {
+                return;
+            }
+
+            link->in_use = true;
+            link->handle_valid = false;
+            link->applied = false;
+            link->generation = ++g_link_generation;
+            link->attach_tick = os::GetSystemTick();
+            link->stats = {
+                .address = address,
+                .mode = mode
+            };
+            link->quality.Reset();
+        }
+
+        OnControllerConnected(address);
+
+        // Controller has just been connected, so apply the active policy straight away
+        g_update_event.Signal();
+    }
+
+    void DetachController(const bluetooth::Address &address, DisconnectReason reason) {
+        OnControllerDisconnected(address, reason);
+
+        std::scoped_lock lk(g_link_lock);
+
+        for (auto &link : g_links) {
+            if (link.in_use && utils::BluetoothAddressCompare(link.stats.address, address)) {
+                link.in_use = false;
+                return;
+            }
+        }
+    }
+
+    size_t GetLinkPolicyStatistics(LinkPolicyStatistics *out_stats, size_t max_count) {
+        std::scoped_lock lk(g_link_lock);
+
+        size_t count = 0;
+        for (auto &link : g_links) {
+            if (link.in_use && (count < max_count)) {
+                out_stats[count++] = link.stats;
+            }
+        }
+
+        return count;
+    }
+
+    size_t GetLinkQualityHistory(LinkQualityHistory *out_history, size_t max_count) {
+        std::scoped_lock lk(g_link_lock);
+
+        size_t count = 0;
+        for (auto &link : g_links) {
+            if (link.in_use && (count < max_count)) {
+                auto history = &out_history[count++];
+                history->address = link.stats.address;
+                history->handle = link.handle_valid ? link.stats.handle : 0;
+                link.quality.GetHistory(history);
+            }
+        }
+
+        return count;
+    }
+
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "../controllers/controller_management.hpp"
+#include "link_quality.hpp"
+#include "link_reconnect.hpp"
+
+namespace ams::link {
+
+    enum LinkPolicyMode : u8 {
+        LinkPolicyMode_None       = 0,  // Leave the link as the system configured it
+        LinkPolicyMode_NoSniff    = 1,  // Keep the link out of sniff mode while the controller is in use
+        LinkPolicyMode_LowLatency = 2,  // As above, also requesting guaranteed QoS and a short flush timeout
+    };
+
+    struct LinkPolicyStatistics {
+        bluetooth::Address address;
+        u16 handle;
+        LinkPolicyMode mode;
+        bool active;
+        bool sniff_disabled;
+        bool qos_guaranteed;
+        u16 flush_timeout;
+        u32 num_updates;
+        u32 num_failures;
+        u32 last_result;
+    };
+
+    void Initialize();
+
+    void AttachController(const bluetooth::Address &address, controller::ControllerType type);
+    void DetachController(const bluetooth::Address &address, DisconnectReason reason);
+
+    size_t GetLinkPolicyStatistics(LinkPolicyStatistics *out_stats, size_t max_count);
+    size_t GetLinkQualityHistory(LinkQualityHistory *out_history, size_t max_count);
+
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "link_quality.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_hci.hpp"
+#include "../controllers/controller_report_rate.hpp"
+
+namespace ams::link {
+
+    void LinkQualityRecorder::Record(Result result, const LinkQualitySample &sample) {
+        m_last_sample_tick = os::GetSystemTick();
+        m_last_result = result.GetValue();
+
+        if (R_FAILED(result)) {
+            m_num_failures += 1;
+            return;
+        }
+
+        m_samples[m_write_index] = sample;
+        m_write_index = (m_write_index + 1) % LinkQualityHistoryLength;
+        m_count = std::min<u32>(m_count + 1, LinkQualityHistoryLength);
+    }
+
+    void LinkQualityRecorder::GetHistory(LinkQualityHistory *out_history) const {
+        out_history->count = m_count;
+        out_history->num_failures = m_num_failures;
+        out_history->last_result = m_last_result;
+
+        const u32 start = (m_write_index + LinkQualityHistoryLength - m_count) % LinkQualityHistoryLength;
+        for (u32 i = 0; i < m_count; ++i) {
+            out_history->samples[i] = m_samples[(start + i) % LinkQualityHistoryLength];
+        }
+    }
+
+    Result SampleLinkQuality(const bluetooth::Address &address, u16 handle, LinkQualitySample *out_sample) {
+        const bluetooth::hci::HciConnectionHandleParams params = { handle };
+
+        bluetooth::hci::HciReadRssiReply rssi = {};
+        bluetooth::hci::HciReadLinkQualityReply link_quality = {};
+        bluetooth::hci::HciReadFailedContactCounterReply failed_contact = {};
+
+        bluetooth::hci::CommandRequest requests[] = {
+            { bluetooth::hci::HciOpcode_ReadRssi,                 &params, sizeof(params), &rssi,           sizeof(rssi),           bluetooth::hci::DefaultTimeout },
+            { bluetooth::hci::HciOpcode_ReadLinkQuality,          &params, sizeof(params), &link_quality,   sizeof(link_quality),   bluetooth::hci::DefaultTimeout },
+            { bluetooth::hci::HciOpcode_ReadFailedContactCounter, &params, sizeof(params), &failed_contact, sizeof(failed_contact), bluetooth::hci::DefaultTimeout },
+        };
+        bluetooth::hci::SendCommandBatch(requests, util::size(requests));
+
+        for (auto &request : requests) {
+            R_TRY(request.result);
+        }
+
+        // Report rates are included so that a drop in input rate can be matched against the state of the radio link
+        controller::ReportRateStatistics rate_stats = {};
+        controller::GetReportRateStatistics(address, &rate_stats);
+
+        *out_sample = {
+            .timestamp_ms = static_cast<u64>(os::ConvertToTimeSpan(os::GetSystemTick()).GetMilliSeconds()),
+            .rssi = rssi.rssi,
+            .link_quality = link_quality.link_quality,
+            .failed_contact_counter = failed_contact.counter,
+            .report_rate = rate_stats.report_rate,
+            .measured_rate = rate_stats.measured_rate
+        };
+
+        R_SUCCEED();
+    }
+
+    Result SetRssiMonitoring(bool enable, u16 period) {
+        tBSA_DM_SET_CONFIG config = {};
+        config.config_mask = BSA_DM_CONFIG_MONITOR_RSSI;
+        config.monitor_rssi_param.enable = enable;
+        config.monitor_rssi_param.period = period;
+        R_RETURN(bluetooth::hci::DmSetConfig(&config));
+    }
+
+}
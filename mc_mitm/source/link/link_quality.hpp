@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
+
+namespace ams::link {
+
+    constexpr size_t LinkQualityHistoryLength = 32;
+
+    struct LinkQualitySample {
+        u64 timestamp_ms;
+        s8 rssi;
+        u8 link_quality;
+        u16 failed_contact_counter;  // Cumulative since the link was established
+        u16 report_rate;
+        u16 measured_rate;
+    };
+
+    struct LinkQualityHistory {
+        bluetooth::Address address;
+        u16 handle;
+        u32 count;
+        u32 num_failures;
+        u32 last_result;
+        LinkQualitySample samples[LinkQualityHistoryLength];  // Oldest first
+    };
+
+    // Fixed size ring of samples for a single link
+    class LinkQualityRecorder {
+        public:
+            constexpr LinkQualityRecorder() = default;
+
+            void Reset() {
+                m_write_index = 0;
+                m_count = 0;
+                m_num_failures = 0;
+                m_last_result = 0;
+                m_last_sample_tick = os::Tick(0);
+            }
+
+            bool IsSampleDue(TimeSpan interval) const {
+                return (m_last_sample_tick.GetInt64Value() == 0) || (os::ConvertToTimeSpan(os::GetSystemTick() - m_last_sample_tick) >= interval);
+            }
+
+            void Record(Result result, const LinkQualitySample &sample);
+            void GetHistory(LinkQualityHistory *out_history) const;
+
+        private:
+            LinkQualitySample m_samples[LinkQualityHistoryLength] = {};
+            u32 m_write_index = 0;
+            u32 m_count = 0;
+            u32 m_num_failures = 0;
+            u32 m_last_result = 0;
+            os::Tick m_last_sample_tick = os::Tick(0);
+    };
+
+    // Reads the current link statistics from the controller. Blocks on the bluetooth stack, see bluetooth::hci
+    Result SampleLinkQuality(const bluetooth::Address &address, u16 handle, LinkQualitySample *out_sample);
+
+    Result SetRssiMonitoring(bool enable, u16 period);
+
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "link_reconnect.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_hci.hpp"
+#include "../controllers/controller_management.hpp"
+#include "../mcmitm_config.hpp"
+#include "../utils.hpp"
+
+namespace ams::link {
+
+    namespace {
+
+        // Page scan parameters are given in 0.625ms slots. Fast scanning listens for half of every 22.5ms. The system's own
+        // parameters are read back from the controller before switching, so that they can be restored afterwards
+        constexpr u16 FastPageScanInterval  = 0x0024;
+        constexpr u16 FastPageScanWindow    = 0x0012;
+
+        // A disconnect requested by the console is reported back once the stack has closed the connection
+        constexpr TimeSpan LocalDisconnectTimeout = TimeSpan::FromSeconds(5);
+
+        enum PageScanState {
+            PageScanState_Stock,
+            PageScanState_Fast,
+            PageScanState_Unknown,
+        };
+
+        struct ExpectedController {
+            bluetooth::Address address;
+            os::Tick since;
+        };
+
+        struct LocalDisconnect {
+            bluetooth::Address address;
+            os::Tick requested;
+        };
+
+        struct PendingConnection {
+            bool in_use;
+            bool fast_page_scan;
+            bluetooth::Address address;
+            os::Tick opened;
+            u32 wait_ms;
+        };
+
+        constinit os::SdkMutex g_reconnect_lock;
+        constinit ExpectedController g_expected[controller::MaxControllers] = {};
+        constinit size_t g_num_expected = 0;
+        constinit PendingConnection g_pending[controller::MaxControllers] = {};
+        constinit LocalDisconnect g_local_disconnects[controller::MaxControllers] = {};
+        constinit bool g_sleeping = false;
+        constinit PageScanState g_page_scan_state = PageScanState_Stock;
+        constinit bool g_stock_page_scan_valid = false;
+        constinit u16 g_stock_page_scan_interval = 0;
+        constinit u16 g_stock_page_scan_window = 0;
+        constinit ReconnectStatistics g_stats = {};
+
+        ExpectedController *FindExpectedController(const bluetooth::Address &address) {
+            for (size_t i = 0; i < g_num_expected; ++i) {
+                if (utils::BluetoothAddressCompare(g_expected[i].address, address)) {
+                    return &g_expected[i];
+                }
+            }
+
+            return nullptr;
+        }
+
+        void RemoveExpectedController(ExpectedController *expected) {
+            *expected = g_expected[--g_num_expected];
+        }
+
+        u32 GetElapsedMilliSeconds(os::Tick from, os::Tick to) {
+            return static_cast<u32>(std::max<s64>(os::ConvertToTimeSpan(to - from).GetMilliSeconds(), 0));
+        }
+
+        // Records are kept oldest first, shifting out the oldest once full
+        void AddReconnectRecord(const ReconnectRecord &record) {
+            if (g_stats.count == ReconnectHistoryLength) {
+                std::copy(g_stats.records + 1, g_stats.records + ReconnectHistoryLength, g_stats.records);
+                g_stats.count -= 1;
+            }
+
+            g_stats.records[g_stats.count++] = record;
+        }
+
+        // Returns whether the console asked for the connection to be closed recently, forgetting the request
+        bool ConsumeLocalDisconnect(const bluetooth::Address &address) {
+            const auto now = os::GetSystemTick();
+            for (auto &local : g_local_disconnects) {
+                if ((local.requested.GetInt64Value() != 0) && utils::BluetoothAddressCompare(local.address, address)) {
+                    const bool recent = now - local.requested < os::ConvertToTick(LocalDisconnectTimeout);
+                    local = {};
+                    return recent;
+                }
+            }
+
+            return false;
+        }
+
+        Result ReadPageScanParameters(u16 *out_interval, u16 *out_window) {
+            bluetooth::hci::HciReadPageScanActivityReply reply;
+            R_TRY(bluetooth::hci::SendCommand(bluetooth::hci::HciOpcode_ReadPageScanActivity, nullptr, 0, &reply, sizeof(reply)));
+            R_UNLESS(reply.status == 0, svc::ResultInvalidState());
+
+            *out_interval = reply.interval;
+            *out_window = reply.window;
+
+            R_SUCCEED();
+        }
+
+        Result SetPageScanParameters(u16 interval, u16 window) {
+            tBSA_DM_SET_CONFIG config = {};
+            config.config_mask = BSA_DM_CONFIG_PAGE_SCAN_PARAM_MASK;
+            config.page_scan_interval = interval;
+            config.page_scan_window = window;
+            R_RETURN(bluetooth::hci::DmSetConfig(&config));
+        }
+
+        // Stock page scan parameters are only accessed from the thread calling UpdateReconnect
+        Result EnableFastPageScan(bool capture_stock) {
+            if (capture_stock || !g_stock_page_scan_valid) {
+                R_TRY(ReadPageScanParameters(&g_stock_page_scan_interval, &g_stock_page_scan_window));
+                g_stock_page_scan_valid = true;
+            }
+
+            R_RETURN(SetPageScanParameters(FastPageScanInterval, FastPageScanWindow));
+        }
+
+        Result RestoreStockPageScan() {
+            // Nothing to restore if the parameters were never changed
+            if (!g_stock_page_scan_valid) {
+                R_SUCCEED();
+            }
+
+            R_RETURN(SetPageScanParameters(g_stock_page_scan_interval, g_stock_page_scan_window));
+        }
+
+        // Measures how long each reconnected controller took to deliver its first input report
+        void UpdatePendingConnections(os::Tick now, os::Tick timeout) {
+            PendingConnection pending[controller::MaxControllers];
+            {
+                std::scoped_lock lk(g_reconnect_lock);
+                std::memcpy(pending, g_pending, sizeof(pending));
+            }
+
+            for (size_t i = 0; i < util::size(pending); ++i) {
+                if (!pending[i].in_use) {
+                    continue;
+                }
+
+                auto controller = controller::LocateHandler(pending[i].address);
+                const auto first_report = controller ? controller->GetFirstInputReportTick() : os::Tick(0);
+                const bool live = first_report.GetInt64Value() != 0;
+                if (!live && controller && (now - pending[i].opened < timeout)) {
+                    continue;
+                }
+
+                std::scoped_lock lk(g_reconnect_lock);
+
+                // Entry may have been replaced by a newer connection in the meantime
+                if (!g_pending[i].in_use || (g_pending[i].opened != pending[i].opened)) {
+                    continue;
+                }
+
+                g_pending[i].in_use = false;
+
+                if (live) {
+                    AddReconnectRecord({
+                        .address = pending[i].address,
+                        .fast_page_scan = pending[i].fast_page_scan,
+                        .wait_ms = pending[i].wait_ms,
+                        .live_ms = GetElapsedMilliSeconds(pending[i].opened, first_report)
+                    });
+                }
+            }
+        }
+
+    }
+
+    void OnControllerConnected(const bluetooth::Address &address) {
+        std::scoped_lock lk(g_reconnect_lock);
+
+        auto expected = FindExpectedController(address);
+        if (expected == nullptr) {
+            return;
+        }
+
+        const auto now = os::GetSystemTick();
+
+        auto pending = std::find_if(std::begin(g_pending), std::end(g_pending), [](const PendingConnection &p) { return !p.in_use; });
+        if (pending != std::end(g_pending)) {
+            *pending = {
+                .in_use = true,
+                .fast_page_scan = g_page_scan_state == PageScanState_Fast,
+                .address = address,
+                .opened = now,
+                .wait_ms = GetElapsedMilliSeconds(expected->since, now)
+            };
+        }
+
+        RemoveExpectedController(expected);
+    }
+
+    void OnLocalDisconnect(const bluetooth::Address &address) {
+        std::scoped_lock lk(g_reconnect_lock);
+
+        // Reuse the entry for this address if there is one, otherwise the oldest
+        auto local = std::find_if(std::begin(g_local_disconnects), std::end(g_local_disconnects), [&](const LocalDisconnect &l) { return utils::BluetoothAddressCompare(l.address, address); });
+        if (local == std::end(g_local_disconnects)) {
+            local = std::min_element(std::begin(g_local_disconnects), std::end(g_local_disconnects), [](const LocalDisconnect &a, const LocalDisconnect &b) { return a.requested < b.requested; });
+        }
+
+        *local = {
+            .address = address,
+            .requested = os::GetSystemTick()
+        };
+    }
+
+    void OnControllerDisconnected(const bluetooth::Address &address, DisconnectReason reason) {
+        std::scoped_lock lk(g_reconnect_lock);
+
+        for (auto &pending : g_pending) {
+            if (pending.in_use && utils::BluetoothAddressCompare(pending.address, address)) {
+                pending.in_use = false;
+            }
+        }
+
+        if (ConsumeLocalDisconnect(address)) {
+            reason = DisconnectReason_LocalHost;
+        }
+
+        // Only wait for controllers that dropped out unexpectedly, or were disconnected by the console going to sleep.
+        // A controller that was switched off or disconnected on purpose isn't coming back soon
+        if (!g_sleeping && (reason != DisconnectReason_LinkLoss)) {
+            if (auto expected = FindExpectedController(address); expected != nullptr) {
+                RemoveExpectedController(expected);
+            }
+
+            return;
+        }
+
+        auto expected = FindExpectedController(address);
+        if (expected == nullptr) {
+            // Make room by forgetting the controller that has been gone the longest
+            if (g_num_expected == util::size(g_expected)) {
+                RemoveExpectedController(std::min_element(g_expected, g_expected + g_num_expected, [](const ExpectedController &a, const ExpectedController &b) { return a.since < b.since; }));
+            }
+
+            expected = &g_expected[g_num_expected++];
+            expected->address = address;
+        }
+
+        expected->since = os::GetSystemTick();
+    }
+
+    void OnSleep() {
+        std::scoped_lock lk(g_reconnect_lock);
+        g_sleeping = true;
+    }
+
+    void OnWake() {
+        std::scoped_lock lk(g_reconnect_lock);
+
+        g_sleeping = false;
+
+        // Controllers are disconnected when the console sleeps and are expected back once it wakes
+        const auto now = os::GetSystemTick();
+        for (size_t i = 0; i < g_num_expected; ++i) {
+            g_expected[i].since = now;
+        }
+
+        // The bluetooth stack may have restored its own settings while asleep
+        if (g_page_scan_state == PageScanState_Fast) {
+            g_page_scan_state = PageScanState_Unknown;
+        }
+    }
+
+    void UpdateReconnect() {
+        auto config = &mitm::GetGlobalConfig()->reconnect;
+
+        const auto now = os::GetSystemTick();
+        const auto timeout = os::ConvertToTick(TimeSpan::FromSeconds(config->timeout));
+
+        UpdatePendingConnections(now, timeout);
+
+        PageScanState state;
+        PageScanState previous_state;
+        {
+            std::scoped_lock lk(g_reconnect_lock);
+
+            // Give up on controllers that haven't come back in time
+            for (size_t i = 0; i < g_num_expected; ) {
+                if (now - g_expected[i].since >= timeout) {
+                    RemoveExpectedController(&g_expected[i]);
+                    if (g_page_scan_state == PageScanState_Fast) {
+                        g_stats.num_timeouts += 1;
+                    }
+                } else {
+                    ++i;
+                }
+            }
+
+            g_stats.num_expected = g_num_expected;
+
+            // The stack can't be configured while the console is asleep
+            if (g_sleeping) {
+                return;
+            }
+
+            state = (config->enable && (g_num_expected > 0)) ? PageScanState_Fast : PageScanState_Stock;
+            if (state == g_page_scan_state) {
+                return;
+            }
+
+            previous_state = g_page_scan_state;
+        }
+
+        // The system's parameters can only be trusted while we know they haven't been overridden
+        const Result result = state == PageScanState_Fast ? EnableFastPageScan(previous_state == PageScanState_Stock)
+                                                          : RestoreStockPageScan();
+
+        std::scoped_lock lk(g_reconnect_lock);
+
+        g_stats.last_result = result.GetValue();
+        if (R_FAILED(result)) {
+            g_stats.num_failures += 1;
+            return;
+        }
+
+        g_page_scan_state = state;
+        g_stats.fast_page_scan = state == PageScanState_Fast;
+        if (g_stats.fast_page_scan) {
+            g_stats.num_fast_page_scans += 1;
+        }
+    }
+
+    void GetReconnectStatistics(ReconnectStatistics *out_stats) {
+        std::scoped_lock lk(g_reconnect_lock);
+        *out_stats = g_stats;
+    }
+
+}
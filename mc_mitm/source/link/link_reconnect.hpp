@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
+
+namespace ams::link {
+
+    constexpr size_t ReconnectHistoryLength = 8;
+
+    struct ReconnectRecord {
+        bluetooth::Address address;
+        bool fast_page_scan;
+        u32 wait_ms;  // From when the controller was expected back until its connection was opened
+        u32 live_ms;  // From the connection being opened until the first input report was received
+    };
+
+    struct ReconnectStatistics {
+        bool fast_page_scan;
+        u32 num_expected;
+        u32 num_fast_page_scans;
+        u32 num_timeouts;
+        u32 num_failures;
+        u32 last_result;
+        u32 count;
+        ReconnectRecord records[ReconnectHistoryLength];  // Oldest first
+    };
+
+    enum DisconnectReason {
+        DisconnectReason_LinkLoss,    // The link dropped out (eg. out of range or interference). The controller is likely to come straight back
+        DisconnectReason_LocalHost,   // Closed by the console, such as when the controller is disconnected from the system menu or unpaired
+        DisconnectReason_RemoteUser,  // Closed by the controller, such as when it is switched off
+    };
+
+    // Connection and power events may be reported from any thread. UpdateReconnect issues the page scan changes, so must be called
+    // periodically from a thread that is allowed to block on the bluetooth stack
+    void OnControllerConnected(const bluetooth::Address &address);
+    void OnLocalDisconnect(const bluetooth::Address &address);
+    void OnControllerDisconnected(const bluetooth::Address &address, DisconnectReason reason);
+    void OnSleep();
+    void OnWake();
+    void UpdateReconnect();
+
+    void GetReconnectStatistics(ReconnectStatistics *out_stats);
+
+}
@@ -15,6 +15,7 @@
  */
 #include "mc_module.hpp"
 #include "mc_service.hpp"
+#include "../mcmitm_config.hpp"
 
 namespace ams::mc {
 
@@ -44,17 +45,14 @@ namespace ams::mc {
 
         ServerManager g_server_manager;
 
-        sf::UnmanagedServiceObject<IMissionControlInterface, MissionControlService> g_mission_control_service;
-
         ams::Result ServerManager::OnNeedsToAccept(int port_index, Server *server) {
             switch (port_index) {
                 case PortIndex_MissionControl:
-                    return this->AcceptImpl(server, g_mission_control_service.GetShared());
+                    return this->AcceptImpl(server, sf::CreateSharedObjectEmplaced<IMissionControlInterface, MissionControlService>());
                 AMS_UNREACHABLE_DEFAULT_CASE();
             }
         }
 
-        constexpr s32 ThreadPriority = 20;
         constexpr size_t ThreadStackSize = 0x1000;
         alignas(os::ThreadStackAlignment) constinit u8 g_thread_stack[ThreadStackSize];
         constinit os::ThreadType g_thread;
@@ -72,7 +70,7 @@ namespace ams::mc {
             nullptr,
             g_thread_stack,
             ThreadStackSize,
-            ThreadPriority
+            mitm::GetGlobalConfig()->threads.mc_priority
         ));
 
         os::SetThreadNamePointer(&g_thread, "mc::MissionControlThread");
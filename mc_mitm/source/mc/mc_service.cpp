@@ -15,29 +15,19 @@
  */
 #include "mc_service.hpp"
 #include "../mcmitm_version.hpp"
-#include "../bluetooth_mitm/btdrv_ext.h"
 #include "../bluetooth_mitm/bluetooth/bluetooth_core.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_hci.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_hid.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_ble.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_hid_report.hpp"
+#include "../bluetooth_mitm/bluetoothmitm_module.hpp"
+#include "../controllers/controller_state_mirror.hpp"
+#include "mc_virtual_controller.hpp"
 
 namespace ams::mc {
 
-    namespace {
-
-        constexpr ncm::ProgramId MissionControlTitleId = ncm::ProgramId(0x010000000000bd00);
-
-        constinit BtdrvExtCustomEventInfo g_event_info;
-        constinit BtdrvExtCustomEventType g_current_event_type;
-
-        Result WaitCustomEventInfo() {
-            // Wait on custom command reply event
-            bluetooth::core::GetCustomDataEvent()->Wait();
-
-            // Fetch custom command reply data
-            R_TRY(bluetooth::core::GetEventInfo(MissionControlTitleId, reinterpret_cast<bluetooth::EventType *>(&g_current_event_type), &g_event_info, sizeof(g_event_info)));
-
-            // Return status code
-            R_RETURN(g_event_info.hci_command_response.status);
-        }
-
+    MissionControlService::~MissionControlService() {
+        mc::DestroyVirtualControllers(this);
     }
 
     Result MissionControlService::GetVersion(sf::Out<u32> version) {
@@ -56,31 +46,145 @@ namespace ams::mc {
     }
 
     Result MissionControlService::GetHciHandle(bluetooth::Address address, sf::Out<u16> out_handle) {
-        R_TRY(btdrvextGetHciHandle(address));
+        R_RETURN(bluetooth::hci::GetHandle(address, out_handle.GetPointer()));
+    }
 
-        // Wait for response to custom event
-        R_TRY(WaitCustomEventInfo());
+    Result MissionControlService::SendHciCommand(u16 opcode, const sf::InPointerBuffer &buffer, const sf::OutPointerBuffer &out_buffer) {
+        R_RETURN(bluetooth::hci::SendCommand(opcode, buffer.GetPointer(), buffer.GetSize(), out_buffer.GetPointer(), out_buffer.GetSize()));
+    }
 
-        // Set the output handle
-        out_handle.SetValue(g_event_info.get_hci_handle.handle);
+    Result MissionControlService::DmSetConfig(const ams::mc::BsaSetConfig &set_config) {
+        R_RETURN(bluetooth::hci::DmSetConfig(&set_config.config));
+    }
 
+    Result MissionControlService::GetHeapStatistics(sf::Out<ams::mitm::HeapStatistics> out_stats) {
+        ams::mitm::GetHeapStatistics(out_stats.GetPointer());
         R_SUCCEED();
     }
 
-    Result MissionControlService::SendHciCommand(u16 opcode, const sf::InPointerBuffer &buffer, const sf::OutPointerBuffer &out_buffer) {
-        R_TRY(btdrvextSendHciCommand(opcode, buffer.GetPointer(), buffer.GetSize()));
+    Result MissionControlService::GetEventQueueStatistics(sf::Out<ams::mc::EventQueueStatistics> out_stats) {
+        auto stats = out_stats.GetPointer();
+        for (int i = 0; i < bluetooth::EventConsumer_Count; ++i) {
+            auto consumer = static_cast<bluetooth::EventConsumer>(i);
+            bluetooth::core::GetEventQueueStatistics(consumer, &stats->core[i]);
+            bluetooth::hid::GetEventQueueStatistics(consumer, &stats->hid[i]);
+            bluetooth::ble::GetEventQueueStatistics(consumer, &stats->ble[i]);
+        }
+
+        R_SUCCEED();
+    }
 
-        // Wait for response to custom event
-        R_TRY(WaitCustomEventInfo());
+    Result MissionControlService::GetReportRateStatistics(sf::Out<ams::mc::ReportRateStatistics> out_stats) {
+        auto stats = out_stats.GetPointer();
+        std::memset(stats, 0, sizeof(*stats));
 
-        // Copy response to output buffer
-        std::memcpy(out_buffer.GetPointer(), g_event_info.hci_command_response.data, g_event_info.hci_command_response.size);
+        stats->count = controller::GetReportRateStatistics(stats->controllers, controller::MaxControllers);
+        for (u32 i = 0; i < stats->count; ++i) {
+            stats->total_measured_rate += stats->controllers[i].measured_rate;
+        }
 
         R_SUCCEED();
     }
 
-    Result MissionControlService::DmSetConfig(const ams::mc::BsaSetConfig &set_config) {
-        R_RETURN(btdrvextDmSetConfig(&set_config.config));
+    Result MissionControlService::GetThreadStatistics(sf::Out<ams::mc::ThreadStatistics> out_stats) {
+        auto stats = out_stats.GetPointer();
+        bluetooth::hid::report::GetThreadStatistics(&stats->hid_report_wake_latency, &stats->hid_report_run_time);
+        mitm::bluetooth::GetThreadStatistics(&stats->btdrv_data_run_time, &stats->btdrv_control_run_time);
+
+        R_SUCCEED();
+    }
+
+    Result MissionControlService::GetLinkPolicyStatistics(sf::Out<ams::mc::LinkPolicyStatistics> out_stats) {
+        auto stats = out_stats.GetPointer();
+        std::memset(stats, 0, sizeof(*stats));
+
+        stats->count = link::GetLinkPolicyStatistics(stats->links, controller::MaxControllers);
+
+        R_SUCCEED();
+    }
+
+    Result MissionControlService::GetLinkQualityHistory(sf::Out<ams::mc::LinkQualityHistory> out_history) {
+        auto history = out_history.GetPointer();
+        std::memset(history, 0, sizeof(*history));
+
+        history->count = link::GetLinkQualityHistory(history->links, controller::MaxControllers);
+
+        R_SUCCEED();
+    }
+
+    Result MissionControlService::SendHciCommandBatch(const ams::mc::HciCommandBatch &batch, sf::Out<ams::mc::HciResponseBatch> out_responses) {
+        R_UNLESS(batch.count <= bluetooth::hci::MaxBatchCommands, svc::ResultOutOfRange());
+
+        auto responses = out_responses.GetPointer();
+        std::memset(responses, 0, sizeof(*responses));
+
+        bluetooth::hci::CommandRequest requests[bluetooth::hci::MaxBatchCommands];
+        for (u32 i = 0; i < batch.count; ++i) {
+            auto &command = batch.commands[i];
+            R_UNLESS(command.size <= sizeof(command.data), svc::ResultOutOfRange());
+
+            // Don't let a client tie up this thread and the pending request slots indefinitely
+            const auto timeout = command.timeout_ms != 0 ? TimeSpan::FromMilliSeconds(command.timeout_ms) : bluetooth::hci::DefaultTimeout;
+            R_UNLESS(timeout <= bluetooth::hci::MaxTimeout, svc::ResultOutOfRange());
+
+            requests[i] = {
+                .opcode = command.opcode,
+                .data = command.data,
+                .size = command.size,
+                .out_data = responses->responses[i].data,
+                .out_size = sizeof(responses->responses[i].data),
+                .timeout = timeout
+            };
+        }
+
+        bluetooth::hci::SendCommandBatch(requests, batch.count);
+
+        responses->count = batch.count;
+        for (u32 i = 0; i < batch.count; ++i) {
+            auto &response = responses->responses[i];
+            response.opcode = requests[i].opcode;
+            response.size = requests[i].out_data_size;
+            response.result = requests[i].result.GetValue();
+        }
+
+        R_SUCCEED();
+    }
+
+    Result MissionControlService::GetReconnectStatistics(sf::Out<ams::mc::ReconnectStatistics> out_stats) {
+        link::GetReconnectStatistics(&out_stats.GetPointer()->stats);
+        R_SUCCEED();
+    }
+
+    Result MissionControlService::GetInquiryStatistics(sf::Out<ams::mc::InquiryStatistics> out_stats) {
+        bluetooth::inquiry::GetInquiryStatistics(&out_stats.GetPointer()->stats);
+        R_SUCCEED();
+    }
+
+    Result MissionControlService::GetAfhStatistics(sf::Out<ams::mc::AfhStatistics> out_stats) {
+        link::GetAfhStatistics(&out_stats.GetPointer()->stats);
+        R_SUCCEED();
+    }
+
+    Result MissionControlService::GetControllerStateSharedMemory(sf::OutCopyHandle out_handle) {
+        out_handle.SetValue(controller::GetStateMirrorSharedMemory()->GetHandle(), false);
+        R_SUCCEED();
+    }
+
+    Result MissionControlService::CreateVirtualController(sf::Out<bluetooth::Address> out_address, sf::OutCopyHandle out_handle) {
+        os::NativeHandle handle;
+        R_TRY(mc::CreateVirtualController(this, out_address.GetPointer(), &handle));
+
+        out_handle.SetValue(handle, false);
+        R_SUCCEED();
+    }
+
+    Result MissionControlService::DestroyVirtualController(bluetooth::Address address) {
+        R_RETURN(mc::DestroyVirtualController(this, address));
+    }
+
+    Result MissionControlService::GetCaptureStatistics(sf::Out<ams::mc::CaptureStatistics> out_stats) {
+        bluetooth::capture::GetStatistics(&out_stats.GetPointer()->stats);
+        R_SUCCEED();
     }
 
 }
@@ -16,28 +16,60 @@
 #pragma once
 #include <stratosphere.hpp>
 #include "mc_types.hpp"
+#include "../mcmitm_heap.hpp"
 #include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
 
-#define AMS_MISSION_CONTROL_INTERFACE_INFO(C, H)                                                                                                                                      \
-    AMS_SF_METHOD_INFO(C, H, 0, Result, GetVersion,            (sf::Out<u32> version),                                                                  (version)                   ) \
-    AMS_SF_METHOD_INFO(C, H, 1, Result, GetBuildVersionString, (sf::Out<ams::mc::VersionString> version),                                               (version)                   ) \
-    AMS_SF_METHOD_INFO(C, H, 2, Result, GetBuildDateString,    (sf::Out<ams::mc::DateString> version),                                                  (version)                   ) \
-    AMS_SF_METHOD_INFO(C, H, 3, Result, GetHciHandle,          (bluetooth::Address address, sf::Out<u16> handle),                                       (address, handle)           ) \
-    AMS_SF_METHOD_INFO(C, H, 4, Result, SendHciCommand,        (u16 opcode, const sf::InPointerBuffer &buffer, const sf::OutPointerBuffer &out_buffer), (opcode, buffer, out_buffer)) \
-    AMS_SF_METHOD_INFO(C, H, 5, Result, DmSetConfig,           (const ams::mc::BsaSetConfig &set_config),                                               (set_config)                ) \
+#define AMS_MISSION_CONTROL_INTERFACE_INFO(C, H)                                                                                                                                                  \
+    AMS_SF_METHOD_INFO(C, H, 0,  Result, GetVersion,                     (sf::Out<u32> version),                                                                    (version)                   ) \
+    AMS_SF_METHOD_INFO(C, H, 1,  Result, GetBuildVersionString,          (sf::Out<ams::mc::VersionString> version),                                                 (version)                   ) \
+    AMS_SF_METHOD_INFO(C, H, 2,  Result, GetBuildDateString,             (sf::Out<ams::mc::DateString> version),                                                    (version)                   ) \
+    AMS_SF_METHOD_INFO(C, H, 3,  Result, GetHciHandle,                   (bluetooth::Address address, sf::Out<u16> handle),                                         (address, handle)           ) \
+    AMS_SF_METHOD_INFO(C, H, 4,  Result, SendHciCommand,                 (u16 opcode, const sf::InPointerBuffer &buffer, const sf::OutPointerBuffer &out_buffer),   (opcode, buffer, out_buffer)) \
+    AMS_SF_METHOD_INFO(C, H, 5,  Result, DmSetConfig,                    (const ams::mc::BsaSetConfig &set_config),                                                 (set_config)                ) \
+    AMS_SF_METHOD_INFO(C, H, 6,  Result, GetHeapStatistics,              (sf::Out<ams::mitm::HeapStatistics> out_stats),                                            (out_stats)                 ) \
+    AMS_SF_METHOD_INFO(C, H, 7,  Result, GetEventQueueStatistics,        (sf::Out<ams::mc::EventQueueStatistics> out_stats),                                        (out_stats)                 ) \
+    AMS_SF_METHOD_INFO(C, H, 8,  Result, GetReportRateStatistics,        (sf::Out<ams::mc::ReportRateStatistics> out_stats),                                        (out_stats)                 ) \
+    AMS_SF_METHOD_INFO(C, H, 9,  Result, GetThreadStatistics,            (sf::Out<ams::mc::ThreadStatistics> out_stats),                                            (out_stats)                 ) \
+    AMS_SF_METHOD_INFO(C, H, 10, Result, GetLinkPolicyStatistics,        (sf::Out<ams::mc::LinkPolicyStatistics> out_stats),                                        (out_stats)                 ) \
+    AMS_SF_METHOD_INFO(C, H, 11, Result, GetLinkQualityHistory,          (sf::Out<ams::mc::LinkQualityHistory> out_history),                                        (out_history)               ) \
+    AMS_SF_METHOD_INFO(C, H, 12, Result, SendHciCommandBatch,            (const ams::mc::HciCommandBatch &batch, sf::Out<ams::mc::HciResponseBatch> out_responses), (batch, out_responses)      ) \
+    AMS_SF_METHOD_INFO(C, H, 13, Result, GetReconnectStatistics,         (sf::Out<ams::mc::ReconnectStatistics> out_stats),                                         (out_stats)                 ) \
+    AMS_SF_METHOD_INFO(C, H, 14, Result, GetInquiryStatistics,           (sf::Out<ams::mc::InquiryStatistics> out_stats),                                           (out_stats)                 ) \
+    AMS_SF_METHOD_INFO(C, H, 15, Result, GetAfhStatistics,               (sf::Out<ams::mc::AfhStatistics> out_stats),                                               (out_stats)                 ) \
+    AMS_SF_METHOD_INFO(C, H, 16, Result, GetControllerStateSharedMemory, (sf::OutCopyHandle out_handle),                                                            (out_handle)                ) \
+    AMS_SF_METHOD_INFO(C, H, 17, Result, CreateVirtualController,        (sf::Out<bluetooth::Address> out_address, sf::OutCopyHandle out_handle),                   (out_address, out_handle)   ) \
+    AMS_SF_METHOD_INFO(C, H, 18, Result, DestroyVirtualController,       (bluetooth::Address address),                                                              (address)                   ) \
+    AMS_SF_METHOD_INFO(C, H, 19, Result, GetCaptureStatistics,           (sf::Out<ams::mc::CaptureStatistics> out_stats),                                           (out_stats)                 ) \
 
 AMS_SF_DEFINE_INTERFACE(ams::mc, IMissionControlInterface, AMS_MISSION_CONTROL_INTERFACE_INFO, 0x30eba3d4)
 
 namespace ams::mc {
 
+    // One instance is created per session, so that virtual controllers go away with the client that created them
     class MissionControlService {
         public:
+            ~MissionControlService();
+
             Result GetVersion(sf::Out<u32> version);
             Result GetBuildVersionString(sf::Out<ams::mc::VersionString> version);
             Result GetBuildDateString(sf::Out<ams::mc::DateString> date);
             Result GetHciHandle(bluetooth::Address address, sf::Out<u16> handle);
             Result SendHciCommand(u16 opcode, const sf::InPointerBuffer &buffer, const sf::OutPointerBuffer &out_buffer);
             Result DmSetConfig(const ams::mc::BsaSetConfig &set_config);
+            Result GetHeapStatistics(sf::Out<ams::mitm::HeapStatistics> out_stats);
+            Result GetEventQueueStatistics(sf::Out<ams::mc::EventQueueStatistics> out_stats);
+            Result GetReportRateStatistics(sf::Out<ams::mc::ReportRateStatistics> out_stats);
+            Result GetThreadStatistics(sf::Out<ams::mc::ThreadStatistics> out_stats);
+            Result GetLinkPolicyStatistics(sf::Out<ams::mc::LinkPolicyStatistics> out_stats);
+            Result GetLinkQualityHistory(sf::Out<ams::mc::LinkQualityHistory> out_history);
+            Result SendHciCommandBatch(const ams::mc::HciCommandBatch &batch, sf::Out<ams::mc::HciResponseBatch> out_responses);
+            Result GetReconnectStatistics(sf::Out<ams::mc::ReconnectStatistics> out_stats);
+            Result GetInquiryStatistics(sf::Out<ams::mc::InquiryStatistics> out_stats);
+            Result GetAfhStatistics(sf::Out<ams::mc::AfhStatistics> out_stats);
+            Result GetControllerStateSharedMemory(sf::OutCopyHandle out_handle);
+            Result CreateVirtualController(sf::Out<bluetooth::Address> out_address, sf::OutCopyHandle out_handle);
+            Result DestroyVirtualController(bluetooth::Address address);
+            Result GetCaptureStatistics(sf::Out<ams::mc::CaptureStatistics> out_stats);
     };
     static_assert(IsIMissionControlInterface<MissionControlService>);
 
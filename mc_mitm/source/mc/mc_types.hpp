@@ -16,6 +16,15 @@
 #pragma once
 #include <stratosphere.hpp>
 #include "../bluetooth_mitm/bsa_defs.h"
+#include "../bluetooth_mitm/bluetooth/bluetooth_event_queue.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_hci.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_inquiry.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_capture.hpp"
+#include "../controllers/controller_report_rate.hpp"
+#include "../utils/utils_latency_histogram.hpp"
+#include "../link/link_afh.hpp"
+#include "../link/link_policy.hpp"
+#include "../link/link_reconnect.hpp"
 
 namespace ams::mc {
 
@@ -31,4 +40,73 @@ namespace ams::mc {
         tBSA_DM_SET_CONFIG config;
     };
 
+    struct EventQueueStatistics : sf::LargeData {
+        bluetooth::EventQueueStatistics core[bluetooth::EventConsumer_Count];
+        bluetooth::EventQueueStatistics hid[bluetooth::EventConsumer_Count];
+        bluetooth::EventQueueStatistics ble[bluetooth::EventConsumer_Count];
+    };
+
+    struct ReportRateStatistics : sf::LargeData {
+        u32 count;
+        u32 total_measured_rate;
+        controller::ReportRateStatistics controllers[controller::MaxControllers];
+    };
+
+    struct ThreadStatistics : sf::LargeData {
+        utils::LatencyHistogramData hid_report_wake_latency;
+        utils::LatencyHistogramData hid_report_run_time;
+        utils::LatencyHistogramData btdrv_data_run_time;
+        utils::LatencyHistogramData btdrv_control_run_time;
+    };
+
+    struct LinkPolicyStatistics : sf::LargeData {
+        u32 count;
+        link::LinkPolicyStatistics links[controller::MaxControllers];
+    };
+
+    struct LinkQualityHistory : sf::LargeData {
+        u32 count;
+        link::LinkQualityHistory links[controller::MaxControllers];
+    };
+
+    struct HciBatchCommand {
+        u16 opcode;
+        u16 size;
+        u32 timeout_ms;  // 0 uses the default timeout. Must not exceed bluetooth::hci::MaxTimeout
+        u8 data[0xff];
+    };
+
+    struct HciBatchResponse {
+        u16 opcode;
+        u16 size;
+        u32 result;
+        u8 data[0xff];
+    };
+
+    struct HciCommandBatch : sf::LargeData {
+        u32 count;
+        HciBatchCommand commands[bluetooth::hci::MaxBatchCommands];
+    };
+
+    struct HciResponseBatch : sf::LargeData {
+        u32 count;
+        HciBatchResponse responses[bluetooth::hci::MaxBatchCommands];
+    };
+
+    struct ReconnectStatistics : sf::LargeData {
+        link::ReconnectStatistics stats;
+    };
+
+    struct InquiryStatistics : sf::LargeData {
+        bluetooth::inquiry::InquiryStatistics stats;
+    };
+
+    struct AfhStatistics : sf::LargeData {
+        link::AfhStatistics stats;
+    };
+
+    struct CaptureStatistics : sf::LargeData {
+        bluetooth::capture::CaptureStatistics stats;
+    };
+
 }
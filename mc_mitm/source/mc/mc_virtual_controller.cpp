@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "mc_virtual_controller.hpp"
+#include "../mcmitm_config.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_hid.hpp"
+#include "../controllers/controller_management.hpp"
+#include "../usb/mc_usb_pairing.hpp"
+#include "../utils/utils_bluetooth_address.hpp"
+
+namespace ams::mc {
+
+    namespace {
+
+        constexpr size_t MaxVirtualControllers = 4;
+
+        // Frames are picked up at this interval, which is enough to keep up with a client writing at 1000Hz
+        constexpr TimeSpan PollInterval = TimeSpan::FromMilliSeconds(1);
+
+        // Upper bound on the frames taken from each ring per poll. Anything beyond it waits for the next poll
+        constexpr size_t MaxFramesPerPoll = 16;
+
+        // Addresses come from a fixed block, so the pairing database entries are reused rather than added every time
+        constexpr bluetooth::Address VirtualAddressBase = {0x4d, 0x43, 0x56, 0x43, 0x00, 0x00};
+        constexpr char VirtualControllerName[] = "Virtual Controller";
+        constexpr bluetooth::DeviceClass VirtualControllerClass = {0x00, 0x25, 0x08};
+
+        constexpr size_t ThreadStackSize = 0x2000;
+        alignas(os::ThreadStackAlignment) constinit u8 g_thread_stack[ThreadStackSize];
+        constinit os::ThreadType g_thread;
+        constinit bool g_thread_started = false;
+
+        // Nothing leaves a virtual controller. Setting a transport also keeps it out of link management, as it has no radio link
+        class NullTransport : public controller::ControllerTransport {
+
+            public:
+                Result WriteDataReport(const bluetooth::HidReport *report) override {
+                    AMS_UNUSED(report);
+                    R_SUCCEED();
+                }
+
+                Result SetReport(BtdrvBluetoothHhReportType type, const bluetooth::HidReport *report) override {
+                    AMS_UNUSED(type, report);
+                    R_SUCCEED();
+                }
+
+                Result GetReport(u8 id, BtdrvBluetoothHhReportType type, bluetooth::HidReport *out_report) override {
+                    AMS_UNUSED(id, type, out_report);
+                    R_RETURN(svc::ResultNotFound());
+                }
+
+        };
+
+        struct VirtualControllerSlot {
+            bool active;
+            const void *owner;
+            bluetooth::Address address;
+            os::SharedMemoryType shmem;
+            controller::VirtualControllerRing *ring;
+            std::shared_ptr<controller::VirtualController> handler;
+        };
+
+        // Frames copied out of a ring, waiting to be submitted once the lock has been released
+        struct PendingFrames {
+            bluetooth::Address address;
+            std::shared_ptr<controller::VirtualController> handler;
+            size_t count;
+            controller::VirtualControllerFrame frames[MaxFramesPerPoll];
+        };
+
+        NullTransport g_null_transport;
+
+        constinit os::SdkMutex g_virtual_controller_lock;
+        VirtualControllerSlot g_slots[MaxVirtualControllers] = {};
+
+        // Only touched by the virtual controller thread
+        PendingFrames g_pending_frames[MaxVirtualControllers] = {};
+
+        os::Event g_wake_event(os::EventClearMode_AutoClear);
+
+        Result EnsurePaired(const bluetooth::Address &address) {
+            // The hid sysmodule only accepts controllers found in the pairing database
+            bluetooth::DevicesSettings device_settings;
+            if (R_SUCCEEDED(btdrvGetPairedDeviceInfo(address, &device_settings))) {
+                R_SUCCEED();
+            }
+
+            const usb::UsbPairedDevice device = {
+                .address = address,
+                .class_of_device = VirtualControllerClass,
+                .vid = controller::VirtualController::hardware_ids[0].vid,
+                .pid = controller::VirtualController::hardware_ids[0].pid,
+                .name = VirtualControllerName,
+                .link_key = nullptr
+            };
+
+            R_RETURN(usb::AddPairedDevice(&device));
+        }
+
+        // Returns whether the controller was connected. The disconnect is left to the caller to signal once it has released the lock
+        bool CloseSlot(VirtualControllerSlot *slot) {
+            const bool connected = slot->handler != nullptr;
+            slot->handler.reset();
+
+            if (controller::LocateHandler(slot->address)) {
+                controller::RemoveHandler(slot->address);
+            }
+
+            if (slot->ring != nullptr) {
+                os::UnmapSharedMemory(&slot->shmem);
+                slot->ring = nullptr;
+            }
+
+            os::DestroySharedMemory(&slot->shmem);
+            slot->owner = nullptr;
+            slot->active = false;
+
+            return connected;
+        }
+
+        void CollectFrames(const VirtualControllerSlot *slot, os::Tick now, PendingFrames *out_pending) {
+            auto ring = slot->ring;
+
+            u32 read_index = ring->read_index.load(std::memory_order_relaxed);
+            const u32 write_index = ring->write_index.load(std::memory_order_acquire);
+
+            // A client that ran too far ahead has overwritten frames that weren't read yet. Resume from the oldest intact one
+            if (write_index - read_index > controller::VirtualControllerRing::Capacity) {
+                read_index = write_index - controller::VirtualControllerRing::Capacity;
+            }
+
+            const s64 schedule_limit = now.GetInt64Value() + os::ConvertToTick(controller::VirtualControllerMaxScheduleAhead).GetInt64Value();
+
+            out_pending->count = 0;
+            while ((read_index != write_index) && (out_pending->count < MaxFramesPerPoll)) {
+                auto frame = &out_pending->frames[out_pending->count];
+                std::memcpy(frame, &ring->frames[read_index % controller::VirtualControllerRing::Capacity], sizeof(*frame));
+
+                // Frames scheduled for later hold back everything queued behind them, unless they're scheduled too far ahead to be genuine
+                const s64 timestamp = static_cast<s64>(frame->timestamp);
+                if ((timestamp > now.GetInt64Value()) && (timestamp <= schedule_limit)) {
+                    break;
+                }
+
+                out_pending->count += 1;
+                read_index += 1;
+            }
+
+            ring->read_index.store(read_index, std::memory_order_release);
+
+            if (out_pending->count != 0) {
+                out_pending->address = slot->address;
+                out_pending->handler = slot->handler;
+            }
+        }
+
+        void SubmitFrames(PendingFrames *pending) {
+            // Frames for a controller that was destroyed since they were collected are dropped, as it has already been disconnected
+            if ((pending->count != 0) && (controller::LocateHandler(pending->address) == pending->handler)) {
+                for (size_t i = 0; i < pending->count; ++i) {
+                    pending->handler->SubmitFrame(&pending->frames[i]);
+                }
+            }
+
+            pending->count = 0;
+            pending->handler.reset();
+        }
+
+        void VirtualControllerThreadFunc(void *) {
+            for (;;) {
+                bool any_active = false;
+
+                {
+                    std::scoped_lock lk(g_virtual_controller_lock);
+
+                    const auto now = os::GetSystemTick();
+                    for (size_t i = 0; i < MaxVirtualControllers; ++i) {
+                        const auto &slot = g_slots[i];
+                        if (!slot.active) {
+                            continue;
+                        }
+
+                        CollectFrames(&slot, now, &g_pending_frames[i]);
+                        any_active = true;
+                    }
+                }
+
+                // Submitting a frame runs the whole input report path, so it's done without holding up clients creating or destroying controllers
+                for (auto &pending : g_pending_frames) {
+                    SubmitFrames(&pending);
+                }
+
+                if (any_active) {
+                    os::SleepThread(PollInterval);
+                } else {
+                    g_wake_event.Wait();
+                }
+            }
+        }
+
+        void EnsureThreadStarted() {
+            if (g_thread_started) {
+                return;
+            }
+
+            R_ABORT_UNLESS(os::CreateThread(&g_thread,
+                VirtualControllerThreadFunc,
+                nullptr,
+                g_thread_stack,
+                ThreadStackSize,
+                mitm::GetGlobalConfig()->threads.hid_report_priority
+            ));
+
+            os::SetThreadNamePointer(&g_thread, "mc::VirtualControllerThread");
+            os::StartThread(&g_thread);
+
+            g_thread_started = true;
+        }
+
+    }
+
+    Result CreateVirtualController(const void *owner, bluetooth::Address *out_address, os::NativeHandle *out_handle) {
+        R_UNLESS(bluetooth::hid::IsInitialized(), svc::ResultInvalidState());
+
+        bluetooth::Address address;
+        {
+            std::scoped_lock lk(g_virtual_controller_lock);
+
+            auto slot = std::find_if(std::begin(g_slots), std::end(g_slots), [](const VirtualControllerSlot &s) { return !s.active; });
+            R_UNLESS(slot != std::end(g_slots), svc::ResultOutOfResource());
+
+            address = VirtualAddressBase;
+            address.address[5] = static_cast<u8>(slot - std::begin(g_slots));
+
+            // Don't take over an address that a previous instance is still being torn down for
+            R_UNLESS(controller::LocateHandler(address) == nullptr, svc::ResultInvalidState());
+
+            R_TRY(EnsurePaired(address));
+
+            R_TRY(os::CreateSharedMemory(&slot->shmem, controller::VirtualControllerRingSize, os::MemoryPermission_ReadWrite, os::MemoryPermission_ReadWrite));
+            slot->owner = owner;
+            slot->address = address;
+            slot->active = true;
+
+            bool success = false;
+            ON_SCOPE_EXIT {
+                if (!success) {
+                    CloseSlot(slot);
+                }
+            };
+
+            slot->ring = static_cast<controller::VirtualControllerRing *>(os::MapSharedMemory(&slot->shmem, os::MemoryPermission_ReadWrite));
+            R_UNLESS(slot->ring != nullptr, svc::ResultOutOfResource());
+            std::memset(static_cast<void *>(slot->ring), 0, controller::VirtualControllerRingSize);
+
+            R_UNLESS(controller::AttachHandler(address, &g_null_transport), svc::ResultInvalidState());
+            slot->handler = std::static_pointer_cast<controller::VirtualController>(controller::LocateHandler(address));
+            R_UNLESS(slot->handler != nullptr, svc::ResultNotFound());
+
+            EnsureThreadStarted();
+
+            *out_address = address;
+            *out_handle = os::GetSharedMemoryHandle(&slot->shmem);
+
+            success = true;
+        }
+
+        // Connection state changes are signalled without the lock held, so that the virtual controller thread is never held up behind them
+        bluetooth::hid::SignalFakeConnectionState(address, true);
+        g_wake_event.Signal();
+
+        R_SUCCEED();
+    }
+
+    Result DestroyVirtualController(const void *owner, bluetooth::Address address) {
+        bool connected = false;
+        {
+            std::scoped_lock lk(g_virtual_controller_lock);
+
+            auto slot = std::find_if(std::begin(g_slots), std::end(g_slots), [&](const VirtualControllerSlot &s) {
+                return s.active && (s.owner == owner) && utils::BluetoothAddressCompare(s.address, address);
+            });
+            R_UNLESS(slot != std::end(g_slots), svc::ResultNotFound());
+
+            connected = CloseSlot(slot);
+        }
+
+        if (connected) {
+            bluetooth::hid::SignalFakeConnectionState(address, false);
+        }
+
+        R_SUCCEED();
+    }
+
+    void DestroyVirtualControllers(const void *owner) {
+        bluetooth::Address disconnected[MaxVirtualControllers];
+        size_t num_disconnected = 0;
+
+        {
+            std::scoped_lock lk(g_virtual_controller_lock);
+
+            for (auto &slot : g_slots) {
+                if (slot.active && (slot.owner == owner)) {
+                    const auto address = slot.address;
+                    if (CloseSlot(&slot)) {
+                        disconnected[num_disconnected++] = address;
+                    }
+                }
+            }
+        }
+
+        for (size_t i = 0; i < num_disconnected; ++i) {
+            bluetooth::hid::SignalFakeConnectionState(disconnected[i], false);
+        }
+    }
+
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
+
+namespace ams::mc {
+
+    // Virtual controllers are fed by a client through a shared memory ring of input frames (see controller::VirtualControllerRing).
+    // Each belongs to the session object that created it, and is destroyed along with that session
+    Result CreateVirtualController(const void *owner, bluetooth::Address *out_address, os::NativeHandle *out_handle);
+    Result DestroyVirtualController(const void *owner, bluetooth::Address address);
+    void DestroyVirtualControllers(const void *owner);
+
+}
@@ -21,6 +21,7 @@ namespace ams::mitm {
     namespace {
 
         constexpr const char config_file_location[] = "sdmc:/config/MissionControl/missioncontrol.ini";
+        constexpr const char profile_directory_location[] = "sdmc:/config/MissionControl/profiles";
 
         constinit SetLanguage g_system_language;
 
@@ -32,15 +33,69 @@ namespace ams::mitm {
             .misc = {
                 .analog_trigger_activation_threshold = 50,
                 .dualshock3_enable_usb_pairing = true,
+                .dualshock4_enable_usb_pairing = true,
+                .dualsense_enable_usb_pairing = true,
+                .enable_wired_controllers = false,
                 .dualshock3_led_mode = 0,
                 .dualshock4_polling_rate = 8,
+                .dualshock4_adaptive_polling_rate = true,
                 .dualshock4_lightbar_brightness = 5,
                 .dualsense_lightbar_brightness = 5,
                 .dualsense_enable_player_leds = true,
                 .dualsense_vibration_intensity = 4
+            },
+            .threads = {
+                .init_priority = -7,
+                .hid_report_priority = -11,
+                .event_priority = 9,
+                .async_priority = 10,
+                .btdrv_data_priority = -11,
+                .btdrv_control_priority = 9,
+                .btm_priority = 9,
+                .mc_priority = 20,
+                .usb_priority = 9,
+                .link_priority = 10,
+                .capture_priority = 30
+            },
+            .link_policy = {
+                .enable = false,
+                .idle_timeout = 30,
+                .flush_timeout = 20,
+                .qos_latency = 10000,
+                .switch_mode = 0,
+                .wii_mode = 1,
+                .dualshock3_mode = 1,
+                .dualshock4_mode = 1,
+                .dualsense_mode = 1,
+                .xboxone_mode = 1,
+                .other_mode = 1
+            },
+            .link_quality = {
+                .enable = true,
+                .sample_interval = 5,
+                .monitor_rssi = false,
+                .rssi_monitor_period = 1
+            },
+            .reconnect = {
+                .enable = true,
+                .timeout = 60
+            },
+            .afh = {
+                .enable = false,
+                .interval = 10,
+                .hold_time = 300
+            },
+            .capture = {
+                .enable = false,
+                .max_file_size = 32
             }
         };
 
+        // Readers take a copy of the active profile under the lock, so it can be replaced at any time without a reader seeing it half written
+        constinit os::SdkMutex g_profile_lock;
+        constinit PerformanceProfile g_active_profile = {};
+        constinit std::atomic<u32> g_profile_generation = 0;
+
         void ParseBoolean(const char *value, bool *out) {
             if (strcasecmp(value, "true") == 0)
                 *out = true;
@@ -55,6 +110,10 @@ namespace ams::mitm {
             }
         }
 
+        void ParseThreadPriority(const char *value, int *out) {
+            ParseInt(value, out, os::HighestSystemThreadPriority, os::LowestThreadPriority);
+        }
+
         void ParseBluetoothAddress(const char *value, bluetooth::Address *out) {
             // Check length of address string is correct
             if (std::strlen(value) != 3*sizeof(bluetooth::Address) - 1) {
@@ -92,16 +151,26 @@ namespace ams::mitm {
                     std::strncpy(config->bluetooth.host_name, value, sizeof(config->bluetooth.host_name));
                 } else if (strcasecmp(name, "host_address") == 0) {
                     ParseBluetoothAddress(value, &config->bluetooth.host_address);
+                } else if (strcasecmp(name, "gamepad_inquiry_filter") == 0) {
+                    ParseBoolean(value, &config->bluetooth.gamepad_inquiry_filter);
                 }
             } else if (strcasecmp(section, "misc") == 0) {
                 if (strcasecmp(name, "analog_trigger_activation_threshold") == 0) {
                     ParseInt(value, &config->misc.analog_trigger_activation_threshold, 0, 100);
                 } else if (strcasecmp(name, "dualshock3_enable_usb_pairing") == 0) {
                     ParseBoolean(value, &config->misc.dualshock3_enable_usb_pairing);
+                } else if (strcasecmp(name, "dualshock4_enable_usb_pairing") == 0) {
+                    ParseBoolean(value, &config->misc.dualshock4_enable_usb_pairing);
+                } else if (strcasecmp(name, "dualsense_enable_usb_pairing") == 0) {
+                    ParseBoolean(value, &config->misc.dualsense_enable_usb_pairing);
+                } else if (strcasecmp(name, "enable_wired_controllers") == 0) {
+                    ParseBoolean(value, &config->misc.enable_wired_controllers);
                 } else if (strcasecmp(name, "dualshock3_led_mode") == 0) {
                     ParseInt(value, &config->misc.dualshock3_led_mode, 0, 2);
                 } else if (strcasecmp(name, "dualshock4_polling_rate") == 0) {
                     ParseInt(value, &config->misc.dualshock4_polling_rate, 0, 16);
+                } else if (strcasecmp(name, "dualshock4_adaptive_polling_rate") == 0) {
+                    ParseBoolean(value, &config->misc.dualshock4_adaptive_polling_rate);
                 } else if (strcasecmp(name, "dualshock4_lightbar_brightness") == 0) {
                     ParseInt(value, &config->misc.dualshock4_lightbar_brightness, 0, 9);
                 } else if (strcasecmp(name, "dualsense_lightbar_brightness") == 0) {
@@ -111,6 +180,84 @@ namespace ams::mitm {
                 } else if (strcasecmp(name, "dualsense_vibration_intensity") == 0) {
                     ParseInt(value, &config->misc.dualsense_vibration_intensity, 1, 8);
                 }
+            } else if (strcasecmp(section, "threads") == 0) {
+                if (strcasecmp(name, "init_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.init_priority);
+                } else if (strcasecmp(name, "hid_report_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.hid_report_priority);
+                } else if (strcasecmp(name, "event_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.event_priority);
+                } else if (strcasecmp(name, "async_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.async_priority);
+                } else if (strcasecmp(name, "btdrv_data_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.btdrv_data_priority);
+                } else if (strcasecmp(name, "btdrv_control_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.btdrv_control_priority);
+                } else if (strcasecmp(name, "btm_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.btm_priority);
+                } else if (strcasecmp(name, "mc_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.mc_priority);
+                } else if (strcasecmp(name, "usb_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.usb_priority);
+                } else if (strcasecmp(name, "link_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.link_priority);
+                } else if (strcasecmp(name, "capture_priority") == 0) {
+                    ParseThreadPriority(value, &config->threads.capture_priority);
+                }
+            } else if (strcasecmp(section, "link_policy") == 0) {
+                if (strcasecmp(name, "enable") == 0) {
+                    ParseBoolean(value, &config->link_policy.enable);
+                } else if (strcasecmp(name, "idle_timeout") == 0) {
+                    ParseInt(value, &config->link_policy.idle_timeout, 1, 3600);
+                } else if (strcasecmp(name, "flush_timeout") == 0) {
+                    ParseInt(value, &config->link_policy.flush_timeout, 0, 1279);
+                } else if (strcasecmp(name, "qos_latency") == 0) {
+                    ParseInt(value, &config->link_policy.qos_latency, 1250, 1000000);
+                } else if (strcasecmp(name, "switch_mode") == 0) {
+                    ParseInt(value, &config->link_policy.switch_mode, 0, 2);
+                } else if (strcasecmp(name, "wii_mode") == 0) {
+                    ParseInt(value, &config->link_policy.wii_mode, 0, 2);
+                } else if (strcasecmp(name, "dualshock3_mode") == 0) {
+                    ParseInt(value, &config->link_policy.dualshock3_mode, 0, 2);
+                } else if (strcasecmp(name, "dualshock4_mode") == 0) {
+                    ParseInt(value, &config->link_policy.dualshock4_mode, 0, 2);
+                } else if (strcasecmp(name, "dualsense_mode") == 0) {
+                    ParseInt(value, &config->link_policy.dualsense_mode, 0, 2);
+                } else if (strcasecmp(name, "xboxone_mode") == 0) {
+                    ParseInt(value, &config->link_policy.xboxone_mode, 0, 2);
+                } else if (strcasecmp(name, "other_mode") == 0) {
+                    ParseInt(value, &config->link_policy.other_mode, 0, 2);
+                }
+            } else if (strcasecmp(section, "link_quality") == 0) {
+                if (strcasecmp(name, "enable") == 0) {
+                    ParseBoolean(value, &config->link_quality.enable);
+                } else if (strcasecmp(name, "sample_interval") == 0) {
+                    ParseInt(value, &config->link_quality.sample_interval, 1, 60);
+                } else if (strcasecmp(name, "monitor_rssi") == 0) {
+                    ParseBoolean(value, &config->link_quality.monitor_rssi);
+                } else if (strcasecmp(name, "rssi_monitor_period") == 0) {
+                    ParseInt(value, &config->link_quality.rssi_monitor_period, 1, 60);
+                }
+            } else if (strcasecmp(section, "reconnect") == 0) {
+                if (strcasecmp(name, "enable") == 0) {
+                    ParseBoolean(value, &config->reconnect.enable);
+                } else if (strcasecmp(name, "timeout") == 0) {
+                    ParseInt(value, &config->reconnect.timeout, 5, 600);
+                }
+            } else if (strcasecmp(section, "afh") == 0) {
+                if (strcasecmp(name, "enable") == 0) {
+                    ParseBoolean(value, &config->afh.enable);
+                } else if (strcasecmp(name, "interval") == 0) {
+                    ParseInt(value, &config->afh.interval, 5, 60);
+                } else if (strcasecmp(name, "hold_time") == 0) {
+                    ParseInt(value, &config->afh.hold_time, 30, 3600);
+                }
+            } else if (strcasecmp(section, "capture") == 0) {
+                if (strcasecmp(name, "enable") == 0) {
+                    ParseBoolean(value, &config->capture.enable);
+                } else if (strcasecmp(name, "max_file_size") == 0) {
+                    ParseInt(value, &config->capture.max_file_size, 1, 1024);
+                }
             } else {
                 return 0;
             }
@@ -118,6 +265,38 @@ namespace ams::mitm {
             return 1;
         }
 
+        int ProfileIniHandler(void *user, const char *section, const char *name, const char *value) {
+            auto profile = reinterpret_cast<PerformanceProfile *>(user);
+
+            if (strcasecmp(section, "profile") == 0) {
+                if (strcasecmp(name, "dualshock4_polling_rate") == 0) {
+                    ParseInt(value, &profile->dualshock4_polling_rate, 0, 16);
+                } else if (strcasecmp(name, "enable_motion") == 0) {
+                    ParseBoolean(value, &profile->enable_motion);
+                } else if (strcasecmp(name, "rumble_rate_limit") == 0) {
+                    ParseInt(value, &profile->rumble_rate_limit, 0, 1000);
+                } else if (strcasecmp(name, "input_report_interval") == 0) {
+                    ParseInt(value, &profile->input_report_interval, 0, 100);
+                } else if (strcasecmp(name, "coalesce_input_reports") == 0) {
+                    ParseBoolean(value, &profile->coalesce_input_reports);
+                }
+            } else {
+                return 0;
+            }
+
+            return 1;
+        }
+
+        void GetDefaultProfile(PerformanceProfile *profile) {
+            *profile = {
+                .dualshock4_polling_rate = g_global_config.misc.dualshock4_polling_rate,
+                .enable_motion = g_global_config.general.enable_motion,
+                .rumble_rate_limit = 0,
+                .input_report_interval = 0,
+                .coalesce_input_reports = false
+            };
+        }
+
         void ParseIniConfiguration() {
             fs::FileHandle file;
             {
@@ -143,6 +322,9 @@ namespace ams::mitm {
     void LoadConfiguration() {
         ParseIniConfiguration();
         ReadSystemLanguage();
+
+        std::scoped_lock lk(g_profile_lock);
+        GetDefaultProfile(&g_active_profile);
     }
 
     MissionControlConfig *GetGlobalConfig() {
@@ -153,4 +335,31 @@ namespace ams::mitm {
         return g_system_language;
     }
 
+    void LoadProgramProfile(ncm::ProgramId program_id) {
+        PerformanceProfile profile;
+        GetDefaultProfile(&profile);
+
+        char path[0x40];
+        util::SNPrintf(path, sizeof(path), "%s/%016lx.ini", profile_directory_location, program_id.value);
+
+        fs::FileHandle file;
+        if (R_SUCCEEDED(fs::OpenFile(std::addressof(file), path, fs::OpenMode_Read))) {
+            ON_SCOPE_EXIT { fs::CloseFile(file); };
+            util::ini::ParseFile(file, &profile, ProfileIniHandler);
+        }
+
+        std::scoped_lock lk(g_profile_lock);
+        g_active_profile = profile;
+        g_profile_generation += 1;
+    }
+
+    void GetActiveProfile(PerformanceProfile *out_profile) {
+        std::scoped_lock lk(g_profile_lock);
+        *out_profile = g_active_profile;
+    }
+
+    u32 GetProfileGeneration() {
+        return g_profile_generation;
+    }
+
 }
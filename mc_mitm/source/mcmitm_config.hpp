@@ -13,6 +13,8 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+#pragma once
+#include <stratosphere.hpp>
 #include "bluetooth_mitm/bluetooth/bluetooth_types.hpp"
 
 namespace ams::mitm {
@@ -26,22 +28,91 @@ namespace ams::mitm {
         struct {
             char host_name[0x20];
             bluetooth::Address host_address;
+            bool gamepad_inquiry_filter;
         } bluetooth;
 
         struct {
             int analog_trigger_activation_threshold;
             bool dualshock3_enable_usb_pairing;
+            bool dualshock4_enable_usb_pairing;
+            bool dualsense_enable_usb_pairing;
+            bool enable_wired_controllers;
             int dualshock3_led_mode;
             int dualshock4_polling_rate;
+            bool dualshock4_adaptive_polling_rate;
             int dualshock4_lightbar_brightness;
             int dualsense_lightbar_brightness;
             bool dualsense_enable_player_leds;
             int dualsense_vibration_intensity;
         } misc;
+
+        struct {
+            int init_priority;
+            int hid_report_priority;
+            int event_priority;
+            int async_priority;
+            int btdrv_data_priority;
+            int btdrv_control_priority;
+            int btm_priority;
+            int mc_priority;
+            int usb_priority;
+            int link_priority;
+            int capture_priority;
+        } threads;
+
+        struct {
+            bool enable;
+            int idle_timeout;
+            int flush_timeout;
+            int qos_latency;
+            int switch_mode;
+            int wii_mode;
+            int dualshock3_mode;
+            int dualshock4_mode;
+            int dualsense_mode;
+            int xboxone_mode;
+            int other_mode;
+        } link_policy;
+
+        struct {
+            bool enable;
+            int sample_interval;
+            bool monitor_rssi;
+            int rssi_monitor_period;
+        } link_quality;
+
+        struct {
+            bool enable;
+            int timeout;
+        } reconnect;
+
+        struct {
+            bool enable;
+            int interval;
+            int hold_time;
+        } afh;
+
+        struct {
+            bool enable;
+            int max_file_size;
+        } capture;
+    };
+
+    // Settings that can be overridden per title by placing a <program id>.ini file in the profiles directory
+    struct PerformanceProfile {
+        int dualshock4_polling_rate;
+        bool enable_motion;
+        int rumble_rate_limit;
+        int input_report_interval;
+        bool coalesce_input_reports;
     };
 
     void LoadConfiguration();
     MissionControlConfig *GetGlobalConfig();
     SetLanguage GetSystemLanguage();
 
+    void LoadProgramProfile(ncm::ProgramId program_id);
+    void GetActiveProfile(PerformanceProfile *out_profile);
+    u32 GetProfileGeneration();
+
 }
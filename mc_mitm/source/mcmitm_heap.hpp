@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::mitm {
+
+    struct HeapStatistics {
+        u64 total_size;
+        u64 used_size;
+        u64 peak_used_size;
+        u64 allocation_count;
+        u64 free_count;
+        u64 failed_allocation_count;
+    };
+
+    void GetHeapStatistics(HeapStatistics *out);
+
+}
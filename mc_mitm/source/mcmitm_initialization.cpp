@@ -27,7 +27,10 @@
 #include "bluetooth_mitm/bluetooth/bluetooth_hid.hpp"
 #include "bluetooth_mitm/bluetooth/bluetooth_hid_report.hpp"
 #include "bluetooth_mitm/bluetooth/bluetooth_ble.hpp"
+#include "bluetooth_mitm/bluetooth/bluetooth_capture.hpp"
 #include "usb/mc_usb_handler.hpp"
+#include "link/link_policy.hpp"
+#include "controllers/controller_state_mirror.hpp"
 
 namespace ams::mitm {
 
@@ -72,6 +75,12 @@ namespace ams::mitm {
             // Start bluetooth event handling thread
             ams::bluetooth::events::Initialize();
 
+            // Map the controller state mirror before any reports can be published to it
+            ams::controller::InitializeStateMirror();
+
+            // Start hid traffic capture, if enabled, before any reports are handled
+            ams::bluetooth::capture::Initialize();
+
             // Start hid report handling thread
             ams::bluetooth::hid::report::Initialize();
 
@@ -81,6 +90,9 @@ namespace ams::mitm {
             // Connect to btdrv service now that we're sure the mitm is up and running
             R_ABORT_UNLESS(btdrvInitialize());
 
+            // Start controller link policy management thread
+            ams::link::Initialize();
+
             // Get global module settings
             auto config = GetGlobalConfig();
 
@@ -96,12 +108,14 @@ namespace ams::mitm {
             }
 
             g_init_event.Signal();
+
+            // Resume any requests that were deferred while waiting for initialisation
+            ams::mitm::bluetooth::ResumeDeferredRequests();
         }
 
     }
 
     void LaunchModules() {
-        constexpr s32 ThreadPriority = -7;
         constexpr size_t ThreadStackSize = 0x1000;
         os::ThreadType init_thread;
 
@@ -115,7 +129,7 @@ namespace ams::mitm {
             nullptr,
             thread_stack.get(),
             ThreadStackSize,
-            ThreadPriority
+            GetGlobalConfig()->threads.init_priority
         ));
         os::SetThreadNamePointer(&init_thread, "mc::InitThread");
         os::StartThread(&init_thread);
@@ -144,4 +158,8 @@ namespace ams::mitm {
         g_init_event.Wait();
     }
 
+    bool IsInitialized() {
+        return g_init_event.TryWait();
+    }
+
 }
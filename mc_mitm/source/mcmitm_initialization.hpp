@@ -20,5 +20,6 @@ namespace ams::mitm {
     void LaunchModules();
     void WaitModules();
     void WaitInitialized();
+    bool IsInitialized();
 
 }
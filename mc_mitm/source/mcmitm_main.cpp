@@ -16,8 +16,12 @@
 #include <switch.h>
 #include <stratosphere.hpp>
 #include "mcmitm_initialization.hpp"
+#include "mcmitm_heap.hpp"
 #include "mcmitm_config.hpp"
 #include "mcmitm_process_monitor.hpp"
+#include "controllers/controller_management.hpp"
+#include "controllers/controller_report_rate.hpp"
+#include "link/link_reconnect.hpp"
 
 namespace ams {
 
@@ -43,21 +47,57 @@ namespace ams {
                 return g_heap_handle;
             }
 
+            constinit std::atomic<size_t> g_heap_used_size;
+            constinit std::atomic<size_t> g_heap_peak_used_size;
+            constinit std::atomic<u64> g_heap_allocation_count;
+            constinit std::atomic<u64> g_heap_free_count;
+            constinit std::atomic<u64> g_heap_failed_allocation_count;
+
+            void *TrackAllocation(void *p) {
+                if (p == nullptr) {
+                    g_heap_failed_allocation_count++;
+                    return p;
+                }
+
+                g_heap_allocation_count++;
+
+                const size_t used_size = g_heap_used_size += lmem::GetExpHeapMemoryBlockSize(p);
+                size_t peak_used_size = g_heap_peak_used_size.load();
+                while ((used_size > peak_used_size) && !g_heap_peak_used_size.compare_exchange_weak(peak_used_size, used_size)) { /* ... */ }
+
+                return p;
+            }
+
             void *Allocate(size_t size) {
-                return lmem::AllocateFromExpHeap(GetHeapHandle(), size);
+                return TrackAllocation(lmem::AllocateFromExpHeap(GetHeapHandle(), size));
             }
 
             void *AllocateWithAlign(size_t size, size_t align) {
-                return lmem::AllocateFromExpHeap(GetHeapHandle(), size, align);
+                return TrackAllocation(lmem::AllocateFromExpHeap(GetHeapHandle(), size, align));
             }
 
             void Deallocate(void *p, size_t size) {
                 AMS_UNUSED(size);
+
+                if (p != nullptr) {
+                    g_heap_free_count++;
+                    g_heap_used_size -= lmem::GetExpHeapMemoryBlockSize(p);
+                }
+
                 return lmem::FreeToExpHeap(GetHeapHandle(), p);
             }
 
         }
 
+        void GetHeapStatistics(HeapStatistics *out) {
+            out->total_size = sizeof(g_heap_memory);
+            out->used_size = g_heap_used_size;
+            out->peak_used_size = g_heap_peak_used_size;
+            out->allocation_count = g_heap_allocation_count;
+            out->free_count = g_heap_free_count;
+            out->failed_allocation_count = g_heap_failed_allocation_count;
+        }
+
     }
 
     namespace init {
@@ -130,6 +170,10 @@ namespace ams {
                                 [[fallthrough]];
                             case psc::PmState_SleepReady:
                                 /* Run sleep/shutdown code */
+                                link::OnSleep();
+                                break;
+                            case psc::PmState_FullAwake:
+                                link::OnWake();
                                 break;
                             default:
                                 break;
@@ -142,6 +186,8 @@ namespace ams {
                 case 1:
                     timer_event.Clear();
                     mc::CheckForProcessSwitch();
+                    controller::ApplyPerformanceProfile();
+                    controller::UpdateReportRates();
                     break;
 
                 AMS_UNREACHABLE_DEFAULT_CASE();
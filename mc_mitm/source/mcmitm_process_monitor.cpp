@@ -14,6 +14,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "mcmitm_process_monitor.hpp"
+#include "mcmitm_config.hpp"
 
 namespace ams::mc {
 
@@ -53,6 +54,7 @@ namespace ams::mc {
         if (R_SUCCEEDED(GetCurrentApplicationProgramId(&id))) {
             if (id != g_current_program) {
                 g_current_program = id;
+                mitm::LoadProgramProfile(id);
                 g_process_switch_event.Signal();
             }
         }
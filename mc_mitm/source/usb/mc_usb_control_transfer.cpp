@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "mc_usb_control_transfer.hpp"
+
+namespace ams::usb {
+
+    Result GetFeatureReport(ControlTransferInterface *control, u8 id, void *out_data, u16 size) {
+        u32 tx_size = 0;
+        R_TRY(control->ControlTransferIn(HidRequest_GetReport, (HidReportType_Feature << 8) | id, out_data, size, &tx_size));
+
+        R_UNLESS(tx_size >= size, svc::ResultOutOfRange());
+
+        R_SUCCEED();
+    }
+
+    Result SetFeatureReport(ControlTransferInterface *control, u8 id, const void *data, u16 size) {
+        R_RETURN(control->ControlTransferOut(HidRequest_SetReport, (HidReportType_Feature << 8) | id, data, size));
+    }
+
+}
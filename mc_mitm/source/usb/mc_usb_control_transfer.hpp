@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::usb {
+
+    constexpr u8 HidRequest_GetReport = 0x01;
+    constexpr u8 HidRequest_SetReport = 0x09;
+    constexpr u16 HidReportType_Feature = 0x03;
+
+    // Issues class specific control requests to a controller's HID interface. Pairing talks to controllers only through this, so
+    // that it can be run against recorded transfers
+    class ControlTransferInterface {
+
+        public:
+            virtual ~ControlTransferInterface() { }
+
+            virtual Result ControlTransferIn(u8 request, u16 value, void *out_data, u16 length, u32 *out_size) = 0;
+            virtual Result ControlTransferOut(u8 request, u16 value, const void *data, u16 length) = 0;
+
+    };
+
+    Result GetFeatureReport(ControlTransferInterface *control, u8 id, void *out_data, u16 size);
+    Result SetFeatureReport(ControlTransferInterface *control, u8 id, const void *data, u16 size);
+
+}
@@ -14,100 +14,95 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "mc_usb_handler.hpp"
+#include "mc_usb_pairing.hpp"
+#include "mc_usb_wired_controller.hpp"
 #include "../mcmitm_config.hpp"
-#include "../controllers/dualshock3_controller.hpp"
 
 namespace ams::usb {
 
     namespace {
 
-        Result GetOldestPairedDeviceAddress(bluetooth::Address *out_address) {
-            if (hos::GetVersion() >= hos::Version_13_0_0) {
-                s32 total_out;
-                BtmDeviceInfoV13 device_info[10];
-                R_TRY(btmGetDeviceInfo(BtmProfile_Hid, device_info, 10, &total_out));
-
-                *out_address = device_info[0].addr;
-            } else {
-                BtmDeviceInfoList device_info_list;
-                R_TRY(btmLegacyGetDeviceInfo(&device_info_list));
+        constexpr size_t ThreadStackSize = 0x4000;
+        alignas(os::ThreadStackAlignment) constinit u8 g_thread_stack[ThreadStackSize];
+        constinit os::ThreadType g_thread;
 
-                *out_address = device_info_list.devices[0].addr;
-            }
+        enum InterfaceAvailableEvent {
+            InterfaceAvailableEvent_Pairing = 0,
+            InterfaceAvailableEvent_WiredController = 1,
+        };
 
-            R_SUCCEED();
+        bool IsUsbThreadRequired() {
+            return IsUsbPairingEnabled() || mitm::GetGlobalConfig()->misc.enable_wired_controllers;
         }
 
-        Result HandleUsbHsInterfaceAvailableEvent() {
-            s32 total_entries = 0;
-            UsbHsInterface interfaces[8] = {};
-            R_TRY(usbHsQueryAvailableInterfaces(controller::Dualshock3Controller::GetUsbInterfaceFilter(), interfaces, sizeof(interfaces), &total_entries));
-
-            // Only connect to these services when we need them, since there is only one free handle available for either on 17.0.0+
-            R_TRY(btmInitialize());
-            R_TRY(btmsysInitialize());
-            ON_SCOPE_EXIT {
-                btmsysExit();
-                btmExit();
-            };
-
-            for(int i = 0; i < total_entries; ++i) {
-                if (controller::Dualshock3Controller::UsbIdentify(&interfaces[i])) {
-                    bool pairing_started = false;
-                    R_TRY(btmsysIsGamepadPairingStarted(&pairing_started));
-                    if (pairing_started) {
-                        // Make room for a new device if pairing database is full
-                        u8 paired_count;
-                        R_TRY(btmsysGetPairedGamepadCount(&paired_count));
-                        if (paired_count >= 10) {
-                            // Get the address of the least recently connected device in the pairing database
-                            bluetooth::Address address;
-                            R_TRY(GetOldestPairedDeviceAddress(&address));
-
-                            // Remove the bonded address to make room for our new pairing
-                            R_TRY(btmRemoveDeviceInfo(address));
-                            R_TRY(btdrvRemoveBond(address));
-                        }
-
-                        // Pair the Dualshock 3 controller via USB
-                        R_TRY(controller::Dualshock3Controller::UsbPair(&interfaces[i]));
-                    }
-                }
-            }
+        void UsbThreadFunction(void *) {
+            auto config = mitm::GetGlobalConfig();
 
-            R_SUCCEED();
-        }
+            os::MultiWaitType wait_manager;
+            os::InitializeMultiWait(&wait_manager);
 
-        constexpr s32 ThreadPriority = 9;
-        constexpr size_t ThreadStackSize = 0x4000;
-        alignas(os::ThreadStackAlignment) constinit u8 g_thread_stack[ThreadStackSize];
-        constinit os::ThreadType g_thread;
+            Event pairing_if_event = {};
+            os::SystemEvent pairing_event;
+            os::MultiWaitHolderType holder_pairing;
+            if (IsUsbPairingEnabled()) {
+                R_ABORT_UNLESS(usbHsCreateInterfaceAvailableEvent(&pairing_if_event, true, InterfaceAvailableEvent_Pairing, GetUsbPairingInterfaceFilter()));
+                pairing_event.AttachReadableHandle(pairing_if_event.revent, false, os::EventClearMode_AutoClear);
 
-        void UsbThreadFunction(void *) {
-            Event if_event;
-            R_ABORT_UNLESS(usbHsCreateInterfaceAvailableEvent(&if_event, true, 0, controller::Dualshock3Controller::GetUsbInterfaceFilter()));
+                os::InitializeMultiWaitHolder(&holder_pairing, pairing_event.GetBase());
+                os::SetMultiWaitHolderUserData(&holder_pairing, InterfaceAvailableEvent_Pairing);
+                os::LinkMultiWaitHolder(&wait_manager, &holder_pairing);
+            }
+
+            Event wired_if_event = {};
+            os::SystemEvent wired_event;
+            os::MultiWaitHolderType holder_wired;
+            if (config->misc.enable_wired_controllers) {
+                R_ABORT_UNLESS(usbHsCreateInterfaceAvailableEvent(&wired_if_event, true, InterfaceAvailableEvent_WiredController, GetWiredControllerInterfaceFilter()));
+                wired_event.AttachReadableHandle(wired_if_event.revent, false, os::EventClearMode_AutoClear);
+
+                os::InitializeMultiWaitHolder(&holder_wired, wired_event.GetBase());
+                os::SetMultiWaitHolderUserData(&holder_wired, InterfaceAvailableEvent_WiredController);
+                os::LinkMultiWaitHolder(&wait_manager, &holder_wired);
 
-            os::SystemEvent interface_available_event;
-            interface_available_event.AttachReadableHandle(if_event.revent, false, os::EventClearMode_AutoClear);
+                InitializeWiredControllers();
+            }
 
             for (;;) {
-                interface_available_event.Wait();
-                R_ABORT_UNLESS(HandleUsbHsInterfaceAvailableEvent());
+                auto signalled_holder = os::WaitAny(&wait_manager);
+                switch (os::GetMultiWaitHolderUserData(signalled_holder)) {
+                    case InterfaceAvailableEvent_Pairing:
+                        pairing_event.Clear();
+                        // Pairing is retried when the controller is next plugged in, so a failure here isn't worth aborting over
+                        static_cast<void>(HandleUsbPairingAvailableEvent());
+                        break;
+                    case InterfaceAvailableEvent_WiredController:
+                        wired_event.Clear();
+                        R_ABORT_UNLESS(HandleWiredControllerAvailableEvent());
+                        break;
+                    default:
+                        break;
+                }
             }
 
-            usbHsDestroyInterfaceAvailableEvent(&if_event, 0);
+            if (config->misc.enable_wired_controllers) {
+                usbHsDestroyInterfaceAvailableEvent(&wired_if_event, InterfaceAvailableEvent_WiredController);
+            }
+
+            if (IsUsbPairingEnabled()) {
+                usbHsDestroyInterfaceAvailableEvent(&pairing_if_event, InterfaceAvailableEvent_Pairing);
+            }
         }
 
     }
 
     void Launch() {
-        if (mitm::GetGlobalConfig()->misc.dualshock3_enable_usb_pairing) {
+        if (IsUsbThreadRequired()) {
             R_ABORT_UNLESS(os::CreateThread(&g_thread,
                 UsbThreadFunction,
                 nullptr,
                 g_thread_stack,
                 ThreadStackSize,
-                ThreadPriority
+                mitm::GetGlobalConfig()->threads.usb_priority
             ));
 
             os::SetThreadNamePointer(&g_thread, "mc::UsbThread");
@@ -116,7 +111,7 @@ namespace ams::usb {
     }
 
     void WaitFinished() {
-        if (mitm::GetGlobalConfig()->misc.dualshock3_enable_usb_pairing) {
+        if (IsUsbThreadRequired()) {
             os::WaitThread(&g_thread);
         }
     }
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "mc_usb_pairing.hpp"
+#include "mc_usb_pairing_strategies.hpp"
+#include "../mcmitm_config.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_core.hpp"
+#include "../controllers/controller_management.hpp"
+
+namespace ams::usb {
+
+    namespace {
+
+        // Class specific requests addressed to the HID interface
+        constexpr u8 HidRequestTypeIn  = USB_ENDPOINT_IN  | (0x01 << 5) | 0x01;
+        constexpr u8 HidRequestTypeOut = USB_ENDPOINT_OUT | (0x01 << 5) | 0x01;
+
+        constexpr u16 SonyVendorId = 0x054c;
+
+        // How a particular controller is told the console address over USB and registered in the pairing database
+        struct UsbPairingStrategy {
+            bool (*IsEnabled)();
+            bool (*Identify)(const UsbHsInterface *iface);
+            Result (*Pair)(ControlTransferInterface *control, const UsbHsInterface *iface);
+        };
+
+        constexpr UsbPairingStrategy PairingStrategies[] = {
+            {
+                [] { return mitm::GetGlobalConfig()->misc.dualshock3_enable_usb_pairing; },
+                IdentifyDualshock3,
+                PairDualshock3
+            },
+            {
+                [] { return mitm::GetGlobalConfig()->misc.dualshock4_enable_usb_pairing; },
+                IdentifyDualshock4,
+                PairDualshock4
+            },
+            {
+                [] { return mitm::GetGlobalConfig()->misc.dualsense_enable_usb_pairing; },
+                IdentifyDualsense,
+                PairDualsense
+            },
+        };
+
+        // All controllers that can currently be paired over USB are made by Sony
+        constinit const UsbHsInterfaceFilter g_interface_filter = {
+            .Flags = UsbHsInterfaceFilterFlags_idVendor | UsbHsInterfaceFilterFlags_bInterfaceClass,
+            .idVendor = SonyVendorId,
+            .bInterfaceClass = USB_CLASS_HID,
+        };
+
+        constinit os::SdkMutex g_usb_buffer_lock;
+        alignas(os::MemoryPageSize) constinit u8 g_usb_buffer[0x1000];
+
+        // Transfers are bounced through a page aligned buffer, since usb:hs maps it for the transfer
+        class InterfaceControlTransfer final : public ControlTransferInterface {
+
+            public:
+                InterfaceControlTransfer(UsbHsClientIfSession *if_session) : m_if_session(if_session) { }
+
+                Result ControlTransferIn(u8 request, u16 value, void *out_data, u16 length, u32 *out_size) override {
+                    R_UNLESS(length <= sizeof(g_usb_buffer), svc::ResultOutOfRange());
+
+                    std::scoped_lock lk(g_usb_buffer_lock);
+
+                    R_TRY(usbHsIfCtrlXfer(m_if_session, HidRequestTypeIn, request, value, this->GetInterfaceNumber(), length, g_usb_buffer, out_size));
+
+                    std::memcpy(out_data, g_usb_buffer, std::min<size_t>(*out_size, length));
+
+                    R_SUCCEED();
+                }
+
+                Result ControlTransferOut(u8 request, u16 value, const void *data, u16 length) override {
+                    R_UNLESS(length <= sizeof(g_usb_buffer), svc::ResultOutOfRange());
+
+                    std::scoped_lock lk(g_usb_buffer_lock);
+
+                    std::memcpy(g_usb_buffer, data, length);
+
+                    u32 rx_size = 0;
+                    R_RETURN(usbHsIfCtrlXfer(m_if_session, HidRequestTypeOut, request, value, this->GetInterfaceNumber(), length, g_usb_buffer, &rx_size));
+                }
+
+            private:
+                u8 GetInterfaceNumber() const {
+                    return m_if_session->inf.inf.interface_desc.bInterfaceNumber;
+                }
+
+                UsbHsClientIfSession *m_if_session;
+
+        };
+
+        const UsbPairingStrategy *FindPairingStrategy(const UsbHsInterface *iface) {
+            for (auto &strategy : PairingStrategies) {
+                if (strategy.IsEnabled() && strategy.Identify(iface)) {
+                    return &strategy;
+                }
+            }
+
+            return nullptr;
+        }
+
+        Result GetOldestPairedDeviceAddress(bluetooth::Address *out_address) {
+            if (hos::GetVersion() >= hos::Version_13_0_0) {
+                s32 total_out;
+                BtmDeviceInfoV13 device_info[10];
+                R_TRY(btmGetDeviceInfo(BtmProfile_Hid, device_info, 10, &total_out));
+
+                *out_address = device_info[0].addr;
+            } else {
+                BtmDeviceInfoList device_info_list;
+                R_TRY(btmLegacyGetDeviceInfo(&device_info_list));
+
+                *out_address = device_info_list.devices[0].addr;
+            }
+
+            R_SUCCEED();
+        }
+
+        Result MakeRoomForPairing() {
+            // Sessions are reference counted, so this only connects if the caller hasn't already
+            R_TRY(btmInitialize());
+            R_TRY(btmsysInitialize());
+            ON_SCOPE_EXIT {
+                btmsysExit();
+                btmExit();
+            };
+
+            // Make room for a new device if pairing database is full
+            u8 paired_count;
+            R_TRY(btmsysGetPairedGamepadCount(&paired_count));
+            if (paired_count >= 10) {
+                // Get the address of the least recently connected device in the pairing database
+                bluetooth::Address address;
+                R_TRY(GetOldestPairedDeviceAddress(&address));
+
+                // Remove the bonded address to make room for our new pairing
+                R_TRY(btmRemoveDeviceInfo(address));
+                R_TRY(btdrvRemoveBond(address));
+            }
+
+            R_SUCCEED();
+        }
+
+        Result PairDevice(const UsbPairingStrategy *strategy, UsbHsInterface *iface) {
+            // Acquire usb:hs client interface session
+            UsbHsClientIfSession if_session;
+            R_TRY(usbHsAcquireUsbIf(&if_session, iface));
+
+            // Close session on function exit
+            ON_SCOPE_EXIT {
+                if (usbHsIfIsActive(&if_session)) {
+                    usbHsIfClose(&if_session);
+                }
+            };
+
+            InterfaceControlTransfer control(&if_session);
+            R_RETURN(strategy->Pair(&control, iface));
+        }
+
+        void SignalBondComplete(const bluetooth::Address *address) {
+            if (hos::GetVersion() < hos::Version_9_0_0) {
+                const struct {
+                    BtdrvAddress addr;
+                    u8 pad[2];
+                    u32 status;
+                    u32 type;
+                } bond_event = { *address, {0}, 0,  BtdrvConnectionEventType_Suspended };
+
+                bluetooth::core::SignalFakeEvent(BtdrvEventTypeOld_Connection, &bond_event, sizeof(bond_event));
+            } else if (hos::GetVersion() < hos::Version_12_0_0) {
+                const struct {
+                    u32 status;
+                    BtdrvAddress addr;
+                    u8 pad[2];
+                    u32 type;
+                } bond_event = { 0, *address, {0}, BtdrvConnectionEventType_Suspended };
+
+                bluetooth::core::SignalFakeEvent(BtdrvEventTypeOld_Connection, &bond_event, sizeof(bond_event));
+            } else {
+                const struct {
+                    u32 type;
+                    BtdrvAddress addr;
+                    u8 reserved[0xfe];
+                } bond_event = { BtdrvConnectionEventType_Suspended, *address, {0} };
+
+                bluetooth::core::SignalFakeEvent(BtdrvEventType_Connection, &bond_event, sizeof(bond_event));
+            }
+        }
+
+    }
+
+    const UsbHsInterfaceFilter *GetUsbPairingInterfaceFilter() {
+        return &g_interface_filter;
+    }
+
+    bool IsUsbPairingEnabled() {
+        return std::any_of(std::begin(PairingStrategies), std::end(PairingStrategies), [](const UsbPairingStrategy &s) { return s.IsEnabled(); });
+    }
+
+    Result HandleUsbPairingAvailableEvent() {
+        s32 total_entries = 0;
+        UsbHsInterface interfaces[8] = {};
+        R_TRY(usbHsQueryAvailableInterfaces(&g_interface_filter, interfaces, sizeof(interfaces), &total_entries));
+
+        // Only connect to these services when we need them, since there is only one free handle available for either on 17.0.0+
+        R_TRY(btmInitialize());
+        R_TRY(btmsysInitialize());
+        ON_SCOPE_EXIT {
+            btmsysExit();
+            btmExit();
+        };
+
+        for (int i = 0; i < total_entries; ++i) {
+            auto strategy = FindPairingStrategy(&interfaces[i]);
+            if (strategy == nullptr) {
+                continue;
+            }
+
+            // A controller that fails to pair shouldn't take the rest of the module down with it, or stop the others from pairing
+            bool pairing_started = false;
+            if (R_SUCCEEDED(btmsysIsGamepadPairingStarted(&pairing_started)) && pairing_started) {
+                static_cast<void>(PairDevice(strategy, &interfaces[i]));
+            }
+        }
+
+        R_SUCCEED();
+    }
+
+    Result GetHostAddress(bluetooth::Address *out_address) {
+        BtdrvAdapterProperty property;
+        R_TRY(btdrvGetAdapterProperty(BtdrvAdapterPropertyType_Address, &property));
+
+        *out_address = *reinterpret_cast<bluetooth::Address *>(property.data);
+
+        R_SUCCEED();
+    }
+
+    Result AddPairedDevice(const UsbPairedDevice *device) {
+        // Only evict a bond once the controller has given up its address, and not at all if it is already in the pairing database
+        bluetooth::DevicesSettings paired_settings;
+        if (R_FAILED(btdrvGetPairedDeviceInfo(device->address, &paired_settings))) {
+            R_TRY(MakeRoomForPairing());
+        }
+
+        // The controller may have been known under a different hardware id before, if it was previously paired in another mode
+        controller::ForgetKnownDevice(device->address);
+
+        SetSysBluetoothDevicesSettings settings = {};
+        settings.addr = device->address;
+        settings.class_of_device = device->class_of_device;
+        settings.trusted_services = 0x100000;
+        settings.vid = device->vid;
+        settings.pid = device->pid;
+        settings.sub_class = 0x08;
+        settings.attribute_mask = 0xff;
+
+        if (device->link_key != nullptr) {
+            std::memcpy(settings.link_key, device->link_key, LinkKeySize);
+            settings.link_key_present = true;
+        }
+
+        if (hos::GetVersion() < hos::Version_13_0_0) {
+            std::strncpy(settings.name.name, device->name, sizeof(settings.name));
+        } else {
+            std::strncpy(settings.name2, device->name, sizeof(settings.name2));
+        }
+
+        R_TRY(btdrvAddPairedDeviceInfo(&settings));
+
+        // Signal fake bonding success event for btm
+        SignalBondComplete(&device->address);
+
+        R_SUCCEED();
+    }
+
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
+
+namespace ams::usb {
+
+    constexpr size_t LinkKeySize = 0x10;
+
+    // Details of a controller paired over USB, as stored in the bluetooth pairing database
+    struct UsbPairedDevice {
+        bluetooth::Address address;
+        bluetooth::DeviceClass class_of_device;
+        u16 vid;
+        u16 pid;
+        const char *name;
+        const u8 *link_key;  // nullptr if the controller negotiates a link key when it first connects
+    };
+
+    const UsbHsInterfaceFilter *GetUsbPairingInterfaceFilter();
+    bool IsUsbPairingEnabled();
+    Result HandleUsbPairingAvailableEvent();
+
+    Result GetHostAddress(bluetooth::Address *out_address);
+    Result AddPairedDevice(const UsbPairedDevice *device);
+
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "mc_usb_pairing_strategies.hpp"
+#include "mc_usb_pairing.hpp"
+#include "../controllers/dualshock3_controller.hpp"
+#include "../controllers/dualshock4_controller.hpp"
+#include "../controllers/dualsense_controller.hpp"
+#include "../utils/utils_bluetooth_address.hpp"
+
+namespace ams::usb {
+
+    namespace {
+
+        constexpr const char Ds3DeviceName[] = "PLAYSTATION(R)3 Controller";
+        constexpr const char Ds4DeviceName[] = "Wireless Controller";
+        constexpr const char DualsenseDeviceName[] = "Wireless Controller";
+
+        constexpr u16 SonyVendorId = 0x054c;
+
+        // The Dualshock 3 reports its address in a 17 byte feature report, after a 4 byte header
+        constexpr u8 Ds3AddressReportId = 0xf2;
+        constexpr u16 Ds3AddressReportSize = 17;
+        constexpr size_t Ds3AddressOffset = 4;
+
+        // Licensed third party controllers don't necessarily support being paired this way
+        template <size_t N>
+        bool IsSonyController(const controller::HardwareID (&hardware_ids)[N], const UsbHsInterface *iface) {
+            for (auto id : hardware_ids) {
+                if ((id.vid == SonyVendorId) && (iface->device_desc.idVendor == id.vid) && (iface->device_desc.idProduct == id.pid)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        Result SetMasterAddress(ControlTransferInterface *control, const bluetooth::Address *address) {
+            const struct {
+                u8 unk1;
+                u8 unk2;
+                bluetooth::Address address;
+            } data = {0x01, 0x00, *address};
+
+            R_RETURN(SetFeatureReport(control, 0xf5, &data, sizeof(data)));
+        }
+
+        Result GetSlaveAddress(ControlTransferInterface *control, bluetooth::Address *address) {
+            u8 data[Ds3AddressReportSize];
+            R_TRY(GetFeatureReport(control, Ds3AddressReportId, data, sizeof(data)));
+
+            std::memcpy(address, &data[Ds3AddressOffset], sizeof(bluetooth::Address));
+
+            R_SUCCEED();
+        }
+
+    }
+
+    bool IdentifyDualshock3(const UsbHsInterface *iface) {
+        return IsSonyController(controller::Dualshock3Controller::hardware_ids, iface);
+    }
+
+    Result PairDualshock3(ControlTransferInterface *control, const UsbHsInterface *iface) {
+        // Set the console address as the master on the DS3
+        bluetooth::Address master_address;
+        R_TRY(GetHostAddress(&master_address));
+        R_TRY(SetMasterAddress(control, &master_address));
+
+        // Get the address of the DS3
+        bluetooth::Address slave_address;
+        R_TRY(GetSlaveAddress(control, &slave_address));
+
+        // Add DS3 to list of trusted devices. The controller negotiates its own link key once it connects
+        const UsbPairedDevice device = {
+            .address = slave_address,
+            .class_of_device = {0x00, 0x05, 0x08},
+            .vid = iface->device_desc.idVendor,
+            .pid = iface->device_desc.idProduct,
+            .name = Ds3DeviceName,
+            .link_key = nullptr
+        };
+
+        R_RETURN(AddPairedDevice(&device));
+    }
+
+    bool IdentifyDualshock4(const UsbHsInterface *iface) {
+        return IsSonyController(controller::Dualshock4Controller::hardware_ids, iface);
+    }
+
+    Result PairDualshock4(ControlTransferInterface *control, const UsbHsInterface *iface) {
+        // Get the address of the controller
+        controller::Dualshock4ReportData report = {};
+        R_TRY(GetFeatureReport(control, 0x12, &report, sizeof(report.feature0x12) + sizeof(report.id)));
+        const bluetooth::Address address = utils::BluetoothAddressReverse(report.feature0x12.address);
+
+        bluetooth::Address host_address;
+        R_TRY(GetHostAddress(&host_address));
+
+        // Program the console address and a new link key into the controller, so that it can connect and authenticate straight away
+        u8 link_key[LinkKeySize];
+        os::GenerateRandomBytes(link_key, sizeof(link_key));
+
+        report = {};
+        report.id = 0x13;
+        report.feature0x13.host_address = utils::BluetoothAddressReverse(host_address);
+        std::memcpy(report.feature0x13.link_key, link_key, sizeof(link_key));
+        R_TRY(SetFeatureReport(control, 0x13, &report, sizeof(report.feature0x13) + sizeof(report.id)));
+
+        const UsbPairedDevice device = {
+            .address = address,
+            .class_of_device = {0x00, 0x25, 0x08},
+            .vid = iface->device_desc.idVendor,
+            .pid = iface->device_desc.idProduct,
+            .name = Ds4DeviceName,
+            .link_key = link_key
+        };
+
+        R_RETURN(AddPairedDevice(&device));
+    }
+
+    bool IdentifyDualsense(const UsbHsInterface *iface) {
+        return IsSonyController(controller::DualsenseController::hardware_ids, iface);
+    }
+
+    Result PairDualsense(ControlTransferInterface *control, const UsbHsInterface *iface) {
+        // Get the address of the controller
+        controller::DualsenseReportData report = {};
+        R_TRY(GetFeatureReport(control, 0x09, &report, sizeof(report.feature0x09) + sizeof(report.id)));
+        const bluetooth::Address address = utils::BluetoothAddressReverse(report.feature0x09.address);
+
+        bluetooth::Address host_address;
+        R_TRY(GetHostAddress(&host_address));
+
+        // Program the console address and a new link key into the controller, so that it can connect and authenticate straight away
+        u8 link_key[LinkKeySize];
+        os::GenerateRandomBytes(link_key, sizeof(link_key));
+
+        report = {};
+        report.id = 0x0a;
+        report.feature0x0a.host_address = utils::BluetoothAddressReverse(host_address);
+        std::memcpy(report.feature0x0a.link_key, link_key, sizeof(link_key));
+        R_TRY(SetFeatureReport(control, 0x0a, &report, sizeof(report.feature0x0a) + sizeof(report.id)));
+
+        const UsbPairedDevice device = {
+            .address = address,
+            .class_of_device = {0x00, 0x25, 0x08},
+            .vid = iface->device_desc.idVendor,
+            .pid = iface->device_desc.idProduct,
+            .name = DualsenseDeviceName,
+            .link_key = link_key
+        };
+
+        R_RETURN(AddPairedDevice(&device));
+    }
+
+}
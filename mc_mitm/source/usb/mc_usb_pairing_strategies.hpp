@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "mc_usb_control_transfer.hpp"
+
+namespace ams::usb {
+
+    // Per controller steps for pairing over USB: recognising the controller, exchanging addresses (and a link key where
+    // supported) with it, and adding it to the pairing database
+    bool IdentifyDualshock3(const UsbHsInterface *iface);
+    Result PairDualshock3(ControlTransferInterface *control, const UsbHsInterface *iface);
+
+    bool IdentifyDualshock4(const UsbHsInterface *iface);
+    Result PairDualshock4(ControlTransferInterface *control, const UsbHsInterface *iface);
+
+    bool IdentifyDualsense(const UsbHsInterface *iface);
+    Result PairDualsense(ControlTransferInterface *control, const UsbHsInterface *iface);
+
+}
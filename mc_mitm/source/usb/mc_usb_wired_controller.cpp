@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "mc_usb_wired_controller.hpp"
+#include "mc_usb_wired_protocol.hpp"
+#include "../mcmitm_config.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_hid.hpp"
+#include "../controllers/controller_management.hpp"
+#include "../utils/utils_bluetooth_address.hpp"
+
+namespace ams::usb {
+
+    namespace {
+
+        constexpr size_t MaxWiredControllers = 4;
+        constexpr size_t MaxReportSize = 64;
+
+        constexpr size_t ThreadStackSize = 0x2000;
+        alignas(os::ThreadStackAlignment) constinit u8 g_thread_stacks[MaxWiredControllers][ThreadStackSize];
+
+        // Class specific requests addressed to the HID interface
+        constexpr u8 HidRequestTypeIn  = USB_ENDPOINT_IN  | (0x01 << 5) | 0x01;
+        constexpr u8 HidRequestTypeOut = USB_ENDPOINT_OUT | (0x01 << 5) | 0x01;
+        constexpr u8 HidRequest_GetReport = 0x01;
+        constexpr u8 HidRequest_SetReport = 0x09;
+
+        constinit const UsbHsInterfaceFilter g_interface_filter = {
+            .Flags = UsbHsInterfaceFilterFlags_bInterfaceClass,
+            .bInterfaceClass = USB_CLASS_HID,
+        };
+
+        template <typename Controller>
+        bool MatchHardwareId(const UsbHsInterface *iface) {
+            for (auto id : Controller::hardware_ids) {
+                if ((iface->device_desc.idVendor == id.vid) && (iface->device_desc.idProduct == id.pid)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        WiredProtocol IdentifyProtocol(const UsbHsInterface *iface) {
+            if (MatchHardwareId<controller::Dualshock3Controller>(iface)) {
+                return WiredProtocol_Dualshock3;
+            } else if (MatchHardwareId<controller::Dualshock4Controller>(iface)) {
+                return WiredProtocol_Dualshock4;
+            } else if (MatchHardwareId<controller::DualsenseController>(iface)) {
+                return WiredProtocol_Dualsense;
+            }
+
+            return WiredProtocol_Unsupported;
+        }
+
+        // A controller plugged in over USB. Input reports are read straight from its interrupt endpoint and passed to the regular
+        // controller driver, which sees the device as though it were connected over Bluetooth
+        class WiredController : public controller::ControllerTransport {
+
+            public:
+                WiredController() : m_attach_event(os::EventClearMode_AutoClear), m_in_use(false), m_open(false) { }
+
+                bool IsInUse() const { return m_in_use; }
+
+                void Launch(void *stack) {
+                    R_ABORT_UNLESS(os::CreateThread(&m_thread,
+                        [](void *arg) { static_cast<WiredController *>(arg)->ThreadFunc(); },
+                        this,
+                        stack,
+                        ThreadStackSize,
+                        mitm::GetGlobalConfig()->threads.hid_report_priority
+                    ));
+
+                    os::SetThreadNamePointer(&m_thread, "mc::WiredControllerThread");
+                    os::StartThread(&m_thread);
+                }
+
+                Result Open(UsbHsInterface *iface, WiredProtocol protocol) {
+                    std::scoped_lock lk(m_mutex);
+
+                    R_TRY(usbHsAcquireUsbIf(&m_if_session, iface));
+
+                    ON_SCOPE_EXIT {
+                        if (!m_open) {
+                            this->CloseSession();
+                        }
+                    };
+
+                    m_protocol = protocol;
+                    m_interface_number = iface->inf.interface_desc.bInterfaceNumber;
+
+                    R_TRY(this->OpenEndpoints(iface));
+                    R_TRY(this->ReadAddress());
+
+                    // The hid sysmodule only accepts controllers it knows about, so the controller must have been paired over Bluetooth first
+                    bluetooth::DevicesSettings device_settings;
+                    R_TRY(btdrvGetPairedDeviceInfo(m_address, &device_settings));
+
+                    // Leave the controller alone if it's already connected over Bluetooth
+                    R_UNLESS(controller::LocateHandler(m_address) == nullptr, svc::ResultInvalidState());
+
+                    m_open = true;
+                    m_in_use = true;
+
+                    R_SUCCEED();
+                }
+
+                void Start() {
+                    m_attach_event.Signal();
+                }
+
+                Result WriteDataReport(const bluetooth::HidReport *report) override {
+                    std::scoped_lock lk(m_mutex);
+                    R_UNLESS(m_open, svc::ResultInvalidState());
+
+                    const size_t size = ConvertOutputReport(m_protocol, report, m_control_buffer);
+
+                    u32 transferred_size = 0;
+                    if (m_has_output_endpoint) {
+                        R_RETURN(usbHsEpPostBuffer(&m_output_endpoint, m_control_buffer, size, &transferred_size));
+                    }
+
+                    R_RETURN(this->ControlTransfer(HidRequestTypeOut, HidRequest_SetReport, MakeReportValue(BtdrvBluetoothHhReportType_Output, m_control_buffer[0]), size, &transferred_size));
+                }
+
+                Result SetReport(BtdrvBluetoothHhReportType type, const bluetooth::HidReport *report) override {
+                    std::scoped_lock lk(m_mutex);
+                    R_UNLESS(m_open, svc::ResultInvalidState());
+
+                    std::memcpy(m_control_buffer, report->data, report->size);
+
+                    u32 transferred_size = 0;
+                    R_RETURN(this->ControlTransfer(HidRequestTypeOut, HidRequest_SetReport, MakeReportValue(type, report->data[0]), report->size, &transferred_size));
+                }
+
+                Result GetReport(u8 id, BtdrvBluetoothHhReportType type, bluetooth::HidReport *out_report) override {
+                    std::scoped_lock lk(m_mutex);
+                    R_UNLESS(m_open, svc::ResultInvalidState());
+
+                    const u8 usb_id = type == BtdrvBluetoothHhReportType_Feature ? GetUsbFeatureReportId(m_protocol, id) : id;
+
+                    u32 transferred_size = 0;
+                    R_TRY(this->ControlTransfer(HidRequestTypeIn, HidRequest_GetReport, MakeReportValue(type, usb_id), MaxReportSize, &transferred_size));
+                    R_UNLESS(transferred_size > 0, svc::ResultOutOfRange());
+
+                    if (type == BtdrvBluetoothHhReportType_Feature) {
+                        ConvertFeatureReport(m_protocol, id, m_control_buffer, transferred_size, out_report);
+                    } else {
+                        out_report->size = transferred_size;
+                        std::memcpy(out_report->data, m_control_buffer, transferred_size);
+                        out_report->data[0] = id;
+                    }
+
+                    R_SUCCEED();
+                }
+
+            private:
+                void ThreadFunc() {
+                    for (;;) {
+                        m_attach_event.Wait();
+
+                        if (controller::AttachHandler(m_address, this)) {
+                            bluetooth::hid::SignalFakeConnectionState(m_address, true);
+                            this->ReadInputReports();
+                            bluetooth::hid::SignalFakeConnectionState(m_address, false);
+                        }
+
+                        // The handler is left attached if the controller failed to initialise
+                        if (controller::LocateHandler(m_address)) {
+                            controller::RemoveHandler(m_address);
+                        }
+
+                        {
+                            std::scoped_lock lk(m_mutex);
+                            this->CloseSession();
+                        }
+
+                        m_in_use = false;
+                    }
+                }
+
+                void ReadInputReports() {
+                    auto handler = controller::LocateHandler(m_address);
+                    if (!handler) {
+                        return;
+                    }
+
+                    // Transfers complete at the polling interval requested by the endpoint, and fail once the controller is unplugged
+                    bluetooth::HidReport report;
+                    u32 transferred_size = 0;
+                    while (R_SUCCEEDED(usbHsEpPostBuffer(&m_input_endpoint, m_input_buffer, m_input_packet_size, &transferred_size))) {
+                        if (transferred_size == 0) {
+                            continue;
+                        }
+
+                        ConvertInputReport(m_protocol, m_input_buffer, std::min<size_t>(transferred_size, MaxReportSize), &report);
+                        handler->HandleInputReport(&report);
+                    }
+                }
+
+                Result OpenEndpoints(UsbHsInterface *iface) {
+                    m_has_input_endpoint = false;
+                    m_has_output_endpoint = false;
+
+                    for (auto &desc : iface->inf.input_endpoint_descs) {
+                        if ((desc.bLength != 0) && ((desc.bmAttributes & USB_TRANSFER_TYPE_MASK) == USB_TRANSFER_TYPE_INTERRUPT)) {
+                            R_TRY(usbHsIfOpenUsbEp(&m_if_session, &m_input_endpoint, 1, desc.wMaxPacketSize, &desc));
+                            m_input_packet_size = desc.wMaxPacketSize;
+                            m_has_input_endpoint = true;
+                            break;
+                        }
+                    }
+
+                    R_UNLESS(m_has_input_endpoint, svc::ResultNotFound());
+
+                    // Output reports are sent as SET_REPORT requests if the controller has no interrupt OUT endpoint
+                    for (auto &desc : iface->inf.output_endpoint_descs) {
+                        if ((desc.bLength != 0) && ((desc.bmAttributes & USB_TRANSFER_TYPE_MASK) == USB_TRANSFER_TYPE_INTERRUPT)) {
+                            R_TRY(usbHsIfOpenUsbEp(&m_if_session, &m_output_endpoint, 1, desc.wMaxPacketSize, &desc));
+                            m_has_output_endpoint = true;
+                            break;
+                        }
+                    }
+
+                    R_SUCCEED();
+                }
+
+                Result ReadAddress() {
+                    const auto &info = WiredProtocols[m_protocol];
+
+                    u32 transferred_size = 0;
+                    R_TRY(this->ControlTransfer(HidRequestTypeIn, HidRequest_GetReport, MakeReportValue(BtdrvBluetoothHhReportType_Feature, info.address_report_id), info.address_report_size, &transferred_size));
+                    R_UNLESS(transferred_size >= info.address_offset + sizeof(bluetooth::Address), svc::ResultOutOfRange());
+
+                    bluetooth::Address address;
+                    std::memcpy(&address, &m_control_buffer[info.address_offset], sizeof(address));
+                    m_address = info.address_reversed ? utils::BluetoothAddressReverse(address) : address;
+
+                    R_SUCCEED();
+                }
+
+                Result ControlTransfer(u8 request_type, u8 request, u16 value, u16 length, u32 *out_size) {
+                    R_RETURN(usbHsIfCtrlXfer(&m_if_session, request_type, request, value, m_interface_number, length, m_control_buffer, out_size));
+                }
+
+                void CloseSession() {
+                    if (m_has_output_endpoint) {
+                        usbHsEpClose(&m_output_endpoint);
+                        m_has_output_endpoint = false;
+                    }
+
+                    if (m_has_input_endpoint) {
+                        usbHsEpClose(&m_input_endpoint);
+                        m_has_input_endpoint = false;
+                    }
+
+                    if (usbHsIfIsActive(&m_if_session)) {
+                        usbHsIfClose(&m_if_session);
+                    }
+
+                    m_open = false;
+                }
+
+            private:
+                alignas(os::MemoryPageSize) u8 m_input_buffer[os::MemoryPageSize];
+                alignas(os::MemoryPageSize) u8 m_control_buffer[os::MemoryPageSize];
+
+                os::ThreadType m_thread;
+                os::Event m_attach_event;
+                std::atomic<bool> m_in_use;
+
+                os::SdkMutex m_mutex;
+                bool m_open;
+
+                UsbHsClientIfSession m_if_session = {};
+                UsbHsClientEpSession m_input_endpoint = {};
+                UsbHsClientEpSession m_output_endpoint = {};
+                bool m_has_input_endpoint = false;
+                bool m_has_output_endpoint = false;
+                u16 m_input_packet_size = 0;
+                u8 m_interface_number = 0;
+
+                WiredProtocol m_protocol = WiredProtocol_Unsupported;
+                bluetooth::Address m_address = {};
+
+        };
+
+        WiredController g_wired_controllers[MaxWiredControllers];
+
+        // Interfaces that were looked at and turned down, so that releasing them again doesn't retrigger the available event forever
+        constexpr size_t MaxRejectedInterfaces = 8;
+        constinit s32 g_rejected_interfaces[MaxRejectedInterfaces] = {};
+        constinit size_t g_num_rejected_interfaces = 0;
+
+        bool IsRejectedInterface(s32 id) {
+            const auto end = g_rejected_interfaces + std::min(g_num_rejected_interfaces, MaxRejectedInterfaces);
+            return std::find(g_rejected_interfaces, end, id) != end;
+        }
+
+        void RejectInterface(s32 id) {
+            g_rejected_interfaces[g_num_rejected_interfaces++ % MaxRejectedInterfaces] = id;
+        }
+
+    }
+
+    const UsbHsInterfaceFilter *GetWiredControllerInterfaceFilter() {
+        return &g_interface_filter;
+    }
+
+    void InitializeWiredControllers() {
+        for (size_t i = 0; i < MaxWiredControllers; ++i) {
+            g_wired_controllers[i].Launch(g_thread_stacks[i]);
+        }
+    }
+
+    Result HandleWiredControllerAvailableEvent() {
+        s32 total_entries = 0;
+        UsbHsInterface interfaces[8] = {};
+        R_TRY(usbHsQueryAvailableInterfaces(&g_interface_filter, interfaces, sizeof(interfaces), &total_entries));
+
+        for (int i = 0; i < total_entries; ++i) {
+            auto iface = &interfaces[i];
+
+            const auto protocol = IdentifyProtocol(iface);
+            if ((protocol == WiredProtocol_Unsupported) || IsRejectedInterface(iface->inf.ID)) {
+                continue;
+            }
+
+            auto controller = std::find_if(std::begin(g_wired_controllers), std::end(g_wired_controllers), [](const WiredController &c) { return !c.IsInUse(); });
+            if (controller == std::end(g_wired_controllers)) {
+                break;
+            }
+
+            if (R_FAILED(controller->Open(iface, protocol))) {
+                RejectInterface(iface->inf.ID);
+                continue;
+            }
+
+            controller->Start();
+        }
+
+        R_SUCCEED();
+    }
+
+}
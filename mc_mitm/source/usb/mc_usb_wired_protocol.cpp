@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "mc_usb_wired_protocol.hpp"
+#include "../controllers/dualshock4_controller.hpp"
+
+namespace ams::usb {
+
+    namespace {
+
+        // Gyro calibration limits are grouped by axis in the USB report, but by sign in the Bluetooth one
+        void ConvertDualshock4Calibration(bluetooth::HidReport *report) {
+            auto calibration = &reinterpret_cast<controller::Dualshock4ReportData *>(report->data)->feature0x05.calibration;
+
+            const auto gyro = calibration->gyro;
+            calibration->gyro.pitch_max = gyro.pitch_max;
+            calibration->gyro.pitch_min = gyro.yaw_max;
+            calibration->gyro.yaw_max   = gyro.roll_max;
+            calibration->gyro.yaw_min   = gyro.pitch_min;
+            calibration->gyro.roll_max  = gyro.yaw_min;
+            calibration->gyro.roll_min  = gyro.roll_min;
+
+            report->size = std::max<u16>(report->size, sizeof(controller::Dualshock4FeatureReport0x05) + 1);
+        }
+
+    }
+
+    void ConvertInputReport(WiredProtocol protocol, const u8 *data, size_t size, bluetooth::HidReport *out_report) {
+        const auto &info = WiredProtocols[protocol];
+
+        if ((size == 0) || (data[0] != info.usb_input_id)) {
+            out_report->size = size;
+            std::memcpy(out_report->data, data, size);
+            return;
+        }
+
+        out_report->size = size + info.bt_input_header_size;
+        out_report->data[0] = info.bt_input_id;
+        std::memset(&out_report->data[1], 0, info.bt_input_header_size);
+        std::memcpy(&out_report->data[1 + info.bt_input_header_size], &data[1], size - 1);
+    }
+
+    size_t ConvertOutputReport(WiredProtocol protocol, const bluetooth::HidReport *report, u8 *out_data) {
+        const auto &info = WiredProtocols[protocol];
+
+        if ((info.usb_output_size == 0) || (report->size <= 1 + info.bt_output_header_size) || (report->data[0] != info.bt_output_id)) {
+            std::memcpy(out_data, report->data, report->size);
+            return report->size;
+        }
+
+        const size_t payload_size = std::min<size_t>(report->size - 1 - info.bt_output_header_size, info.usb_output_size - 1);
+
+        std::memset(out_data, 0, info.usb_output_size);
+        out_data[0] = info.usb_output_id;
+        std::memcpy(&out_data[1], &report->data[1 + info.bt_output_header_size], payload_size);
+
+        return info.usb_output_size;
+    }
+
+    // The Dualshock 4 serves its calibration and firmware info from different feature reports over USB
+    u8 GetUsbFeatureReportId(WiredProtocol protocol, u8 id) {
+        if (protocol == WiredProtocol_Dualshock4) {
+            switch (id) {
+                case 0x05: return 0x02;
+                case 0x06: return 0xa3;
+                default: break;
+            }
+        }
+
+        return id;
+    }
+
+    // Presents a feature report read over USB under the id and layout the driver requested over Bluetooth
+    void ConvertFeatureReport(WiredProtocol protocol, u8 id, const u8 *data, size_t size, bluetooth::HidReport *out_report) {
+        out_report->size = size;
+        std::memcpy(out_report->data, data, size);
+        out_report->data[0] = id;
+
+        if ((protocol == WiredProtocol_Dualshock4) && (id == 0x05)) {
+            ConvertDualshock4Calibration(out_report);
+        }
+    }
+
+}
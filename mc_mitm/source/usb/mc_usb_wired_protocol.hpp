@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
+
+namespace ams::usb {
+
+    enum WiredProtocol {
+        WiredProtocol_Dualshock3,
+        WiredProtocol_Dualshock4,
+        WiredProtocol_Dualsense,
+        WiredProtocol_Unsupported,
+    };
+
+    // Wired reports carry the same payload as the Bluetooth ones, just with a different report id and without the Bluetooth specific header bytes
+    struct WiredProtocolInfo {
+        u8 usb_input_id;
+        u8 bt_input_id;
+        u8 bt_input_header_size;
+        u8 usb_output_id;
+        u8 bt_output_id;
+        u8 bt_output_header_size;
+        u8 usb_output_size;         // 0 if output reports are the same as over Bluetooth
+        u8 address_report_id;
+        u8 address_report_size;
+        u8 address_offset;
+        bool address_reversed;
+    };
+
+    constexpr WiredProtocolInfo WiredProtocols[] = {
+        { 0x01, 0x01, 0, 0x01, 0x01, 0,  0, 0xf2, 17, 4, false },   // WiredProtocol_Dualshock3
+        { 0x01, 0x11, 2, 0x05, 0x11, 2, 32, 0x12, 16, 1, true  },   // WiredProtocol_Dualshock4
+        { 0x01, 0x31, 1, 0x02, 0x31, 1, 48, 0x09, 20, 1, true  },   // WiredProtocol_Dualsense
+    };
+    static_assert(util::size(WiredProtocols) == WiredProtocol_Unsupported);
+
+    // Bluetooth HH report types share their values with the USB HID ones
+    constexpr u16 MakeReportValue(BtdrvBluetoothHhReportType type, u8 id) {
+        return (static_cast<u16>(type) << 8) | id;
+    }
+
+    void ConvertInputReport(WiredProtocol protocol, const u8 *data, size_t size, bluetooth::HidReport *out_report);
+    size_t ConvertOutputReport(WiredProtocol protocol, const bluetooth::HidReport *report, u8 *out_data);
+
+    u8 GetUsbFeatureReportId(WiredProtocol protocol, u8 id);
+    void ConvertFeatureReport(WiredProtocol protocol, u8 id, const u8 *data, size_t size, bluetooth::HidReport *out_report);
+
+}
@@ -15,3 +15,7 @@
  */
 #include "utils/utils_bluetooth_address.hpp"
 #include "utils/utils_crc8.hpp"
+#include "utils/utils_crc32.hpp"
+#include "utils/utils_latency_histogram.hpp"
+#include "utils/utils_prefix_trie.hpp"
+#include "utils/utils_slab_heap.hpp"
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace ams::utils {
+
+    // CRC-32 (ISO-HDLC, as used by zlib and libnx's crc32Calculate). Seeding with the result of a previous calculation continues it over further data,
+    // so a fixed prefix can be folded into a seed at compile time
+    class Crc32 {
+        private:
+            static constexpr u32 Polynomial = 0xedb88320;  // Bit reversed 0x04c11db7
+            static constexpr size_t SliceCount = 8;
+
+        public:
+            static u32 Calculate(const void *data, size_t size, u32 seed = 0) {
+            #if defined(__ARM_FEATURE_CRC32)
+                return CalculateHardware(data, size, seed);
+            #else
+                return CalculateSliced(data, size, seed);
+            #endif
+            }
+
+        #if defined(__ARM_FEATURE_CRC32)
+            static u32 CalculateHardware(const void *data, size_t size, u32 seed = 0) {
+                return ~UpdateHardware(~seed, reinterpret_cast<const u8 *>(data), size);
+            }
+        #endif
+
+            // Always available so both paths can be checked against each other
+            static u32 CalculateSliced(const void *data, size_t size, u32 seed = 0) {
+                return ~UpdateSliced(~seed, reinterpret_cast<const u8 *>(data), size);
+            }
+
+            static consteval u32 ComputeSeed(std::initializer_list<u8> bytes, u32 seed = 0) {
+                u32 crc = ~seed;
+                for (u8 b : bytes) {
+                    crc = (crc >> 8) ^ CrcLookup[0][(crc ^ b) & 0xff];
+                }
+                return ~crc;
+            }
+
+        private:
+        #if defined(__ARM_FEATURE_CRC32)
+            static u32 UpdateHardware(u32 crc, const u8 *bytes, size_t size) {
+                while ((size > 0) && (reinterpret_cast<uintptr_t>(bytes) % sizeof(u64) != 0)) {
+                    crc = __crc32b(crc, *bytes++);
+                    --size;
+                }
+
+                for (; size >= sizeof(u64); size -= sizeof(u64), bytes += sizeof(u64)) {
+                    u64 value;
+                    std::memcpy(&value, bytes, sizeof(value));
+                    crc = __crc32d(crc, value);
+                }
+
+                while (size-- > 0) {
+                    crc = __crc32b(crc, *bytes++);
+                }
+
+                return crc;
+            }
+        #endif
+
+            // Slicing-by-8 processes eight bytes per step using one table lookup per byte, with no dependency between the lookups
+            static u32 UpdateSliced(u32 crc, const u8 *bytes, size_t size) {
+                for (; size >= SliceCount; size -= SliceCount, bytes += SliceCount) {
+                    u32 lo, hi;
+                    std::memcpy(&lo, bytes, sizeof(lo));
+                    std::memcpy(&hi, bytes + sizeof(lo), sizeof(hi));
+                    lo ^= crc;
+                    crc = CrcLookup[7][lo & 0xff]         ^ CrcLookup[6][(lo >> 8) & 0xff]  ^
+                          CrcLookup[5][(lo >> 16) & 0xff] ^ CrcLookup[4][lo >> 24]          ^
+                          CrcLookup[3][hi & 0xff]         ^ CrcLookup[2][(hi >> 8) & 0xff]  ^
+                          CrcLookup[1][(hi >> 16) & 0xff] ^ CrcLookup[0][hi >> 24];
+                }
+
+                while (size-- > 0) {
+                    crc = (crc >> 8) ^ CrcLookup[0][(crc ^ *bytes++) & 0xff];
+                }
+
+                return crc;
+            }
+
+            static constexpr std::array<std::array<u32, 0x100>, SliceCount> CrcLookup = []() {
+                std::array<std::array<u32, 0x100>, SliceCount> tables {};
+
+                for (size_t i = 0; i < tables[0].size(); ++i) {
+                    u32 crc = i;
+                    for (int b = 8; b > 0; --b) {
+                        crc = (crc & 1) ? (crc >> 1) ^ Polynomial : crc >> 1;
+                    }
+
+                    tables[0][i] = crc;
+                }
+
+                // Each further table advances the previous one by another zero byte
+                for (size_t n = 1; n < SliceCount; ++n) {
+                    for (size_t i = 0; i < tables[n].size(); ++i) {
+                        const u32 prev = tables[n - 1][i];
+                        tables[n][i] = (prev >> 8) ^ tables[0][prev & 0xff];
+                    }
+                }
+
+                return tables;
+            }();
+    };
+
+    static_assert(Crc32::ComputeSeed({ '1', '2', '3', '4', '5', '6', '7', '8', '9' }) == 0xcbf43926);
+
+}
@@ -30,11 +30,19 @@ namespace ams::utils {
                 return crc;
             }
 
+            static constexpr u8 Calculate(std::span<const u8> data, u8 seed = 0x00) {
+                u8 crc = seed;
+                for (u8 b : data) {
+                    crc = CrcLookup[crc ^ b];
+                }
+                return crc;
+            }
+
         private:
-            static constexpr std::array<u8, UINT8_MAX> CrcLookup = []() {
-                std::array<u8, UINT8_MAX> table {};
+            static constexpr std::array<u8, 0x100> CrcLookup = []() {
+                std::array<u8, 0x100> table {};
 
-                for (size_t i = 0; i < UINT8_MAX; ++i) {
+                for (size_t i = 0; i < table.size(); ++i) {
                     u8 crc = i;
                     for (int b = 8; b > 0; --b) {
                         if (crc & BIT(7)) {
@@ -43,7 +51,7 @@ namespace ams::utils {
                             crc <<= 1;
                         }
                     }
-                    
+
                     table[i] = crc;
                 }
                 return table;
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include <bit>
+
+namespace ams::utils {
+
+    constexpr size_t LatencyHistogramBucketCount = 16;
+
+    struct LatencyHistogramData {
+        u32 buckets[LatencyHistogramBucketCount];
+        u32 count;
+        u32 max_us;
+        u64 total_us;
+    };
+
+    // Histogram of durations with power of two microsecond buckets. Bucket n holds samples in the range [2^n, 2^(n+1))us,
+    // except for the first and last buckets which also take everything below 2us and above 32ms respectively
+    class LatencyHistogram {
+        public:
+            constexpr LatencyHistogram() = default;
+
+            void Record(TimeSpan time) {
+                const u64 us = std::max<s64>(time.GetMicroSeconds(), 0);
+                const size_t bucket = std::min<size_t>(us > 1 ? std::bit_width(us) - 1 : 0, LatencyHistogramBucketCount - 1);
+
+                std::scoped_lock lk(m_mutex);
+                m_data.buckets[bucket] += 1;
+                m_data.count += 1;
+                m_data.max_us = std::max<u64>(m_data.max_us, std::min<u64>(us, UINT32_MAX));
+                m_data.total_us += us;
+            }
+
+            void GetData(LatencyHistogramData *out_data) {
+                std::scoped_lock lk(m_mutex);
+                *out_data = m_data;
+            }
+
+        private:
+            os::SdkMutex m_mutex;
+            LatencyHistogramData m_data = {};
+    };
+
+}
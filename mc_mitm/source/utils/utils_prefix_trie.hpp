@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include <string_view>
+
+namespace ams::utils {
+
+    // Prefix trie built at compile time from a fixed set of strings. Lookup cost is bounded by the length of the longest string
+    template <size_t MaxNodes>
+    class PrefixTrie {
+        private:
+            struct Node {
+                char label;
+                bool terminal;
+                u16 first_child;
+                u16 next_sibling;
+            };
+
+        public:
+            template <size_t N>
+            consteval PrefixTrie(const std::string_view (&strings)[N]) : m_nodes(), m_num_nodes(1) {
+                for (auto &s : strings) {
+                    this->Insert(s);
+                }
+            }
+
+            // Returns true if any string in the trie is a prefix of str
+            constexpr bool HasPrefixOf(std::string_view str) const {
+                u16 node = 0;
+                for (char c : str) {
+                    node = this->FindChild(node, c);
+                    if (node == 0) {
+                        return false;
+                    }
+
+                    if (m_nodes[node].terminal) {
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            constexpr size_t GetNodeCount() const { return m_num_nodes; }
+
+        private:
+            constexpr u16 FindChild(u16 node, char c) const {
+                u16 child = m_nodes[node].first_child;
+                while ((child != 0) && (m_nodes[child].label != c)) {
+                    child = m_nodes[child].next_sibling;
+                }
+
+                return child;
+            }
+
+            consteval void Insert(std::string_view str) {
+                u16 node = 0;
+                for (char c : str) {
+                    u16 child = this->FindChild(node, c);
+                    if (child == 0) {
+                        if (m_num_nodes >= MaxNodes) {
+                            // Not a constant expression, so fails the build if the trie is too small
+                            AMS_ABORT("Prefix trie node capacity exceeded");
+                        }
+
+                        child = m_num_nodes++;
+                        m_nodes[child] = { c, false, 0, m_nodes[node].first_child };
+                        m_nodes[node].first_child = child;
+                    }
+
+                    node = child;
+                }
+
+                m_nodes[node].terminal = true;
+            }
+
+        private:
+            std::array<Node, MaxNodes> m_nodes;
+            u16 m_num_nodes;
+    };
+
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::utils {
+
+    // Fixed number of equally sized slots in static storage. Allocations never touch the global heap, so they can't be starved by fragmentation
+    template <size_t Size, size_t Count, size_t Alignment = alignof(std::max_align_t)>
+    class SlabHeap {
+        public:
+            static constexpr size_t SlotSize = Size;
+            static constexpr size_t SlotAlignment = Alignment;
+            static constexpr size_t SlotCount = Count;
+
+        private:
+            union Slot {
+                Slot *next;
+                alignas(Alignment) u8 storage[Size];
+            };
+
+        public:
+            constexpr SlabHeap() = default;
+
+            void *Allocate() {
+                std::scoped_lock lk(m_mutex);
+
+                Slot *slot = nullptr;
+                if (m_free_list != nullptr) {
+                    slot = m_free_list;
+                    m_free_list = slot->next;
+                } else if (m_num_initialized < Count) {
+                    slot = &m_slots[m_num_initialized++];
+                } else {
+                    return nullptr;
+                }
+
+                m_num_used += 1;
+                m_peak_used = std::max(m_peak_used, m_num_used);
+
+                return slot->storage;
+            }
+
+            void Free(void *ptr) {
+                if (ptr == nullptr) {
+                    return;
+                }
+
+                std::scoped_lock lk(m_mutex);
+
+                auto slot = reinterpret_cast<Slot *>(ptr);
+                AMS_ABORT_UNLESS((slot >= &m_slots[0]) && (slot < &m_slots[Count]));
+
+                slot->next = m_free_list;
+                m_free_list = slot;
+                m_num_used -= 1;
+            }
+
+            size_t GetUsedCount() const { return m_num_used; }
+            size_t GetPeakUsedCount() const { return m_peak_used; }
+
+        private:
+            Slot m_slots[Count] = {};
+            Slot *m_free_list = nullptr;
+            size_t m_num_initialized = 0;
+            size_t m_num_used = 0;
+            size_t m_peak_used = 0;
+            os::SdkMutex m_mutex;
+    };
+
+    template <typename T, size_t Count>
+    class ObjectPool {
+        public:
+            constexpr ObjectPool() = default;
+
+            template <typename... Args>
+            T *Allocate(Args&&... args) {
+                void *storage = m_heap.Allocate();
+                if (storage == nullptr) {
+                    return nullptr;
+                }
+
+                return std::construct_at(static_cast<T *>(storage), std::forward<Args>(args)...);
+            }
+
+            void Free(T *obj) {
+                if (obj != nullptr) {
+                    std::destroy_at(obj);
+                    m_heap.Free(obj);
+                }
+            }
+
+            size_t GetUsedCount() const { return m_heap.GetUsedCount(); }
+            size_t GetPeakUsedCount() const { return m_heap.GetPeakUsedCount(); }
+
+        private:
+            SlabHeap<sizeof(T), Count, alignof(T)> m_heap;
+    };
+
+    // Allocator for std::allocate_shared that hands out a single slot reserved from a SlabHeap beforehand.
+    // Reserving up front lets the caller handle an exhausted heap gracefully instead of aborting inside allocate_shared
+    template <typename T, typename Heap>
+    class SlabAllocator {
+        public:
+            using value_type = T;
+
+            constexpr SlabAllocator(Heap *heap, void *storage) : m_heap(heap), m_storage(storage) { }
+
+            template <typename U>
+            constexpr SlabAllocator(const SlabAllocator<U, Heap> &other) : m_heap(other.m_heap), m_storage(other.m_storage) { }
+
+            T *allocate(size_t n) {
+                static_assert(sizeof(T) <= Heap::SlotSize, "Object too large for slab heap slot");
+                static_assert(alignof(T) <= Heap::SlotAlignment, "Object alignment exceeds slab heap slot alignment");
+
+                AMS_ABORT_UNLESS((n == 1) && (m_storage != nullptr));
+                return static_cast<T *>(std::exchange(m_storage, nullptr));
+            }
+
+            void deallocate(T *ptr, size_t n) {
+                AMS_UNUSED(n);
+                m_heap->Free(ptr);
+            }
+
+            template <typename U>
+            bool operator==(const SlabAllocator<U, Heap> &other) const {
+                return m_heap == other.m_heap;
+            }
+
+        private:
+            template <typename U, typename H>
+            friend class SlabAllocator;
+
+            Heap *m_heap;
+            void *m_storage;
+    };
+
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "utils/utils_crc32.hpp"
+
+namespace {
+
+    using ams::utils::Crc32;
+
+    // Bytewise table lookup, equivalent to libnx's crc32Calculate
+    u32 BytewiseCrc32(const void *data, size_t size) {
+        static const auto table = []() {
+            std::array<u32, 0x100> t {};
+            for (u32 i = 0; i < t.size(); ++i) {
+                u32 crc = i;
+                for (int b = 0; b < 8; ++b) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+                }
+                t[i] = crc;
+            }
+            return t;
+        }();
+
+        auto *bytes = reinterpret_cast<const u8 *>(data);
+        u32 crc = ~0u;
+        while (size-- > 0) {
+            crc = (crc >> 8) ^ table[(crc ^ *bytes++) & 0xff];
+        }
+        return ~crc;
+    }
+
+    template<typename F>
+    void Run(const char *name, F func, const std::vector<u8> &buffer, size_t size, size_t iterations) {
+        volatile u32 sink = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            sink = sink ^ func(buffer.data() + (i & 7), size);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const double mib = static_cast<double>(size) * iterations / (1024.0 * 1024.0);
+        std::printf("  %-10s %5zu bytes: %8.1f MiB/s\n", name, size, mib / elapsed.count());
+    }
+
+}
+
+int main() {
+    std::vector<u8> buffer(0x10000 + 8);
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] = static_cast<u8>(i * 31 + 7);
+    }
+
+    // Sizes of an input report, a device cache entry and a bulk buffer
+    constexpr size_t Sizes[] = { 78, 0x400, 0x10000 };
+
+    std::printf("crc32 throughput:\n");
+    for (size_t size : Sizes) {
+        const size_t iterations = (size_t(256) << 20) / size;
+        Run("bytewise", BytewiseCrc32, buffer, size, iterations);
+        Run("sliced", [](const void *d, size_t s) { return Crc32::CalculateSliced(d, s); }, buffer, size, iterations);
+    #if defined(__ARM_FEATURE_CRC32)
+        Run("hardware", [](const void *d, size_t s) { return Crc32::CalculateHardware(d, s); }, buffer, size, iterations);
+    #endif
+    }
+
+    return 0;
+}
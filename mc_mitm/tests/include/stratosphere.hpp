@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+// Minimal host stand-in for libstratosphere, covering only what the sources under test use
+#include <switch.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <list>
+#include <mutex>
+#include <span>
+#include <string>
+#include <utility>
+
+#define AMS_ABORT(...) ::std::abort()
+#define AMS_ABORT_UNLESS(expr) do { if (!(expr)) { ::std::abort(); } } while (0)
+#define AMS_ASSERT(expr) AMS_ABORT_UNLESS(expr)
+#define AMS_UNUSED(...) static_cast<void>(sizeof(__VA_ARGS__))
+
+#define R_SUCCEED() return ::ams::ResultSuccess()
+#define R_RETURN(expr) return (expr)
+#define R_TRY(expr) do { const ::ams::Result _tmp_r = (expr); if (R_FAILED(_tmp_r)) { return _tmp_r; } } while (0)
+#define R_UNLESS(expr, res) do { if (!(expr)) { return (res); } } while (0)
+#define R_SUCCEEDED(res) (::ams::Result(res).IsSuccess())
+#define R_FAILED(res) (::ams::Result(res).IsFailure())
+
+namespace ams {
+
+    class Result {
+        public:
+            constexpr Result() : m_value(0) { }
+            constexpr Result(u32 value) : m_value(value) { }
+
+            constexpr bool IsSuccess() const { return m_value == 0; }
+            constexpr bool IsFailure() const { return m_value != 0; }
+            constexpr u32 GetValue() const { return m_value; }
+
+            constexpr operator u32() const { return m_value; }
+
+        private:
+            u32 m_value;
+    };
+
+    constexpr Result ResultSuccess() { return Result(0); }
+
+    // Distinct, non-zero results for the error codes the sources return
+    #define AMS_HOST_DEFINE_RESULT(ns, name, value) namespace ns { constexpr ::ams::Result Result##name() { return ::ams::Result(value); } }
+    AMS_HOST_DEFINE_RESULT(svc, InvalidArgument,   0x1001)
+    AMS_HOST_DEFINE_RESULT(svc, OutOfRange,        0x1002)
+    AMS_HOST_DEFINE_RESULT(svc, NotFound,          0x1003)
+    AMS_HOST_DEFINE_RESULT(svc, InvalidState,      0x1004)
+    AMS_HOST_DEFINE_RESULT(svc, NotImplemented,    0x1005)
+    AMS_HOST_DEFINE_RESULT(svc, Timeout,           0x1006)
+    AMS_HOST_DEFINE_RESULT(svc, OutOfResource,     0x1007)
+    AMS_HOST_DEFINE_RESULT(svc, InvalidSize,       0x1008)
+    AMS_HOST_DEFINE_RESULT(fs,  DataCorrupted,     0x2001)
+    #undef AMS_HOST_DEFINE_RESULT
+
+    class TimeSpan {
+        public:
+            constexpr TimeSpan() : m_ns(0) { }
+            constexpr TimeSpan(s64 ns) : m_ns(ns) { }
+
+            static constexpr TimeSpan FromNanoSeconds(s64 v)  { return TimeSpan(v); }
+            static constexpr TimeSpan FromMicroSeconds(s64 v) { return TimeSpan(v * 1'000); }
+            static constexpr TimeSpan FromMilliSeconds(s64 v) { return TimeSpan(v * 1'000'000); }
+            static constexpr TimeSpan FromSeconds(s64 v)      { return TimeSpan(v * 1'000'000'000); }
+
+            constexpr s64 GetNanoSeconds() const  { return m_ns; }
+            constexpr s64 GetMicroSeconds() const { return m_ns / 1'000; }
+            constexpr s64 GetMilliSeconds() const { return m_ns / 1'000'000; }
+            constexpr s64 GetSeconds() const      { return m_ns / 1'000'000'000; }
+
+            constexpr auto operator<=>(const TimeSpan &) const = default;
+            constexpr TimeSpan operator+(const TimeSpan &rhs) const { return TimeSpan(m_ns + rhs.m_ns); }
+            constexpr TimeSpan operator-(const TimeSpan &rhs) const { return TimeSpan(m_ns - rhs.m_ns); }
+
+        private:
+            s64 m_ns;
+    };
+
+    namespace util {
+
+        template <typename T>
+        class IntrusiveListBaseNode { };
+
+        template <typename T>
+        struct IntrusiveListBaseTraits {
+            using ListType = std::list<T *>;
+        };
+
+        template <char A, char B, char C, char D>
+        struct FourCC {
+            static constexpr u32 Code = (static_cast<u32>(A) << 0) | (static_cast<u32>(B) << 8) | (static_cast<u32>(C) << 16) | (static_cast<u32>(D) << 24);
+        };
+
+        template <typename T>
+        constexpr T AlignUp(T value, size_t alignment) {
+            return (value + alignment - 1) & ~static_cast<T>(alignment - 1);
+        }
+
+        template <typename T, size_t N>
+        constexpr size_t size(const T (&)[N]) {
+            return N;
+        }
+
+        constexpr u64 SwapEndian(u64 value) {
+            return __builtin_bswap64(value);
+        }
+
+    }
+
+    namespace os {
+
+        class SdkMutex {
+            public:
+                constexpr SdkMutex() = default;
+                void lock() { m_mutex.lock(); }
+                void unlock() { m_mutex.unlock(); }
+                bool try_lock() { return m_mutex.try_lock(); }
+                void Lock() { this->lock(); }
+                void Unlock() { this->unlock(); }
+
+            private:
+                std::mutex m_mutex;
+        };
+
+        using SdkRecursiveMutex = SdkMutex;
+
+        class Tick {
+            public:
+                constexpr Tick() : m_ns(0) { }
+                constexpr explicit Tick(s64 ns) : m_ns(ns) { }
+
+                constexpr s64 GetInt64Value() const { return m_ns; }
+                constexpr auto operator<=>(const Tick &) const = default;
+                constexpr TimeSpan operator-(const Tick &rhs) const { return TimeSpan(m_ns - rhs.m_ns); }
+                constexpr Tick operator+(const TimeSpan &rhs) const { return Tick(m_ns + rhs.GetNanoSeconds()); }
+
+            private:
+                s64 m_ns;
+        };
+
+        // Deterministic, so that generated keys can appear in recorded transfers
+        inline void GenerateRandomBytes(void *dst, size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                static_cast<u8 *>(dst)[i] = static_cast<u8>(i);
+            }
+        }
+
+        // Host time is controlled by the test, so behaviour that depends on it is reproducible
+        inline s64 g_host_tick = 0;
+
+        inline Tick GetSystemTick() { return Tick(g_host_tick); }
+        inline TimeSpan ConvertToTimeSpan(TimeSpan span) { return span; }
+        inline Tick ConvertToTick(TimeSpan span) { return Tick(span.GetNanoSeconds()); }
+
+        enum EventClearMode {
+            EventClearMode_ManualClear,
+            EventClearMode_AutoClear,
+        };
+
+        struct EventType {
+            bool signaled;
+            EventClearMode clear_mode;
+        };
+
+        inline void InitializeEvent(EventType *event, bool signaled, EventClearMode clear_mode) { *event = { signaled, clear_mode }; }
+        inline void FinalizeEvent(EventType *) { }
+        inline void SignalEvent(EventType *event) { event->signaled = true; }
+        inline void ClearEvent(EventType *event) { event->signaled = false; }
+        inline bool TryWaitEvent(EventType *event) {
+            const bool signaled = event->signaled;
+            if (event->clear_mode == EventClearMode_AutoClear) {
+                event->signaled = false;
+            }
+            return signaled;
+        }
+        inline void WaitEvent(EventType *event) { TryWaitEvent(event); }
+        inline bool TimedWaitEvent(EventType *event, TimeSpan) { return TryWaitEvent(event); }
+
+        class Event {
+            public:
+                explicit Event(EventClearMode clear_mode) { InitializeEvent(&m_event, false, clear_mode); }
+                void Signal() { SignalEvent(&m_event); }
+                void Clear() { ClearEvent(&m_event); }
+                void Wait() { WaitEvent(&m_event); }
+                bool TryWait() { return TryWaitEvent(&m_event); }
+                bool TimedWait(TimeSpan timeout) { return TimedWaitEvent(&m_event, timeout); }
+
+            private:
+                EventType m_event;
+        };
+
+        inline void SleepThread(TimeSpan) { }
+
+        class SharedMemory;
+        class SystemEvent;
+        using NativeHandle = Handle;
+
+    }
+
+    namespace fs {
+
+        struct FileHandle {
+            void *handle;
+        };
+
+    }
+
+    namespace ncm {
+
+        struct ProgramId {
+            u64 value;
+            constexpr bool operator==(const ProgramId &) const = default;
+        };
+
+    }
+
+}
+
+#define ON_SCOPE_EXIT_CAT_(a, b) a##b
+#define ON_SCOPE_EXIT_CAT(a, b) ON_SCOPE_EXIT_CAT_(a, b)
+namespace ams::impl {
+    template <typename F>
+    struct ScopeGuard {
+        F f;
+        ~ScopeGuard() { f(); }
+    };
+    struct ScopeGuardHelper {
+        template <typename F>
+        ScopeGuard<F> operator+(F &&f) { return ScopeGuard<F>{std::forward<F>(f)}; }
+    };
+}
+#define ON_SCOPE_EXIT auto ON_SCOPE_EXIT_CAT(scope_exit_guard_, __LINE__) = ::ams::impl::ScopeGuardHelper() + [&]()
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+// Minimal host stand-in for libnx. Types mirror the libnx definitions closely enough for the sources under test to compile
+#include <cstddef>
+#include <cstdint>
+
+typedef std::uint8_t  u8;
+typedef std::uint16_t u16;
+typedef std::uint32_t u32;
+typedef std::uint64_t u64;
+typedef std::int8_t   s8;
+typedef std::int16_t  s16;
+typedef std::int32_t  s32;
+typedef std::int64_t  s64;
+
+typedef u32 Result;
+typedef u32 Handle;
+
+#ifndef BIT
+#define BIT(n) (1U << (n))
+#endif
+
+#define NX_PACKED __attribute__((packed))
+#define PACKED __attribute__((packed))
+#define NX_CONSTEXPR static constexpr inline
+
+typedef struct {
+    u8 address[0x6];
+} BtdrvAddress;
+
+typedef struct {
+    u8 class_of_device[0x3];
+} BtdrvClassOfDevice;
+
+typedef struct {
+    u8 code[0x10];
+} BtdrvBluetoothPinCode;
+
+typedef struct {
+    u8 type;
+    u8 size;
+    u8 data[0x100];
+} BtdrvAdapterProperty;
+
+typedef struct {
+    u16 size;
+    u8 data[0x28c];
+} BtdrvHidReport;
+
+typedef enum {
+    BtdrvBluetoothHhReportType_Other   = 0,
+    BtdrvBluetoothHhReportType_Input   = 1,
+    BtdrvBluetoothHhReportType_Output  = 2,
+    BtdrvBluetoothHhReportType_Feature = 3,
+} BtdrvBluetoothHhReportType;
+
+typedef struct {
+    u8 data[0x200];
+} SetSysBluetoothDevicesSettings;
+
+typedef u32 BtdrvEventType;
+typedef u32 BtdrvHidEventType;
+typedef u32 BtdrvBleEventType;
+
+typedef struct {
+    u8 data[0x400];
+} BtdrvEventInfo;
+
+typedef struct {
+    u8 data[0x480];
+} BtdrvHidEventInfo;
+
+typedef struct {
+    u8 data[0x400];
+} BtdrvBleEventInfo;
+
+typedef struct {
+    union {
+        u8 data[0x480];
+
+        struct {
+            u32 res;
+            u8 unk_x4;
+            BtdrvAddress addr;
+            u8 pad;
+            u16 report_size;
+            BtdrvHidReport report;
+        } data_report;
+
+        struct {
+            BtdrvAddress addr;
+            u8 pad[2];
+            u32 res;
+            BtdrvHidReport report;
+        } get_report;
+    };
+} BtdrvHidReportEventInfo;
+
+// Only the USB host fields read by the code under test
+struct usb_device_descriptor {
+    u16 idVendor;
+    u16 idProduct;
+};
+
+typedef struct {
+    struct usb_device_descriptor device_desc;
+} UsbHsInterface;
+
+typedef struct UsbHsInterfaceFilter UsbHsInterfaceFilter;
+
+typedef enum {
+    SetLanguage_ENUS = 1,
+} SetLanguage;
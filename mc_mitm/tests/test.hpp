@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ams::test {
+
+    inline int g_failures = 0;
+
+    // Fixtures hold one report per line as hex bytes. Lines starting with '#' are comments
+    inline std::vector<std::vector<u8>> LoadReportFixture(const char *name) {
+        const std::string path = std::string("fixtures/") + name + ".txt";
+        std::ifstream file(path);
+        if (!file) {
+            std::fprintf(stderr, "failed to open fixture %s\n", path.c_str());
+            std::exit(EXIT_FAILURE);
+        }
+
+        std::vector<std::vector<u8>> reports;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+
+            std::vector<u8> report;
+            std::istringstream stream(line);
+            unsigned int value;
+            while (stream >> std::hex >> value) {
+                report.push_back(static_cast<u8>(value));
+            }
+            reports.push_back(std::move(report));
+        }
+
+        return reports;
+    }
+
+}
+
+#define TEST_EXPECT(cond) \
+    do { \
+        if (!(cond)) { \
+            std::fprintf(stderr, "%s:%d: expectation failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++::ams::test::g_failures; \
+        } \
+    } while (0)
+
+#define TEST_EXPECT_EQ(a, b) \
+    do { \
+        const auto _a = (a); \
+        const auto _b = (b); \
+        if (!(_a == _b)) { \
+            std::fprintf(stderr, "%s:%d: expected %s == %s (0x%llx != 0x%llx)\n", __FILE__, __LINE__, #a, #b, \
+                static_cast<unsigned long long>(_a), static_cast<unsigned long long>(_b)); \
+            ++::ams::test::g_failures; \
+        } \
+    } while (0)
+
+#define TEST_RESULT() \
+    ([]() { \
+        if (::ams::test::g_failures != 0) { \
+            std::fprintf(stderr, "%s: %d failure(s)\n", __FILE__, ::ams::test::g_failures); \
+            return EXIT_FAILURE; \
+        } \
+        std::printf("%s: passed\n", __FILE__); \
+        return EXIT_SUCCESS; \
+    })()
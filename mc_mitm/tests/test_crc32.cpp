@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test.hpp"
+#include "utils/utils_crc32.hpp"
+
+namespace ams::test {
+
+    namespace {
+
+        using utils::Crc32;
+
+        // Bit at a time reference implementation
+        u32 ReferenceCrc32(const u8 *data, size_t size, u32 seed = 0) {
+            u32 crc = ~seed;
+            for (size_t i = 0; i < size; ++i) {
+                crc ^= data[i];
+                for (int b = 0; b < 8; ++b) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+                }
+            }
+            return ~crc;
+        }
+
+        struct Vector {
+            const char *data;
+            u32 crc;
+        };
+
+        constexpr Vector KnownVectors[] = {
+            { "",                                            0x00000000 },
+            { "a",                                           0xe8b7be43 },
+            { "abc",                                         0x352441c2 },
+            { "123456789",                                   0xcbf43926 },
+            { "message digest",                              0x20159d7f },
+            { "The quick brown fox jumps over the lazy dog", 0x414fa339 },
+        };
+
+        void TestKnownVectors() {
+            for (const auto &v : KnownVectors) {
+                const size_t size = std::strlen(v.data);
+                TEST_EXPECT_EQ(ReferenceCrc32(reinterpret_cast<const u8 *>(v.data), size), v.crc);
+                TEST_EXPECT_EQ(Crc32::Calculate(v.data, size), v.crc);
+                TEST_EXPECT_EQ(Crc32::CalculateSliced(v.data, size), v.crc);
+            #if defined(__ARM_FEATURE_CRC32)
+                TEST_EXPECT_EQ(Crc32::CalculateHardware(v.data, size), v.crc);
+            #endif
+            }
+        }
+
+        // Every length around the 8 byte step at every alignment, so the head, body and tail loops are all covered
+        void TestUnalignedAndOddLengths() {
+            alignas(8) u8 buffer[0x200 + 8];
+            u32 state = 0x12345678;
+            for (auto &b : buffer) {
+                state = state * 1103515245 + 12345;
+                b = state >> 16;
+            }
+
+            for (size_t offset = 0; offset < 8; ++offset) {
+                for (size_t size = 0; size <= 0x200; ++size) {
+                    const u8 *data = buffer + offset;
+                    const u32 expected = ReferenceCrc32(data, size);
+                    TEST_EXPECT_EQ(Crc32::Calculate(data, size), expected);
+                    TEST_EXPECT_EQ(Crc32::CalculateSliced(data, size), expected);
+                #if defined(__ARM_FEATURE_CRC32)
+                    TEST_EXPECT_EQ(Crc32::CalculateHardware(data, size), expected);
+                #endif
+                }
+            }
+        }
+
+        void TestSeedContinuation() {
+            const u8 data[] = { 0xa1, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c };
+            const u32 whole = ReferenceCrc32(data, sizeof(data));
+
+            for (size_t split = 0; split <= sizeof(data); ++split) {
+                const u32 head = Crc32::Calculate(data, split);
+                TEST_EXPECT_EQ(Crc32::Calculate(data + split, sizeof(data) - split, head), whole);
+                TEST_EXPECT_EQ(Crc32::CalculateSliced(data + split, sizeof(data) - split, head), whole);
+            }
+
+            // A compile time prefix seed matches hashing the prefix at runtime
+            constexpr u32 seed = Crc32::ComputeSeed({ 0xa1 });
+            TEST_EXPECT_EQ(seed, ReferenceCrc32(data, 1));
+            TEST_EXPECT_EQ(Crc32::Calculate(data + 1, sizeof(data) - 1, seed), whole);
+        }
+
+    }
+
+}
+
+int main() {
+    ams::test::TestKnownVectors();
+    ams::test::TestUnalignedAndOddLengths();
+    ams::test::TestSeedContinuation();
+#if defined(__ARM_FEATURE_CRC32)
+    std::printf("crc32: hardware path tested\n");
+#else
+    std::printf("crc32: hardware path not available on this target, slicing-by-8 path tested\n");
+#endif
+    return TEST_RESULT();
+}
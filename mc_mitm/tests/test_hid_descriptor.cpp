@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test.hpp"
+#include "controllers/controller_hid_descriptor.cpp"
+
+namespace ams::test {
+
+    namespace {
+
+        using namespace ams::controller;
+
+        // Report 1: 16 buttons, a 4-bit hat, X/Y/Z/Rz sticks and brake/accelerator triggers
+        constexpr u8 GamepadDescriptor[] = {
+            0x05, 0x01, 0x09, 0x05, 0xa1, 0x01,
+            0x85, 0x01,
+            0x05, 0x09, 0x19, 0x01, 0x29, 0x10, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x10, 0x81, 0x02,
+            0x05, 0x01, 0x09, 0x39, 0x15, 0x00, 0x25, 0x07, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42,
+            0x75, 0x04, 0x95, 0x01, 0x81, 0x03,
+            0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x15, 0x00, 0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x04, 0x81, 0x02,
+            0x05, 0x02, 0x09, 0xc5, 0x09, 0xc4, 0x95, 0x02, 0x81, 0x02,
+            0xc0,
+        };
+
+        // Two buttons, then constant padding that pushes the X axis past the end of any HidReport
+        constexpr u8 OversizedDescriptor[] = {
+            0x05, 0x01, 0x09, 0x05, 0xa1, 0x01,
+            0x05, 0x09, 0x19, 0x01, 0x29, 0x02, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x02, 0x81, 0x02,
+            0x75, 0x06, 0x95, 0x01, 0x81, 0x03,
+            0x75, 0x08, 0x96, 0xff, 0x02, 0x81, 0x03,
+            0x05, 0x01, 0x09, 0x30, 0x15, 0x00, 0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x01, 0x81, 0x02,
+            0xc0,
+        };
+
+        // Only an X axis, placed past the end of any HidReport
+        constexpr u8 OutOfRangeDescriptor[] = {
+            0x05, 0x01, 0x09, 0x05, 0xa1, 0x01,
+            0x75, 0x08, 0x96, 0xff, 0x02, 0x81, 0x03,
+            0x09, 0x30, 0x15, 0x00, 0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x01, 0x81, 0x02,
+            0xc0,
+        };
+
+        void TestGamepadDescriptor() {
+            HidMappingPlan plan;
+            TEST_EXPECT(CompileHidMappingPlan(GamepadDescriptor, sizeof(GamepadDescriptor), &plan));
+
+            TEST_EXPECT_EQ(plan.has_report_id, 1);
+            TEST_EXPECT_EQ(plan.report_id, 1);
+            TEST_EXPECT_EQ(plan.report_size, 9);
+            TEST_EXPECT_EQ(plan.num_buttons, 16);
+            for (size_t i = 0; i < HidMappingPlan::MaxButtons; ++i) {
+                TEST_EXPECT_EQ(plan.button_bit_offsets[i], i);
+            }
+
+            TEST_EXPECT_EQ(plan.hat.bit_offset, 16);
+            TEST_EXPECT_EQ(plan.hat.bit_size, 4);
+            TEST_EXPECT_EQ(plan.hat.logical_max, 7);
+
+            TEST_EXPECT_EQ(plan.axes[HidPlanAxis_LeftStickX].bit_offset, 24);
+            TEST_EXPECT_EQ(plan.axes[HidPlanAxis_LeftStickY].bit_offset, 32);
+            TEST_EXPECT_EQ(plan.axes[HidPlanAxis_RightStickX].bit_offset, 40);
+            TEST_EXPECT_EQ(plan.axes[HidPlanAxis_RightStickY].bit_offset, 48);
+            TEST_EXPECT_EQ(plan.axes[HidPlanAxis_LeftTrigger].bit_offset, 56);
+            TEST_EXPECT_EQ(plan.axes[HidPlanAxis_RightTrigger].bit_offset, 64);
+            for (const auto &axis : plan.axes) {
+                TEST_EXPECT_EQ(axis.bit_size, 8);
+                TEST_EXPECT_EQ(axis.logical_min, 0);
+                TEST_EXPECT_EQ(axis.logical_max, 0xff);
+            }
+
+            TEST_EXPECT(IsValidHidMappingPlan(plan));
+        }
+
+        void TestFieldsBeyondReportAreDropped() {
+            HidMappingPlan plan;
+            TEST_EXPECT(CompileHidMappingPlan(OversizedDescriptor, sizeof(OversizedDescriptor), &plan));
+
+            TEST_EXPECT_EQ(plan.num_buttons, 2);
+            TEST_EXPECT_EQ(plan.report_size, 1);
+            TEST_EXPECT_EQ(plan.axes[HidPlanAxis_LeftStickX].bit_size, 0);
+            TEST_EXPECT(IsValidHidMappingPlan(plan));
+
+            TEST_EXPECT(!CompileHidMappingPlan(OutOfRangeDescriptor, sizeof(OutOfRangeDescriptor), &plan));
+        }
+
+        // Every truncation of a valid descriptor either fails or yields a plan that stays within its report
+        void TestTruncatedDescriptors() {
+            for (size_t size = 0; size <= sizeof(GamepadDescriptor); ++size) {
+                HidMappingPlan plan;
+                if (CompileHidMappingPlan(GamepadDescriptor, size, &plan)) {
+                    TEST_EXPECT(IsValidHidMappingPlan(plan));
+                    TEST_EXPECT(plan.report_size <= sizeof(bluetooth::HidReport::data) - 1);
+                }
+            }
+        }
+
+        // Plans loaded from the SD card are checked before use
+        void TestCorruptPlansAreRejected() {
+            HidMappingPlan valid;
+            TEST_EXPECT(CompileHidMappingPlan(GamepadDescriptor, sizeof(GamepadDescriptor), &valid));
+
+            auto plan = valid;
+            plan.report_size = sizeof(bluetooth::HidReport::data);
+            TEST_EXPECT(!IsValidHidMappingPlan(plan));
+
+            plan = valid;
+            plan.has_report_id = 0;
+            plan.report_size = sizeof(bluetooth::HidReport::data);
+            TEST_EXPECT(IsValidHidMappingPlan(plan));
+
+            plan = valid;
+            plan.button_bit_offsets[3] = valid.report_size * 8;
+            TEST_EXPECT(!IsValidHidMappingPlan(plan));
+
+            plan = valid;
+            plan.num_buttons = HidMappingPlan::MaxButtons + 1;
+            TEST_EXPECT(!IsValidHidMappingPlan(plan));
+
+            plan = valid;
+            plan.axes[HidPlanAxis_RightTrigger].bit_offset = valid.report_size * 8 - 4;
+            TEST_EXPECT(!IsValidHidMappingPlan(plan));
+
+            plan = valid;
+            plan.axes[HidPlanAxis_LeftStickX].bit_size = 33;
+            TEST_EXPECT(!IsValidHidMappingPlan(plan));
+
+            plan = valid;
+            plan.hat.logical_max = plan.hat.logical_min;
+            TEST_EXPECT(!IsValidHidMappingPlan(plan));
+        }
+
+    }
+
+}
+
+int main() {
+    ams::test::TestGamepadDescriptor();
+    ams::test::TestFieldsBeyondReportAreDropped();
+    ams::test::TestTruncatedDescriptors();
+    ams::test::TestCorruptPlansAreRejected();
+    return TEST_RESULT();
+}
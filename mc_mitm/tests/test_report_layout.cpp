@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test.hpp"
+#include "controllers/gamesir_controller.hpp"
+#include "controllers/betop_controller.hpp"
+#include "controllers/ipega_controller.hpp"
+#include "controllers/xiaomi_controller.hpp"
+
+namespace ams::test {
+
+    namespace {
+
+        using namespace ams::controller;
+
+        constexpr u8 TriggerMax = UINT8_MAX;
+
+        struct MappedState {
+            SwitchButtonData buttons;
+            SwitchAnalogStick left_stick;
+            SwitchAnalogStick right_stick;
+        };
+
+        // Hand-written mappers as they were before the drivers were converted to report layouts. Only the member accesses differ
+
+        void ReferenceGamesir0x03(const GamesirReportData *src, float trigger_threshold, MappedState *s) {
+            s->left_stick  = PackAnalogStickValues(src->input0x03.left_stick.x,  InvertAnalogStickValue(src->input0x03.left_stick.y));
+            s->right_stick = PackAnalogStickValues(src->input0x03.right_stick.x, InvertAnalogStickValue(src->input0x03.right_stick.y));
+
+            s->buttons.dpad_down  = (src->input0x03.dpad == GamesirDpad2_S)  ||
+                                    (src->input0x03.dpad == GamesirDpad2_SE) ||
+                                    (src->input0x03.dpad == GamesirDpad2_SW);
+            s->buttons.dpad_up    = (src->input0x03.dpad == GamesirDpad2_N)  ||
+                                    (src->input0x03.dpad == GamesirDpad2_NE) ||
+                                    (src->input0x03.dpad == GamesirDpad2_NW);
+            s->buttons.dpad_right = (src->input0x03.dpad == GamesirDpad2_E)  ||
+                                    (src->input0x03.dpad == GamesirDpad2_NE) ||
+                                    (src->input0x03.dpad == GamesirDpad2_SE);
+            s->buttons.dpad_left  = (src->input0x03.dpad == GamesirDpad2_W)  ||
+                                    (src->input0x03.dpad == GamesirDpad2_NW) ||
+                                    (src->input0x03.dpad == GamesirDpad2_SW);
+
+            s->buttons.A = src->input0x03.buttons.B;
+            s->buttons.B = src->input0x03.buttons.A;
+            s->buttons.X = src->input0x03.buttons.Y;
+            s->buttons.Y = src->input0x03.buttons.X;
+
+            s->buttons.R  = src->input0x03.buttons.RB;
+            s->buttons.ZR = src->input0x03.right_trigger > (trigger_threshold * TriggerMax);
+            s->buttons.L  = src->input0x03.buttons.LB;
+            s->buttons.ZL = src->input0x03.left_trigger  > (trigger_threshold * TriggerMax);
+
+            s->buttons.minus = src->input0x03.buttons.select;
+            s->buttons.plus  = src->input0x03.buttons.start;
+
+            s->buttons.lstick_press = src->input0x03.buttons.L3;
+            s->buttons.rstick_press = src->input0x03.buttons.R3;
+
+            s->buttons.home = src->input0x03.buttons.home;
+        }
+
+        void ReferenceGamesir0x07(const GamesirReportData *src, float trigger_threshold, MappedState *s) {
+            s->left_stick  = PackAnalogStickValues(src->input0x07.left_stick.x,  InvertAnalogStickValue(src->input0x07.left_stick.y));
+            s->right_stick = PackAnalogStickValues(src->input0x07.right_stick.x, InvertAnalogStickValue(src->input0x07.right_stick.y));
+
+            s->buttons.dpad_down  = (src->input0x07.dpad == GamesirDpad2_S)  ||
+                                    (src->input0x07.dpad == GamesirDpad2_SE) ||
+                                    (src->input0x07.dpad == GamesirDpad2_SW);
+            s->buttons.dpad_up    = (src->input0x07.dpad == GamesirDpad2_N)  ||
+                                    (src->input0x07.dpad == GamesirDpad2_NE) ||
+                                    (src->input0x07.dpad == GamesirDpad2_NW);
+            s->buttons.dpad_right = (src->input0x07.dpad == GamesirDpad2_E)  ||
+                                    (src->input0x07.dpad == GamesirDpad2_NE) ||
+                                    (src->input0x07.dpad == GamesirDpad2_SE);
+            s->buttons.dpad_left  = (src->input0x07.dpad == GamesirDpad2_W)  ||
+                                    (src->input0x07.dpad == GamesirDpad2_NW) ||
+                                    (src->input0x07.dpad == GamesirDpad2_SW);
+
+            s->buttons.A = src->input0x07.buttons.B;
+            s->buttons.B = src->input0x07.buttons.A;
+            s->buttons.X = src->input0x07.buttons.Y;
+            s->buttons.Y = src->input0x07.buttons.X;
+
+            s->buttons.R  = src->input0x07.buttons.RB;
+            s->buttons.ZR = src->input0x07.right_trigger > (trigger_threshold * TriggerMax);
+            s->buttons.L  = src->input0x07.buttons.LB;
+            s->buttons.ZL = src->input0x07.left_trigger  > (trigger_threshold * TriggerMax);
+
+            s->buttons.minus = src->input0x07.buttons.select;
+            s->buttons.plus  = src->input0x07.buttons.start;
+
+            s->buttons.lstick_press = src->input0x07.buttons.L3;
+            s->buttons.rstick_press = src->input0x07.buttons.R3;
+
+            s->buttons.home = src->input0x07.buttons.home;
+        }
+
+        void ReferenceGamesir0xc4(const GamesirReportData *src, float trigger_threshold, MappedState *s) {
+            s->left_stick  = PackAnalogStickValues(src->input0xc4.left_stick.x,  InvertAnalogStickValue(src->input0xc4.left_stick.y));
+            s->right_stick = PackAnalogStickValues(src->input0xc4.right_stick.x, InvertAnalogStickValue(src->input0xc4.right_stick.y));
+
+            s->buttons.dpad_down   = (src->input0xc4.dpad == GamesirDpad_S)  ||
+                                     (src->input0xc4.dpad == GamesirDpad_SE) ||
+                                     (src->input0xc4.dpad == GamesirDpad_SW);
+            s->buttons.dpad_up     = (src->input0xc4.dpad == GamesirDpad_N)  ||
+                                     (src->input0xc4.dpad == GamesirDpad_NE) ||
+                                     (src->input0xc4.dpad == GamesirDpad_NW);
+            s->buttons.dpad_right  = (src->input0xc4.dpad == GamesirDpad_E)  ||
+                                     (src->input0xc4.dpad == GamesirDpad_NE) ||
+                                     (src->input0xc4.dpad == GamesirDpad_SE);
+            s->buttons.dpad_left   = (src->input0xc4.dpad == GamesirDpad_W)  ||
+                                     (src->input0xc4.dpad == GamesirDpad_NW) ||
+                                     (src->input0xc4.dpad == GamesirDpad_SW);
+
+            s->buttons.A = src->input0xc4.buttons.B;
+            s->buttons.B = src->input0xc4.buttons.A;
+            s->buttons.X = src->input0xc4.buttons.Y;
+            s->buttons.Y = src->input0xc4.buttons.X;
+
+            s->buttons.R  = src->input0xc4.buttons.RB;
+            s->buttons.ZR = src->input0xc4.right_trigger > (trigger_threshold * TriggerMax);
+            s->buttons.L  = src->input0xc4.buttons.LB;
+            s->buttons.ZL = src->input0xc4.left_trigger  > (trigger_threshold * TriggerMax);
+
+            s->buttons.minus = src->input0xc4.buttons.select;
+            s->buttons.plus  = src->input0xc4.buttons.start;
+
+            s->buttons.lstick_press = src->input0xc4.buttons.L3;
+            s->buttons.rstick_press = src->input0xc4.buttons.R3;
+        }
+
+        void ReferenceBetop0x03(const BetopReportData *src, float, MappedState *s) {
+            s->left_stick  = PackAnalogStickValues(src->input0x03.left_stick.x,  InvertAnalogStickValue(src->input0x03.left_stick.y));
+            s->right_stick = PackAnalogStickValues(src->input0x03.right_stick.x, InvertAnalogStickValue(src->input0x03.right_stick.y));
+
+            s->buttons.dpad_down  = (src->input0x03.buttons.dpad == BetopDPad_S)  ||
+                                    (src->input0x03.buttons.dpad == BetopDPad_SE) ||
+                                    (src->input0x03.buttons.dpad == BetopDPad_SW);
+            s->buttons.dpad_up    = (src->input0x03.buttons.dpad == BetopDPad_N)  ||
+                                    (src->input0x03.buttons.dpad == BetopDPad_NE) ||
+                                    (src->input0x03.buttons.dpad == BetopDPad_NW);
+            s->buttons.dpad_right = (src->input0x03.buttons.dpad == BetopDPad_E)  ||
+                                    (src->input0x03.buttons.dpad == BetopDPad_NE) ||
+                                    (src->input0x03.buttons.dpad == BetopDPad_SE);
+            s->buttons.dpad_left  = (src->input0x03.buttons.dpad == BetopDPad_W)  ||
+                                    (src->input0x03.buttons.dpad == BetopDPad_NW) ||
+                                    (src->input0x03.buttons.dpad == BetopDPad_SW);
+
+            s->buttons.A = src->input0x03.buttons.B;
+            s->buttons.B = src->input0x03.buttons.A;
+            s->buttons.X = src->input0x03.buttons.Y;
+            s->buttons.Y = src->input0x03.buttons.X;
+
+            s->buttons.R  = src->input0x03.buttons.R1;
+            s->buttons.ZR = src->input0x03.buttons.R2;
+            s->buttons.L  = src->input0x03.buttons.L1;
+            s->buttons.ZL = src->input0x03.buttons.L2;
+
+            s->buttons.lstick_press = src->input0x03.buttons.L3;
+            s->buttons.rstick_press = src->input0x03.buttons.R3;
+
+            s->buttons.minus = src->input0x03.buttons.select;
+            s->buttons.plus  = src->input0x03.buttons.start;
+
+            s->buttons.home = src->input0x03.buttons.home;
+        }
+
+        void ReferenceIpega0x07(const IpegaReportData *src, float trigger_threshold, MappedState *s) {
+            s->left_stick  = PackAnalogStickValues(src->input0x07.left_stick.x,  InvertAnalogStickValue(src->input0x07.left_stick.y));
+            s->right_stick = PackAnalogStickValues(src->input0x07.right_stick.x, InvertAnalogStickValue(src->input0x07.right_stick.y));
+
+            s->buttons.dpad_down  = (src->input0x07.buttons.dpad == IpegaDPad_S)  ||
+                                    (src->input0x07.buttons.dpad == IpegaDPad_SE) ||
+                                    (src->input0x07.buttons.dpad == IpegaDPad_SW);
+            s->buttons.dpad_up    = (src->input0x07.buttons.dpad == IpegaDPad_N)  ||
+                                    (src->input0x07.buttons.dpad == IpegaDPad_NE) ||
+                                    (src->input0x07.buttons.dpad == IpegaDPad_NW);
+            s->buttons.dpad_right = (src->input0x07.buttons.dpad == IpegaDPad_E)  ||
+                                    (src->input0x07.buttons.dpad == IpegaDPad_NE) ||
+                                    (src->input0x07.buttons.dpad == IpegaDPad_SE);
+            s->buttons.dpad_left  = (src->input0x07.buttons.dpad == IpegaDPad_W)  ||
+                                    (src->input0x07.buttons.dpad == IpegaDPad_NW) ||
+                                    (src->input0x07.buttons.dpad == IpegaDPad_SW);
+
+            s->buttons.A = src->input0x07.buttons.B;
+            s->buttons.B = src->input0x07.buttons.A;
+            s->buttons.X = src->input0x07.buttons.Y;
+            s->buttons.Y = src->input0x07.buttons.X;
+
+            s->buttons.R  = src->input0x07.buttons.RB;
+            s->buttons.ZR = src->input0x07.right_trigger > (trigger_threshold * TriggerMax);
+            s->buttons.L  = src->input0x07.buttons.LB;
+            s->buttons.ZL = src->input0x07.left_trigger  > (trigger_threshold * TriggerMax);
+
+            s->buttons.minus = src->input0x07.buttons.view;
+            s->buttons.plus  = src->input0x07.buttons.menu;
+
+            s->buttons.lstick_press = src->input0x07.buttons.lstick_press | src->input0x07.buttons.L3_g910;
+            s->buttons.rstick_press = src->input0x07.buttons.rstick_press | src->input0x07.buttons.R3_g910;
+        }
+
+        void ReferenceXiaomi0x04(const XiaomiReportData *src, float trigger_threshold, MappedState *s) {
+            s->left_stick  = PackAnalogStickValues(src->input0x04.left_stick.x,  InvertAnalogStickValue(src->input0x04.left_stick.y));
+            s->right_stick = PackAnalogStickValues(src->input0x04.right_stick.x, InvertAnalogStickValue(src->input0x04.right_stick.y));
+
+            s->buttons.dpad_down  = (src->input0x04.buttons.dpad == XiaomiDPad_S)  ||
+                                    (src->input0x04.buttons.dpad == XiaomiDPad_SE) ||
+                                    (src->input0x04.buttons.dpad == XiaomiDPad_SW);
+            s->buttons.dpad_up    = (src->input0x04.buttons.dpad == XiaomiDPad_N)  ||
+                                    (src->input0x04.buttons.dpad == XiaomiDPad_NE) ||
+                                    (src->input0x04.buttons.dpad == XiaomiDPad_NW);
+            s->buttons.dpad_right = (src->input0x04.buttons.dpad == XiaomiDPad_E)  ||
+                                    (src->input0x04.buttons.dpad == XiaomiDPad_NE) ||
+                                    (src->input0x04.buttons.dpad == XiaomiDPad_SE);
+            s->buttons.dpad_left  = (src->input0x04.buttons.dpad == XiaomiDPad_W)  ||
+                                    (src->input0x04.buttons.dpad == XiaomiDPad_NW) ||
+                                    (src->input0x04.buttons.dpad == XiaomiDPad_SW);
+
+            s->buttons.A = src->input0x04.buttons.B;
+            s->buttons.B = src->input0x04.buttons.A;
+            s->buttons.X = src->input0x04.buttons.Y;
+            s->buttons.Y = src->input0x04.buttons.X;
+
+            s->buttons.R  = src->input0x04.buttons.R1;
+            s->buttons.ZR = src->input0x04.right_trigger > (trigger_threshold * TriggerMax);
+            s->buttons.L  = src->input0x04.buttons.L1;
+            s->buttons.ZL = src->input0x04.left_trigger  > (trigger_threshold * TriggerMax);
+
+            s->buttons.minus = src->input0x04.buttons.back;
+            s->buttons.plus  = src->input0x04.buttons.menu;
+
+            s->buttons.lstick_press = src->input0x04.buttons.lstick_press;
+            s->buttons.rstick_press = src->input0x04.buttons.rstick_press;
+
+            s->buttons.home = src->input0x04.home;
+        }
+
+        // Same steps as EmulatedSwitchController::MapReportLayout
+        template <layout::ReportLayout Layout>
+        void MapLayout(const u8 *report, float trigger_threshold, MappedState *s) {
+            layout::MapStick<Layout.left_stick>(report, &s->left_stick);
+            layout::MapStick<Layout.right_stick>(report, &s->right_stick);
+            layout::MapButtons<Layout>(report, trigger_threshold, &s->buttons);
+        }
+
+        bool operator==(const MappedState &lhs, const MappedState &rhs) {
+            return std::memcmp(&lhs, &rhs, sizeof(MappedState)) == 0;
+        }
+
+        void PrintBytes(const char *label, const void *data, size_t size) {
+            std::fprintf(stderr, "%s", label);
+            for (size_t i = 0; i < size; ++i) {
+                std::fprintf(stderr, " %02x", static_cast<const u8 *>(data)[i]);
+            }
+            std::fprintf(stderr, "\n");
+        }
+
+        template <layout::ReportLayout Layout, typename ReportData>
+        void CheckParity(const char *fixture, void (*reference)(const ReportData *, float, MappedState *)) {
+            constexpr float Thresholds[] = { 0.0f, 0.5f, 0.99f };
+
+            const auto reports = LoadReportFixture(fixture);
+            TEST_EXPECT(!reports.empty());
+
+            for (const auto &report : reports) {
+                bluetooth::HidReport hid_report = {};
+                hid_report.size = report.size();
+                std::memcpy(hid_report.data, report.data(), report.size());
+                auto src = reinterpret_cast<const ReportData *>(hid_report.data);
+
+                for (float threshold : Thresholds) {
+                    // Buttons a layout doesn't cover must keep whatever state they had
+                    for (u8 fill : { 0x00, 0xff }) {
+                        MappedState expected, actual;
+                        std::memset(&expected, fill, sizeof(expected));
+                        std::memset(&actual, fill, sizeof(actual));
+
+                        reference(src, threshold, &expected);
+                        MapLayout<Layout>(hid_report.data, threshold, &actual);
+
+                        if (!(expected == actual)) {
+                            std::fprintf(stderr, "%s: mismatch at threshold %.2f, fill %02x\n", fixture, threshold, fill);
+                            PrintBytes("  report  ", report.data(), report.size());
+                            PrintBytes("  expected", &expected, sizeof(expected));
+                            PrintBytes("  actual  ", &actual, sizeof(actual));
+                            ++g_failures;
+                        }
+                    }
+                }
+            }
+        }
+
+    }
+
+}
+
+int main() {
+    using namespace ams::controller;
+
+    ams::test::CheckParity<GamesirInputReport0x03Layout>("gamesir_0x03", ams::test::ReferenceGamesir0x03);
+    ams::test::CheckParity<GamesirInputReport0x07Layout>("gamesir_0x07", ams::test::ReferenceGamesir0x07);
+    ams::test::CheckParity<GamesirInputReport0xc4Layout>("gamesir_0xc4", ams::test::ReferenceGamesir0xc4);
+    ams::test::CheckParity<BetopInputReport0x03Layout>("betop_0x03", ams::test::ReferenceBetop0x03);
+    ams::test::CheckParity<IpegaInputReport0x07Layout>("ipega_0x07", ams::test::ReferenceIpega0x07);
+    ams::test::CheckParity<XiaomiInputReport0x04Layout>("xiaomi_0x04", ams::test::ReferenceXiaomi0x04);
+
+    return TEST_RESULT();
+}
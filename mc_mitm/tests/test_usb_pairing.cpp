@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test.hpp"
+#include "usb/mc_usb_control_transfer.cpp"
+#include "usb/mc_usb_pairing_strategies.cpp"
+#include "utils/utils_bluetooth_address.cpp"
+
+namespace ams::test {
+
+    namespace {
+
+        constexpr bluetooth::Address HostAddress = {{0x98, 0xb6, 0xe9, 0xa1, 0xb2, 0xc3}};
+        constexpr u8 GeneratedLinkKey[usb::LinkKeySize] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+
+        struct PairedDevice {
+            bool added;
+            bluetooth::Address address;
+            bluetooth::DeviceClass class_of_device;
+            u16 vid;
+            u16 pid;
+            std::string name;
+            bool has_link_key;
+            u8 link_key[usb::LinkKeySize];
+        };
+
+        PairedDevice g_paired_device;
+
+    }
+
+}
+
+namespace ams::usb {
+
+    Result GetHostAddress(bluetooth::Address *out_address) {
+        *out_address = test::HostAddress;
+        R_SUCCEED();
+    }
+
+    Result AddPairedDevice(const UsbPairedDevice *device) {
+        auto &paired = test::g_paired_device;
+        paired.added = true;
+        paired.address = device->address;
+        paired.class_of_device = device->class_of_device;
+        paired.vid = device->vid;
+        paired.pid = device->pid;
+        paired.name = device->name;
+        paired.has_link_key = device->link_key != nullptr;
+        if (paired.has_link_key) {
+            std::memcpy(paired.link_key, device->link_key, sizeof(paired.link_key));
+        }
+
+        R_SUCCEED();
+    }
+
+}
+
+namespace ams::test {
+
+    namespace {
+
+        constexpr size_t SetupPacketSize = 8;
+        constexpr u8 RequestTypeIn  = 0xa1;
+        constexpr u8 RequestTypeOut = 0x21;
+
+        // Replays recorded control transfers, checking each request against the recording and answering it with the recorded data
+        class RecordedControlTransfer final : public usb::ControlTransferInterface {
+
+            public:
+                explicit RecordedControlTransfer(std::vector<std::vector<u8>> transfers) : m_transfers(std::move(transfers)), m_index(0) { }
+
+                Result ControlTransferIn(u8 request, u16 value, void *out_data, u16 length, u32 *out_size) override {
+                    auto transfer = this->Next(RequestTypeIn, request, value, length);
+                    R_UNLESS(transfer != nullptr, svc::ResultNotFound());
+
+                    const size_t size = std::min<size_t>(transfer->size() - SetupPacketSize, length);
+                    std::memcpy(out_data, transfer->data() + SetupPacketSize, size);
+                    *out_size = size;
+
+                    R_SUCCEED();
+                }
+
+                Result ControlTransferOut(u8 request, u16 value, const void *data, u16 length) override {
+                    auto transfer = this->Next(RequestTypeOut, request, value, length);
+                    R_UNLESS(transfer != nullptr, svc::ResultNotFound());
+
+                    TEST_EXPECT_EQ(transfer->size() - SetupPacketSize, length);
+                    TEST_EXPECT(std::memcmp(transfer->data() + SetupPacketSize, data, std::min<size_t>(transfer->size() - SetupPacketSize, length)) == 0);
+
+                    R_SUCCEED();
+                }
+
+                bool IsComplete() const {
+                    return m_index == m_transfers.size();
+                }
+
+            private:
+                const std::vector<u8> *Next(u8 request_type, u8 request, u16 value, u16 length) {
+                    TEST_EXPECT(m_index < m_transfers.size());
+                    if (m_index >= m_transfers.size()) {
+                        return nullptr;
+                    }
+
+                    const auto &transfer = m_transfers[m_index++];
+                    TEST_EXPECT(transfer.size() >= SetupPacketSize);
+                    if (transfer.size() < SetupPacketSize) {
+                        return nullptr;
+                    }
+
+                    TEST_EXPECT_EQ(transfer[0], request_type);
+                    TEST_EXPECT_EQ(transfer[1], request);
+                    TEST_EXPECT_EQ(transfer[2] | (transfer[3] << 8), value);
+                    TEST_EXPECT_EQ(transfer[6] | (transfer[7] << 8), length);
+
+                    return &transfer;
+                }
+
+                std::vector<std::vector<u8>> m_transfers;
+                size_t m_index;
+
+        };
+
+        constexpr UsbHsInterface MakeInterface(u16 vid, u16 pid) {
+            return { .device_desc = { .idVendor = vid, .idProduct = pid } };
+        }
+
+        bool IsAddress(const bluetooth::Address &address, std::initializer_list<u8> expected) {
+            return std::equal(expected.begin(), expected.end(), address.address);
+        }
+
+        void TestIdentify() {
+            const auto ds3 = MakeInterface(0x054c, 0x0268);
+            const auto ds4 = MakeInterface(0x054c, 0x09cc);
+            const auto dualsense = MakeInterface(0x054c, 0x0ce6);
+            const auto hori = MakeInterface(0x0f0d, 0x00f6);
+
+            TEST_EXPECT(usb::IdentifyDualshock3(&ds3));
+            TEST_EXPECT(!usb::IdentifyDualshock3(&ds4));
+            TEST_EXPECT(usb::IdentifyDualshock4(&ds4));
+            TEST_EXPECT(!usb::IdentifyDualshock4(&dualsense));
+            TEST_EXPECT(usb::IdentifyDualsense(&dualsense));
+            TEST_EXPECT(!usb::IdentifyDualsense(&ds3));
+
+            // Licensed controllers share a driver with the Dualshock 4, but don't support USB pairing
+            TEST_EXPECT(!usb::IdentifyDualshock4(&hori));
+        }
+
+        void TestPairDualshock3() {
+            RecordedControlTransfer control(LoadReportFixture("dualshock3_usb_pairing"));
+            const auto iface = MakeInterface(0x054c, 0x0268);
+
+            g_paired_device = {};
+            TEST_EXPECT(R_SUCCEEDED(usb::PairDualshock3(&control, &iface)));
+            TEST_EXPECT(control.IsComplete());
+
+            TEST_EXPECT(g_paired_device.added);
+            TEST_EXPECT(IsAddress(g_paired_device.address, {0x00, 0x06, 0xf5, 0x48, 0xe2, 0x49}));
+            TEST_EXPECT_EQ(g_paired_device.class_of_device.class_of_device[1], 0x05);
+            TEST_EXPECT_EQ(g_paired_device.vid, 0x054c);
+            TEST_EXPECT_EQ(g_paired_device.pid, 0x0268);
+            TEST_EXPECT(g_paired_device.name == "PLAYSTATION(R)3 Controller");
+            TEST_EXPECT(!g_paired_device.has_link_key);
+        }
+
+        void TestPairWithLinkKey(Result (*pair)(usb::ControlTransferInterface *, const UsbHsInterface *), const char *fixture, u16 pid, std::initializer_list<u8> address) {
+            RecordedControlTransfer control(LoadReportFixture(fixture));
+            const auto iface = MakeInterface(0x054c, pid);
+
+            g_paired_device = {};
+            TEST_EXPECT(R_SUCCEEDED(pair(&control, &iface)));
+            TEST_EXPECT(control.IsComplete());
+
+            TEST_EXPECT(g_paired_device.added);
+            TEST_EXPECT(IsAddress(g_paired_device.address, address));
+            TEST_EXPECT_EQ(g_paired_device.class_of_device.class_of_device[1], 0x25);
+            TEST_EXPECT_EQ(g_paired_device.vid, 0x054c);
+            TEST_EXPECT_EQ(g_paired_device.pid, pid);
+            TEST_EXPECT(g_paired_device.name == "Wireless Controller");
+            TEST_EXPECT(g_paired_device.has_link_key);
+            TEST_EXPECT(std::memcmp(g_paired_device.link_key, GeneratedLinkKey, sizeof(GeneratedLinkKey)) == 0);
+        }
+
+        // A controller that answers with less than the full report must not be added with a partial address
+        void TestShortResponse(Result (*pair)(usb::ControlTransferInterface *, const UsbHsInterface *), const char *fixture, size_t transfer_index, u16 pid) {
+            auto transfers = LoadReportFixture(fixture);
+            transfers[transfer_index].pop_back();
+
+            RecordedControlTransfer control(std::move(transfers));
+            const auto iface = MakeInterface(0x054c, pid);
+
+            g_paired_device = {};
+            TEST_EXPECT_EQ(pair(&control, &iface), svc::ResultOutOfRange());
+            TEST_EXPECT(!g_paired_device.added);
+        }
+
+    }
+
+}
+
+int main() {
+    using namespace ams;
+
+    test::TestIdentify();
+    test::TestPairDualshock3();
+    test::TestPairWithLinkKey(usb::PairDualshock4, "dualshock4_usb_pairing", 0x09cc, {0x1c, 0x06, 0xf5, 0x48, 0xe2, 0x49});
+    test::TestPairWithLinkKey(usb::PairDualsense, "dualsense_usb_pairing", 0x0ce6, {0xa0, 0x5a, 0x5d, 0x12, 0x34, 0x56});
+    test::TestShortResponse(usb::PairDualshock3, "dualshock3_usb_pairing", 1, 0x0268);
+    test::TestShortResponse(usb::PairDualshock4, "dualshock4_usb_pairing", 0, 0x09cc);
+    test::TestShortResponse(usb::PairDualsense, "dualsense_usb_pairing", 0, 0x0ce6);
+    return TEST_RESULT();
+}
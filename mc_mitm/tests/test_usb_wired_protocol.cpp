@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2020-2026 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test.hpp"
+#include "usb/mc_usb_wired_protocol.cpp"
+#include "controllers/dualsense_controller.hpp"
+
+namespace ams::test {
+
+    namespace {
+
+        using namespace ams::controller;
+        using namespace ams::usb;
+
+        bluetooth::HidReport MakeReport(const std::vector<u8> &data) {
+            bluetooth::HidReport report = {};
+            report.size = data.size();
+            std::memcpy(report.data, data.data(), data.size());
+            return report;
+        }
+
+        // The converted report must read exactly like the USB one through the fields the driver uses
+        void TestDualshock4InputReport() {
+            for (const auto &usb : LoadReportFixture("dualshock4_usb_input_0x01")) {
+                bluetooth::HidReport report;
+                ConvertInputReport(WiredProtocol_Dualshock4, usb.data(), usb.size(), &report);
+
+                TEST_EXPECT_EQ(report.size, usb.size() + 2);
+                TEST_EXPECT_EQ(report.data[0], 0x11);
+
+                auto in = reinterpret_cast<const Dualshock4ReportData *>(usb.data());
+                auto out = reinterpret_cast<const Dualshock4ReportData *>(report.data);
+                TEST_EXPECT(std::memcmp(&out->input0x11.left_stick, &in->input0x01, sizeof(in->input0x01)) == 0);
+                TEST_EXPECT_EQ(out->input0x11.vel_x, static_cast<s16>(usb[13] | (usb[14] << 8)));
+                TEST_EXPECT_EQ(out->input0x11.acc_z, static_cast<s16>(usb[23] | (usb[24] << 8)));
+                TEST_EXPECT_EQ(out->input0x11.battery_level, usb[30] & 0xf);
+                TEST_EXPECT_EQ(out->input0x11.usb, (usb[30] >> 4) & 1);
+                TEST_EXPECT_EQ(out->input0x11.num_reports, usb[33]);
+                TEST_EXPECT(std::memcmp(out->input0x11.touch_reports, &usb[34], sizeof(out->input0x11.touch_reports)) == 0);
+            }
+        }
+
+        void TestDualsenseInputReport() {
+            for (const auto &usb : LoadReportFixture("dualsense_usb_input_0x01")) {
+                bluetooth::HidReport report;
+                ConvertInputReport(WiredProtocol_Dualsense, usb.data(), usb.size(), &report);
+
+                TEST_EXPECT_EQ(report.size, usb.size() + 1);
+                TEST_EXPECT_EQ(report.data[0], 0x31);
+
+                auto out = reinterpret_cast<const DualsenseReportData *>(report.data);
+                TEST_EXPECT_EQ(out->input0x31.left_stick.x, usb[1]);
+                TEST_EXPECT_EQ(out->input0x31.right_stick.y, usb[4]);
+                TEST_EXPECT_EQ(out->input0x31.left_trigger, usb[5]);
+                TEST_EXPECT_EQ(out->input0x31.right_trigger, usb[6]);
+                TEST_EXPECT(std::memcmp(&out->input0x31.buttons, &usb[8], sizeof(out->input0x31.buttons)) == 0);
+                TEST_EXPECT_EQ(out->input0x31.vel_x, static_cast<s16>(usb[16] | (usb[17] << 8)));
+                TEST_EXPECT_EQ(out->input0x31.acc_z, static_cast<s16>(usb[26] | (usb[27] << 8)));
+                TEST_EXPECT_EQ(out->input0x31.timestamp, static_cast<s32>(usb[28] | (usb[29] << 8) | (usb[30] << 16) | (usb[31] << 24)));
+                TEST_EXPECT_EQ(out->input0x31.battery_level, usb[53] & 0xf);
+                TEST_EXPECT_EQ(out->input0x31.usb, (usb[53] >> 4) & 1);
+                TEST_EXPECT_EQ(out->input0x31.full, (usb[53] >> 5) & 1);
+            }
+        }
+
+        // Dualshock 3 reports are identical over both transports, and reports other than the main input one are never rewritten
+        void TestPassthroughInputReports() {
+            const u8 dualshock3[] = { 0x01, 0x00, 0x01, 0x10, 0x00, 0xff, 0x7f, 0x80, 0x00, 0x81 };
+            const u8 other[] = { 0x02, 0xaa, 0xbb, 0xcc };
+
+            bluetooth::HidReport report;
+            ConvertInputReport(WiredProtocol_Dualshock3, dualshock3, sizeof(dualshock3), &report);
+            TEST_EXPECT_EQ(report.size, sizeof(dualshock3));
+            TEST_EXPECT(std::memcmp(report.data, dualshock3, sizeof(dualshock3)) == 0);
+
+            for (auto protocol : { WiredProtocol_Dualshock4, WiredProtocol_Dualsense }) {
+                ConvertInputReport(protocol, other, sizeof(other), &report);
+                TEST_EXPECT_EQ(report.size, sizeof(other));
+                TEST_EXPECT(std::memcmp(report.data, other, sizeof(other)) == 0);
+            }
+        }
+
+        void TestOutputReport(WiredProtocol protocol, const char *bt_fixture, const char *usb_fixture) {
+            const auto bt = LoadReportFixture(bt_fixture);
+            const auto usb = LoadReportFixture(usb_fixture);
+            TEST_EXPECT_EQ(bt.size(), usb.size());
+
+            for (size_t i = 0; i < std::min(bt.size(), usb.size()); ++i) {
+                const auto report = MakeReport(bt[i]);
+                u8 data[sizeof(report.data)];
+                std::memset(data, 0xcc, sizeof(data));
+
+                const size_t size = ConvertOutputReport(protocol, &report, data);
+                TEST_EXPECT_EQ(size, usb[i].size());
+                TEST_EXPECT(std::memcmp(data, usb[i].data(), std::min(size, usb[i].size())) == 0);
+            }
+        }
+
+        void TestPassthroughOutputReports() {
+            const auto report = MakeReport({ 0x01, 0x00, 0xfe, 0x10, 0xff, 0x20, 0x00, 0x00, 0x00, 0x00, 0x02 });
+            u8 data[sizeof(report.data)];
+
+            TEST_EXPECT_EQ(ConvertOutputReport(WiredProtocol_Dualshock3, &report, data), report.size);
+            TEST_EXPECT(std::memcmp(data, report.data, report.size) == 0);
+
+            // Reports too short to hold the Bluetooth header are passed through rather than read past their end
+            const auto header_only = MakeReport({ 0x11, 0xc0 });
+            TEST_EXPECT_EQ(ConvertOutputReport(WiredProtocol_Dualshock4, &header_only, data), header_only.size);
+            TEST_EXPECT(std::memcmp(data, header_only.data, header_only.size) == 0);
+        }
+
+        void TestFeatureReportIds() {
+            TEST_EXPECT_EQ(GetUsbFeatureReportId(WiredProtocol_Dualshock4, 0x05), 0x02);
+            TEST_EXPECT_EQ(GetUsbFeatureReportId(WiredProtocol_Dualshock4, 0x06), 0xa3);
+            TEST_EXPECT_EQ(GetUsbFeatureReportId(WiredProtocol_Dualshock4, 0x12), 0x12);
+            TEST_EXPECT_EQ(GetUsbFeatureReportId(WiredProtocol_Dualsense, 0x05), 0x05);
+            TEST_EXPECT_EQ(GetUsbFeatureReportId(WiredProtocol_Dualsense, 0x09), 0x09);
+            TEST_EXPECT_EQ(GetUsbFeatureReportId(WiredProtocol_Dualshock3, 0xf2), 0xf2);
+        }
+
+        void TestDualshock4Calibration() {
+            for (const auto &usb : LoadReportFixture("dualshock4_usb_feature_0x02")) {
+                bluetooth::HidReport report;
+                ConvertFeatureReport(WiredProtocol_Dualshock4, 0x05, usb.data(), usb.size(), &report);
+
+                TEST_EXPECT_EQ(report.data[0], 0x05);
+                TEST_EXPECT(report.size >= sizeof(Dualshock4FeatureReport0x05) + 1);
+
+                // Fields in the fixture hold their position in the USB report
+                const auto &calibration = reinterpret_cast<const Dualshock4ReportData *>(report.data)->feature0x05.calibration;
+                TEST_EXPECT_EQ(calibration.gyro.pitch_bias, 1);
+                TEST_EXPECT_EQ(calibration.gyro.yaw_bias,   2);
+                TEST_EXPECT_EQ(calibration.gyro.roll_bias,  3);
+                TEST_EXPECT_EQ(calibration.gyro.pitch_max,  4);
+                TEST_EXPECT_EQ(calibration.gyro.pitch_min,  5);
+                TEST_EXPECT_EQ(calibration.gyro.yaw_max,    6);
+                TEST_EXPECT_EQ(calibration.gyro.yaw_min,    7);
+                TEST_EXPECT_EQ(calibration.gyro.roll_max,   8);
+                TEST_EXPECT_EQ(calibration.gyro.roll_min,   9);
+                TEST_EXPECT_EQ(calibration.gyro.speed_max, 10);
+                TEST_EXPECT_EQ(calibration.gyro.speed_min, 11);
+                TEST_EXPECT_EQ(calibration.acc.x_max,      12);
+                TEST_EXPECT_EQ(calibration.acc.z_min,      17);
+            }
+        }
+
+        // Only the Dualshock 4 calibration report is rearranged
+        void TestOtherFeatureReports() {
+            const auto usb = LoadReportFixture("dualshock4_usb_feature_0x02");
+            for (auto [protocol, id] : { std::pair{WiredProtocol_Dualshock4, u8(0x12)}, std::pair{WiredProtocol_Dualsense, u8(0x05)} }) {
+                bluetooth::HidReport report;
+                ConvertFeatureReport(protocol, id, usb[0].data(), usb[0].size(), &report);
+
+                TEST_EXPECT_EQ(report.size, usb[0].size());
+                TEST_EXPECT_EQ(report.data[0], id);
+                TEST_EXPECT(std::memcmp(&report.data[1], &usb[0][1], usb[0].size() - 1) == 0);
+            }
+        }
+
+    }
+
+}
+
+int main() {
+    ams::test::TestDualshock4InputReport();
+    ams::test::TestDualsenseInputReport();
+    ams::test::TestPassthroughInputReports();
+    ams::test::TestOutputReport(ams::usb::WiredProtocol_Dualshock4, "dualshock4_bt_output_0x11", "dualshock4_usb_output_0x05");
+    ams::test::TestOutputReport(ams::usb::WiredProtocol_Dualsense, "dualsense_bt_output_0x31", "dualsense_usb_output_0x02");
+    ams::test::TestPassthroughOutputReports();
+    ams::test::TestFeatureReportIds();
+    ams::test::TestDualshock4Calibration();
+    ams::test::TestOtherFeatureReports();
+    return TEST_RESULT();
+}